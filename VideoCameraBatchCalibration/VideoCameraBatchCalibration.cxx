@@ -0,0 +1,606 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: VideoCameraBatchCalibration.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// Headless calibration: detect the board in every frame on a pool of threads, solve the camera and
+// write it with the video camera storage node, exit code depending on the reprojection errors.
+
+#include "VideoCameraBatchCalibrationCLP.h"
+
+// VideoCameras MRML includes
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkMRMLVideoCameraStorageNode.h"
+#include "vtkVideoCameraObservations.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkMatrix3x3.h>
+#include <vtkNew.h>
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// OpenCV includes
+#include <opencv2/aruco.hpp>
+#include <opencv2/aruco/charuco.hpp>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  enum
+  {
+    ExitAccepted = 0,
+    ExitFailed = 1,
+    ExitRejected = 2
+  };
+
+  // Frames are detected in batches so that a long video is never held in memory at once
+  const size_t FramesPerThread = 8;
+
+  //----------------------------------------------------------------------------
+  struct Board
+  {
+    std::string                         Type;
+    cv::Size                            PatternSize;
+    std::vector<cv::Point3f>            Pattern;
+    cv::Ptr<cv::aruco::Dictionary>      Dictionary;
+    cv::Ptr<cv::aruco::GridBoard>       GridBoard;
+    cv::Ptr<cv::aruco::CharucoBoard>    CharucoBoard;
+    bool                                Invert;
+    int                                 SubPixelRadius;
+  };
+
+  //----------------------------------------------------------------------------
+  // One frame to detect in, and what was found
+  struct View
+  {
+    std::string                         FileName;
+    cv::Mat                             Image;
+    bool                                Found;
+    /// Checkerboard and circle grid points or charuco corners
+    std::vector<cv::Point2f>            Points;
+    /// Aruco marker corners
+    std::vector<std::vector<cv::Point2f> > MarkerCorners;
+    /// Aruco marker or charuco corner ids
+    std::vector<int>                    Ids;
+  };
+
+  //----------------------------------------------------------------------------
+  bool GetPredefinedDictionary(const std::string& name, cv::Ptr<cv::aruco::Dictionary>& dictionary)
+  {
+    static const char* names[] =
+    {
+      "4X4_50", "4X4_100", "4X4_250", "4X4_1000",
+      "5X5_50", "5X5_100", "5X5_250", "5X5_1000",
+      "6X6_50", "6X6_100", "6X6_250", "6X6_1000",
+      "7X7_50", "7X7_100", "7X7_250", "7X7_1000",
+      "ARUCO_ORIGINAL"
+    };
+    const std::string shortName = name.compare(0, 5, "DICT_") == 0 ? name.substr(5) : name;
+    for (int i = 0; i < static_cast<int>(sizeof(names) / sizeof(names[0])); ++i)
+    {
+      if (shortName == names[i])
+      {
+        dictionary = cv::aruco::getPredefinedDictionary(static_cast<cv::aruco::PREDEFINED_DICTIONARY_NAME>(i));
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  void Detect(const Board& board, View& view)
+  {
+    view.Found = false;
+    // images are detected as read, row 0 is the first row of the file or frame
+    // (pixel convention of vtkSlicerVideoCameraProjection.h)
+    if (view.Image.empty() && !view.FileName.empty())
+    {
+      view.Image = cv::imread(view.FileName, cv::IMREAD_GRAYSCALE);
+    }
+    if (view.Image.empty())
+    {
+      return;
+    }
+
+    cv::Mat gray = view.Image;
+    if (gray.channels() == 3)
+    {
+      cv::cvtColor(view.Image, gray, cv::COLOR_BGR2GRAY);
+    }
+    if (board.Invert)
+    {
+      cv::bitwise_not(gray, gray);
+    }
+    view.Image = gray;
+
+    if (board.Type == "checkerboard")
+    {
+      view.Found = cv::findChessboardCorners(gray, board.PatternSize, view.Points, cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE);
+      if (view.Found)
+      {
+        cv::cornerSubPix(gray, view.Points, cv::Size(board.SubPixelRadius, board.SubPixelRadius), cv::Size(-1, -1),
+                         cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.1));
+      }
+    }
+    else if (board.Type == "circlegrid")
+    {
+      view.Found = cv::findCirclesGrid(gray, board.PatternSize, view.Points, cv::CALIB_CB_SYMMETRIC_GRID);
+    }
+    else if (board.Type == "aruco")
+    {
+      cv::aruco::detectMarkers(gray, board.Dictionary, view.MarkerCorners, view.Ids);
+      view.Found = !view.Ids.empty();
+    }
+    else if (board.Type == "charuco")
+    {
+      std::vector<std::vector<cv::Point2f> > markerCorners;
+      std::vector<int> markerIds;
+      cv::aruco::detectMarkers(gray, board.Dictionary, markerCorners, markerIds);
+      if (!markerIds.empty())
+      {
+        for (size_t i = 0; i < markerCorners.size(); ++i)
+        {
+          cv::cornerSubPix(gray, markerCorners[i], cv::Size(3, 3), cv::Size(-1, -1),
+                           cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 100, 0.00001));
+        }
+        cv::aruco::interpolateCornersCharuco(markerCorners, markerIds, gray, board.CharucoBoard, view.Points, view.Ids);
+        view.Found = view.Ids.size() > 3;
+      }
+    }
+
+    // only the detections are kept
+    view.Image.release();
+  }
+
+  //----------------------------------------------------------------------------
+  void DetectAll(const Board& board, std::vector<View>& views, unsigned int threadCount)
+  {
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; ++t)
+    {
+      threads.push_back(std::thread([&board, &views, &next]()
+      {
+        for (size_t i = next++; i < views.size(); i = next++)
+        {
+          Detect(board, views[i]);
+        }
+      }));
+    }
+    for (size_t t = 0; t < threads.size(); ++t)
+    {
+      threads[t].join();
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Board points matching the image points of a view
+  void GetViewCorrespondences(const Board& board, const View& view, std::vector<cv::Point3f>& objectPoints, std::vector<cv::Point2f>& imagePoints)
+  {
+    objectPoints.clear();
+    imagePoints.clear();
+    if (board.Type == "aruco")
+    {
+      for (size_t i = 0; i < view.Ids.size(); ++i)
+      {
+        std::vector<int>::const_iterator it = std::find(board.GridBoard->ids.begin(), board.GridBoard->ids.end(), view.Ids[i]);
+        if (it == board.GridBoard->ids.end())
+        {
+          continue;
+        }
+        const std::vector<cv::Point3f>& markerPoints = board.GridBoard->objPoints[it - board.GridBoard->ids.begin()];
+        objectPoints.insert(objectPoints.end(), markerPoints.begin(), markerPoints.end());
+        imagePoints.insert(imagePoints.end(), view.MarkerCorners[i].begin(), view.MarkerCorners[i].end());
+      }
+    }
+    else if (board.Type == "charuco")
+    {
+      for (size_t i = 0; i < view.Ids.size(); ++i)
+      {
+        objectPoints.push_back(board.CharucoBoard->chessboardCorners[view.Ids[i]]);
+      }
+      imagePoints = view.Points;
+    }
+    else
+    {
+      objectPoints = board.Pattern;
+      imagePoints = view.Points;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Board points the ids of the views refer to, none for aruco boards whose ids are marker ids
+  void SetBoardPoints(const Board& board, vtkVideoCameraObservations* observations)
+  {
+    const std::vector<cv::Point3f>* points = nullptr;
+    if (board.Type == "charuco")
+    {
+      points = &board.CharucoBoard->chessboardCorners;
+    }
+    else if (board.Type != "aruco")
+    {
+      points = &board.Pattern;
+    }
+    if (points == nullptr || points->empty())
+    {
+      return;
+    }
+    vtkNew<vtkFloatArray> boardPoints;
+    boardPoints->SetNumberOfComponents(3);
+    boardPoints->SetNumberOfTuples(static_cast<vtkIdType>(points->size()));
+    for (size_t i = 0; i < points->size(); ++i)
+    {
+      boardPoints->SetTuple3(static_cast<vtkIdType>(i), (*points)[i].x, (*points)[i].y, (*points)[i].z);
+    }
+    observations->SetBoardPoints(boardPoints.GetPointer());
+  }
+
+  //----------------------------------------------------------------------------
+  void AddObservation(const Board& board, const View& view, vtkVideoCameraObservations* observations)
+  {
+    std::vector<cv::Point2f> imagePoints;
+    std::vector<int> ids;
+    if (board.Type == "aruco")
+    {
+      // one id per corner, the 4 corners of a marker are consecutive
+      for (size_t i = 0; i < view.MarkerCorners.size(); ++i)
+      {
+        imagePoints.insert(imagePoints.end(), view.MarkerCorners[i].begin(), view.MarkerCorners[i].end());
+        ids.insert(ids.end(), view.MarkerCorners[i].size(), view.Ids[i]);
+      }
+    }
+    else if (board.Type == "charuco")
+    {
+      imagePoints = view.Points;
+      ids = view.Ids;
+    }
+    else
+    {
+      // complete pattern, the ids are the board point indices
+      imagePoints = view.Points;
+      for (int i = 0; i < static_cast<int>(view.Points.size()); ++i)
+      {
+        ids.push_back(i);
+      }
+    }
+    observations->AddView(imagePoints.empty() ? nullptr : &imagePoints[0].x, nullptr, ids.empty() ? nullptr : &ids[0],
+                          static_cast<vtkIdType>(imagePoints.size()));
+  }
+
+  //----------------------------------------------------------------------------
+  bool ListImages(const std::string& directory, std::vector<std::string>& fileNames)
+  {
+    vtksys::Directory dir;
+    if (!dir.Load(directory))
+    {
+      return false;
+    }
+    for (unsigned long i = 0; i < dir.GetNumberOfFiles(); ++i)
+    {
+      const std::string extension = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(dir.GetFile(i)));
+      if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" ||
+          extension == ".tif" || extension == ".tiff")
+      {
+        fileNames.push_back(directory + "/" + dir.GetFile(i));
+      }
+    }
+    std::sort(fileNames.begin(), fileNames.end());
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  PARSE_ARGS;
+
+  if (inputDirectory.empty() && inputVideo.empty())
+  {
+    std::cerr << "An image directory or a video file is required" << std::endl;
+    return ExitFailed;
+  }
+  if (outputCamera.empty())
+  {
+    std::cerr << "An output camera file is required" << std::endl;
+    return ExitFailed;
+  }
+  if (boardRows < 2 || boardColumns < 2 || boardParameter1 <= 0.0)
+  {
+    std::cerr << "Invalid board geometry" << std::endl;
+    return ExitFailed;
+  }
+  if (frameStep < 1)
+  {
+    std::cerr << "The frame step must be at least 1" << std::endl;
+    return ExitFailed;
+  }
+
+  // Board
+  Board board;
+  board.Type = boardType;
+  board.PatternSize = cv::Size(boardColumns, boardRows);
+  board.Invert = invert;
+  board.SubPixelRadius = std::max(1, subPixelRadius);
+  for (int row = 0; row < boardRows; ++row)
+  {
+    for (int column = 0; column < boardColumns; ++column)
+    {
+      board.Pattern.push_back(cv::Point3f(column * boardParameter1, row * boardParameter1, 0.f));
+    }
+  }
+  std::string dictionaryName;
+  if (boardType == "aruco" || boardType == "charuco")
+  {
+    if (!GetPredefinedDictionary(dictionary, board.Dictionary))
+    {
+      std::cerr << "Unknown aruco dictionary " << dictionary << std::endl;
+      return ExitFailed;
+    }
+    dictionaryName = dictionary.compare(0, 5, "DICT_") == 0 ? dictionary.substr(5) : dictionary;
+    if (boardType == "aruco")
+    {
+      board.GridBoard = cv::aruco::GridBoard::create(boardColumns, boardRows, boardParameter1, boardParameter2, board.Dictionary);
+    }
+    else
+    {
+      board.CharucoBoard = cv::aruco::CharucoBoard::create(boardColumns, boardRows, boardParameter1, boardParameter2, board.Dictionary);
+    }
+  }
+
+  // Detection, in batches of frames
+  const unsigned int threadCount = threads > 0 ? static_cast<unsigned int>(threads) : std::max(1u, std::thread::hardware_concurrency());
+  const size_t batchSize = threadCount * FramesPerThread;
+  std::vector<View> views;
+  std::vector<View> batch;
+  cv::Size imageSize;
+  int frameCount = 0;
+
+  if (!inputDirectory.empty())
+  {
+    std::vector<std::string> fileNames;
+    if (!ListImages(inputDirectory, fileNames) || fileNames.empty())
+    {
+      std::cerr << "No images in " << inputDirectory << std::endl;
+      return ExitFailed;
+    }
+    // the image size is needed by the solve, the detection only keeps points
+    cv::Mat first = cv::imread(fileNames[0], cv::IMREAD_GRAYSCALE);
+    imageSize = first.size();
+    for (size_t i = 0; i < fileNames.size(); i += frameStep)
+    {
+      View view;
+      view.FileName = fileNames[i];
+      batch.push_back(view);
+      ++frameCount;
+      if (batch.size() == batchSize || i + frameStep >= fileNames.size())
+      {
+        DetectAll(board, batch, threadCount);
+        views.insert(views.end(), batch.begin(), batch.end());
+        batch.clear();
+      }
+    }
+  }
+  else
+  {
+    cv::VideoCapture capture(inputVideo);
+    if (!capture.isOpened())
+    {
+      std::cerr << "Cannot open " << inputVideo << std::endl;
+      return ExitFailed;
+    }
+    cv::Mat frame;
+    for (int index = 0; capture.read(frame); ++index)
+    {
+      if (index % frameStep == 0)
+      {
+        View view;
+        view.Image = frame.clone();
+        imageSize = frame.size();
+        batch.push_back(view);
+        ++frameCount;
+      }
+      if (batch.size() == batchSize)
+      {
+        DetectAll(board, batch, threadCount);
+        views.insert(views.end(), batch.begin(), batch.end());
+        batch.clear();
+      }
+    }
+    DetectAll(board, batch, threadCount);
+    views.insert(views.end(), batch.begin(), batch.end());
+  }
+
+  std::vector<View> found;
+  for (size_t i = 0; i < views.size(); ++i)
+  {
+    if (views[i].Found)
+    {
+      found.push_back(views[i]);
+    }
+  }
+  std::cout << "Pattern found in " << found.size() << " of " << frameCount << " frames" << std::endl;
+  if (static_cast<int>(found.size()) < std::max(1, minimumViews) || imageSize.area() == 0)
+  {
+    std::cerr << "Not enough views to calibrate, " << minimumViews << " required" << std::endl;
+    return ExitFailed;
+  }
+
+  // Solve
+  int flags = 0;
+  if (rationalModel)
+  {
+    flags |= cv::CALIB_RATIONAL_MODEL;
+  }
+  if (fixAspectRatio)
+  {
+    flags |= cv::CALIB_FIX_ASPECT_RATIO;
+  }
+  if (zeroTangentDistortion)
+  {
+    flags |= cv::CALIB_ZERO_TANGENT_DIST;
+  }
+
+  cv::Mat cameraMatrix = (cv::Mat_<double>(3, 3) << 1000., 0., imageSize.width / 2., 0., 1000., imageSize.height / 2., 0., 0., 1.);
+  cv::Mat distortionCoefficients = cv::Mat::zeros(rationalModel ? 8 : 5, 1, CV_64F);
+  std::vector<cv::Mat> rvecs;
+  std::vector<cv::Mat> tvecs;
+  double rmsError = 0.0;
+  try
+  {
+    if (boardType == "aruco")
+    {
+      std::vector<std::vector<cv::Point2f> > corners;
+      std::vector<int> ids;
+      std::vector<int> counter;
+      for (size_t i = 0; i < found.size(); ++i)
+      {
+        corners.insert(corners.end(), found[i].MarkerCorners.begin(), found[i].MarkerCorners.end());
+        ids.insert(ids.end(), found[i].Ids.begin(), found[i].Ids.end());
+        counter.push_back(static_cast<int>(found[i].Ids.size()));
+      }
+      rmsError = cv::aruco::calibrateCameraAruco(corners, ids, counter, board.GridBoard, imageSize, cameraMatrix, distortionCoefficients, rvecs, tvecs, flags);
+    }
+    else if (boardType == "charuco")
+    {
+      std::vector<std::vector<cv::Point2f> > corners;
+      std::vector<std::vector<int> > ids;
+      for (size_t i = 0; i < found.size(); ++i)
+      {
+        corners.push_back(found[i].Points);
+        ids.push_back(found[i].Ids);
+      }
+      rmsError = cv::aruco::calibrateCameraCharuco(corners, ids, board.CharucoBoard, imageSize, cameraMatrix, distortionCoefficients, rvecs, tvecs,
+                                                   flags | cv::CALIB_USE_INTRINSIC_GUESS);
+    }
+    else
+    {
+      std::vector<std::vector<cv::Point3f> > objectPoints(found.size(), board.Pattern);
+      std::vector<std::vector<cv::Point2f> > imagePoints;
+      for (size_t i = 0; i < found.size(); ++i)
+      {
+        imagePoints.push_back(found[i].Points);
+      }
+      rmsError = cv::calibrateCamera(objectPoints, imagePoints, imageSize, cameraMatrix, distortionCoefficients, rvecs, tvecs, flags);
+    }
+  }
+  catch (const cv::Exception& e)
+  {
+    std::cerr << "Calibration failed: " << e.what() << std::endl;
+    return ExitFailed;
+  }
+
+  // Per-view errors
+  double maximumViewErrorFound = 0.0;
+  int worstView = -1;
+  for (size_t i = 0; i < found.size() && i < rvecs.size(); ++i)
+  {
+    std::vector<cv::Point3f> objectPoints;
+    std::vector<cv::Point2f> imagePoints;
+    GetViewCorrespondences(board, found[i], objectPoints, imagePoints);
+    if (objectPoints.empty())
+    {
+      continue;
+    }
+    std::vector<cv::Point2f> projected;
+    cv::projectPoints(objectPoints, rvecs[i], tvecs[i], cameraMatrix, distortionCoefficients, projected);
+    double sum = 0.0;
+    for (size_t j = 0; j < projected.size(); ++j)
+    {
+      const cv::Point2f residual = projected[j] - imagePoints[j];
+      sum += residual.dot(residual);
+    }
+    const double viewError = std::sqrt(sum / projected.size());
+    if (viewError > maximumViewErrorFound)
+    {
+      maximumViewErrorFound = viewError;
+      worstView = static_cast<int>(i);
+    }
+  }
+
+  // Write
+  vtkNew<vtkMRMLVideoCameraNode> cameraNode;
+  cameraNode->SetName(vtksys::SystemTools::GetFilenameWithoutLastExtension(outputCamera).c_str());
+  vtkNew<vtkMatrix3x3> intrinsics;
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      intrinsics->SetElement(i, j, cameraMatrix.at<double>(i, j));
+    }
+  }
+  cameraNode->SetAndObserveIntrinsicMatrix(intrinsics.GetPointer());
+  vtkNew<vtkDoubleArray> distortion;
+  for (int i = 0; i < static_cast<int>(distortionCoefficients.total()); ++i)
+  {
+    distortion->InsertNextValue(distortionCoefficients.at<double>(i));
+  }
+  cameraNode->SetAndObserveDistortionCoefficients(distortion.GetPointer());
+  cameraNode->SetReprojectionError(rmsError);
+
+  vtkNew<vtkVideoCameraObservations> observations;
+  observations->SetBoardType(boardType.c_str());
+  observations->SetBoardRows(boardRows);
+  observations->SetBoardColumns(boardColumns);
+  observations->SetBoardParameters(boardParameter1, boardParameter2);
+  observations->SetDictionaryName(dictionaryName.c_str());
+  observations->SetImageSize(imageSize.width, imageSize.height);
+  SetBoardPoints(board, observations.GetPointer());
+  for (size_t i = 0; i < found.size(); ++i)
+  {
+    AddObservation(board, found[i], observations.GetPointer());
+  }
+  cameraNode->SetAndObserveObservations(observations.GetPointer());
+
+  vtkNew<vtkMRMLVideoCameraStorageNode> storageNode;
+  storageNode->SetFileName(outputCamera.c_str());
+  if (!storageNode->WriteData(cameraNode.GetPointer()))
+  {
+    std::cerr << "Cannot write " << outputCamera << std::endl;
+    return ExitFailed;
+  }
+
+  std::cout << "RMS reprojection error: " << rmsError << " px" << std::endl;
+  std::cout << "Largest view error: " << maximumViewErrorFound << " px";
+  if (worstView >= 0)
+  {
+    std::cout << " (view " << worstView << ")";
+  }
+  std::cout << std::endl;
+
+  // Acceptance
+  bool accepted = true;
+  if (maximumRMSError > 0.0 && rmsError > maximumRMSError)
+  {
+    std::cerr << "RMS reprojection error exceeds " << maximumRMSError << " px" << std::endl;
+    accepted = false;
+  }
+  if (maximumViewError > 0.0 && maximumViewErrorFound > maximumViewError)
+  {
+    std::cerr << "View reprojection error exceeds " << maximumViewError << " px" << std::endl;
+    accepted = false;
+  }
+  return accepted ? ExitAccepted : ExitRejected;
+}
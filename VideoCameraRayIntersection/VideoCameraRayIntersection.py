@@ -1,462 +1,678 @@
-import os
-import vtk
-import qt
-import slicer
-import numpy as np
-import logging
-from slicer.ScriptedLoadableModule import ScriptedLoadableModule, ScriptedLoadableModuleWidget, ScriptedLoadableModuleLogic, ScriptedLoadableModuleTest
-
-# VideoCameraRayIntersection
-class VideoCameraRayIntersection(ScriptedLoadableModule):
-  def __init__(self, parent):
-    ScriptedLoadableModule.__init__(self, parent)
-    self.parent.title = "VideoCamera Ray Intersection"
-    self.parent.categories = ["VideoCameras"]
-    self.parent.dependencies = ["VideoCameras", "LinesIntersection", "Annotations"]
-    self.parent.contributors = ["Adam Rankin (Robarts Research Institute)"]
-    self.parent.helpText = """This module calculates the offset between ray intersections on an object from multiple videoCamera angles. """ + self.getDefaultModuleDocumentationLink()
-    self.parent.acknowledgementText = """This module was developed with support from the Natural Sciences and Engineering Research Council of Canada, the Canadian Foundation for Innovation, and the Virtual Augmentation and Simulation for Surgery and Therapy laboratory, Western University."""
-
-# VideoCameraRayIntersectionWidget
-class VideoCameraRayIntersectionWidget(ScriptedLoadableModuleWidget):
-  @staticmethod
-  def get(widget, objectName):
-    if widget.objectName == objectName:
-      return widget
-    else:
-      for w in widget.children():
-        resulting_widget = VideoCameraRayIntersectionWidget.get(w, objectName)
-        if resulting_widget:
-          return resulting_widget
-      return None
-
-  @staticmethod
-  def emptyOrZeros(doubleArray):
-    count = doubleArray.GetNumberOfValues()
-    result = True
-    for i in range(0, count):
-      if doubleArray.GetValue(i) != 0.0:
-        return False
-    return True
-
-  @staticmethod
-  def areSameVTK4x4(a, b):
-    for i in range(0, 4):
-      for j in range(0, 4):
-        if a.GetElement(i,j) != b.GetElement(i,j):
-          return False
-    return True
-
-  @staticmethod
-  def areSameVTK3x3(a, b):
-    for i in range(0, 3):
-      for j in range(0, 3):
-        if a.GetElement(i,j) != b.GetElement(i,j):
-          return False
-    return True
-
-  @staticmethod
-  def vtk4x4ToNumpy(vtk4x4):
-    if vtk4x4 is None:
-      return
-
-    val = np.asmatrix(np.eye(4, 4, dtype=np.float64))
-    for i in range(0, 4):
-      for j in range(0, 4):
-        val[i, j] = vtk4x4.GetElement(i, j)
-
-    return val
-
-  @staticmethod
-  def vtk3x3ToNumpy(vtk3x3):
-    if vtk3x3 is None:
-      return
-
-    val = np.asmatrix(np.eye(3, 3, dtype=np.float64))
-    for i in range(0, 3):
-      for j in range(0, 3):
-        val[i, j] = vtk3x3.GetElement(i, j)
-    return val
-
-  @staticmethod
-  def loadPixmap(param, x, y):
-    iconPath = os.path.join(os.path.dirname(slicer.modules.videocameracalibration.path), 'Resources/Icons/', param + ".png")
-    icon = qt.QIcon(iconPath)
-    return icon.pixmap(icon.actualSize(qt.QSize(x, y)))
-
-  def __init__(self, parent):
-    ScriptedLoadableModuleWidget.__init__(self, parent)
-
-    global OPENCV2_AVAILABLE
-    try:
-      global cv2
-      import cv2
-      OPENCV2_AVAILABLE = True
-    except ImportError:
-      OPENCV2_AVAILABLE = False
-
-    if not OPENCV2_AVAILABLE:
-      logging.error("OpenCV2 python interface not available.")
-      return
-
-    self.logic = VideoCameraRayIntersectionLogic()
-    self.markupsLogic = slicer.modules.markups.logic()
-
-    self.canSelectFiducials = False
-    self.isManualCapturing = False
-    self.validVideoCamera = False
-
-    self.centerFiducialSelectionNode = None
-    self.copyNode = None
-    self.widget = None
-    self.videoCameraIntrinWidget = None
-    self.videoCameraSelector = None
-    self.videoCameraNode = None
-    self.markupsNode = None
-
-    # Observer tags
-    self.videoCameraObserverTag = None
-    self.videoCameraTransformObserverTag = None
-    self.pointModifiedObserverTag = None
-
-    self.videoCameraTransformNode = None
-    self.videoCameraTransformStatusLabel = None
-
-    self.okPixmap = VideoCameraRayIntersectionWidget.loadPixmap('icon_Ok', 20, 20)
-    self.notOkPixmap = VideoCameraRayIntersectionWidget.loadPixmap('icon_NotOk', 20, 20)
-
-    # Inputs/Outputs
-    self.imageSelector = None
-    self.videoCameraTransformSelector = None
-
-    # Actions
-    self.captureButton = None
-    self.resetButton = None
-    self.actionContainer = None
-
-    # Results
-    self.resultsLabel = None
-    self.videoCameraToReference = None
-
-    self.identity3x3 = vtk.vtkMatrix3x3()
-    self.identity4x4 = vtk.vtkMatrix4x4()
-
-  def setup(self):
-    ScriptedLoadableModuleWidget.setup(self)
-
-    if not OPENCV2_AVAILABLE:
-      self.layout.addWidget(qt.QLabel("OpenCV2 python is required and not available. Check installation/configuration of SlicerOpenCV."))
-    else:
-      # Load the UI From file
-      scriptedModulesPath = eval('slicer.modules.%s.path' % self.moduleName.lower())
-      scriptedModulesPath = os.path.dirname(scriptedModulesPath)
-      path = os.path.join(scriptedModulesPath, 'Resources', 'UI', 'q' + self.moduleName + 'Widget.ui')
-      self.widget = slicer.util.loadUI(path)
-      self.layout.addWidget(self.widget)
-
-    # Camera UI
-    layout = VideoCameraRayIntersectionWidget.get(self.widget, "gridLayout")
-    placeholder = VideoCameraRayIntersectionWidget.get(self.widget, "placeholder")
-    layout.removeWidget(placeholder)
-    self.videoCameraIntrinWidget = slicer.qMRMLVideoCameraIntrinsicsWidget()
-    self.videoCameraIntrinWidget.setMRMLScene(slicer.mrmlScene)
-    layout.addWidget(self.videoCameraIntrinWidget, 0, 0)
-
-    # Workaround for videoCamera selector
-    self.videoCameraSelector = self.videoCameraIntrinWidget.children()[1].children()[1]
-
-    # Inputs/Outputs
-    self.imageSelector = VideoCameraRayIntersectionWidget.get(self.widget, "comboBox_ImageSelector")
-    self.videoCameraTransformSelector = VideoCameraRayIntersectionWidget.get(self.widget, "comboBox_VideoCameraTransform")
-    self.actionContainer = VideoCameraRayIntersectionWidget.get(self.widget, "widget_ActionContainer")
-
-    self.captureButton = VideoCameraRayIntersectionWidget.get(self.widget, "pushButton_Capture")
-    self.resetButton = VideoCameraRayIntersectionWidget.get(self.widget, "pushButton_Reset")
-    self.actionContainer = VideoCameraRayIntersectionWidget.get(self.widget, "widget_ActionContainer")
-
-    self.resultsLabel = VideoCameraRayIntersectionWidget.get(self.widget, "label_Results")
-    self.videoCameraTransformStatusLabel = VideoCameraRayIntersectionWidget.get(self.widget, "label_VideoCameraTransform_Status")
-
-    # Disable capture as image processing isn't active yet
-    self.actionContainer.setEnabled(False)
-
-    # UI file method does not do mrml scene connections, do them manually
-    self.videoCameraIntrinWidget.setMRMLScene(slicer.mrmlScene)
-    self.imageSelector.setMRMLScene(slicer.mrmlScene)
-    self.videoCameraTransformSelector.setMRMLScene(slicer.mrmlScene)
-
-    # Connections
-    self.videoCameraSelector.connect("currentNodeChanged(vtkMRMLNode*)", self.onVideoCameraSelected)
-    self.imageSelector.connect("currentNodeChanged(vtkMRMLNode*)", self.onImageSelected)
-    self.videoCameraTransformSelector.connect("currentNodeChanged(vtkMRMLNode*)", self.onVideoCameraTransformSelected)
-    self.captureButton.connect('clicked(bool)', self.onCapture)
-    self.resetButton.connect('clicked(bool)', self.onReset)
-
-    # Choose red slice only
-    lm = slicer.app.layoutManager()
-    lm.setLayout(slicer.vtkMRMLLayoutNode.SlicerLayoutOneUpRedSliceView)
-
-    # Refresh Apply button state
-    self.onSelect()
-
-  def onVideoCameraSelected(self):
-    if self.videoCameraNode is not None:
-      self.videoCameraNode.RemoveObserver(self.videoCameraObserverTag)
-
-    self.videoCameraNode = self.videoCameraSelector.currentNode()
-
-    if self.videoCameraNode is not None:
-      self.videoCameraObserverTag = self.videoCameraNode.AddObserver(vtk.vtkCommand.ModifiedEvent, self.onVideoCameraModified)
-
-    self.checkVideoCamera()
-
-  def cleanup(self):
-    self.videoCameraSelector.disconnect("currentNodeChanged(vtkMRMLNode*)", self.onVideoCameraSelected)
-    self.imageSelector.disconnect("currentNodeChanged(vtkMRMLNode*)", self.onImageSelected)
-    self.videoCameraTransformSelector.disconnect("currentNodeChanged(vtkMRMLNode*)", self.onVideoCameraTransformSelected)
-    self.captureButton.disconnect('clicked(bool)', self.onCapture)
-    self.resetButton.disconnect('clicked(bool)', self.onReset)
-
-  @vtk.calldata_type(vtk.VTK_OBJECT)
-  def onVideoCameraModified(self, caller, event):
-    self.checkVideoCamera()
-
-  def checkVideoCamera(self):
-    if self.videoCameraNode is None:
-      self.validVideoCamera = False
-      return()
-
-    self.validVideoCamera = True
-    string = ""
-    # Check state of selected videoCamera
-    if VideoCameraRayIntersectionWidget.areSameVTK3x3(self.videoCameraNode.GetIntrinsicMatrix(), self.identity3x3):
-      string += "No videoCamera intrinsics! "
-      self.validVideoCamera = False
-    if VideoCameraRayIntersectionWidget.emptyOrZeros(self.videoCameraNode.GetDistortionCoefficients()):
-      string += "No distortion coefficients! "
-      self.validVideoCamera = False
-    if VideoCameraRayIntersectionWidget.areSameVTK4x4(self.videoCameraNode.GetMarkerToImageSensorTransform(), self.identity4x4):
-      string += "No tracker calibration performed! "
-
-    if len(string) > 0:
-      self.resultsLabel.text = string
-    else:
-      self.resultsLabel.text = "VideoCamera ok!"
-
-    self.onSelect()
-
-  def onImageSelected(self):
-    # Set red slice to the copy node
-    if self.imageSelector.currentNode() is not None:
-      slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().SetBackgroundVolumeID(self.imageSelector.currentNode().GetID())
-      slicer.app.layoutManager().sliceWidget('Red').sliceLogic().FitSliceToAll()
-      slicer.app.layoutManager().sliceWidget('Red').sliceController().rotateSliceToBackground()  # If the image is not RAS aligned, we want to show it to the user anyways
-
-      # Check pixel spacing, x and y must be 1px = 1mm in order for markups to produce correct pixel locations
-      spacing = self.imageSelector.currentNode().GetImageData().GetSpacing()
-      if spacing[0] != 1.0 or spacing[1] != 1.0:
-        message = "Image does not have 1.0 spacing in x or y, markup fiducials will not represent pixels exactly!"
-        logging.error(message)
-        self.resultsLabel.text = message
-        self.canSelectFiducials = False
-      else:
-        self.canSelectFiducials = True
-
-    self.onSelect()
-
-  def onReset(self):
-    self.resultsLabel.text = "Reset."
-    self.logic.reset()
-
-  def onSelect(self):
-    self.actionContainer.enabled = self.imageSelector.currentNode() \
-                                   and self.videoCameraTransformSelector.currentNode() \
-                                   and self.videoCameraSelector.currentNode() \
-                                   and self.canSelectFiducials \
-                                   and self.validVideoCamera
-
-  def onCapture(self):
-    if self.isManualCapturing:
-      # Cancel button hit
-      self.endManualCapturing()
-      slicer.modules.annotations.logic().StopPlaceMode()
-      return()
-
-    # Record tracker data at time of freeze and store
-    videoCameraToReferenceVtk = vtk.vtkMatrix4x4()
-    self.videoCameraTransformSelector.currentNode().GetMatrixTransformToParent(videoCameraToReferenceVtk)
-    self.videoCameraToReference = VideoCameraRayIntersectionWidget.vtk4x4ToNumpy(videoCameraToReferenceVtk)
-
-    if VideoCameraRayIntersectionWidget.areSameVTK4x4(videoCameraToReferenceVtk, self.identity4x4):
-      self.resultsLabel.text = "Invalid transform. Please try again with sensor in view."
-      return()
-
-    # Reset view so that capture button always works
-    if self.imageSelector.currentNode() is not None:
-      slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().SetBackgroundVolumeID(self.imageSelector.currentNode().GetID())
-      slicer.app.layoutManager().sliceWidget('Red').sliceLogic().FitSliceToAll()
-    self.onSelect()
-
-    # Make a copy of the volume node (aka freeze cv capture) to allow user to play with detection parameters or click on center
-    self.centerFiducialSelectionNode = slicer.mrmlScene.GetNodeByID(slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().GetBackgroundVolumeID())
-    self.copyNode = slicer.mrmlScene.CopyNode(self.centerFiducialSelectionNode)
-    imData = vtk.vtkImageData()
-    imData.DeepCopy(self.centerFiducialSelectionNode.GetImageData())
-    self.copyNode.SetAndObserveImageData(imData)
-    self.copyNode.SetName('FrozenImage')
-    slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().SetBackgroundVolumeID(self.copyNode.GetID())
-
-    # Initiate fiducial selection
-    self.markupsNode = slicer.vtkMRMLMarkupsFiducialNode()
-    slicer.mrmlScene.AddNode(self.markupsNode)
-    self.markupsNode.SetName('SphereCenter')
-    self.markupsLogic.SetActiveListId(self.markupsNode)
-    self.markupsLogic.StartPlaceMode(False)
-    self.pointModifiedObserverTag = self.markupsNode.AddObserver(slicer.vtkMRMLMarkupsNode.PointModifiedEvent, self.onPointModified)
-
-    # Disable resetting while capture is active
-    self.resetButton.setEnabled(False)
-    self.isManualCapturing = True
-    self.captureButton.setText('Cancel')
-
-  @vtk.calldata_type(vtk.VTK_INT)
-  def onPointModified(self, caller, event, callData):
-    if callData is None:
-      return()
-
-    if self.markupsNode.GetNthControlPointPositionStatus(callData) == slicer.vtkMRMLMarkupsNode.PositionDefined:
-      self.endManualCapturing()
-
-      # Calculate point and line pair
-      arr = [0,0,0]
-      self.markupsNode.GetNthControlPointPosition(callData, arr)
-      point = np.zeros((1,1,2),dtype=np.float64)
-      point[0,0,0] = abs(arr[0])
-      point[0,0,1] = abs(arr[1])
-
-      # Get videoCamera parameters
-      mtx = VideoCameraRayIntersectionWidget.vtk3x3ToNumpy(self.videoCameraSelector.currentNode().GetIntrinsicMatrix())
-
-      if self.videoCameraSelector.currentNode().GetDistortionCoefficients().GetNumberOfValues() != 0:
-        dist = np.asarray(np.zeros((1, self.videoCameraSelector.currentNode().GetDistortionCoefficients().GetNumberOfValues()), dtype=np.float64))
-        for i in range(0, self.videoCameraSelector.currentNode().GetDistortionCoefficients().GetNumberOfValues()):
-          dist[0, i] = self.videoCameraSelector.currentNode().GetDistortionCoefficients().GetValue(i)
-      else:
-        dist = np.asarray([], dtype=np.float64)
-
-      # Calculate the direction vector for the given pixel (after undistortion)
-      pixel = np.vstack((cv2.undistortPoints(point, mtx, dist, P=mtx)[0].transpose(), np.array([1.0], dtype=np.float64)))
-
-      # Get the direction based on selected pixel
-
-      ## Origin - defined in camera, typically 0,0,0
-      origin_sensor = np.asarray(np.zeros((1, 3),dtype=np.float64))
-      for i in range(0, 3):
-        origin_sensor[0, i] = self.videoCameraSelector.currentNode().GetCameraPlaneOffset().GetValue(i)
-
-      directionVec_sensor = np.vstack(((np.linalg.inv(mtx) * pixel) / np.linalg.norm(np.linalg.inv(mtx) * pixel), np.array([0.0], dtype=np.float64)))
-
-      sensorToVideoCamera = np.linalg.inv(VideoCameraRayIntersectionWidget.vtk4x4ToNumpy(self.videoCameraSelector.currentNode().GetMarkerToImageSensorTransform()))
-
-      sensorToReference = self.videoCameraToReference * sensorToVideoCamera
-
-      origin_ref = sensorToReference * origin_sensor
-      directionVec_ref = sensorToReference * directionVec_sensor
-
-      if self.developerMode:
-        logging.debug("origin_ref: " + str(origin_ref).replace('\n',''))
-        logging.debug("dir_ref: " + str(directionVec_ref).replace('\n',''))
-
-      result = self.logic.addRay(origin_ref[0:-1], directionVec_ref[0:-1])
-      if result is not None:
-        self.resultsLabel.text = "Point: " + str(result[0]) + "," + str(result[1]) + "," + str(result[2]) + ". Error: " + str(self.logic.getError())
-        if self.developerMode:
-          # For ease of copy pasting multiple entries, print it to the python console
-          print("Intersection|" + str(result[0]) + "," + str(result[1]) + "," + str(result[2]) + "|" + str(self.logic.getError()))
-
-      # Allow markups module some time to process the new markup, but then quickly delete it
-      # Avoids VTK errors in log
-      qt.QTimer.singleShot(10, self.removeMarkup)
-
-  def endManualCapturing(self):
-    self.isManualCapturing = False
-    self.captureButton.setText('Capture')
-
-    # Resume playback
-    slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().SetBackgroundVolumeID(self.centerFiducialSelectionNode.GetID())
-    slicer.mrmlScene.RemoveNode(self.copyNode)
-    self.copyNode = None
-
-    # Re-enable UI
-    self.resetButton.setEnabled(True)
-
-  def removeMarkup(self):
-    if self.markupsNode is not None:
-      self.markupsNode.RemoveObserver(self.pointModifiedObserverTag)
-      self.pointModifiedObserverTag = None
-      self.markupsNode.RemoveAllMarkups()
-      slicer.mrmlScene.RemoveNode(self.markupsNode)
-      self.markupsNode = None
-
-  def onVideoCameraTransformSelected(self):
-    if self.videoCameraTransformObserverTag is not None:
-      self.videoCameraTransformNode.RemoveObserver(self.videoCameraTransformObserverTag)
-      self.videoCameraTransformObserverTag = None
-
-    self.videoCameraTransformNode = self.videoCameraTransformSelector.currentNode()
-    if self.videoCameraTransformNode is not None:
-      self.videoCameraTransformObserverTag = self.videoCameraTransformNode.AddObserver(slicer.vtkMRMLTransformNode.TransformModifiedEvent, self.onVideoCameraTransformModified)
-
-    self.onSelect()
-
-  @vtk.calldata_type(vtk.VTK_OBJECT)
-  def onVideoCameraTransformModified(self, caller, event):
-    mat = vtk.vtkMatrix4x4()
-    self.videoCameraTransformNode.GetMatrixTransformToParent(mat)
-    if VideoCameraRayIntersectionWidget.areSameVTK4x4(mat, self.identity4x4):
-      self.videoCameraTransformStatusLabel.setPixmap(self.notOkPixmap)
-      self.captureButton.enabled = False
-    else:
-      self.videoCameraTransformStatusLabel.setPixmap(self.okPixmap)
-      self.captureButton.enabled = True
-
-# VideoCameraRayIntersectionLogic
-class VideoCameraRayIntersectionLogic(ScriptedLoadableModuleLogic):
-  def __init__(self):
-    self.linesRegistrationLogic = slicer.vtkSlicerLinesIntersectionLogic()
-
-  def reset(self):
-    # clear list of rays
-    self.linesRegistrationLogic.Reset()
-
-  def addRay(self, origin, direction):
-    self.linesRegistrationLogic.AddLine(origin, direction)
-    if self.linesRegistrationLogic.Count() > 2:
-      return self.linesRegistrationLogic.Update()
-    return None
-
-  def getCount(self):
-    return self.linesRegistrationLogic.Count()
-
-  def getPoint(self):
-    if self.linesRegistrationLogic.Count() > 2:
-      return self.linesRegistrationLogic.Update()
-    return None
-
-  def getError(self):
-    return self.linesRegistrationLogic.GetError()
-
-# VideoCameraRayIntersectionTest
-class VideoCameraRayIntersectionTest(ScriptedLoadableModuleTest):
-  def setUp(self):
-    """ Do whatever is needed to reset the state - typically a scene clear will be enough. """
-    slicer.mrmlScene.Clear(0)
-
-  def runTest(self):
-    """ Run as few or as many tests as needed here. """
-    self.setUp()
-    self.test_VideoCameraRayIntersection1()
-
-  def test_VideoCameraRayIntersection1(self):
-    self.delayDisplay("Starting the test")
-    self.delayDisplay('Test passed!')
+import os
+import vtk
+import qt
+import slicer
+import numpy as np
+import logging
+import time
+from vtk.util import numpy_support
+from slicer.ScriptedLoadableModule import ScriptedLoadableModule, ScriptedLoadableModuleWidget, ScriptedLoadableModuleLogic, ScriptedLoadableModuleTest
+
+# VideoCameraRayIntersection
+class VideoCameraRayIntersection(ScriptedLoadableModule):
+  def __init__(self, parent):
+    ScriptedLoadableModule.__init__(self, parent)
+    self.parent.title = "VideoCamera Ray Intersection"
+    self.parent.categories = ["VideoCameras"]
+    self.parent.dependencies = ["VideoCameras", "LinesIntersection", "Annotations"]
+    self.parent.contributors = ["Adam Rankin (Robarts Research Institute)"]
+    self.parent.helpText = """This module calculates the offset between ray intersections on an object from multiple videoCamera angles. """ + self.getDefaultModuleDocumentationLink()
+    self.parent.acknowledgementText = """This module was developed with support from the Natural Sciences and Engineering Research Council of Canada, the Canadian Foundation for Innovation, and the Virtual Augmentation and Simulation for Surgery and Therapy laboratory, Western University."""
+
+# VideoCameraRayIntersectionWidget
+class VideoCameraRayIntersectionWidget(ScriptedLoadableModuleWidget):
+  @staticmethod
+  def get(widget, objectName):
+    if widget.objectName == objectName:
+      return widget
+    else:
+      for w in widget.children():
+        resulting_widget = VideoCameraRayIntersectionWidget.get(w, objectName)
+        if resulting_widget:
+          return resulting_widget
+      return None
+
+  @staticmethod
+  def emptyOrZeros(doubleArray):
+    count = doubleArray.GetNumberOfValues()
+    result = True
+    for i in range(0, count):
+      if doubleArray.GetValue(i) != 0.0:
+        return False
+    return True
+
+  @staticmethod
+  def areSameVTK4x4(a, b):
+    for i in range(0, 4):
+      for j in range(0, 4):
+        if a.GetElement(i,j) != b.GetElement(i,j):
+          return False
+    return True
+
+  @staticmethod
+  def areSameVTK3x3(a, b):
+    for i in range(0, 3):
+      for j in range(0, 3):
+        if a.GetElement(i,j) != b.GetElement(i,j):
+          return False
+    return True
+
+  @staticmethod
+  def vtk4x4ToNumpy(vtk4x4):
+    if vtk4x4 is None:
+      return
+
+    val = np.asmatrix(np.eye(4, 4, dtype=np.float64))
+    for i in range(0, 4):
+      for j in range(0, 4):
+        val[i, j] = vtk4x4.GetElement(i, j)
+
+    return val
+
+  @staticmethod
+  def vtk3x3ToNumpy(vtk3x3):
+    if vtk3x3 is None:
+      return
+
+    val = np.asmatrix(np.eye(3, 3, dtype=np.float64))
+    for i in range(0, 3):
+      for j in range(0, 3):
+        val[i, j] = vtk3x3.GetElement(i, j)
+    return val
+
+  @staticmethod
+  def loadPixmap(param, x, y):
+    iconPath = os.path.join(os.path.dirname(slicer.modules.videocameracalibration.path), 'Resources/Icons/', param + ".png")
+    icon = qt.QIcon(iconPath)
+    return icon.pixmap(icon.actualSize(qt.QSize(x, y)))
+
+  def __init__(self, parent):
+    ScriptedLoadableModuleWidget.__init__(self, parent)
+
+    global OPENCV2_AVAILABLE
+    try:
+      global cv2
+      import cv2
+      OPENCV2_AVAILABLE = True
+    except ImportError:
+      OPENCV2_AVAILABLE = False
+
+    if not OPENCV2_AVAILABLE:
+      logging.error("OpenCV2 python interface not available.")
+      return
+
+    self.logic = VideoCameraRayIntersectionLogic()
+    self.markupsLogic = slicer.modules.markups.logic()
+
+    self.canSelectFiducials = False
+    self.isManualCapturing = False
+    self.validVideoCamera = False
+
+    self.centerFiducialSelectionNode = None
+    self.copyNode = None
+    self.widget = None
+    self.videoCameraIntrinWidget = None
+    self.videoCameraSelector = None
+    self.videoCameraNode = None
+    self.markupsNode = None
+
+    # Observer tags
+    self.videoCameraObserverTag = None
+    self.videoCameraTransformObserverTag = None
+    self.pointModifiedObserverTag = None
+
+    self.videoCameraTransformNode = None
+    self.videoCameraTransformStatusLabel = None
+
+    self.okPixmap = VideoCameraRayIntersectionWidget.loadPixmap('icon_Ok', 20, 20)
+    self.notOkPixmap = VideoCameraRayIntersectionWidget.loadPixmap('icon_NotOk', 20, 20)
+
+    # Inputs/Outputs
+    self.imageSelector = None
+    self.videoCameraTransformSelector = None
+
+    # Multi-target
+    self.multiTargetCheckBox = None
+    self.targetNamesLineEdit = None
+    self.targetsNodeSelector = None
+    self.videoCameraToReferenceVtk = None
+
+    # Actions
+    self.captureButton = None
+    self.resetButton = None
+    self.actionContainer = None
+
+    # Results
+    self.resultsLabel = None
+    self.videoCameraToReference = None
+
+    self.identity3x3 = vtk.vtkMatrix3x3()
+    self.identity4x4 = vtk.vtkMatrix4x4()
+
+  def setup(self):
+    ScriptedLoadableModuleWidget.setup(self)
+
+    if not OPENCV2_AVAILABLE:
+      self.layout.addWidget(qt.QLabel("OpenCV2 python is required and not available. Check installation/configuration of SlicerOpenCV."))
+    else:
+      # Load the UI From file
+      scriptedModulesPath = eval('slicer.modules.%s.path' % self.moduleName.lower())
+      scriptedModulesPath = os.path.dirname(scriptedModulesPath)
+      path = os.path.join(scriptedModulesPath, 'Resources', 'UI', 'q' + self.moduleName + 'Widget.ui')
+      self.widget = slicer.util.loadUI(path)
+      self.layout.addWidget(self.widget)
+
+    # Camera UI
+    layout = VideoCameraRayIntersectionWidget.get(self.widget, "gridLayout")
+    placeholder = VideoCameraRayIntersectionWidget.get(self.widget, "placeholder")
+    layout.removeWidget(placeholder)
+    self.videoCameraIntrinWidget = slicer.qMRMLVideoCameraIntrinsicsWidget()
+    self.videoCameraIntrinWidget.setMRMLScene(slicer.mrmlScene)
+    layout.addWidget(self.videoCameraIntrinWidget, 0, 0)
+
+    # Workaround for videoCamera selector
+    self.videoCameraSelector = self.videoCameraIntrinWidget.children()[1].children()[1]
+
+    # Inputs/Outputs
+    self.imageSelector = VideoCameraRayIntersectionWidget.get(self.widget, "comboBox_ImageSelector")
+    self.videoCameraTransformSelector = VideoCameraRayIntersectionWidget.get(self.widget, "comboBox_VideoCameraTransform")
+    self.actionContainer = VideoCameraRayIntersectionWidget.get(self.widget, "widget_ActionContainer")
+    self.multiTargetCheckBox = VideoCameraRayIntersectionWidget.get(self.widget, "checkBox_MultiTarget")
+    self.targetNamesLineEdit = VideoCameraRayIntersectionWidget.get(self.widget, "lineEdit_TargetNames")
+    self.targetsNodeSelector = VideoCameraRayIntersectionWidget.get(self.widget, "comboBox_TargetsNode")
+
+    self.captureButton = VideoCameraRayIntersectionWidget.get(self.widget, "pushButton_Capture")
+    self.resetButton = VideoCameraRayIntersectionWidget.get(self.widget, "pushButton_Reset")
+    self.actionContainer = VideoCameraRayIntersectionWidget.get(self.widget, "widget_ActionContainer")
+
+    self.resultsLabel = VideoCameraRayIntersectionWidget.get(self.widget, "label_Results")
+    self.videoCameraTransformStatusLabel = VideoCameraRayIntersectionWidget.get(self.widget, "label_VideoCameraTransform_Status")
+
+    # Disable capture as image processing isn't active yet
+    self.actionContainer.setEnabled(False)
+
+    # UI file method does not do mrml scene connections, do them manually
+    self.videoCameraIntrinWidget.setMRMLScene(slicer.mrmlScene)
+    self.imageSelector.setMRMLScene(slicer.mrmlScene)
+    self.videoCameraTransformSelector.setMRMLScene(slicer.mrmlScene)
+    self.targetsNodeSelector.setMRMLScene(slicer.mrmlScene)
+
+    # Connections
+    self.videoCameraSelector.connect("currentNodeChanged(vtkMRMLNode*)", self.onVideoCameraSelected)
+    self.imageSelector.connect("currentNodeChanged(vtkMRMLNode*)", self.onImageSelected)
+    self.videoCameraTransformSelector.connect("currentNodeChanged(vtkMRMLNode*)", self.onVideoCameraTransformSelected)
+    self.multiTargetCheckBox.connect('toggled(bool)', self.onMultiTargetToggled)
+    self.captureButton.connect('clicked(bool)', self.onCapture)
+    self.resetButton.connect('clicked(bool)', self.onReset)
+
+    # Choose red slice only
+    lm = slicer.app.layoutManager()
+    lm.setLayout(slicer.vtkMRMLLayoutNode.SlicerLayoutOneUpRedSliceView)
+
+    # Refresh Apply button state
+    self.onSelect()
+
+  def onVideoCameraSelected(self):
+    if self.videoCameraNode is not None:
+      self.videoCameraNode.RemoveObserver(self.videoCameraObserverTag)
+
+    self.videoCameraNode = self.videoCameraSelector.currentNode()
+
+    if self.videoCameraNode is not None:
+      self.videoCameraObserverTag = self.videoCameraNode.AddObserver(vtk.vtkCommand.ModifiedEvent, self.onVideoCameraModified)
+
+    self.checkVideoCamera()
+
+  def cleanup(self):
+    self.videoCameraSelector.disconnect("currentNodeChanged(vtkMRMLNode*)", self.onVideoCameraSelected)
+    self.imageSelector.disconnect("currentNodeChanged(vtkMRMLNode*)", self.onImageSelected)
+    self.videoCameraTransformSelector.disconnect("currentNodeChanged(vtkMRMLNode*)", self.onVideoCameraTransformSelected)
+    self.multiTargetCheckBox.disconnect('toggled(bool)', self.onMultiTargetToggled)
+    self.captureButton.disconnect('clicked(bool)', self.onCapture)
+    self.resetButton.disconnect('clicked(bool)', self.onReset)
+
+  @vtk.calldata_type(vtk.VTK_OBJECT)
+  def onVideoCameraModified(self, caller, event):
+    self.checkVideoCamera()
+
+  def checkVideoCamera(self):
+    if self.videoCameraNode is None:
+      self.validVideoCamera = False
+      return()
+
+    self.validVideoCamera = True
+    string = ""
+    # Check state of selected videoCamera
+    if VideoCameraRayIntersectionWidget.areSameVTK3x3(self.videoCameraNode.GetIntrinsicMatrix(), self.identity3x3):
+      string += "No videoCamera intrinsics! "
+      self.validVideoCamera = False
+    if VideoCameraRayIntersectionWidget.emptyOrZeros(self.videoCameraNode.GetDistortionCoefficients()):
+      string += "No distortion coefficients! "
+      self.validVideoCamera = False
+    if VideoCameraRayIntersectionWidget.areSameVTK4x4(self.videoCameraNode.GetMarkerToImageSensorTransform(), self.identity4x4):
+      string += "No tracker calibration performed! "
+
+    if len(string) > 0:
+      self.resultsLabel.text = string
+    else:
+      self.resultsLabel.text = "VideoCamera ok!"
+
+    self.onSelect()
+
+  def onImageSelected(self):
+    # Set red slice to the copy node
+    if self.imageSelector.currentNode() is not None:
+      slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().SetBackgroundVolumeID(self.imageSelector.currentNode().GetID())
+      slicer.app.layoutManager().sliceWidget('Red').sliceLogic().FitSliceToAll()
+      slicer.app.layoutManager().sliceWidget('Red').sliceController().rotateSliceToBackground()  # If the image is not RAS aligned, we want to show it to the user anyways
+
+      # Check pixel spacing, x and y must be 1px = 1mm in order for markups to produce correct pixel locations
+      spacing = self.imageSelector.currentNode().GetImageData().GetSpacing()
+      if spacing[0] != 1.0 or spacing[1] != 1.0:
+        message = "Image does not have 1.0 spacing in x or y, markup fiducials will not represent pixels exactly!"
+        logging.error(message)
+        self.resultsLabel.text = message
+        self.canSelectFiducials = False
+      else:
+        self.canSelectFiducials = True
+
+    self.onSelect()
+
+  def onReset(self):
+    self.resultsLabel.text = "Reset."
+    self.logic.reset()
+
+  def onMultiTargetToggled(self, checked):
+    self.targetNamesLineEdit.enabled = checked
+    self.targetsNodeSelector.enabled = checked
+    self.onSelect()
+
+  def isMultiTarget(self):
+    return self.multiTargetCheckBox.checked
+
+  def targetNames(self):
+    return [name.strip() for name in self.targetNamesLineEdit.text.split(',') if len(name.strip()) > 0]
+
+  def onSelect(self):
+    self.actionContainer.enabled = self.imageSelector.currentNode() \
+                                   and self.videoCameraTransformSelector.currentNode() \
+                                   and self.videoCameraSelector.currentNode() \
+                                   and self.canSelectFiducials \
+                                   and self.validVideoCamera \
+                                   and (not self.isMultiTarget() or self.targetsNodeSelector.currentNode() is not None)
+
+  def onCapture(self):
+    if self.isManualCapturing and self.isMultiTarget():
+      # Done button hit, triangulate the targets placed so far
+      self.endMultiTargetFrame()
+      return()
+
+    if self.isManualCapturing:
+      # Cancel button hit
+      self.endManualCapturing()
+      slicer.modules.annotations.logic().StopPlaceMode()
+      return()
+
+    # Record tracker data at time of freeze and store
+    videoCameraToReferenceVtk = vtk.vtkMatrix4x4()
+    self.videoCameraTransformSelector.currentNode().GetMatrixTransformToParent(videoCameraToReferenceVtk)
+    self.videoCameraToReference = VideoCameraRayIntersectionWidget.vtk4x4ToNumpy(videoCameraToReferenceVtk)
+    self.videoCameraToReferenceVtk = videoCameraToReferenceVtk
+
+    if VideoCameraRayIntersectionWidget.areSameVTK4x4(videoCameraToReferenceVtk, self.identity4x4):
+      self.resultsLabel.text = "Invalid transform. Please try again with sensor in view."
+      return()
+
+    # Reset view so that capture button always works
+    if self.imageSelector.currentNode() is not None:
+      slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().SetBackgroundVolumeID(self.imageSelector.currentNode().GetID())
+      slicer.app.layoutManager().sliceWidget('Red').sliceLogic().FitSliceToAll()
+    self.onSelect()
+
+    # Make a copy of the volume node (aka freeze cv capture) to allow user to play with detection parameters or click on center
+    self.centerFiducialSelectionNode = slicer.mrmlScene.GetNodeByID(slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().GetBackgroundVolumeID())
+    self.copyNode = slicer.mrmlScene.CopyNode(self.centerFiducialSelectionNode)
+    imData = vtk.vtkImageData()
+    imData.DeepCopy(self.centerFiducialSelectionNode.GetImageData())
+    self.copyNode.SetAndObserveImageData(imData)
+    self.copyNode.SetName('FrozenImage')
+    slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().SetBackgroundVolumeID(self.copyNode.GetID())
+
+    # Initiate fiducial selection
+    self.markupsNode = slicer.vtkMRMLMarkupsFiducialNode()
+    slicer.mrmlScene.AddNode(self.markupsNode)
+    self.markupsNode.SetName('SphereCenter')
+    self.markupsLogic.SetActiveListId(self.markupsNode)
+    # In multi-target mode, keep placing until every target is placed or Done is hit
+    self.markupsLogic.StartPlaceMode(self.isMultiTarget())
+    self.pointModifiedObserverTag = self.markupsNode.AddObserver(slicer.vtkMRMLMarkupsNode.PointModifiedEvent, self.onPointModified)
+
+    # Disable resetting while capture is active
+    self.resetButton.setEnabled(False)
+    self.isManualCapturing = True
+    if self.isMultiTarget():
+      self.captureButton.setText('Done')
+      self.resultsLabel.text = "Place: " + ", ".join(self.targetNames())
+    else:
+      self.captureButton.setText('Cancel')
+
+  @vtk.calldata_type(vtk.VTK_INT)
+  def onPointModified(self, caller, event, callData):
+    if callData is None:
+      return()
+
+    if self.isMultiTarget():
+      self.onTargetPointModified(callData)
+      return()
+
+    if self.markupsNode.GetNthControlPointPositionStatus(callData) == slicer.vtkMRMLMarkupsNode.PositionDefined:
+      self.endManualCapturing()
+
+      # Calculate point and line pair
+      arr = [0,0,0]
+      self.markupsNode.GetNthControlPointPosition(callData, arr)
+      point = np.zeros((1,1,2),dtype=np.float64)
+      point[0,0,0] = abs(arr[0])
+      point[0,0,1] = abs(arr[1])
+
+      # Get videoCamera parameters
+      mtx = VideoCameraRayIntersectionWidget.vtk3x3ToNumpy(self.videoCameraSelector.currentNode().GetIntrinsicMatrix())
+
+      # Calculate the direction vector for the given pixel (after undistortion)
+      imageSize = self.centerFiducialSelectionNode.GetImageData().GetDimensions()
+      pixel = np.vstack((self.logic.undistortPoints(self.videoCameraSelector.currentNode(), imageSize, point)[0].transpose(), np.array([1.0], dtype=np.float64)))
+
+      # Get the direction based on selected pixel
+
+      ## Origin - defined in camera, typically 0,0,0
+      origin_sensor = np.asarray(np.zeros((1, 3),dtype=np.float64))
+      for i in range(0, 3):
+        origin_sensor[0, i] = self.videoCameraSelector.currentNode().GetCameraPlaneOffset().GetValue(i)
+
+      directionVec_sensor = np.vstack(((np.linalg.inv(mtx) * pixel) / np.linalg.norm(np.linalg.inv(mtx) * pixel), np.array([0.0], dtype=np.float64)))
+
+      sensorToVideoCamera = np.linalg.inv(VideoCameraRayIntersectionWidget.vtk4x4ToNumpy(self.videoCameraSelector.currentNode().GetMarkerToImageSensorTransform()))
+
+      sensorToReference = self.videoCameraToReference * sensorToVideoCamera
+
+      origin_ref = sensorToReference * origin_sensor
+      directionVec_ref = sensorToReference * directionVec_sensor
+
+      if self.developerMode:
+        logging.debug("origin_ref: " + str(origin_ref).replace('\n',''))
+        logging.debug("dir_ref: " + str(directionVec_ref).replace('\n',''))
+
+      result = self.logic.addRay(origin_ref[0:-1], directionVec_ref[0:-1])
+      if result is not None:
+        self.resultsLabel.text = "Point: " + str(result[0]) + "," + str(result[1]) + "," + str(result[2]) + ". Error: " + str(self.logic.getError())
+        if self.developerMode:
+          # For ease of copy pasting multiple entries, print it to the python console
+          print("Intersection|" + str(result[0]) + "," + str(result[1]) + "," + str(result[2]) + "|" + str(self.logic.getError()))
+
+      # Allow markups module some time to process the new markup, but then quickly delete it
+      # Avoids VTK errors in log
+      qt.QTimer.singleShot(10, self.removeMarkup)
+
+  def onTargetPointModified(self, pointIndex):
+    if self.markupsNode.GetNthControlPointPositionStatus(pointIndex) != slicer.vtkMRMLMarkupsNode.PositionDefined:
+      return()
+
+    # Points are labelled with the target names in placement order
+    names = self.targetNames()
+    if pointIndex < len(names) and self.markupsNode.GetNthControlPointLabel(pointIndex) != names[pointIndex]:
+      self.markupsNode.SetNthControlPointLabel(pointIndex, names[pointIndex])
+
+    if pointIndex + 1 < len(names):
+      self.resultsLabel.text = "Place: " + ", ".join(names[pointIndex + 1:])
+    else:
+      # Every target is placed, the frame is complete
+      qt.QTimer.singleShot(10, self.endMultiTargetFrame)
+
+  def endMultiTargetFrame(self):
+    if not self.isManualCapturing:
+      return()
+    self.markupsLogic.StopPlaceMode()
+    self.endManualCapturing()
+
+    # Gather the labelled pixels of the frame
+    names = self.targetNames()
+    pixels = []
+    labels = []
+    arr = [0, 0, 0]
+    for i in range(0, min(self.markupsNode.GetNumberOfControlPoints(), len(names))):
+      if self.markupsNode.GetNthControlPointPositionStatus(i) != slicer.vtkMRMLMarkupsNode.PositionDefined:
+        continue
+      self.markupsNode.GetNthControlPointPosition(i, arr)
+      pixels.append([abs(arr[0]), abs(arr[1])])
+      labels.append(names[i])
+
+    if len(pixels) > 0:
+      count = self.logic.addFrameRays(self.videoCameraSelector.currentNode(), self.videoCameraToReferenceVtk, pixels, labels)
+      solved = self.logic.updateTargetsNode(self.targetsNodeSelector.currentNode())
+      self.resultsLabel.text = "Added {0} rays. {1} of {2} targets solved, mean error: {3:.3f}".format(count, solved, self.logic.getNumberOfTargets(), self.logic.getMeanTargetError())
+
+    qt.QTimer.singleShot(10, self.removeMarkup)
+
+  def endManualCapturing(self):
+    self.isManualCapturing = False
+    self.captureButton.setText('Capture')
+
+    # Resume playback
+    slicer.app.layoutManager().sliceWidget('Red').sliceLogic().GetSliceCompositeNode().SetBackgroundVolumeID(self.centerFiducialSelectionNode.GetID())
+    slicer.mrmlScene.RemoveNode(self.copyNode)
+    self.copyNode = None
+
+    # Re-enable UI
+    self.resetButton.setEnabled(True)
+
+  def removeMarkup(self):
+    if self.markupsNode is not None:
+      self.markupsNode.RemoveObserver(self.pointModifiedObserverTag)
+      self.pointModifiedObserverTag = None
+      self.markupsNode.RemoveAllMarkups()
+      slicer.mrmlScene.RemoveNode(self.markupsNode)
+      self.markupsNode = None
+
+  def onVideoCameraTransformSelected(self):
+    if self.videoCameraTransformObserverTag is not None:
+      self.videoCameraTransformNode.RemoveObserver(self.videoCameraTransformObserverTag)
+      self.videoCameraTransformObserverTag = None
+
+    self.videoCameraTransformNode = self.videoCameraTransformSelector.currentNode()
+    if self.videoCameraTransformNode is not None:
+      self.videoCameraTransformObserverTag = self.videoCameraTransformNode.AddObserver(slicer.vtkMRMLTransformNode.TransformModifiedEvent, self.onVideoCameraTransformModified)
+
+    self.onSelect()
+
+  @vtk.calldata_type(vtk.VTK_OBJECT)
+  def onVideoCameraTransformModified(self, caller, event):
+    mat = vtk.vtkMatrix4x4()
+    self.videoCameraTransformNode.GetMatrixTransformToParent(mat)
+    if VideoCameraRayIntersectionWidget.areSameVTK4x4(mat, self.identity4x4):
+      self.videoCameraTransformStatusLabel.setPixmap(self.notOkPixmap)
+      self.captureButton.enabled = False
+    else:
+      self.videoCameraTransformStatusLabel.setPixmap(self.okPixmap)
+      self.captureButton.enabled = True
+
+# VideoCameraRayIntersectionLogic
+class VideoCameraRayIntersectionLogic(ScriptedLoadableModuleLogic):
+  def __init__(self):
+    self.linesRegistrationLogic = slicer.vtkSlicerLinesIntersectionLogic()
+
+    # Multi-target mode, rays of many labelled targets solved together
+    self.triangulation = slicer.vtkSlicerVideoCameraRayTriangulation()
+    # Inverse distortion lookup, rebuilt when the camera or its distortion changes
+    self.undistortionGrid = slicer.vtkSlicerVideoCameraUndistortionGrid()
+
+  def reset(self):
+    # clear list of rays
+    self.linesRegistrationLogic.Reset()
+    self.triangulation.Reset()
+
+  def addRay(self, origin, direction):
+    self.linesRegistrationLogic.AddLine(origin, direction)
+    if self.linesRegistrationLogic.Count() > 2:
+      return self.linesRegistrationLogic.Update()
+    return None
+
+  def undistortPoints(self, videoCameraNode, imageSize, points):
+    """ Same result as cv2.undistortPoints(points, mtx, dist, P=mtx), points shaped (n, 1, 2), from the cached inverse distortion grid """
+    self.undistortionGrid.SetCameraNode(videoCameraNode)
+    self.undistortionGrid.SetImageSize(imageSize[0], imageSize[1])
+    pixels = vtk.vtkDoubleArray()
+    pixels.SetNumberOfComponents(2)
+    for point in np.asarray(points, dtype=np.float64).reshape(-1, 2):
+      pixels.InsertNextTuple2(point[0], point[1])
+    idealPixels = vtk.vtkDoubleArray()
+    if not self.undistortionGrid.UndistortPoints(pixels, idealPixels):
+      return None
+    return numpy_support.vtk_to_numpy(idealPixels).reshape(-1, 1, 2).copy()
+
+  def getCount(self):
+    return self.linesRegistrationLogic.Count()
+
+  def getPoint(self):
+    if self.linesRegistrationLogic.Count() > 2:
+      return self.linesRegistrationLogic.Update()
+    return None
+
+  def getError(self):
+    return self.linesRegistrationLogic.GetError()
+
+  def addFrameRays(self, videoCameraNode, videoCameraToReference, pixels, labels):
+    """ Add the rays of the labelled raw image pixels of one frame, returns the number of rays added """
+    pixelArray = vtk.vtkDoubleArray()
+    pixelArray.SetNumberOfComponents(2)
+    labelArray = vtk.vtkStringArray()
+    for pixel, label in zip(pixels, labels):
+      pixelArray.InsertNextTuple2(pixel[0], pixel[1])
+      labelArray.InsertNextValue(label)
+    count = self.triangulation.AddFrameRays(videoCameraNode, videoCameraToReference, pixelArray, labelArray)
+    self.triangulation.Solve()
+    return count
+
+  def getNumberOfTargets(self):
+    return self.triangulation.GetNumberOfTargets()
+
+  def getTargetPoint(self, name):
+    target = self.triangulation.GetTargetIndex(name)
+    point = [0.0, 0.0, 0.0]
+    if not self.triangulation.GetTargetPoint(target, point):
+      return None
+    return point
+
+  def getMeanTargetError(self):
+    errors = [self.triangulation.GetTargetError(i) for i in range(0, self.triangulation.GetNumberOfTargets()) if self.triangulation.IsTargetValid(i)]
+    if len(errors) == 0:
+      return 0.0
+    return sum(errors) / len(errors)
+
+  def updateTargetsNode(self, markupsNode):
+    """ Write every solved target to markupsNode, one control point per target matched by label. Returns the number of solved targets. """
+    if markupsNode is None:
+      return 0
+
+    existing = {}
+    for i in range(0, markupsNode.GetNumberOfControlPoints()):
+      existing[markupsNode.GetNthControlPointLabel(i)] = i
+
+    solved = 0
+    wasModifying = markupsNode.StartModify()
+    point = [0.0, 0.0, 0.0]
+    for target in range(0, self.triangulation.GetNumberOfTargets()):
+      if not self.triangulation.GetTargetPoint(target, point):
+        continue
+      solved += 1
+      name = self.triangulation.GetTargetName(target)
+      if name in existing:
+        index = existing[name]
+        markupsNode.SetNthControlPointPosition(index, point[0], point[1], point[2])
+      else:
+        index = markupsNode.AddControlPoint(vtk.vtkVector3d(point[0], point[1], point[2]))
+        markupsNode.SetNthControlPointLabel(index, name)
+      markupsNode.SetNthControlPointDescription(index, "Error: {0:.3f}, rays: {1}".format(self.triangulation.GetTargetError(target), self.triangulation.GetNumberOfRays(target)))
+    markupsNode.EndModify(wasModifying)
+    return solved
+
+# VideoCameraRayIntersectionTest
+class VideoCameraRayIntersectionTest(ScriptedLoadableModuleTest):
+  """Accuracy and speed regression tests on the golden rays of Resources/Testing
+
+  Tolerances and wall-clock baselines are read from Resources/Testing/Baselines.txt. The
+  VIDEOCAMERAS_TEST_TIME_FACTOR environment variable overrides its TimeFactor, 0 disables the
+  timing checks.
+  """
+  def setUp(self):
+    """ Do whatever is needed to reset the state - typically a scene clear will be enough. """
+    slicer.mrmlScene.Clear(0)
+    global VideoCamerasTesting
+    import VideoCamerasTesting
+
+  def runTest(self):
+    """ Run as few or as many tests as needed here. """
+    self.setUp()
+    self.test_VideoCameraRayIntersection1()
+    self.setUp()
+    self.test_VideoCameraRayIntersection2()
+
+  @staticmethod
+  def testingPath(fileName):
+    return os.path.join(os.path.dirname(slicer.modules.videocamerarayintersection.path), 'Resources', 'Testing', fileName)
+
+  def readGoldenRays(self):
+    """Rays as (name, origin, direction), true targets and stored solutions by name"""
+    records = VideoCamerasTesting.readRecords(VideoCameraRayIntersectionTest.testingPath('GoldenRays_v1.txt'))
+    self.assertEqual(int(records[0][1]) if records[0][0] == 'Version' else 0, 1, 'GoldenRays_v1.txt is not version 1')
+    rays = [(fields[1], [float(v) for v in fields[2:5]], [float(v) for v in fields[5:8]]) for fields in records if fields[0] == 'Ray']
+    targets = dict((fields[1], np.array([float(v) for v in fields[2:5]])) for fields in records if fields[0] == 'Target')
+    solutions = dict((fields[1], np.array([float(v) for v in fields[2:5]])) for fields in records if fields[0] == 'Solution')
+    return rays, targets, solutions
+
+  def readBaselines(self):
+    return VideoCamerasTesting.readBaselines(VideoCameraRayIntersectionTest.testingPath('Baselines.txt'))
+
+  def test_VideoCameraRayIntersection1(self):
+    """Single target intersection of the rays of the first golden target"""
+    self.delayDisplay("Starting the single target test")
+    baselines = self.readBaselines()
+    rays, targets, solutions = self.readGoldenRays()
+    name = rays[0][0]
+
+    logic = VideoCameraRayIntersectionLogic()
+    for ray in rays:
+      if ray[0] == name:
+        logic.addRay(ray[1], ray[2])
+    point = logic.getPoint()
+    self.assertIsNotNone(point, 'Rays of {0} were not intersected'.format(name))
+    error = np.linalg.norm(np.asarray(point[0:3]) - targets[name])
+    logging.info('Single target error {0:.3f} mm'.format(error))
+    self.assertLessEqual(error, baselines['RayIntersection.Tolerance'])
+    self.delayDisplay('Test passed!')
+
+  def test_VideoCameraRayIntersection2(self):
+    """Multi-target triangulation of all golden rays against the true targets and the stored solutions"""
+    self.delayDisplay("Starting the multi-target test")
+    baselines = self.readBaselines()
+    rays, targets, solutions = self.readGoldenRays()
+
+    logic = VideoCameraRayIntersectionLogic()
+    start = time.time()
+    for ray in rays:
+      self.assertGreaterEqual(logic.triangulation.AddRay(ray[0], ray[1], ray[2]), 0)
+    solved = logic.triangulation.Solve()
+    elapsed = time.time() - start
+    self.assertEqual(solved, len(targets))
+
+    maximumError = 0.0
+    maximumSolutionDifference = 0.0
+    for name in targets.keys():
+      point = logic.getTargetPoint(name)
+      self.assertIsNotNone(point, 'Target {0} was not solved'.format(name))
+      maximumError = max(maximumError, np.linalg.norm(np.asarray(point) - targets[name]))
+      maximumSolutionDifference = max(maximumSolutionDifference, np.linalg.norm(np.asarray(point) - solutions[name]))
+    logging.info('Maximum error {0:.3f} mm, maximum difference to the golden solutions {1:.2e} mm'.format(maximumError, maximumSolutionDifference))
+    self.assertLessEqual(maximumError, baselines['RayIntersection.Tolerance'])
+    self.assertLessEqual(maximumSolutionDifference, baselines['RayIntersection.SolutionTolerance'])
+    VideoCamerasTesting.checkTime(self, baselines, 'RayIntersection', elapsed)
+    self.delayDisplay('Test passed!')
@@ -0,0 +1,1301 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraBundleAdjustment.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraBundleAdjustment.h"
+#include "vtkMRMLVideoCameraNode.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMatrix3x3.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+// OpenCV includes
+#include <opencv2/calib3d.hpp>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraBundleAdjustment);
+
+namespace
+{
+  /// Camera parameters: fx, fy, cx, cy, k1, k2, p1, p2, k3, k4, k5, k6, reference to camera rotation (angle-axis), translation
+  const int CameraBlockSize = 18;
+  const int DistortionOffset = 4;
+  const int MaximumNumberOfDistortionCoefficients = 8;
+  const int ExtrinsicsOffset = 12;
+  /// View parameters: board to reference rotation (angle-axis), translation
+  const int ViewBlockSize = 6;
+
+  //----------------------------------------------------------------------------
+  void AngleAxisRotatePoint(const double w[3], const double p[3], double out[3])
+  {
+    const double theta2 = w[0] * w[0] + w[1] * w[1] + w[2] * w[2];
+    if (theta2 > 1e-30)
+    {
+      const double theta = std::sqrt(theta2);
+      const double c = std::cos(theta);
+      const double s = std::sin(theta);
+      const double k[3] = { w[0] / theta, w[1] / theta, w[2] / theta };
+      const double kxp[3] = { k[1] * p[2] - k[2] * p[1], k[2] * p[0] - k[0] * p[2], k[0] * p[1] - k[1] * p[0] };
+      const double kdp = (k[0] * p[0] + k[1] * p[1] + k[2] * p[2]) * (1.0 - c);
+      for (int i = 0; i < 3; ++i)
+      {
+        out[i] = p[i] * c + kxp[i] * s + k[i] * kdp;
+      }
+    }
+    else
+    {
+      // first order approximation close to the identity
+      out[0] = p[0] + w[1] * p[2] - w[2] * p[1];
+      out[1] = p[1] + w[2] * p[0] - w[0] * p[2];
+      out[2] = p[2] + w[0] * p[1] - w[1] * p[0];
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void ProjectPoint(const double* camera, const double* view, const double boardPoint[3], double imagePoint[2])
+  {
+    double referencePoint[3];
+    AngleAxisRotatePoint(view, boardPoint, referencePoint);
+    referencePoint[0] += view[3];
+    referencePoint[1] += view[4];
+    referencePoint[2] += view[5];
+
+    double cameraPoint[3];
+    AngleAxisRotatePoint(camera + ExtrinsicsOffset, referencePoint, cameraPoint);
+    cameraPoint[0] += camera[ExtrinsicsOffset + 3];
+    cameraPoint[1] += camera[ExtrinsicsOffset + 4];
+    cameraPoint[2] += camera[ExtrinsicsOffset + 5];
+
+    double z = cameraPoint[2];
+    if (std::abs(z) < 1e-12)
+    {
+      z = z < 0.0 ? -1e-12 : 1e-12;
+    }
+    const double x = cameraPoint[0] / z;
+    const double y = cameraPoint[1] / z;
+
+    const double* d = camera + DistortionOffset;
+    const double r2 = x * x + y * y;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double radial = (1.0 + d[0] * r2 + d[1] * r4 + d[4] * r6) / (1.0 + d[5] * r2 + d[6] * r4 + d[7] * r6);
+    const double xd = x * radial + 2.0 * d[2] * x * y + d[3] * (r2 + 2.0 * x * x);
+    const double yd = y * radial + d[2] * (r2 + 2.0 * y * y) + 2.0 * d[3] * x * y;
+
+    imagePoint[0] = camera[0] * xd + camera[2];
+    imagePoint[1] = camera[1] * yd + camera[3];
+  }
+
+  //----------------------------------------------------------------------------
+  // In-place Cholesky factorization and solve of a dense symmetric positive definite system
+  bool CholeskySolve(std::vector<double>& a, int n, double* b)
+  {
+    for (int j = 0; j < n; ++j)
+    {
+      double d = a[j * n + j];
+      for (int k = 0; k < j; ++k)
+      {
+        d -= a[j * n + k] * a[j * n + k];
+      }
+      if (!(d > 0.0))
+      {
+        return false;
+      }
+      d = std::sqrt(d);
+      a[j * n + j] = d;
+      for (int i = j + 1; i < n; ++i)
+      {
+        double s = a[i * n + j];
+        for (int k = 0; k < j; ++k)
+        {
+          s -= a[i * n + k] * a[j * n + k];
+        }
+        a[i * n + j] = s / d;
+      }
+    }
+    for (int i = 0; i < n; ++i)
+    {
+      double s = b[i];
+      for (int k = 0; k < i; ++k)
+      {
+        s -= a[i * n + k] * b[k];
+      }
+      b[i] = s / a[i * n + i];
+    }
+    for (int i = n - 1; i >= 0; --i)
+    {
+      double s = b[i];
+      for (int k = i + 1; k < n; ++k)
+      {
+        s -= a[k * n + i] * b[k];
+      }
+      b[i] = s / a[i * n + i];
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool InvertSymmetricPositiveDefinite6x6(const double* a, double* inverse)
+  {
+    for (int col = 0; col < ViewBlockSize; ++col)
+    {
+      std::vector<double> factor(a, a + ViewBlockSize * ViewBlockSize);
+      double e[ViewBlockSize] = { 0.0 };
+      e[col] = 1.0;
+      if (!CholeskySolve(factor, ViewBlockSize, e))
+      {
+        return false;
+      }
+      for (int row = 0; row < ViewBlockSize; ++row)
+      {
+        inverse[row * ViewBlockSize + col] = e[row];
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void PoseToMatrix(const double* pose, double m[16])
+  {
+    cv::Mat rotation;
+    cv::Rodrigues(cv::Mat(3, 1, CV_64F, const_cast<double*>(pose)), rotation);
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        m[i * 4 + j] = rotation.at<double>(i, j);
+      }
+      m[i * 4 + 3] = pose[3 + i];
+    }
+    m[12] = m[13] = m[14] = 0.0;
+    m[15] = 1.0;
+  }
+
+  //----------------------------------------------------------------------------
+  void MatrixToPose(const double m[16], double* pose)
+  {
+    cv::Mat rotation(3, 3, CV_64F);
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        rotation.at<double>(i, j) = m[i * 4 + j];
+      }
+    }
+    cv::Mat rotationVector;
+    cv::Rodrigues(rotation, rotationVector);
+    for (int i = 0; i < 3; ++i)
+    {
+      pose[i] = rotationVector.at<double>(i, 0);
+      pose[3 + i] = m[i * 4 + 3];
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void InvertPose(const double* pose, double* inverse)
+  {
+    double m[16];
+    PoseToMatrix(pose, m);
+    double mInv[16];
+    vtkMatrix4x4::Invert(m, mInv);
+    MatrixToPose(mInv, inverse);
+  }
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCameraBundleAdjustment::vtkInternal
+{
+public:
+  struct Observation
+  {
+    int     Camera;
+    int     View;
+    double  BoardPoint[3];
+    double  ImagePoint[2];
+  };
+
+  /// All observations of one camera in one view
+  struct Pair
+  {
+    int       Camera;
+    int       View;
+    vtkIdType Begin;
+    vtkIdType End;
+  };
+
+  /// Group observations by view, then camera
+  void BuildPairs();
+  void UpdateFreeParameters(bool optimizeIntrinsics);
+
+  /// Sum of squared residuals, optionally per camera
+  double Cost(const std::vector<double>& cameraParameters, const std::vector<double>& viewParameters,
+              std::vector<double>* cameraCosts = nullptr) const;
+
+  /// Jacobian blocks and gradient at the current estimates
+  void Linearize();
+
+  /// Damped Schur complement step, returns false if the reduced system is not positive definite
+  bool ComputeStep(double lambda, std::vector<double>& cameraStep, std::vector<double>& viewStep);
+
+public:
+  std::vector<double>       CameraParameters;
+  std::vector<int>          NumberOfDistortionCoefficients;
+  std::vector<double>       ViewParameters;
+  std::vector<Observation>  Observations;
+  std::vector<double>       CameraRMSErrors;
+
+  std::vector<vtkIdType>    ObservationOrder;
+  std::vector<Pair>         Pairs;
+  std::vector<vtkIdType>    ViewPairBegin;
+  /// 1 for every camera parameter being optimized
+  std::vector<char>         FreeParameters;
+
+  /// Normal equation blocks: U per camera, V per view, W per pair, gradients per camera and view
+  std::vector<double>       U;
+  std::vector<double>       V;
+  std::vector<double>       W;
+  std::vector<double>       CameraGradient;
+  std::vector<double>       ViewGradient;
+  std::vector<double>       VInverse;
+
+  class CostFunctor;
+  class LinearizeFunctor;
+  class SchurFunctor;
+};
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCameraBundleAdjustment::vtkInternal::CostFunctor
+{
+public:
+  CostFunctor(const vtkSlicerVideoCameraBundleAdjustment::vtkInternal* internal,
+              const std::vector<double>& cameraParameters, const std::vector<double>& viewParameters)
+    : Internal(internal)
+    , CameraParameters(cameraParameters)
+    , ViewParameters(viewParameters)
+  {
+  }
+
+  void Initialize()
+  {
+    this->LocalCosts.Local().assign(this->CameraParameters.size() / CameraBlockSize, 0.0);
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    std::vector<double>& costs = this->LocalCosts.Local();
+    for (vtkIdType view = begin; view < end; ++view)
+    {
+      for (vtkIdType p = this->Internal->ViewPairBegin[view]; p < this->Internal->ViewPairBegin[view + 1]; ++p)
+      {
+        const vtkSlicerVideoCameraBundleAdjustment::vtkInternal::Pair& pair = this->Internal->Pairs[p];
+        const double* camera = &this->CameraParameters[pair.Camera * CameraBlockSize];
+        const double* viewParameters = &this->ViewParameters[pair.View * ViewBlockSize];
+        for (vtkIdType i = pair.Begin; i < pair.End; ++i)
+        {
+          const vtkSlicerVideoCameraBundleAdjustment::vtkInternal::Observation& obs = this->Internal->Observations[this->Internal->ObservationOrder[i]];
+          double projected[2];
+          ProjectPoint(camera, viewParameters, obs.BoardPoint, projected);
+          const double dx = projected[0] - obs.ImagePoint[0];
+          const double dy = projected[1] - obs.ImagePoint[1];
+          costs[pair.Camera] += dx * dx + dy * dy;
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    this->CameraCosts.assign(this->CameraParameters.size() / CameraBlockSize, 0.0);
+    for (vtkSMPThreadLocal<std::vector<double> >::iterator it = this->LocalCosts.begin(); it != this->LocalCosts.end(); ++it)
+    {
+      for (size_t c = 0; c < this->CameraCosts.size(); ++c)
+      {
+        this->CameraCosts[c] += (*it)[c];
+      }
+    }
+  }
+
+  std::vector<double> CameraCosts;
+
+protected:
+  const vtkSlicerVideoCameraBundleAdjustment::vtkInternal* Internal;
+  const std::vector<double>& CameraParameters;
+  const std::vector<double>& ViewParameters;
+  vtkSMPThreadLocal<std::vector<double> > LocalCosts;
+};
+
+//----------------------------------------------------------------------------
+// Numeric Jacobians of every observation, accumulated into the normal equation blocks
+// Views are processed in parallel, camera blocks are accumulated per thread and reduced.
+class vtkSlicerVideoCameraBundleAdjustment::vtkInternal::LinearizeFunctor
+{
+public:
+  LinearizeFunctor(vtkSlicerVideoCameraBundleAdjustment::vtkInternal* internal)
+    : Internal(internal)
+    , NumberOfCameras(static_cast<int>(internal->NumberOfDistortionCoefficients.size()))
+  {
+  }
+
+  void Initialize()
+  {
+    this->LocalU.Local().assign(this->NumberOfCameras * CameraBlockSize * CameraBlockSize, 0.0);
+    this->LocalGradient.Local().assign(this->NumberOfCameras * CameraBlockSize, 0.0);
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    std::vector<double>& localU = this->LocalU.Local();
+    std::vector<double>& localGradient = this->LocalGradient.Local();
+    vtkSlicerVideoCameraBundleAdjustment::vtkInternal* internal = this->Internal;
+
+    for (vtkIdType view = begin; view < end; ++view)
+    {
+      double* V = &internal->V[view * ViewBlockSize * ViewBlockSize];
+      double* viewGradient = &internal->ViewGradient[view * ViewBlockSize];
+      std::fill(V, V + ViewBlockSize * ViewBlockSize, 0.0);
+      std::fill(viewGradient, viewGradient + ViewBlockSize, 0.0);
+
+      for (vtkIdType p = internal->ViewPairBegin[view]; p < internal->ViewPairBegin[view + 1]; ++p)
+      {
+        const vtkSlicerVideoCameraBundleAdjustment::vtkInternal::Pair& pair = internal->Pairs[p];
+        const char* free = &internal->FreeParameters[pair.Camera * CameraBlockSize];
+        double camera[CameraBlockSize];
+        std::copy(&internal->CameraParameters[pair.Camera * CameraBlockSize], &internal->CameraParameters[pair.Camera * CameraBlockSize] + CameraBlockSize, camera);
+        double viewParameters[ViewBlockSize];
+        std::copy(&internal->ViewParameters[view * ViewBlockSize], &internal->ViewParameters[view * ViewBlockSize] + ViewBlockSize, viewParameters);
+
+        double* U = &localU[pair.Camera * CameraBlockSize * CameraBlockSize];
+        double* cameraGradient = &localGradient[pair.Camera * CameraBlockSize];
+        double* W = &internal->W[p * CameraBlockSize * ViewBlockSize];
+        std::fill(W, W + CameraBlockSize * ViewBlockSize, 0.0);
+
+        for (vtkIdType i = pair.Begin; i < pair.End; ++i)
+        {
+          const vtkSlicerVideoCameraBundleAdjustment::vtkInternal::Observation& obs = internal->Observations[internal->ObservationOrder[i]];
+
+          double projected[2];
+          ProjectPoint(camera, viewParameters, obs.BoardPoint, projected);
+          const double residual[2] = { projected[0] - obs.ImagePoint[0], projected[1] - obs.ImagePoint[1] };
+
+          // central differences, fixed parameters keep a zero column
+          double Jc[2][CameraBlockSize] = { { 0.0 } };
+          for (int j = 0; j < CameraBlockSize; ++j)
+          {
+            if (!free[j])
+            {
+              continue;
+            }
+            const double value = camera[j];
+            const double h = 1e-6 * std::max(1.0, std::abs(value));
+            double plus[2];
+            double minus[2];
+            camera[j] = value + h;
+            ProjectPoint(camera, viewParameters, obs.BoardPoint, plus);
+            camera[j] = value - h;
+            ProjectPoint(camera, viewParameters, obs.BoardPoint, minus);
+            camera[j] = value;
+            Jc[0][j] = (plus[0] - minus[0]) / (2.0 * h);
+            Jc[1][j] = (plus[1] - minus[1]) / (2.0 * h);
+          }
+
+          double Jv[2][ViewBlockSize];
+          for (int j = 0; j < ViewBlockSize; ++j)
+          {
+            const double value = viewParameters[j];
+            const double h = 1e-6 * std::max(1.0, std::abs(value));
+            double plus[2];
+            double minus[2];
+            viewParameters[j] = value + h;
+            ProjectPoint(camera, viewParameters, obs.BoardPoint, plus);
+            viewParameters[j] = value - h;
+            ProjectPoint(camera, viewParameters, obs.BoardPoint, minus);
+            viewParameters[j] = value;
+            Jv[0][j] = (plus[0] - minus[0]) / (2.0 * h);
+            Jv[1][j] = (plus[1] - minus[1]) / (2.0 * h);
+          }
+
+          for (int a = 0; a < CameraBlockSize; ++a)
+          {
+            if (!free[a])
+            {
+              continue;
+            }
+            for (int b = a; b < CameraBlockSize; ++b)
+            {
+              U[a * CameraBlockSize + b] += Jc[0][a] * Jc[0][b] + Jc[1][a] * Jc[1][b];
+            }
+            for (int b = 0; b < ViewBlockSize; ++b)
+            {
+              W[a * ViewBlockSize + b] += Jc[0][a] * Jv[0][b] + Jc[1][a] * Jv[1][b];
+            }
+            cameraGradient[a] += Jc[0][a] * residual[0] + Jc[1][a] * residual[1];
+          }
+          for (int a = 0; a < ViewBlockSize; ++a)
+          {
+            for (int b = a; b < ViewBlockSize; ++b)
+            {
+              V[a * ViewBlockSize + b] += Jv[0][a] * Jv[0][b] + Jv[1][a] * Jv[1][b];
+            }
+            viewGradient[a] += Jv[0][a] * residual[0] + Jv[1][a] * residual[1];
+          }
+        }
+      }
+
+      // only the upper triangle was accumulated
+      for (int a = 0; a < ViewBlockSize; ++a)
+      {
+        for (int b = 0; b < a; ++b)
+        {
+          V[a * ViewBlockSize + b] = V[b * ViewBlockSize + a];
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    vtkSlicerVideoCameraBundleAdjustment::vtkInternal* internal = this->Internal;
+    internal->U.assign(this->NumberOfCameras * CameraBlockSize * CameraBlockSize, 0.0);
+    internal->CameraGradient.assign(this->NumberOfCameras * CameraBlockSize, 0.0);
+    for (vtkSMPThreadLocal<std::vector<double> >::iterator it = this->LocalU.begin(); it != this->LocalU.end(); ++it)
+    {
+      for (size_t i = 0; i < it->size(); ++i)
+      {
+        internal->U[i] += (*it)[i];
+      }
+    }
+    for (vtkSMPThreadLocal<std::vector<double> >::iterator it = this->LocalGradient.begin(); it != this->LocalGradient.end(); ++it)
+    {
+      for (size_t i = 0; i < it->size(); ++i)
+      {
+        internal->CameraGradient[i] += (*it)[i];
+      }
+    }
+    for (int c = 0; c < this->NumberOfCameras; ++c)
+    {
+      double* U = &internal->U[c * CameraBlockSize * CameraBlockSize];
+      for (int a = 0; a < CameraBlockSize; ++a)
+      {
+        for (int b = 0; b < a; ++b)
+        {
+          U[a * CameraBlockSize + b] = U[b * CameraBlockSize + a];
+        }
+      }
+    }
+  }
+
+protected:
+  vtkSlicerVideoCameraBundleAdjustment::vtkInternal* Internal;
+  int NumberOfCameras;
+  vtkSMPThreadLocal<std::vector<double> > LocalU;
+  vtkSMPThreadLocal<std::vector<double> > LocalGradient;
+};
+
+//----------------------------------------------------------------------------
+// Eliminate the view parameters: S = U - sum W V^-1 W^T, rhs = -g_c + sum W V^-1 g_v
+class vtkSlicerVideoCameraBundleAdjustment::vtkInternal::SchurFunctor
+{
+public:
+  SchurFunctor(vtkSlicerVideoCameraBundleAdjustment::vtkInternal* internal, double lambda)
+    : Failed(false)
+    , Internal(internal)
+    , Lambda(lambda)
+    , Size(static_cast<int>(internal->NumberOfDistortionCoefficients.size()) * CameraBlockSize)
+  {
+  }
+
+  void Initialize()
+  {
+    this->LocalS.Local().assign(this->Size * this->Size, 0.0);
+    this->LocalRhs.Local().assign(this->Size, 0.0);
+    this->LocalFailed.Local() = false;
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    std::vector<double>& S = this->LocalS.Local();
+    std::vector<double>& rhs = this->LocalRhs.Local();
+    vtkSlicerVideoCameraBundleAdjustment::vtkInternal* internal = this->Internal;
+    std::vector<double> Y;
+
+    for (vtkIdType view = begin; view < end; ++view)
+    {
+      double damped[ViewBlockSize * ViewBlockSize];
+      std::copy(&internal->V[view * ViewBlockSize * ViewBlockSize], &internal->V[view * ViewBlockSize * ViewBlockSize] + ViewBlockSize * ViewBlockSize, damped);
+      for (int a = 0; a < ViewBlockSize; ++a)
+      {
+        damped[a * ViewBlockSize + a] += this->Lambda * std::max(damped[a * ViewBlockSize + a], 1e-9);
+      }
+      double* Vinv = &internal->VInverse[view * ViewBlockSize * ViewBlockSize];
+      if (!InvertSymmetricPositiveDefinite6x6(damped, Vinv))
+      {
+        this->LocalFailed.Local() = true;
+        continue;
+      }
+
+      const vtkIdType pairBegin = internal->ViewPairBegin[view];
+      const vtkIdType pairEnd = internal->ViewPairBegin[view + 1];
+      const double* viewGradient = &internal->ViewGradient[view * ViewBlockSize];
+
+      // Y = W V^-1 for every camera in the view
+      Y.assign((pairEnd - pairBegin) * CameraBlockSize * ViewBlockSize, 0.0);
+      for (vtkIdType p = pairBegin; p < pairEnd; ++p)
+      {
+        const double* W = &internal->W[p * CameraBlockSize * ViewBlockSize];
+        double* y = &Y[(p - pairBegin) * CameraBlockSize * ViewBlockSize];
+        for (int a = 0; a < CameraBlockSize; ++a)
+        {
+          for (int b = 0; b < ViewBlockSize; ++b)
+          {
+            double s = 0.0;
+            for (int k = 0; k < ViewBlockSize; ++k)
+            {
+              s += W[a * ViewBlockSize + k] * Vinv[k * ViewBlockSize + b];
+            }
+            y[a * ViewBlockSize + b] = s;
+          }
+        }
+
+        const int row0 = internal->Pairs[p].Camera * CameraBlockSize;
+        for (int a = 0; a < CameraBlockSize; ++a)
+        {
+          double s = 0.0;
+          for (int k = 0; k < ViewBlockSize; ++k)
+          {
+            s += y[a * ViewBlockSize + k] * viewGradient[k];
+          }
+          rhs[row0 + a] += s;
+        }
+      }
+
+      for (vtkIdType p1 = pairBegin; p1 < pairEnd; ++p1)
+      {
+        const double* y = &Y[(p1 - pairBegin) * CameraBlockSize * ViewBlockSize];
+        const int row0 = internal->Pairs[p1].Camera * CameraBlockSize;
+        for (vtkIdType p2 = pairBegin; p2 < pairEnd; ++p2)
+        {
+          const double* W = &internal->W[p2 * CameraBlockSize * ViewBlockSize];
+          const int col0 = internal->Pairs[p2].Camera * CameraBlockSize;
+          for (int a = 0; a < CameraBlockSize; ++a)
+          {
+            for (int b = 0; b < CameraBlockSize; ++b)
+            {
+              double s = 0.0;
+              for (int k = 0; k < ViewBlockSize; ++k)
+              {
+                s += y[a * ViewBlockSize + k] * W[b * ViewBlockSize + k];
+              }
+              S[(row0 + a) * this->Size + col0 + b] -= s;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    this->S.assign(this->Size * this->Size, 0.0);
+    this->Rhs.assign(this->Size, 0.0);
+    for (vtkSMPThreadLocal<std::vector<double> >::iterator it = this->LocalS.begin(); it != this->LocalS.end(); ++it)
+    {
+      for (size_t i = 0; i < it->size(); ++i)
+      {
+        this->S[i] += (*it)[i];
+      }
+    }
+    for (vtkSMPThreadLocal<std::vector<double> >::iterator it = this->LocalRhs.begin(); it != this->LocalRhs.end(); ++it)
+    {
+      for (size_t i = 0; i < it->size(); ++i)
+      {
+        this->Rhs[i] += (*it)[i];
+      }
+    }
+    for (vtkSMPThreadLocal<bool>::iterator it = this->LocalFailed.begin(); it != this->LocalFailed.end(); ++it)
+    {
+      this->Failed = this->Failed || *it;
+    }
+  }
+
+  std::vector<double> S;
+  std::vector<double> Rhs;
+  bool                Failed;
+
+protected:
+  vtkSlicerVideoCameraBundleAdjustment::vtkInternal* Internal;
+  double Lambda;
+  int Size;
+  vtkSMPThreadLocal<std::vector<double> > LocalS;
+  vtkSMPThreadLocal<std::vector<double> > LocalRhs;
+  vtkSMPThreadLocal<bool> LocalFailed;
+};
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraBundleAdjustment::vtkInternal::BuildPairs()
+{
+  const vtkIdType numberOfObservations = static_cast<vtkIdType>(this->Observations.size());
+  this->ObservationOrder.resize(numberOfObservations);
+  for (vtkIdType i = 0; i < numberOfObservations; ++i)
+  {
+    this->ObservationOrder[i] = i;
+  }
+  const std::vector<Observation>& observations = this->Observations;
+  std::stable_sort(this->ObservationOrder.begin(), this->ObservationOrder.end(), [&observations](vtkIdType a, vtkIdType b)
+  {
+    return observations[a].View < observations[b].View ||
+           (observations[a].View == observations[b].View && observations[a].Camera < observations[b].Camera);
+  });
+
+  this->Pairs.clear();
+  const int numberOfViews = static_cast<int>(this->ViewParameters.size() / ViewBlockSize);
+  this->ViewPairBegin.assign(numberOfViews + 1, 0);
+  for (vtkIdType i = 0; i < numberOfObservations; ++i)
+  {
+    const Observation& obs = observations[this->ObservationOrder[i]];
+    if (this->Pairs.empty() || this->Pairs.back().Camera != obs.Camera || this->Pairs.back().View != obs.View)
+    {
+      Pair pair;
+      pair.Camera = obs.Camera;
+      pair.View = obs.View;
+      pair.Begin = i;
+      pair.End = i;
+      this->Pairs.push_back(pair);
+    }
+    this->Pairs.back().End = i + 1;
+  }
+
+  // pairs are sorted by view, record where each view starts
+  vtkIdType p = 0;
+  for (int view = 0; view <= numberOfViews; ++view)
+  {
+    while (p < static_cast<vtkIdType>(this->Pairs.size()) && this->Pairs[p].View < view)
+    {
+      ++p;
+    }
+    this->ViewPairBegin[view] = p;
+  }
+
+  this->W.assign(this->Pairs.size() * CameraBlockSize * ViewBlockSize, 0.0);
+  this->V.assign(numberOfViews * ViewBlockSize * ViewBlockSize, 0.0);
+  this->VInverse.assign(numberOfViews * ViewBlockSize * ViewBlockSize, 0.0);
+  this->ViewGradient.assign(numberOfViews * ViewBlockSize, 0.0);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraBundleAdjustment::vtkInternal::UpdateFreeParameters(bool optimizeIntrinsics)
+{
+  const int numberOfCameras = static_cast<int>(this->NumberOfDistortionCoefficients.size());
+  this->FreeParameters.assign(numberOfCameras * CameraBlockSize, 0);
+  for (int c = 0; c < numberOfCameras; ++c)
+  {
+    char* free = &this->FreeParameters[c * CameraBlockSize];
+    if (optimizeIntrinsics)
+    {
+      std::fill(free, free + DistortionOffset + this->NumberOfDistortionCoefficients[c], 1);
+    }
+    // camera 0 is the reference
+    if (c > 0)
+    {
+      std::fill(free + ExtrinsicsOffset, free + CameraBlockSize, 1);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraBundleAdjustment::vtkInternal::Cost(const std::vector<double>& cameraParameters, const std::vector<double>& viewParameters, std::vector<double>* cameraCosts) const
+{
+  CostFunctor functor(this, cameraParameters, viewParameters);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(this->ViewPairBegin.size()) - 1, functor);
+
+  double cost = 0.0;
+  for (size_t c = 0; c < functor.CameraCosts.size(); ++c)
+  {
+    cost += functor.CameraCosts[c];
+  }
+  if (cameraCosts != nullptr)
+  {
+    *cameraCosts = functor.CameraCosts;
+  }
+  return cost;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraBundleAdjustment::vtkInternal::Linearize()
+{
+  LinearizeFunctor functor(this);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(this->ViewPairBegin.size()) - 1, functor);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraBundleAdjustment::vtkInternal::ComputeStep(double lambda, std::vector<double>& cameraStep, std::vector<double>& viewStep)
+{
+  const int numberOfCameras = static_cast<int>(this->NumberOfDistortionCoefficients.size());
+  const int numberOfViews = static_cast<int>(this->ViewPairBegin.size()) - 1;
+  const int size = numberOfCameras * CameraBlockSize;
+
+  SchurFunctor schur(this, lambda);
+  vtkSMPTools::For(0, numberOfViews, schur);
+  if (schur.Failed)
+  {
+    return false;
+  }
+
+  // add the damped camera blocks, fixed parameters get an identity row so their step is zero
+  std::vector<double>& S = schur.S;
+  cameraStep = schur.Rhs;
+  for (int c = 0; c < numberOfCameras; ++c)
+  {
+    const double* U = &this->U[c * CameraBlockSize * CameraBlockSize];
+    const int offset = c * CameraBlockSize;
+    for (int a = 0; a < CameraBlockSize; ++a)
+    {
+      cameraStep[offset + a] -= this->CameraGradient[offset + a];
+      for (int b = 0; b < CameraBlockSize; ++b)
+      {
+        S[(offset + a) * size + offset + b] += U[a * CameraBlockSize + b];
+      }
+      double& diagonal = S[(offset + a) * size + offset + a];
+      if (this->FreeParameters[offset + a])
+      {
+        diagonal += lambda * std::max(U[a * CameraBlockSize + a], 1e-9);
+      }
+      else
+      {
+        for (int k = 0; k < size; ++k)
+        {
+          S[(offset + a) * size + k] = 0.0;
+          S[k * size + offset + a] = 0.0;
+        }
+        S[(offset + a) * size + offset + a] = 1.0;
+        cameraStep[offset + a] = 0.0;
+      }
+    }
+  }
+
+  if (!CholeskySolve(S, size, cameraStep.data()))
+  {
+    return false;
+  }
+
+  // back-substitute the view steps: dv = V^-1 (-g_v - sum W^T dc)
+  viewStep.assign(numberOfViews * ViewBlockSize, 0.0);
+  vtkSMPTools::For(0, numberOfViews, [this, &cameraStep, &viewStep](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType view = begin; view < end; ++view)
+    {
+      double b[ViewBlockSize];
+      for (int k = 0; k < ViewBlockSize; ++k)
+      {
+        b[k] = -this->ViewGradient[view * ViewBlockSize + k];
+      }
+      for (vtkIdType p = this->ViewPairBegin[view]; p < this->ViewPairBegin[view + 1]; ++p)
+      {
+        const double* W = &this->W[p * CameraBlockSize * ViewBlockSize];
+        const double* dc = &cameraStep[this->Pairs[p].Camera * CameraBlockSize];
+        for (int a = 0; a < CameraBlockSize; ++a)
+        {
+          for (int k = 0; k < ViewBlockSize; ++k)
+          {
+            b[k] -= W[a * ViewBlockSize + k] * dc[a];
+          }
+        }
+      }
+      const double* Vinv = &this->VInverse[view * ViewBlockSize * ViewBlockSize];
+      for (int a = 0; a < ViewBlockSize; ++a)
+      {
+        double s = 0.0;
+        for (int k = 0; k < ViewBlockSize; ++k)
+        {
+          s += Vinv[a * ViewBlockSize + k] * b[k];
+        }
+        viewStep[view * ViewBlockSize + a] = s;
+      }
+    }
+  });
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraBundleAdjustment::vtkSlicerVideoCameraBundleAdjustment()
+  : Internal(new vtkInternal)
+  , OptimizeIntrinsics(true)
+  , MaximumNumberOfIterations(100)
+  , RelativeTolerance(1e-10)
+  , InitialRMSError(-1.0)
+  , FinalRMSError(-1.0)
+  , NumberOfIterations(0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraBundleAdjustment::~vtkSlicerVideoCameraBundleAdjustment()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraBundleAdjustment::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfCameras: " << this->GetNumberOfCameras() << std::endl;
+  os << indent << "NumberOfViews: " << this->GetNumberOfViews() << std::endl;
+  os << indent << "NumberOfObservations: " << this->GetNumberOfObservations() << std::endl;
+  os << indent << "OptimizeIntrinsics: " << (this->OptimizeIntrinsics ? "true" : "false") << std::endl;
+  os << indent << "MaximumNumberOfIterations: " << this->MaximumNumberOfIterations << std::endl;
+  os << indent << "RelativeTolerance: " << this->RelativeTolerance << std::endl;
+  os << indent << "InitialRMSError: " << this->InitialRMSError << std::endl;
+  os << indent << "FinalRMSError: " << this->FinalRMSError << std::endl;
+  os << indent << "NumberOfIterations: " << this->NumberOfIterations << std::endl;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraBundleAdjustment::AddCamera(vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs)
+{
+  if (intrinsics == nullptr)
+  {
+    vtkErrorMacro("AddCamera: intrinsics are required");
+    return -1;
+  }
+
+  int numberOfDistortionCoefficients = distCoeffs ? static_cast<int>(distCoeffs->GetNumberOfValues()) : 0;
+  if (numberOfDistortionCoefficients > MaximumNumberOfDistortionCoefficients)
+  {
+    // refining a subset would write the others back unchanged, against the refined ones
+    vtkErrorMacro("AddCamera: " << numberOfDistortionCoefficients << " distortion coefficients, at most " << MaximumNumberOfDistortionCoefficients << " are supported");
+    return -1;
+  }
+  // the 5 coefficient model is refined with at least k1, k2, p1, p2, k3
+  numberOfDistortionCoefficients = numberOfDistortionCoefficients <= 5 ? 5 : MaximumNumberOfDistortionCoefficients;
+
+  double parameters[CameraBlockSize] = { 0.0 };
+  parameters[0] = intrinsics->GetElement(0, 0);
+  parameters[1] = intrinsics->GetElement(1, 1);
+  parameters[2] = intrinsics->GetElement(0, 2);
+  parameters[3] = intrinsics->GetElement(1, 2);
+  for (vtkIdType i = 0; distCoeffs != nullptr && i < distCoeffs->GetNumberOfValues(); ++i)
+  {
+    parameters[DistortionOffset + i] = distCoeffs->GetValue(i);
+  }
+
+  this->Internal->CameraParameters.insert(this->Internal->CameraParameters.end(), parameters, parameters + CameraBlockSize);
+  this->Internal->NumberOfDistortionCoefficients.push_back(numberOfDistortionCoefficients);
+  this->Internal->CameraRMSErrors.push_back(-1.0);
+  this->Modified();
+  return this->GetNumberOfCameras() - 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraBundleAdjustment::AddCamera(vtkMRMLVideoCameraNode* node)
+{
+  if (node == nullptr)
+  {
+    vtkErrorMacro("AddCamera: invalid camera node");
+    return -1;
+  }
+  if (node->GetCameraModel() != vtkMRMLVideoCameraNode::PinholeCameraModel)
+  {
+    vtkErrorMacro("AddCamera: " << vtkMRMLVideoCameraNode::GetCameraModelAsString(node->GetCameraModel()) << " cameras are not supported, only pinhole");
+    return -1;
+  }
+  return this->AddCamera(node->GetIntrinsicMatrix(), node->GetDistortionCoefficients());
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraBundleAdjustment::GetNumberOfCameras() const
+{
+  return static_cast<int>(this->Internal->NumberOfDistortionCoefficients.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraBundleAdjustment::AddView()
+{
+  this->Internal->ViewParameters.insert(this->Internal->ViewParameters.end(), ViewBlockSize, 0.0);
+  this->Modified();
+  return this->GetNumberOfViews() - 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraBundleAdjustment::GetNumberOfViews() const
+{
+  return static_cast<int>(this->Internal->ViewParameters.size() / ViewBlockSize);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraBundleAdjustment::AddObservation(int camera, int view, const double boardPoint[3], const double imagePoint[2])
+{
+  if (camera < 0 || camera >= this->GetNumberOfCameras() || view < 0 || view >= this->GetNumberOfViews())
+  {
+    vtkErrorMacro("AddObservation: invalid camera " << camera << " or view " << view);
+    return false;
+  }
+
+  vtkInternal::Observation obs;
+  obs.Camera = camera;
+  obs.View = view;
+  std::copy(boardPoint, boardPoint + 3, obs.BoardPoint);
+  std::copy(imagePoint, imagePoint + 2, obs.ImagePoint);
+  this->Internal->Observations.push_back(obs);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerVideoCameraBundleAdjustment::GetNumberOfObservations() const
+{
+  return static_cast<vtkIdType>(this->Internal->Observations.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraBundleAdjustment::Reset()
+{
+  delete this->Internal;
+  this->Internal = new vtkInternal;
+  this->InitialRMSError = -1.0;
+  this->FinalRMSError = -1.0;
+  this->NumberOfIterations = 0;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraBundleAdjustment::Initialize()
+{
+  const int numberOfCameras = this->GetNumberOfCameras();
+  const int numberOfViews = this->GetNumberOfViews();
+  if (numberOfCameras == 0 || numberOfViews == 0)
+  {
+    vtkErrorMacro("Initialize: no cameras or views");
+    return false;
+  }
+
+  this->Internal->BuildPairs();
+  const std::vector<vtkInternal::Pair>& pairs = this->Internal->Pairs;
+
+  // board to camera pose of every pair with enough observations
+  std::vector<double> boardToCamera(pairs.size() * ViewBlockSize, 0.0);
+  std::vector<char> solved(pairs.size(), 0);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(pairs.size()), [this, &pairs, &boardToCamera, &solved](vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType p = begin; p < end; ++p)
+    {
+      const vtkInternal::Pair& pair = pairs[p];
+      if (pair.End - pair.Begin < 4)
+      {
+        continue;
+      }
+      std::vector<cv::Point3d> objectPoints;
+      std::vector<cv::Point2d> imagePoints;
+      for (vtkIdType i = pair.Begin; i < pair.End; ++i)
+      {
+        const vtkInternal::Observation& obs = this->Internal->Observations[this->Internal->ObservationOrder[i]];
+        objectPoints.push_back(cv::Point3d(obs.BoardPoint[0], obs.BoardPoint[1], obs.BoardPoint[2]));
+        imagePoints.push_back(cv::Point2d(obs.ImagePoint[0], obs.ImagePoint[1]));
+      }
+      const double* camera = &this->Internal->CameraParameters[pair.Camera * CameraBlockSize];
+      cv::Mat K = (cv::Mat_<double>(3, 3) << camera[0], 0.0, camera[2], 0.0, camera[1], camera[3], 0.0, 0.0, 1.0);
+      cv::Mat D(1, MaximumNumberOfDistortionCoefficients, CV_64F, const_cast<double*>(camera + DistortionOffset));
+      cv::Mat rvec;
+      cv::Mat tvec;
+      if (cv::solvePnP(objectPoints, imagePoints, K, D, rvec, tvec))
+      {
+        for (int i = 0; i < 3; ++i)
+        {
+          boardToCamera[p * ViewBlockSize + i] = rvec.at<double>(i, 0);
+          boardToCamera[p * ViewBlockSize + 3 + i] = tvec.at<double>(i, 0);
+        }
+        solved[p] = 1;
+      }
+    }
+  });
+
+  // chain the poses from camera 0: board to reference = (reference to camera)^-1 * board to camera
+  std::vector<char> cameraKnown(numberOfCameras, 0);
+  std::vector<char> viewKnown(numberOfViews, 0);
+  cameraKnown[0] = 1;
+  std::fill(&this->Internal->CameraParameters[ExtrinsicsOffset], &this->Internal->CameraParameters[CameraBlockSize], 0.0);
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    for (size_t p = 0; p < pairs.size(); ++p)
+    {
+      if (!solved[p] || cameraKnown[pairs[p].Camera] == viewKnown[pairs[p].View])
+      {
+        continue;
+      }
+      double* extrinsics = &this->Internal->CameraParameters[pairs[p].Camera * CameraBlockSize + ExtrinsicsOffset];
+      double* viewPose = &this->Internal->ViewParameters[pairs[p].View * ViewBlockSize];
+      double boardToCameraMatrix[16];
+      PoseToMatrix(&boardToCamera[p * ViewBlockSize], boardToCameraMatrix);
+      double result[16];
+      if (cameraKnown[pairs[p].Camera])
+      {
+        double referenceToCamera[16];
+        PoseToMatrix(extrinsics, referenceToCamera);
+        double cameraToReference[16];
+        vtkMatrix4x4::Invert(referenceToCamera, cameraToReference);
+        vtkMatrix4x4::Multiply4x4(cameraToReference, boardToCameraMatrix, result);
+        MatrixToPose(result, viewPose);
+        viewKnown[pairs[p].View] = 1;
+      }
+      else
+      {
+        double boardToReference[16];
+        PoseToMatrix(viewPose, boardToReference);
+        double referenceToBoard[16];
+        vtkMatrix4x4::Invert(boardToReference, referenceToBoard);
+        vtkMatrix4x4::Multiply4x4(boardToCameraMatrix, referenceToBoard, result);
+        MatrixToPose(result, extrinsics);
+        cameraKnown[pairs[p].Camera] = 1;
+      }
+      changed = true;
+    }
+  }
+
+  if (std::find(cameraKnown.begin(), cameraKnown.end(), 0) != cameraKnown.end() ||
+      std::find(viewKnown.begin(), viewKnown.end(), 0) != viewKnown.end())
+  {
+    vtkErrorMacro("Initialize: some cameras or views do not share enough observations with camera 0");
+    return false;
+  }
+
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraBundleAdjustment::Optimize()
+{
+  vtkInternal* internal = this->Internal;
+  if (internal->Observations.empty())
+  {
+    vtkErrorMacro("Optimize: no observations");
+    return false;
+  }
+
+  internal->BuildPairs();
+  internal->UpdateFreeParameters(this->OptimizeIntrinsics);
+
+  const double numberOfObservations = static_cast<double>(internal->Observations.size());
+  std::vector<double> cameraCosts;
+  double cost = internal->Cost(internal->CameraParameters, internal->ViewParameters);
+  this->InitialRMSError = std::sqrt(cost / numberOfObservations);
+
+  double lambda = 1e-3;
+  std::vector<double> cameraStep;
+  std::vector<double> viewStep;
+  std::vector<double> candidateCameras;
+  std::vector<double> candidateViews;
+  this->NumberOfIterations = 0;
+  bool converged = false;
+  while (!converged && this->NumberOfIterations < this->MaximumNumberOfIterations)
+  {
+    ++this->NumberOfIterations;
+    internal->Linearize();
+
+    // increase damping until the step reduces the cost
+    bool accepted = false;
+    while (!accepted && lambda < 1e12)
+    {
+      if (!internal->ComputeStep(lambda, cameraStep, viewStep))
+      {
+        lambda *= 10.0;
+        continue;
+      }
+
+      candidateCameras = internal->CameraParameters;
+      candidateViews = internal->ViewParameters;
+      for (size_t i = 0; i < candidateCameras.size(); ++i)
+      {
+        candidateCameras[i] += cameraStep[i];
+      }
+      for (size_t i = 0; i < candidateViews.size(); ++i)
+      {
+        candidateViews[i] += viewStep[i];
+      }
+
+      double candidateCost = internal->Cost(candidateCameras, candidateViews);
+      if (candidateCost < cost)
+      {
+        converged = (cost - candidateCost) < this->RelativeTolerance * cost;
+        internal->CameraParameters.swap(candidateCameras);
+        internal->ViewParameters.swap(candidateViews);
+        cost = candidateCost;
+        lambda = std::max(lambda / 10.0, 1e-12);
+        accepted = true;
+      }
+      else
+      {
+        lambda *= 10.0;
+      }
+    }
+    if (!accepted)
+    {
+      // no descent direction left
+      converged = true;
+    }
+  }
+
+  cost = internal->Cost(internal->CameraParameters, internal->ViewParameters, &cameraCosts);
+  this->FinalRMSError = std::sqrt(cost / numberOfObservations);
+
+  std::vector<vtkIdType> cameraObservationCounts(this->GetNumberOfCameras(), 0);
+  for (std::vector<vtkInternal::Observation>::const_iterator it = internal->Observations.begin(); it != internal->Observations.end(); ++it)
+  {
+    cameraObservationCounts[it->Camera]++;
+  }
+  for (int c = 0; c < this->GetNumberOfCameras(); ++c)
+  {
+    internal->CameraRMSErrors[c] = cameraObservationCounts[c] > 0 ? std::sqrt(cameraCosts[c] / cameraObservationCounts[c]) : -1.0;
+  }
+
+  vtkDebugMacro("Optimize: RMS error " << this->InitialRMSError << " -> " << this->FinalRMSError << " px in " << this->NumberOfIterations << " iterations");
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraBundleAdjustment::GetCameraIntrinsics(int camera, vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs) const
+{
+  if (camera < 0 || camera >= this->GetNumberOfCameras())
+  {
+    return false;
+  }
+
+  const double* parameters = &this->Internal->CameraParameters[camera * CameraBlockSize];
+  if (intrinsics != nullptr)
+  {
+    intrinsics->Identity();
+    intrinsics->SetElement(0, 0, parameters[0]);
+    intrinsics->SetElement(1, 1, parameters[1]);
+    intrinsics->SetElement(0, 2, parameters[2]);
+    intrinsics->SetElement(1, 2, parameters[3]);
+  }
+  if (distCoeffs != nullptr)
+  {
+    const int numberOfDistortionCoefficients = this->Internal->NumberOfDistortionCoefficients[camera];
+    distCoeffs->SetNumberOfValues(numberOfDistortionCoefficients);
+    for (int i = 0; i < numberOfDistortionCoefficients; ++i)
+    {
+      distCoeffs->SetValue(i, parameters[DistortionOffset + i]);
+    }
+    distCoeffs->Modified();
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraBundleAdjustment::SetCameraToReferenceTransform(int camera, vtkMatrix4x4* cameraToReference)
+{
+  if (camera < 0 || camera >= this->GetNumberOfCameras() || cameraToReference == nullptr)
+  {
+    vtkErrorMacro("SetCameraToReferenceTransform: invalid camera " << camera);
+    return;
+  }
+
+  double referenceToCamera[16];
+  vtkMatrix4x4::Invert(&cameraToReference->Element[0][0], referenceToCamera);
+  MatrixToPose(referenceToCamera, &this->Internal->CameraParameters[camera * CameraBlockSize + ExtrinsicsOffset]);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraBundleAdjustment::GetCameraToReferenceTransform(int camera, vtkMatrix4x4* cameraToReference) const
+{
+  if (camera < 0 || camera >= this->GetNumberOfCameras() || cameraToReference == nullptr)
+  {
+    return false;
+  }
+
+  double cameraPose[ViewBlockSize];
+  InvertPose(&this->Internal->CameraParameters[camera * CameraBlockSize + ExtrinsicsOffset], cameraPose);
+  double m[16];
+  PoseToMatrix(cameraPose, m);
+  cameraToReference->DeepCopy(m);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraBundleAdjustment::SetBoardToReferenceTransform(int view, vtkMatrix4x4* boardToReference)
+{
+  if (view < 0 || view >= this->GetNumberOfViews() || boardToReference == nullptr)
+  {
+    vtkErrorMacro("SetBoardToReferenceTransform: invalid view " << view);
+    return;
+  }
+
+  MatrixToPose(&boardToReference->Element[0][0], &this->Internal->ViewParameters[view * ViewBlockSize]);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraBundleAdjustment::GetBoardToReferenceTransform(int view, vtkMatrix4x4* boardToReference) const
+{
+  if (view < 0 || view >= this->GetNumberOfViews() || boardToReference == nullptr)
+  {
+    return false;
+  }
+
+  double m[16];
+  PoseToMatrix(&this->Internal->ViewParameters[view * ViewBlockSize], m);
+  boardToReference->DeepCopy(m);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraBundleAdjustment::UpdateCameraNode(int camera, vtkMRMLVideoCameraNode* node) const
+{
+  if (node == nullptr || camera < 0 || camera >= this->GetNumberOfCameras())
+  {
+    return false;
+  }
+  if (node->GetCameraModel() != vtkMRMLVideoCameraNode::PinholeCameraModel)
+  {
+    vtkErrorMacro("UpdateCameraNode: the refined parameters are pinhole, the node is " << vtkMRMLVideoCameraNode::GetCameraModelAsString(node->GetCameraModel()));
+    return false;
+  }
+
+  vtkNew<vtkMatrix3x3> intrinsics;
+  vtkNew<vtkDoubleArray> distCoeffs;
+  this->GetCameraIntrinsics(camera, intrinsics.GetPointer(), distCoeffs.GetPointer());
+
+  int wasModifying = node->StartModify();
+  node->SetAndObserveIntrinsicMatrix(intrinsics.GetPointer());
+  node->SetAndObserveDistortionCoefficients(distCoeffs.GetPointer());
+  if (this->Internal->CameraRMSErrors[camera] >= 0.0)
+  {
+    node->SetReprojectionError(this->Internal->CameraRMSErrors[camera]);
+  }
+  node->EndModify(wasModifying);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraBundleAdjustment::GetCameraRMSError(int camera) const
+{
+  if (camera < 0 || camera >= this->GetNumberOfCameras())
+  {
+    return -1.0;
+  }
+  return this->Internal->CameraRMSErrors[camera];
+}
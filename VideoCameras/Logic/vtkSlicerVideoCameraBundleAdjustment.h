@@ -0,0 +1,133 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraBundleAdjustment.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraBundleAdjustment - joint calibration of a multi-camera rig
+// .SECTION Description
+// Refines the intrinsics and distortion coefficients of every camera, the pose of every camera
+// relative to camera 0 (the reference) and the pose of the calibration board in every view by
+// minimizing the reprojection error of all board corner observations (Levenberg-Marquardt).
+// The normal equations are reduced to the camera parameters with a Schur complement, so a step
+// costs one dense solve of size 18 x number of cameras plus work linear in the number of views.
+// Jacobians are evaluated numerically, in parallel over views with vtkSMPTools.
+//
+// A view is one board pose: every camera that sees the board at that time adds its
+// observations to the same view.
+
+#ifndef __vtkSlicerVideoCameraBundleAdjustment_h
+#define __vtkSlicerVideoCameraBundleAdjustment_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkDoubleArray;
+class vtkMatrix3x3;
+class vtkMatrix4x4;
+class vtkMRMLVideoCameraNode;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraBundleAdjustment : public vtkObject
+{
+public:
+  static vtkSlicerVideoCameraBundleAdjustment* New();
+  vtkTypeMacro(vtkSlicerVideoCameraBundleAdjustment, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Add a camera with its initial intrinsics and distortion coefficients, returns the camera index
+  /// Only the pinhole model with up to 8 distortion coefficients (k1, k2, p1, p2[, k3[, k4, k5, k6]])
+  /// is supported, other cameras are rejected (-1). Camera 0 defines the reference coordinate system.
+  int AddCamera(vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs);
+  int AddCamera(vtkMRMLVideoCameraNode* node);
+  int GetNumberOfCameras() const;
+
+  ///
+  /// Add a board pose, returns the view index
+  int AddView();
+  int GetNumberOfViews() const;
+
+  ///
+  /// Board corner (board coordinates) detected by a camera at an image position (pixels) in a view
+  bool AddObservation(int camera, int view, const double boardPoint[3], const double imagePoint[2]);
+  vtkIdType GetNumberOfObservations() const;
+
+  ///
+  /// Remove all cameras, views and observations
+  void Reset();
+
+  ///
+  /// Compute initial camera and board poses with PnP on every camera/view pair, chained from camera 0
+  /// Fails if some camera or view is not connected to camera 0 through shared views.
+  bool Initialize();
+
+  ///
+  /// Run the optimization from the current estimates
+  bool Optimize();
+
+  ///
+  /// Current estimates
+  bool GetCameraIntrinsics(int camera, vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs) const;
+  void SetCameraToReferenceTransform(int camera, vtkMatrix4x4* cameraToReference);
+  bool GetCameraToReferenceTransform(int camera, vtkMatrix4x4* cameraToReference) const;
+  void SetBoardToReferenceTransform(int view, vtkMatrix4x4* boardToReference);
+  bool GetBoardToReferenceTransform(int view, vtkMatrix4x4* boardToReference) const;
+
+  ///
+  /// Copy the refined intrinsics, distortion coefficients and reprojection error of a camera to a node
+  /// Fails if the node is not a pinhole camera.
+  bool UpdateCameraNode(int camera, vtkMRMLVideoCameraNode* node) const;
+
+  ///
+  /// Refine intrinsics and distortion coefficients (default on), otherwise only poses are refined
+  vtkSetMacro(OptimizeIntrinsics, bool);
+  vtkGetMacro(OptimizeIntrinsics, bool);
+  vtkBooleanMacro(OptimizeIntrinsics, bool);
+
+  vtkSetClampMacro(MaximumNumberOfIterations, int, 1, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfIterations, int);
+
+  ///
+  /// Stop when the relative decrease of the cost falls below this value (default 1e-10)
+  vtkSetMacro(RelativeTolerance, double);
+  vtkGetMacro(RelativeTolerance, double);
+
+  ///
+  /// Results of the last optimization
+  vtkGetMacro(InitialRMSError, double);
+  vtkGetMacro(FinalRMSError, double);
+  vtkGetMacro(NumberOfIterations, int);
+  double GetCameraRMSError(int camera) const;
+
+protected:
+  vtkSlicerVideoCameraBundleAdjustment();
+  virtual ~vtkSlicerVideoCameraBundleAdjustment();
+
+protected:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  bool    OptimizeIntrinsics;
+  int     MaximumNumberOfIterations;
+  double  RelativeTolerance;
+  double  InitialRMSError;
+  double  FinalRMSError;
+  int     NumberOfIterations;
+
+private:
+  vtkSlicerVideoCameraBundleAdjustment(const vtkSlicerVideoCameraBundleAdjustment&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraBundleAdjustment&); // Not implemented
+};
+
+#endif
@@ -0,0 +1,611 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraContinuousTriangulation.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraContinuousTriangulation.h"
+#include "vtkSlicerVideoCameraProjection.h"
+#include "vtkMRMLVideoCameraNode.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraContinuousTriangulation);
+
+namespace
+{
+  typedef std::chrono::steady_clock Clock;
+
+  //----------------------------------------------------------------------------
+  double SecondsBetween(const Clock::time_point& from, const Clock::time_point& to)
+  {
+    return std::chrono::duration<double>(to - from).count();
+  }
+
+  //----------------------------------------------------------------------------
+  struct Camera
+  {
+    vtkWeakPointer<vtkMRMLVideoCameraNode>  Node;
+    vtkWeakPointer<vtkMRMLTransformNode>    Pose;
+    bool                                    HasPose;
+    /// Single tuple arrays reused for every back-projection
+    vtkSmartPointer<vtkDoubleArray>         Pixel;
+    vtkSmartPointer<vtkDoubleArray>         Ray;
+  };
+
+  //----------------------------------------------------------------------------
+  struct Detection
+  {
+    int     Camera;
+    double  Pixel[2];
+    double  Weight;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Ray of a detection in reference space, with the data the DLT rows need
+  struct View
+  {
+    double  Weight;
+    double  Origin[3];
+    double  Direction[3];
+    /// Normalized image coordinates (x / z, y / z of the camera ray)
+    double  Normalized[2];
+    /// Columns of the image sensor to reference rotation
+    double  Axes[3][3];
+  };
+
+  //----------------------------------------------------------------------------
+  void AddOuterProduct(double A[3][3], double b[3], const double row[3], double rhs, double weight)
+  {
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        A[i][j] += weight * row[i] * row[j];
+      }
+      b[i] += weight * row[i] * rhs;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCameraContinuousTriangulation::vtkInternal
+{
+public:
+  vtkInternal();
+
+  /// Back-project a detection, false if the camera is gone or the pixel is outside its model
+  bool MakeView(const Detection& detection, View& view);
+  void ClearPending();
+  /// Solve, publish and account one frame
+  bool SolveFrame(vtkSlicerVideoCameraContinuousTriangulation* self, double timestamp, const std::vector<Detection>& detections, const Clock::time_point& arrival);
+
+  std::vector<Camera>                         Cameras;
+  vtkWeakPointer<vtkMRMLLinearTransformNode>  OutputNode;
+
+  // Synchronization buffer, one slot per camera
+  std::vector<Detection>                      Pending;
+  std::vector<char>                           PendingValid;
+  int                                         PendingCount;
+  bool                                        FrameOpen;
+  double                                      FrameTimestamp;
+  Clock::time_point                           FrameArrival;
+
+  // Statistics
+  int                                         PublishedFrames;
+  int                                         RejectedFrames;
+  double                                      TotalLatency;
+  double                                      MaximumLatency;
+  double                                      TotalSolveTime;
+  bool                                        HasFirstArrival;
+  Clock::time_point                           FirstArrival;
+  Clock::time_point                           LastPublication;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraContinuousTriangulation::vtkInternal::vtkInternal()
+  : PendingCount(0)
+  , FrameOpen(false)
+  , FrameTimestamp(0.0)
+  , PublishedFrames(0)
+  , RejectedFrames(0)
+  , TotalLatency(0.0)
+  , MaximumLatency(0.0)
+  , TotalSolveTime(0.0)
+  , HasFirstArrival(false)
+{
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraContinuousTriangulation::vtkInternal::MakeView(const Detection& detection, View& view)
+{
+  Camera& camera = this->Cameras[detection.Camera];
+  vtkMRMLVideoCameraNode* node = camera.Node;
+  if (node == nullptr || (camera.HasPose && camera.Pose == nullptr))
+  {
+    return false;
+  }
+
+  double* pixel = camera.Pixel->GetPointer(0);
+  pixel[0] = detection.Pixel[0];
+  pixel[1] = detection.Pixel[1];
+  if (!vtkSlicerVideoCameraProjection::BackProjectPixels(node, camera.Pixel, camera.Ray))
+  {
+    return false;
+  }
+  const double* ray = camera.Ray->GetPointer(0);
+  if (vtkMath::IsNan(ray[0]) || ray[2] <= 1e-9)
+  {
+    // the linear solver needs the point in front of the camera
+    return false;
+  }
+
+  // image sensor to reference, as in the ray intersection module
+  vtkNew<vtkMatrix4x4> sensorToReference;
+  if (node->GetMarkerToImageSensorTransform() != nullptr)
+  {
+    vtkMatrix4x4::Invert(node->GetMarkerToImageSensorTransform(), sensorToReference.GetPointer());
+  }
+  if (camera.Pose != nullptr)
+  {
+    vtkNew<vtkMatrix4x4> cameraToReference;
+    camera.Pose->GetMatrixTransformToParent(cameraToReference.GetPointer());
+    vtkMatrix4x4::Multiply4x4(cameraToReference.GetPointer(), sensorToReference.GetPointer(), sensorToReference.GetPointer());
+  }
+
+  double originSensor[4] = { 0.0, 0.0, 0.0, 1.0 };
+  vtkDoubleArray* offset = node->GetCameraPlaneOffset();
+  for (int i = 0; offset != nullptr && i < 3 && i < offset->GetNumberOfValues(); ++i)
+  {
+    originSensor[i] = offset->GetValue(i);
+  }
+  double origin[4];
+  sensorToReference->MultiplyPoint(originSensor, origin);
+
+  for (int i = 0; i < 3; ++i)
+  {
+    view.Origin[i] = origin[i];
+    view.Direction[i] = 0.0;
+    for (int k = 0; k < 3; ++k)
+    {
+      view.Axes[k][i] = sensorToReference->GetElement(i, k);
+      view.Direction[i] += sensorToReference->GetElement(i, k) * ray[k];
+    }
+  }
+  if (vtkMath::Normalize(view.Direction) == 0.0)
+  {
+    return false;
+  }
+  view.Normalized[0] = ray[0] / ray[2];
+  view.Normalized[1] = ray[1] / ray[2];
+  view.Weight = detection.Weight;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraContinuousTriangulation::vtkInternal::ClearPending()
+{
+  std::fill(this->PendingValid.begin(), this->PendingValid.end(), 0);
+  this->PendingCount = 0;
+  this->FrameOpen = false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraContinuousTriangulation::vtkInternal::SolveFrame(vtkSlicerVideoCameraContinuousTriangulation* self, double timestamp, const std::vector<Detection>& detections, const Clock::time_point& arrival)
+{
+  const Clock::time_point start = Clock::now();
+
+  std::vector<View> views;
+  views.reserve(detections.size());
+  for (std::vector<Detection>::const_iterator it = detections.begin(); it != detections.end(); ++it)
+  {
+    View view;
+    if (this->MakeView(*it, view))
+    {
+      views.push_back(view);
+    }
+  }
+  if (static_cast<int>(views.size()) < self->MinimumNumberOfViews)
+  {
+    ++this->RejectedFrames;
+    return false;
+  }
+
+  double A[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+  double b[3] = { 0.0, 0.0, 0.0 };
+  for (std::vector<View>::const_iterator view = views.begin(); view != views.end(); ++view)
+  {
+    if (self->Solver == DLTSolver)
+    {
+      // x * r3 - r1 and y * r3 - r2 applied to (X - origin) vanish for points on the ray
+      for (int k = 0; k < 2; ++k)
+      {
+        double row[3];
+        for (int i = 0; i < 3; ++i)
+        {
+          row[i] = view->Axes[k][i] - view->Normalized[k] * view->Axes[2][i];
+        }
+        AddOuterProduct(A, b, row, vtkMath::Dot(row, view->Origin), view->Weight);
+      }
+    }
+    else
+    {
+      // projector (I - d d^T) onto the plane normal to the ray
+      const double* d = view->Direction;
+      for (int i = 0; i < 3; ++i)
+      {
+        for (int j = 0; j < 3; ++j)
+        {
+          const double p = (i == j ? 1.0 : 0.0) - d[i] * d[j];
+          A[i][j] += view->Weight * p;
+          b[i] += view->Weight * p * view->Origin[j];
+        }
+      }
+    }
+  }
+
+  // parallel rays leave the system without a unique solution
+  const double scale = (A[0][0] + A[1][1] + A[2][2]) / 3.0;
+  if (!(vtkMath::Determinant3x3(A) > 1e-12 * scale * scale * scale))
+  {
+    ++this->RejectedFrames;
+    return false;
+  }
+  double AInverse[3][3];
+  double point[3];
+  vtkMath::Invert3x3(A, AInverse);
+  vtkMath::Multiply3x3(AInverse, b, point);
+
+  double residual = 0.0;
+  double totalWeight = 0.0;
+  for (std::vector<View>::const_iterator view = views.begin(); view != views.end(); ++view)
+  {
+    double v[3];
+    vtkMath::Subtract(point, view->Origin, v);
+    double r[3];
+    vtkMath::Cross(v, view->Direction, r);
+    residual += view->Weight * vtkMath::Norm(r);
+    totalWeight += view->Weight;
+  }
+  residual /= totalWeight;
+  if (self->MaximumResidual > 0.0 && residual > self->MaximumResidual)
+  {
+    ++this->RejectedFrames;
+    return false;
+  }
+
+  self->LastPoint[0] = point[0];
+  self->LastPoint[1] = point[1];
+  self->LastPoint[2] = point[2];
+  self->LastTimestamp = timestamp;
+  self->LastNumberOfViews = static_cast<int>(views.size());
+  self->LastResidual = residual;
+
+  if (this->OutputNode != nullptr)
+  {
+    vtkNew<vtkMatrix4x4> pointToReference;
+    pointToReference->SetElement(0, 3, point[0]);
+    pointToReference->SetElement(1, 3, point[1]);
+    pointToReference->SetElement(2, 3, point[2]);
+    this->OutputNode->SetMatrixTransformToParent(pointToReference.GetPointer());
+  }
+
+  const Clock::time_point end = Clock::now();
+  const double latency = SecondsBetween(arrival, end);
+  ++this->PublishedFrames;
+  this->TotalLatency += latency;
+  this->MaximumLatency = std::max(this->MaximumLatency, latency);
+  this->TotalSolveTime += SecondsBetween(start, end);
+  this->LastPublication = end;
+
+  self->InvokeEvent(PointPublishedEvent);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraContinuousTriangulation::vtkSlicerVideoCameraContinuousTriangulation()
+  : Solver(MidpointSolver)
+  , MinimumNumberOfViews(2)
+  , SynchronizationTolerance(0.01)
+  , MaximumResidual(0.0)
+  , LastTimestamp(0.0)
+  , LastNumberOfViews(0)
+  , LastResidual(0.0)
+  , Internal(new vtkInternal())
+{
+  this->LastPoint[0] = this->LastPoint[1] = this->LastPoint[2] = 0.0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraContinuousTriangulation::~vtkSlicerVideoCameraContinuousTriangulation()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraContinuousTriangulation::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfCameras: " << this->GetNumberOfCameras() << std::endl;
+  os << indent << "Solver: " << (this->Solver == DLTSolver ? "DLT" : "Midpoint") << std::endl;
+  os << indent << "MinimumNumberOfViews: " << this->MinimumNumberOfViews << std::endl;
+  os << indent << "SynchronizationTolerance: " << this->SynchronizationTolerance << std::endl;
+  os << indent << "MaximumResidual: " << this->MaximumResidual << std::endl;
+  os << indent << "LastPoint: " << this->LastPoint[0] << " " << this->LastPoint[1] << " " << this->LastPoint[2] << std::endl;
+  os << indent << "LastTimestamp: " << this->LastTimestamp << std::endl;
+  os << indent << "LastNumberOfViews: " << this->LastNumberOfViews << std::endl;
+  os << indent << "LastResidual: " << this->LastResidual << std::endl;
+  os << indent << "PublishedFrames: " << this->GetNumberOfPublishedFrames() << std::endl;
+  os << indent << "RejectedFrames: " << this->GetNumberOfRejectedFrames() << std::endl;
+  os << indent << "MeanLatency: " << this->GetMeanLatency() << std::endl;
+  os << indent << "Throughput: " << this->GetThroughput() << std::endl;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraContinuousTriangulation::AddCamera(vtkMRMLVideoCameraNode* node, vtkMRMLTransformNode* cameraToReference)
+{
+  if (node == nullptr)
+  {
+    vtkErrorMacro("AddCamera: camera node is required");
+    return -1;
+  }
+
+  Camera camera;
+  camera.Node = node;
+  camera.Pose = cameraToReference;
+  camera.HasPose = cameraToReference != nullptr;
+  camera.Pixel = vtkSmartPointer<vtkDoubleArray>::New();
+  camera.Pixel->SetNumberOfComponents(2);
+  camera.Pixel->SetNumberOfTuples(1);
+  camera.Ray = vtkSmartPointer<vtkDoubleArray>::New();
+  camera.Ray->SetNumberOfComponents(3);
+  camera.Ray->SetNumberOfTuples(1);
+  this->Internal->Cameras.push_back(camera);
+
+  Detection empty = { 0, { 0.0, 0.0 }, 0.0 };
+  this->Internal->Pending.push_back(empty);
+  this->Internal->PendingValid.push_back(0);
+  this->Modified();
+  return static_cast<int>(this->Internal->Cameras.size()) - 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraContinuousTriangulation::RemoveAllCameras()
+{
+  this->Internal->Cameras.clear();
+  this->Internal->Pending.clear();
+  this->Internal->PendingValid.clear();
+  this->Internal->ClearPending();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraContinuousTriangulation::GetNumberOfCameras() const
+{
+  return static_cast<int>(this->Internal->Cameras.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraContinuousTriangulation::SetOutputTransformNode(vtkMRMLLinearTransformNode* node)
+{
+  if (this->Internal->OutputNode == node)
+  {
+    return;
+  }
+  this->Internal->OutputNode = node;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLLinearTransformNode* vtkSlicerVideoCameraContinuousTriangulation::GetOutputTransformNode() const
+{
+  return this->Internal->OutputNode;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraContinuousTriangulation::AddDetection(int camera, double timestamp, double u, double v, double weight)
+{
+  if (camera < 0 || camera >= this->GetNumberOfCameras())
+  {
+    vtkErrorMacro("AddDetection: invalid camera index " << camera);
+    return false;
+  }
+  if (!(weight > 0.0) || vtkMath::IsNan(u) || vtkMath::IsNan(v))
+  {
+    return false;
+  }
+
+  vtkInternal* internal = this->Internal;
+  bool published = false;
+  if (internal->FrameOpen && std::fabs(timestamp - internal->FrameTimestamp) > this->SynchronizationTolerance)
+  {
+    if (timestamp < internal->FrameTimestamp)
+    {
+      // older than the frame being collected, too late to be used
+      return false;
+    }
+    // a later frame started, solve the one pending
+    published = this->Flush();
+  }
+
+  if (!internal->FrameOpen)
+  {
+    internal->FrameOpen = true;
+    internal->FrameTimestamp = timestamp;
+    internal->FrameArrival = Clock::now();
+    if (!internal->HasFirstArrival)
+    {
+      internal->HasFirstArrival = true;
+      internal->FirstArrival = internal->FrameArrival;
+    }
+  }
+
+  // a camera reporting twice in a frame keeps its latest detection
+  Detection& detection = internal->Pending[camera];
+  detection.Camera = camera;
+  detection.Pixel[0] = u;
+  detection.Pixel[1] = v;
+  detection.Weight = weight;
+  if (!internal->PendingValid[camera])
+  {
+    internal->PendingValid[camera] = 1;
+    ++internal->PendingCount;
+  }
+
+  if (internal->PendingCount == this->GetNumberOfCameras())
+  {
+    published = this->Flush() || published;
+  }
+  return published;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraContinuousTriangulation::Flush()
+{
+  vtkInternal* internal = this->Internal;
+  if (!internal->FrameOpen)
+  {
+    return false;
+  }
+
+  std::vector<Detection> detections;
+  detections.reserve(internal->PendingCount);
+  for (size_t c = 0; c < internal->Pending.size(); ++c)
+  {
+    if (internal->PendingValid[c])
+    {
+      detections.push_back(internal->Pending[c]);
+    }
+  }
+  const double timestamp = internal->FrameTimestamp;
+  const Clock::time_point arrival = internal->FrameArrival;
+  internal->ClearPending();
+
+  return internal->SolveFrame(this, timestamp, detections, arrival);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraContinuousTriangulation::TriangulateFrame(double timestamp, vtkDoubleArray* pixels, vtkDoubleArray* weights)
+{
+  if (pixels == nullptr || pixels->GetNumberOfComponents() != 2 || pixels->GetNumberOfTuples() != this->GetNumberOfCameras())
+  {
+    vtkErrorMacro("TriangulateFrame: pixels must have 2 components and one tuple per camera");
+    return false;
+  }
+  if (weights != nullptr && weights->GetNumberOfValues() != this->GetNumberOfCameras())
+  {
+    vtkErrorMacro("TriangulateFrame: weights must have one value per camera");
+    return false;
+  }
+
+  const Clock::time_point arrival = Clock::now();
+  if (!this->Internal->HasFirstArrival)
+  {
+    this->Internal->HasFirstArrival = true;
+    this->Internal->FirstArrival = arrival;
+  }
+
+  std::vector<Detection> detections;
+  detections.reserve(this->GetNumberOfCameras());
+  for (int c = 0; c < this->GetNumberOfCameras(); ++c)
+  {
+    Detection detection;
+    detection.Camera = c;
+    detection.Pixel[0] = pixels->GetComponent(c, 0);
+    detection.Pixel[1] = pixels->GetComponent(c, 1);
+    detection.Weight = weights != nullptr ? weights->GetValue(c) : 1.0;
+    if (detection.Weight > 0.0 && !vtkMath::IsNan(detection.Pixel[0]) && !vtkMath::IsNan(detection.Pixel[1]))
+    {
+      detections.push_back(detection);
+    }
+  }
+  return this->Internal->SolveFrame(this, timestamp, detections, arrival);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraContinuousTriangulation::GetLastPoint(double point[3]) const
+{
+  point[0] = this->LastPoint[0];
+  point[1] = this->LastPoint[1];
+  point[2] = this->LastPoint[2];
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraContinuousTriangulation::GetNumberOfPublishedFrames() const
+{
+  return this->Internal->PublishedFrames;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraContinuousTriangulation::GetNumberOfRejectedFrames() const
+{
+  return this->Internal->RejectedFrames;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraContinuousTriangulation::GetMeanLatency() const
+{
+  return this->Internal->PublishedFrames > 0 ? this->Internal->TotalLatency / this->Internal->PublishedFrames : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraContinuousTriangulation::GetMaximumLatency() const
+{
+  return this->Internal->MaximumLatency;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraContinuousTriangulation::GetMeanSolveTime() const
+{
+  return this->Internal->PublishedFrames > 0 ? this->Internal->TotalSolveTime / this->Internal->PublishedFrames : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraContinuousTriangulation::GetThroughput() const
+{
+  if (this->Internal->PublishedFrames < 2)
+  {
+    return 0.0;
+  }
+  const double elapsed = SecondsBetween(this->Internal->FirstArrival, this->Internal->LastPublication);
+  return elapsed > 0.0 ? this->Internal->PublishedFrames / elapsed : 0.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraContinuousTriangulation::ResetStatistics()
+{
+  this->Internal->PublishedFrames = 0;
+  this->Internal->RejectedFrames = 0;
+  this->Internal->TotalLatency = 0.0;
+  this->Internal->MaximumLatency = 0.0;
+  this->Internal->TotalSolveTime = 0.0;
+  this->Internal->HasFirstArrival = false;
+}
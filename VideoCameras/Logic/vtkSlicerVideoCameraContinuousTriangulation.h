@@ -0,0 +1,153 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraContinuousTriangulation.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraContinuousTriangulation - live multi-view triangulation of a tool tip
+// .SECTION Description
+// Triangulates one point (e.g. an instrument tip) seen by two or more video cameras at frame
+// rate and publishes it into a linear transform node. Detections are pushed per camera with
+// their capture timestamp; detections within SynchronizationTolerance of the first detection of
+// a frame belong to that frame. A frame is solved as soon as every camera reported, or when a
+// later detection closes it with at least MinimumNumberOfViews cameras.
+//
+// Every detection is back-projected through the camera model of its node and moved to
+// reference space with cameraToReference * inverse(MarkerToImageSensorTransform), the
+// convention of the ray intersection module. The point is solved with a weighted midpoint
+// (least squares distance to the rays) or a weighted linear DLT; both reduce to one 3x3 system.
+//
+// AddDetection and TriangulateFrame update MRML and must be called on the main thread.
+
+#ifndef __vtkSlicerVideoCameraContinuousTriangulation_h
+#define __vtkSlicerVideoCameraContinuousTriangulation_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkDoubleArray;
+class vtkMRMLLinearTransformNode;
+class vtkMRMLTransformNode;
+class vtkMRMLVideoCameraNode;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraContinuousTriangulation : public vtkObject
+{
+public:
+  enum SolverType
+  {
+    MidpointSolver = 0,
+    DLTSolver
+  };
+
+  enum
+  {
+    /// Invoked after a triangulated point was published
+    PointPublishedEvent = 404201
+  };
+
+  static vtkSlicerVideoCameraContinuousTriangulation* New();
+  vtkTypeMacro(vtkSlicerVideoCameraContinuousTriangulation, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Add a camera, returns its index. cameraToReference is the pose of the camera (tracked marker
+  /// or rig calibration), read when a frame is solved. Without a node the camera is at the origin.
+  int AddCamera(vtkMRMLVideoCameraNode* camera, vtkMRMLTransformNode* cameraToReference);
+  void RemoveAllCameras();
+  int GetNumberOfCameras() const;
+
+  ///
+  /// Transform node the point is published to, as a translation
+  void SetOutputTransformNode(vtkMRMLLinearTransformNode* node);
+  vtkMRMLLinearTransformNode* GetOutputTransformNode() const;
+
+  vtkSetClampMacro(Solver, int, MidpointSolver, DLTSolver);
+  vtkGetMacro(Solver, int);
+  void SetSolverToMidpoint() { this->SetSolver(MidpointSolver); }
+  void SetSolverToDLT() { this->SetSolver(DLTSolver); }
+
+  ///
+  /// Cameras a frame needs to be solved (default 2)
+  vtkSetClampMacro(MinimumNumberOfViews, int, 2, VTK_INT_MAX);
+  vtkGetMacro(MinimumNumberOfViews, int);
+
+  ///
+  /// Largest capture time difference between detections of one frame, in seconds (default 0.01)
+  vtkSetClampMacro(SynchronizationTolerance, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(SynchronizationTolerance, double);
+
+  ///
+  /// Frames whose mean ray distance exceeds this value are not published. 0 (default) disables.
+  vtkSetClampMacro(MaximumResidual, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(MaximumResidual, double);
+
+  ///
+  /// Detection of the point by a camera: raw image pixel, capture timestamp (seconds) and weight
+  /// (e.g. detector confidence). Returns true if a frame was published.
+  bool AddDetection(int camera, double timestamp, double u, double v, double weight = 1.0);
+
+  ///
+  /// Solve and publish the frame pending in the synchronization buffer, if it has enough views
+  bool Flush();
+
+  ///
+  /// Triangulate one synchronised frame directly
+  /// pixels: one tuple (u, v) per camera, NaN for cameras that did not see the point
+  /// weights: optional, one value per camera
+  bool TriangulateFrame(double timestamp, vtkDoubleArray* pixels, vtkDoubleArray* weights = nullptr);
+
+  ///
+  /// Last published point (reference space), its capture timestamp, views and mean ray distance
+  void GetLastPoint(double point[3]) const;
+  vtkGetMacro(LastTimestamp, double);
+  vtkGetMacro(LastNumberOfViews, int);
+  vtkGetMacro(LastResidual, double);
+
+  ///
+  /// Statistics since the last reset
+  /// Latency is the time from the arrival of the first detection of a frame to its publication,
+  /// solve time the time spent back-projecting, solving and publishing.
+  int GetNumberOfPublishedFrames() const;
+  /// Frames with too few views, degenerate geometry or a residual above MaximumResidual
+  int GetNumberOfRejectedFrames() const;
+  double GetMeanLatency() const;
+  double GetMaximumLatency() const;
+  double GetMeanSolveTime() const;
+  /// Published frames per second
+  double GetThroughput() const;
+  void ResetStatistics();
+
+protected:
+  vtkSlicerVideoCameraContinuousTriangulation();
+  virtual ~vtkSlicerVideoCameraContinuousTriangulation();
+
+protected:
+  int     Solver;
+  int     MinimumNumberOfViews;
+  double  SynchronizationTolerance;
+  double  MaximumResidual;
+  double  LastPoint[3];
+  double  LastTimestamp;
+  int     LastNumberOfViews;
+  double  LastResidual;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSlicerVideoCameraContinuousTriangulation(const vtkSlicerVideoCameraContinuousTriangulation&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraContinuousTriangulation&); // Not implemented
+};
+
+#endif
@@ -0,0 +1,823 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraFrameProcessor.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraFrameProcessor.h"
+#include "vtkSlicerVideoCameraProjection.h"
+#include "vtkMRMLVideoCameraNode.h"
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+
+// VTK includes
+#include <vtkCommand.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+
+// OpenCV includes
+#include <opencv2/imgproc.hpp>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraFrameProcessor);
+
+namespace
+{
+  typedef vtkSlicerVideoCameraFrameProcessor::Frame Frame;
+  typedef std::unique_ptr<Frame> FramePointer;
+
+  //----------------------------------------------------------------------------
+  // Bounded lock-free queue, one thread pushes and one thread pops. A stage that finds its input
+  // empty, or its output full, parks on a condition variable of the queue; the other side only
+  // takes the lock to wake it when it announced that it is parked.
+  class FrameQueue
+  {
+  public:
+    explicit FrameQueue(size_t capacity)
+      : Slots(capacity + 1)
+      , Head(0)
+      , Tail(0)
+      , ConsumerParked(false)
+      , ProducerParked(false)
+    {
+    }
+
+    /// Takes ownership of the frame on success only, never waits
+    bool Push(FramePointer& frame)
+    {
+      const size_t tail = this->Tail.load(std::memory_order_relaxed);
+      const size_t next = (tail + 1) % this->Slots.size();
+      if (next == this->Head.load(std::memory_order_acquire))
+      {
+        return false;
+      }
+      this->Slots[tail] = std::move(frame);
+      this->Tail.store(next, std::memory_order_seq_cst);
+      this->Wake(this->ConsumerParked, this->NotEmpty);
+      return true;
+    }
+
+    /// Never waits
+    bool Pop(FramePointer& frame)
+    {
+      const size_t head = this->Head.load(std::memory_order_relaxed);
+      if (head == this->Tail.load(std::memory_order_acquire))
+      {
+        return false;
+      }
+      frame = std::move(this->Slots[head]);
+      this->Head.store((head + 1) % this->Slots.size(), std::memory_order_seq_cst);
+      this->Wake(this->ProducerParked, this->NotFull);
+      return true;
+    }
+
+    /// Wait for room for the frame, false if running was cleared first
+    bool WaitPush(FramePointer& frame, const std::atomic<bool>& running)
+    {
+      while (running)
+      {
+        if (this->Push(frame))
+        {
+          return true;
+        }
+        this->Park(this->ProducerParked, this->NotFull, running, [this] { return !this->IsFull(); });
+      }
+      return false;
+    }
+
+    /// Wait for a frame, false if running was cleared first
+    bool WaitPop(FramePointer& frame, const std::atomic<bool>& running)
+    {
+      while (running)
+      {
+        if (this->Pop(frame))
+        {
+          return true;
+        }
+        this->Park(this->ConsumerParked, this->NotEmpty, running, [this] { return !this->IsEmpty(); });
+      }
+      return false;
+    }
+
+    /// Wake the parked threads so they can see that running was cleared
+    void WakeAll()
+    {
+      // taking the lock orders the wake up after a parked thread checked running
+      {
+        std::lock_guard<std::mutex> lock(this->Mutex);
+      }
+      this->NotEmpty.notify_all();
+      this->NotFull.notify_all();
+    }
+
+    int GetSize() const
+    {
+      const size_t head = this->Head.load(std::memory_order_acquire);
+      const size_t tail = this->Tail.load(std::memory_order_acquire);
+      return static_cast<int>((tail + this->Slots.size() - head) % this->Slots.size());
+    }
+
+  protected:
+    bool IsEmpty() const
+    {
+      return this->Head.load(std::memory_order_seq_cst) == this->Tail.load(std::memory_order_seq_cst);
+    }
+
+    bool IsFull() const
+    {
+      return (this->Tail.load(std::memory_order_seq_cst) + 1) % this->Slots.size() == this->Head.load(std::memory_order_seq_cst);
+    }
+
+    /// Sleep until woken, unless ready() or !running once parked is announced: a Push or Pop
+    /// that did not see the announcement happened before it and is seen by ready()
+    template<class Predicate>
+    void Park(std::atomic<bool>& parked, std::condition_variable& condition, const std::atomic<bool>& running, Predicate ready)
+    {
+      std::unique_lock<std::mutex> lock(this->Mutex);
+      parked.store(true, std::memory_order_seq_cst);
+      if (running && !ready())
+      {
+        condition.wait(lock);
+      }
+      parked.store(false, std::memory_order_relaxed);
+    }
+
+    /// Wake the other side if it is parked, the lock is only taken then
+    void Wake(const std::atomic<bool>& parked, std::condition_variable& condition)
+    {
+      if (!parked.load(std::memory_order_seq_cst))
+      {
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(this->Mutex);
+      }
+      condition.notify_one();
+    }
+
+    std::vector<FramePointer> Slots;
+    std::atomic<size_t>       Head;
+    std::atomic<size_t>       Tail;
+    std::atomic<bool>         ConsumerParked;
+    std::atomic<bool>         ProducerParked;
+    std::mutex                Mutex;
+    std::condition_variable   NotEmpty;
+    std::condition_variable   NotFull;
+  };
+
+  //----------------------------------------------------------------------------
+  // Shares the scalars, buffer row j is Mat row j (pixel convention of vtkSlicerVideoCameraProjection.h)
+  cv::Mat ToMat(vtkImageData* image)
+  {
+    int dimensions[3];
+    image->GetDimensions(dimensions);
+    return cv::Mat(dimensions[1], dimensions[0], CV_8UC(image->GetNumberOfScalarComponents()), image->GetScalarPointer());
+  }
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkImageData> NewImage(vtkImageData* like, int components)
+  {
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetOrigin(like->GetOrigin());
+    image->SetSpacing(like->GetSpacing());
+    image->SetExtent(like->GetExtent());
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, components);
+    return image;
+  }
+
+  //----------------------------------------------------------------------------
+  // Camera parameters and stage options read by the worker stages, immutable once published
+  struct Parameters
+  {
+    /// Values the camera copies were made from, compared to reuse them
+    std::shared_ptr<const vtkMRMLVideoCameraNode::ParameterBlock> CameraParameters;
+    int                                     CameraModel;
+    double                                  Xi;
+    vtkSmartPointer<vtkMRMLVideoCameraNode> Camera;
+    /// Same intrinsics without distortion, the camera of undistorted frames
+    vtkSmartPointer<vtkMRMLVideoCameraNode> IdealCamera;
+    vtkSmartPointer<vtkFloatArray>          OverlayPoints;
+    bool                                    Grayscale;
+    bool                                    Undistort;
+    bool                                    DrawOverlay;
+  };
+
+  //----------------------------------------------------------------------------
+  // True if both snapshots were made from the same projection values, other options are ignored
+  bool SameCamera(const Parameters& a, const Parameters& b)
+  {
+    if (a.Camera == nullptr || a.CameraParameters == nullptr || b.CameraParameters == nullptr ||
+        a.CameraModel != b.CameraModel || a.Xi != b.Xi)
+    {
+      return false;
+    }
+    return a.CameraParameters == b.CameraParameters ||
+      (std::equal(a.CameraParameters->Intrinsics, a.CameraParameters->Intrinsics + 9, b.CameraParameters->Intrinsics) &&
+       a.CameraParameters->DistortionCoefficients == b.CameraParameters->DistortionCoefficients);
+  }
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCameraFrameProcessor::vtkInternal
+{
+public:
+  vtkInternal();
+
+  std::shared_ptr<const Parameters> GetParameters();
+  void RunStage(int stage);
+  void Convert(const Parameters& parameters, Frame& frame);
+  void UndistortFrame(const Parameters& parameters, Frame& frame);
+  void Overlay(const Parameters& parameters, Frame& frame);
+
+  std::unique_ptr<FrameQueue>       Queues[NumberOfStages];
+  std::vector<std::thread>          Threads;
+  std::atomic<bool>                 Running;
+  std::atomic<vtkIdType>            ProcessedFrames[NumberOfStages];
+  std::atomic<vtkIdType>            DroppedFrames;
+
+  std::mutex                        ParametersMutex;
+  std::shared_ptr<const Parameters> CurrentParameters;
+  vtkSmartPointer<vtkFloatArray>    OverlayPoints;
+  DetectCallbackType                DetectCallback;
+
+  /// Undistort map of the last camera copy and frame size, only used by the undistort stage.
+  /// Snapshots share the copy as long as the camera values are unchanged.
+  vtkSmartPointer<vtkMRMLVideoCameraNode> UndistortMapCamera;
+  vtkSmartPointer<vtkFloatArray>          UndistortMap;
+  int                                     UndistortMapSize[2];
+
+  std::vector<float>                LastDetectedPoints;
+  std::vector<float>                LastOverlayPixels;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraFrameProcessor::vtkInternal::vtkInternal()
+  : Running(false)
+  , DroppedFrames(0)
+{
+  for (int stage = 0; stage < NumberOfStages; ++stage)
+  {
+    this->ProcessedFrames[stage] = 0;
+  }
+  this->UndistortMapSize[0] = this->UndistortMapSize[1] = 0;
+}
+
+//----------------------------------------------------------------------------
+std::shared_ptr<const Parameters> vtkSlicerVideoCameraFrameProcessor::vtkInternal::GetParameters()
+{
+  std::lock_guard<std::mutex> lock(this->ParametersMutex);
+  return this->CurrentParameters;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::vtkInternal::RunStage(int stage)
+{
+  FrameQueue& input = *this->Queues[stage];
+  FrameQueue& output = *this->Queues[stage + 1];
+  FramePointer frame;
+  while (input.WaitPop(frame, this->Running))
+  {
+    std::shared_ptr<const Parameters> parameters = this->GetParameters();
+    switch (stage)
+    {
+      case ConvertStage:
+        this->Convert(*parameters, *frame);
+        break;
+      case UndistortStage:
+        this->UndistortFrame(*parameters, *frame);
+        break;
+      case DetectStage:
+        if (this->DetectCallback)
+        {
+          this->DetectCallback(*frame);
+        }
+        break;
+      case OverlayStage:
+        this->Overlay(*parameters, *frame);
+        break;
+    }
+    ++this->ProcessedFrames[stage];
+
+    if (!output.WaitPush(frame, this->Running))
+    {
+      return;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::vtkInternal::Convert(const Parameters& parameters, Frame& frame)
+{
+  const int components = frame.Image->GetNumberOfScalarComponents();
+  const int outputComponents = parameters.Grayscale ? 1 : std::min(components, 3);
+  if (outputComponents == components)
+  {
+    return;
+  }
+
+  vtkSmartPointer<vtkImageData> converted = NewImage(frame.Image, outputComponents);
+  cv::Mat source = ToMat(frame.Image);
+  cv::Mat target = ToMat(converted);
+  if (outputComponents == 1)
+  {
+    cv::cvtColor(source, target, components == 4 ? cv::COLOR_RGBA2GRAY : cv::COLOR_RGB2GRAY);
+  }
+  else if (components == 4)
+  {
+    cv::cvtColor(source, target, cv::COLOR_RGBA2RGB);
+  }
+  else
+  {
+    cv::cvtColor(source, target, cv::COLOR_GRAY2RGB);
+  }
+  frame.Image = converted;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::vtkInternal::UndistortFrame(const Parameters& parameters, Frame& frame)
+{
+  if (!parameters.Undistort || parameters.Camera == nullptr)
+  {
+    return;
+  }
+
+  int dimensions[3];
+  frame.Image->GetDimensions(dimensions);
+  if (this->UndistortMapCamera != parameters.Camera || this->UndistortMapSize[0] != dimensions[0] || this->UndistortMapSize[1] != dimensions[1])
+  {
+    vtkSmartPointer<vtkFloatArray> map = vtkSmartPointer<vtkFloatArray>::New();
+    if (!vtkSlicerVideoCameraProjection::ComputeUndistortMap(parameters.Camera, dimensions[0], dimensions[1], map))
+    {
+      return;
+    }
+    this->UndistortMap = map;
+    this->UndistortMapCamera = parameters.Camera;
+    this->UndistortMapSize[0] = dimensions[0];
+    this->UndistortMapSize[1] = dimensions[1];
+  }
+
+  vtkSmartPointer<vtkImageData> undistorted = NewImage(frame.Image, frame.Image->GetNumberOfScalarComponents());
+  cv::Mat map(dimensions[1], dimensions[0], CV_32FC2, this->UndistortMap->GetPointer(0));
+  cv::Mat target = ToMat(undistorted);
+  cv::remap(ToMat(frame.Image), target, map, cv::noArray(), cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+  frame.Image = undistorted;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::vtkInternal::Overlay(const Parameters& parameters, Frame& frame)
+{
+  frame.OverlayPixels.clear();
+  vtkMRMLVideoCameraNode* camera = parameters.Undistort ? parameters.IdealCamera : parameters.Camera;
+  if (camera == nullptr || parameters.OverlayPoints == nullptr)
+  {
+    return;
+  }
+
+  vtkNew<vtkFloatArray> pixels;
+  if (!vtkSlicerVideoCameraProjection::ProjectPoints(camera, parameters.OverlayPoints, pixels.GetPointer()))
+  {
+    return;
+  }
+  const float* values = pixels->GetPointer(0);
+  frame.OverlayPixels.assign(values, values + 2 * pixels->GetNumberOfTuples());
+
+  if (!parameters.DrawOverlay)
+  {
+    return;
+  }
+  cv::Mat image = ToMat(frame.Image);
+  const cv::Scalar color = image.channels() == 1 ? cv::Scalar(255) : cv::Scalar(0, 255, 0);
+  for (size_t i = 0; i + 1 < frame.OverlayPixels.size(); i += 2)
+  {
+    if (!std::isnan(frame.OverlayPixels[i]))
+    {
+      cv::drawMarker(image, cv::Point2f(frame.OverlayPixels[i], frame.OverlayPixels[i + 1]), color, cv::MARKER_CROSS, 10, 1);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraFrameProcessor::vtkSlicerVideoCameraFrameProcessor()
+  : VideoCameraNode(nullptr)
+  , CameraObserverTag(0)
+  , OutputVolumeNode(nullptr)
+  , QueueCapacity(4)
+  , Grayscale(false)
+  , Undistort(true)
+  , DrawOverlay(true)
+  , LastPublishedTimestamp(0.0)
+  , Internal(new vtkInternal)
+{
+  this->UpdateParameters();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraFrameProcessor::~vtkSlicerVideoCameraFrameProcessor()
+{
+  this->Stop();
+  this->SetVideoCameraNode(nullptr);
+  this->SetOutputVolumeNode(nullptr);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "VideoCameraNode: " << (this->VideoCameraNode ? this->VideoCameraNode->GetID() : "(none)") << std::endl;
+  os << indent << "OutputVolumeNode: " << (this->OutputVolumeNode ? this->OutputVolumeNode->GetID() : "(none)") << std::endl;
+  os << indent << "QueueCapacity: " << this->QueueCapacity << std::endl;
+  os << indent << "Grayscale: " << this->Grayscale << std::endl;
+  os << indent << "Undistort: " << this->Undistort << std::endl;
+  os << indent << "DrawOverlay: " << this->DrawOverlay << std::endl;
+  os << indent << "Running: " << this->IsRunning() << std::endl;
+  for (int stage = 0; stage < NumberOfStages; ++stage)
+  {
+    os << indent << GetStageName(stage) << ": queue depth " << this->GetQueueDepth(stage)
+       << ", processed " << this->GetNumberOfProcessedFrames(stage) << std::endl;
+  }
+  os << indent << "DroppedFrames: " << this->GetNumberOfDroppedFrames() << std::endl;
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerVideoCameraFrameProcessor::GetStageName(int stage)
+{
+  switch (stage)
+  {
+    case ConvertStage:
+      return "Convert";
+    case UndistortStage:
+      return "Undistort";
+    case DetectStage:
+      return "Detect";
+    case OverlayStage:
+      return "Overlay";
+    case PublishStage:
+      return "Publish";
+    default:
+      return "";
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::SetVideoCameraNode(vtkMRMLVideoCameraNode* node)
+{
+  if (this->VideoCameraNode == node)
+  {
+    return;
+  }
+
+  if (this->VideoCameraNode != nullptr)
+  {
+    this->VideoCameraNode->RemoveObserver(this->CameraObserverTag);
+    this->VideoCameraNode->UnRegister(this);
+  }
+
+  this->VideoCameraNode = node;
+
+  if (this->VideoCameraNode != nullptr)
+  {
+    this->VideoCameraNode->Register(this);
+    this->CameraObserverTag = this->VideoCameraNode->AddObserver(vtkCommand::ModifiedEvent, this, &vtkSlicerVideoCameraFrameProcessor::OnCameraModified);
+  }
+
+  this->UpdateParameters();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::SetOutputVolumeNode(vtkMRMLScalarVolumeNode* node)
+{
+  if (this->OutputVolumeNode == node)
+  {
+    return;
+  }
+
+  if (this->OutputVolumeNode != nullptr)
+  {
+    this->OutputVolumeNode->UnRegister(this);
+  }
+
+  this->OutputVolumeNode = node;
+
+  if (this->OutputVolumeNode != nullptr)
+  {
+    this->OutputVolumeNode->Register(this);
+  }
+
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::SetGrayscale(bool grayscale)
+{
+  if (this->Grayscale != grayscale)
+  {
+    this->Grayscale = grayscale;
+    this->UpdateParameters();
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::SetUndistort(bool undistort)
+{
+  if (this->Undistort != undistort)
+  {
+    this->Undistort = undistort;
+    this->UpdateParameters();
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::SetDrawOverlay(bool draw)
+{
+  if (this->DrawOverlay != draw)
+  {
+    this->DrawOverlay = draw;
+    this->UpdateParameters();
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::SetOverlayPoints(vtkDoubleArray* points)
+{
+  if (points != nullptr && points->GetNumberOfComponents() != 3)
+  {
+    vtkErrorMacro("SetOverlayPoints: points must have 3 components");
+    return;
+  }
+
+  this->Internal->OverlayPoints = nullptr;
+  if (points != nullptr)
+  {
+    this->Internal->OverlayPoints = vtkSmartPointer<vtkFloatArray>::New();
+    this->Internal->OverlayPoints->DeepCopy(points);
+  }
+  this->UpdateParameters();
+  this->Modified();
+}
+
+#if !defined(__VTK_WRAP__)
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::SetDetectCallback(const DetectCallbackType& callback)
+{
+  if (this->IsRunning())
+  {
+    vtkErrorMacro("SetDetectCallback: the pipeline must be stopped");
+    return;
+  }
+  this->Internal->DetectCallback = callback;
+}
+#endif
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::OnCameraModified(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(event), void* vtkNotUsed(data))
+{
+  this->UpdateParameters();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::UpdateParameters()
+{
+  std::shared_ptr<Parameters> parameters = std::make_shared<Parameters>();
+  parameters->Grayscale = this->Grayscale;
+  parameters->Undistort = this->Undistort;
+  parameters->DrawOverlay = this->DrawOverlay;
+  parameters->OverlayPoints = this->Internal->OverlayPoints;
+
+  // private copies, the stages must not read a node the main thread may be modifying. They are
+  // kept while the projection values are unchanged so that the stages keep their undistort map.
+  if (this->VideoCameraNode != nullptr && this->VideoCameraNode->GetIntrinsicMatrix() != nullptr)
+  {
+    std::shared_ptr<const Parameters> previous = this->Internal->GetParameters();
+    parameters->CameraParameters = this->VideoCameraNode->GetParameters();
+    parameters->CameraModel = this->VideoCameraNode->GetCameraModel();
+    parameters->Xi = this->VideoCameraNode->GetXi();
+    if (previous != nullptr && SameCamera(*previous, *parameters))
+    {
+      parameters->Camera = previous->Camera;
+      parameters->IdealCamera = previous->IdealCamera;
+    }
+    else
+    {
+      parameters->Camera = vtkSmartPointer<vtkMRMLVideoCameraNode>::New();
+      parameters->Camera->GetIntrinsicMatrix()->DeepCopy(this->VideoCameraNode->GetIntrinsicMatrix());
+      if (this->VideoCameraNode->GetDistortionCoefficients() != nullptr)
+      {
+        parameters->Camera->GetDistortionCoefficients()->DeepCopy(this->VideoCameraNode->GetDistortionCoefficients());
+      }
+      parameters->Camera->SetCameraModel(parameters->CameraModel);
+      parameters->Camera->SetXi(parameters->Xi);
+
+      parameters->IdealCamera = vtkSmartPointer<vtkMRMLVideoCameraNode>::New();
+      parameters->IdealCamera->GetIntrinsicMatrix()->DeepCopy(this->VideoCameraNode->GetIntrinsicMatrix());
+      // views are created on first access, not by the stages
+      parameters->IdealCamera->GetDistortionCoefficients();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(this->Internal->ParametersMutex);
+  this->Internal->CurrentParameters = parameters;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraFrameProcessor::Start()
+{
+  if (this->IsRunning())
+  {
+    return false;
+  }
+
+  for (int stage = 0; stage < NumberOfStages; ++stage)
+  {
+    this->Internal->Queues[stage].reset(new FrameQueue(this->QueueCapacity));
+    this->Internal->ProcessedFrames[stage] = 0;
+  }
+  this->Internal->DroppedFrames = 0;
+  this->Internal->Running = true;
+  for (int stage = ConvertStage; stage < PublishStage; ++stage)
+  {
+    this->Internal->Threads.push_back(std::thread(&vtkInternal::RunStage, this->Internal, stage));
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::Stop()
+{
+  if (!this->IsRunning())
+  {
+    return;
+  }
+
+  this->Internal->Running = false;
+  for (int stage = 0; stage < NumberOfStages; ++stage)
+  {
+    this->Internal->Queues[stage]->WakeAll();
+  }
+  for (std::vector<std::thread>::iterator it = this->Internal->Threads.begin(); it != this->Internal->Threads.end(); ++it)
+  {
+    it->join();
+  }
+  this->Internal->Threads.clear();
+  for (int stage = 0; stage < NumberOfStages; ++stage)
+  {
+    this->Internal->Queues[stage].reset();
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraFrameProcessor::IsRunning() const
+{
+  return this->Internal->Running;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraFrameProcessor::PushFrame(vtkImageData* image, double timestamp)
+{
+  if (image == nullptr || image->GetScalarType() != VTK_UNSIGNED_CHAR)
+  {
+    vtkErrorMacro("PushFrame: frames must be unsigned char images");
+    return false;
+  }
+  const int components = image->GetNumberOfScalarComponents();
+  if (components != 1 && components != 3 && components != 4)
+  {
+    vtkErrorMacro("PushFrame: frames must have 1, 3 or 4 components");
+    return false;
+  }
+  if (!this->IsRunning())
+  {
+    return false;
+  }
+
+  FramePointer frame(new Frame);
+  frame->Image = vtkSmartPointer<vtkImageData>::New();
+  frame->Image->DeepCopy(image);
+  frame->Timestamp = timestamp;
+  if (!this->Internal->Queues[ConvertStage]->Push(frame))
+  {
+    ++this->Internal->DroppedFrames;
+    return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraFrameProcessor::ProcessPublishQueue()
+{
+  if (!this->IsRunning())
+  {
+    return 0;
+  }
+
+  FramePointer newest;
+  FramePointer frame;
+  int count = 0;
+  while (this->Internal->Queues[PublishStage]->Pop(frame))
+  {
+    if (newest)
+    {
+      ++this->Internal->DroppedFrames;
+    }
+    newest = std::move(frame);
+    ++count;
+  }
+  if (!newest)
+  {
+    return 0;
+  }
+
+  this->Internal->LastDetectedPoints.swap(newest->DetectedPoints);
+  this->Internal->LastOverlayPixels.swap(newest->OverlayPixels);
+  this->LastPublishedTimestamp = newest->Timestamp;
+  if (this->OutputVolumeNode != nullptr)
+  {
+    this->OutputVolumeNode->SetAndObserveImageData(newest->Image);
+  }
+  ++this->Internal->ProcessedFrames[PublishStage];
+  this->InvokeEvent(FramePublishedEvent);
+  return count;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraFrameProcessor::GetQueueDepth(int stage) const
+{
+  if (stage < 0 || stage >= NumberOfStages || !this->Internal->Queues[stage])
+  {
+    return 0;
+  }
+  return this->Internal->Queues[stage]->GetSize();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerVideoCameraFrameProcessor::GetNumberOfProcessedFrames(int stage) const
+{
+  if (stage < 0 || stage >= NumberOfStages)
+  {
+    return 0;
+  }
+  return this->Internal->ProcessedFrames[stage];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerVideoCameraFrameProcessor::GetNumberOfDroppedFrames() const
+{
+  return this->Internal->DroppedFrames;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::GetLastDetectedPoints(vtkDoubleArray* points) const
+{
+  if (points == nullptr)
+  {
+    return;
+  }
+  points->SetNumberOfComponents(2);
+  points->SetNumberOfTuples(static_cast<vtkIdType>(this->Internal->LastDetectedPoints.size() / 2));
+  for (size_t i = 0; i < this->Internal->LastDetectedPoints.size(); ++i)
+  {
+    points->SetValue(static_cast<vtkIdType>(i), this->Internal->LastDetectedPoints[i]);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraFrameProcessor::GetLastOverlayPixels(vtkDoubleArray* pixels) const
+{
+  if (pixels == nullptr)
+  {
+    return;
+  }
+  pixels->SetNumberOfComponents(2);
+  pixels->SetNumberOfTuples(static_cast<vtkIdType>(this->Internal->LastOverlayPixels.size() / 2));
+  for (size_t i = 0; i < this->Internal->LastOverlayPixels.size(); ++i)
+  {
+    pixels->SetValue(static_cast<vtkIdType>(i), this->Internal->LastOverlayPixels[i]);
+  }
+}
@@ -0,0 +1,186 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraFrameProcessor.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraFrameProcessor - threaded live video pipeline
+// .SECTION Description
+// Runs convert -> undistort -> detect -> overlay on one thread per stage. Stages are connected by
+// bounded lock-free single-producer/single-consumer rings. A stage only sleeps when its input ring
+// is empty or its output ring is full, until a frame or room is handed over or the processor is
+// stopped. The publish stage is ProcessPublishQueue, called on the main thread (e.g. from a
+// timer): it is the only one that touches MRML, writing the newest frame to the output volume node.
+//
+// Frames are processed in buffer row order, detected points and the undistort map use the pixel
+// convention of vtkSlicerVideoCameraProjection.h.
+//
+// Worker stages never read the camera node: its parameters are snapshotted on the main thread
+// whenever the node is modified, and stages pick up the latest snapshot per frame.
+//
+// When the input queue is full PushFrame drops the frame instead of blocking the producer.
+// Between stages a full queue stalls the upstream stage, which backs up to the input queue.
+// The input queue has a single producer: PushFrame, Start and Stop must be called from one thread.
+
+#ifndef __vtkSlicerVideoCameraFrameProcessor_h
+#define __vtkSlicerVideoCameraFrameProcessor_h
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+// STD includes
+#if !defined(__VTK_WRAP__)
+#include <functional>
+#include <vector>
+#endif
+
+class vtkDoubleArray;
+class vtkImageData;
+class vtkMRMLScalarVolumeNode;
+class vtkMRMLVideoCameraNode;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraFrameProcessor : public vtkObject
+{
+public:
+  enum StageType
+  {
+    ConvertStage = 0,
+    UndistortStage,
+    DetectStage,
+    OverlayStage,
+    PublishStage,
+    NumberOfStages
+  };
+
+  enum
+  {
+    /// Invoked on the main thread by ProcessPublishQueue after a frame was published
+    FramePublishedEvent = 404101
+  };
+
+  static vtkSlicerVideoCameraFrameProcessor* New();
+  vtkTypeMacro(vtkSlicerVideoCameraFrameProcessor, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  static const char* GetStageName(int stage);
+
+  ///
+  /// Camera whose intrinsics, distortion and model are used to undistort and project
+  void SetVideoCameraNode(vtkMRMLVideoCameraNode* node);
+  vtkGetObjectMacro(VideoCameraNode, vtkMRMLVideoCameraNode);
+
+  ///
+  /// Volume the processed frames are published to
+  void SetOutputVolumeNode(vtkMRMLScalarVolumeNode* node);
+  vtkGetObjectMacro(OutputVolumeNode, vtkMRMLScalarVolumeNode);
+
+  ///
+  /// Frames each queue can hold, applied by the next Start (default 4)
+  vtkSetClampMacro(QueueCapacity, int, 1, 1024);
+  vtkGetMacro(QueueCapacity, int);
+
+  ///
+  /// Stage options, can be changed while running
+  /// Grayscale converts frames to one component, otherwise alpha is dropped.
+  void SetGrayscale(bool grayscale);
+  vtkGetMacro(Grayscale, bool);
+  void SetUndistort(bool undistort);
+  vtkGetMacro(Undistort, bool);
+  void SetDrawOverlay(bool draw);
+  vtkGetMacro(DrawOverlay, bool);
+
+  ///
+  /// Camera space points (3 components) projected by the overlay stage, null to disable
+  /// The points are copied. They are projected with the ideal camera when frames are undistorted.
+  void SetOverlayPoints(vtkDoubleArray* points);
+
+  ///
+  /// Start the stage threads, returns false if already running
+  bool Start();
+  /// Stop and join the stage threads, queued frames are discarded
+  void Stop();
+  bool IsRunning() const;
+
+  ///
+  /// Queue a frame (unsigned char, 1, 3 or 4 components), the image is copied
+  /// Returns false if the frame was dropped because the pipeline is stopped or full.
+  bool PushFrame(vtkImageData* frame, double timestamp);
+
+  ///
+  /// Publish the newest processed frame to the output volume, older ones are skipped
+  /// Must be called on the main thread. Returns the number of frames taken from the queue.
+  int ProcessPublishQueue();
+
+  ///
+  /// Frames waiting at the input of a stage
+  int GetQueueDepth(int stage) const;
+  /// Frames a stage has finished
+  vtkIdType GetNumberOfProcessedFrames(int stage) const;
+  /// Frames dropped at the input or skipped by the publish stage
+  vtkIdType GetNumberOfDroppedFrames() const;
+
+  ///
+  /// Results of the last published frame: detected points (2 components) and overlay pixels
+  /// (2 components, NaN for points the camera cannot see)
+  vtkGetMacro(LastPublishedTimestamp, double);
+  void GetLastDetectedPoints(vtkDoubleArray* points) const;
+  void GetLastOverlayPixels(vtkDoubleArray* pixels) const;
+
+#if !defined(__VTK_WRAP__)
+  /// Frame handed from stage to stage
+  struct Frame
+  {
+    vtkSmartPointer<vtkImageData> Image;
+    double                        Timestamp;
+    /// Image points (x, y) found by the detect callback
+    std::vector<float>            DetectedPoints;
+    /// Overlay points (x, y) projected by the overlay stage
+    std::vector<float>            OverlayPixels;
+  };
+
+  ///
+  /// Detection run by the detect stage on its own thread, must not touch MRML
+  /// Set while the pipeline is stopped.
+  typedef std::function<void(Frame&)> DetectCallbackType;
+  void SetDetectCallback(const DetectCallbackType& callback);
+#endif
+
+protected:
+  vtkSlicerVideoCameraFrameProcessor();
+  virtual ~vtkSlicerVideoCameraFrameProcessor();
+
+  void OnCameraModified(vtkObject* caller, unsigned long event, void* data);
+  /// Snapshot the camera and stage options for the worker stages
+  void UpdateParameters();
+
+protected:
+  vtkMRMLVideoCameraNode*   VideoCameraNode;
+  unsigned long             CameraObserverTag;
+  vtkMRMLScalarVolumeNode*  OutputVolumeNode;
+  int                       QueueCapacity;
+  bool                      Grayscale;
+  bool                      Undistort;
+  bool                      DrawOverlay;
+  double                    LastPublishedTimestamp;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSlicerVideoCameraFrameProcessor(const vtkSlicerVideoCameraFrameProcessor&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraFrameProcessor&); // Not implemented
+};
+
+#endif
@@ -0,0 +1,501 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraOverlayFilter.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraOverlayFilter.h"
+#include "vtkSlicerVideoCameraProjection.h"
+#include "vtkMRMLVideoCameraNode.h"
+
+// VTK includes
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// OpenCV includes
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraOverlayFilter);
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // OpenCV only accepts 4, 5, 8, 12 or 14 distortion coefficients, pad anything else with zeros
+  cv::Mat DistortionCoefficientsToMat(vtkDoubleArray* array)
+  {
+    int count = array ? array->GetNumberOfValues() : 0;
+    int size = 4;
+    const int supportedSizes[] = { 4, 5, 8, 12, 14 };
+    for (int supportedSize : supportedSizes)
+    {
+      size = supportedSize;
+      if (count <= supportedSize)
+      {
+        break;
+      }
+    }
+
+    cv::Mat distCoeffs = cv::Mat::zeros(1, size, CV_64F);
+    for (int i = 0; i < std::min(count, size); ++i)
+    {
+      distCoeffs.at<double>(0, i) = array->GetValue(i);
+    }
+    return distCoeffs;
+  }
+
+  //----------------------------------------------------------------------------
+  template<class T>
+  void vtkSlicerVideoCameraOverlayFilterExecute(vtkImageData* videoData,
+      vtkImageData* overlayData,
+      vtkImageData* outData,
+      int outExt[6],
+      const float* mapX,
+      const float* mapY,
+      const int mapExtent[6],
+      double opacity,
+      T*)
+  {
+    const int videoComps = videoData->GetNumberOfScalarComponents();
+    T* videoPtr = static_cast<T*>(videoData->GetScalarPointerForExtent(outExt));
+    T* outPtr = static_cast<T*>(outData->GetScalarPointerForExtent(outExt));
+
+    vtkIdType videoIncX, videoIncY, videoIncZ;
+    vtkIdType outIncX, outIncY, outIncZ;
+    videoData->GetContinuousIncrements(outExt, videoIncX, videoIncY, videoIncZ);
+    outData->GetContinuousIncrements(outExt, outIncX, outIncY, outIncZ);
+
+    int overlayExtent[6];
+    overlayData->GetExtent(overlayExtent);
+    const int overlayWidth = overlayExtent[1] - overlayExtent[0] + 1;
+    const int overlayHeight = overlayExtent[3] - overlayExtent[2] + 1;
+    const int overlayComps = overlayData->GetNumberOfScalarComponents();
+    const bool overlayHasAlpha = (overlayComps == 2 || overlayComps == 4);
+    const int overlayColorComps = overlayHasAlpha ? overlayComps - 1 : overlayComps;
+    const T* overlayPtr = static_cast<const T*>(overlayData->GetScalarPointer());
+    const vtkIdType* overlayIncrements = overlayData->GetIncrements();
+    const double alphaScale = std::numeric_limits<T>::is_integer ? 1.0 / overlayData->GetScalarTypeMax() : 1.0;
+    const double rounding = std::numeric_limits<T>::is_integer ? 0.5 : 0.0;
+    const vtkIdType mapWidth = mapExtent[1] - mapExtent[0] + 1;
+
+    for (int idxZ = outExt[4]; idxZ <= outExt[5]; ++idxZ)
+    {
+      for (int idxY = outExt[2]; idxY <= outExt[3]; ++idxY)
+      {
+        vtkIdType mapIndex = (idxY - mapExtent[2]) * mapWidth + (outExt[0] - mapExtent[0]);
+        for (int idxX = outExt[0]; idxX <= outExt[1]; ++idxX, ++mapIndex)
+        {
+          const float sampleX = mapX[mapIndex];
+          const float sampleY = mapY[mapIndex];
+          const int x0 = static_cast<int>(std::floor(sampleX));
+          const int y0 = static_cast<int>(std::floor(sampleY));
+
+          if (x0 < 0 || y0 < 0 || x0 + 1 >= overlayWidth || y0 + 1 >= overlayHeight)
+          {
+            // Overlay does not cover this raw pixel, keep the video as is
+            for (int c = 0; c < videoComps; ++c)
+            {
+              *outPtr++ = *videoPtr++;
+            }
+            continue;
+          }
+
+          // Bilinear sample of the overlay
+          const double fx = sampleX - x0;
+          const double fy = sampleY - y0;
+          const double w00 = (1.0 - fx) * (1.0 - fy);
+          const double w10 = fx * (1.0 - fy);
+          const double w01 = (1.0 - fx) * fy;
+          const double w11 = fx * fy;
+          const T* p00 = overlayPtr + x0 * overlayIncrements[0] + y0 * overlayIncrements[1];
+          const T* p10 = p00 + overlayIncrements[0];
+          const T* p01 = p00 + overlayIncrements[1];
+          const T* p11 = p01 + overlayIncrements[0];
+
+          double sample[4];
+          for (int c = 0; c < overlayComps; ++c)
+          {
+            sample[c] = w00 * p00[c] + w10 * p10[c] + w01 * p01[c] + w11 * p11[c];
+          }
+
+          double alpha = opacity;
+          if (overlayHasAlpha)
+          {
+            alpha *= sample[overlayColorComps] * alphaScale;
+          }
+
+          if (videoComps == 1 && overlayColorComps >= 3)
+          {
+            // Grayscale video, blend the overlay luminance
+            sample[0] = 0.299 * sample[0] + 0.587 * sample[1] + 0.114 * sample[2];
+          }
+
+          for (int c = 0; c < videoComps; ++c)
+          {
+            const double videoValue = static_cast<double>(*videoPtr++);
+            const double overlayValue = sample[std::min(c, overlayColorComps - 1)];
+            *outPtr++ = static_cast<T>(videoValue + alpha * (overlayValue - videoValue) + rounding);
+          }
+        }
+        videoPtr += videoIncY;
+        outPtr += outIncY;
+      }
+      videoPtr += videoIncZ;
+      outPtr += outIncZ;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template<class T>
+  void vtkSlicerVideoCameraOverlayFilterCopy(vtkImageData* videoData, vtkImageData* outData, int outExt[6], T*)
+  {
+    const int videoComps = videoData->GetNumberOfScalarComponents();
+    T* videoPtr = static_cast<T*>(videoData->GetScalarPointerForExtent(outExt));
+    T* outPtr = static_cast<T*>(outData->GetScalarPointerForExtent(outExt));
+
+    vtkIdType videoIncX, videoIncY, videoIncZ;
+    vtkIdType outIncX, outIncY, outIncZ;
+    videoData->GetContinuousIncrements(outExt, videoIncX, videoIncY, videoIncZ);
+    outData->GetContinuousIncrements(outExt, outIncX, outIncY, outIncZ);
+
+    const vtkIdType rowLength = static_cast<vtkIdType>(outExt[1] - outExt[0] + 1) * videoComps;
+    for (int idxZ = outExt[4]; idxZ <= outExt[5]; ++idxZ)
+    {
+      for (int idxY = outExt[2]; idxY <= outExt[3]; ++idxY)
+      {
+        std::copy(videoPtr, videoPtr + rowLength, outPtr);
+        videoPtr += rowLength + videoIncY;
+        outPtr += rowLength + outIncY;
+      }
+      videoPtr += videoIncZ;
+      outPtr += outIncZ;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraOverlayFilter::vtkSlicerVideoCameraOverlayFilter()
+  : VideoCameraNode(nullptr)
+  , OverlayRowsBottomUp(false)
+  , Opacity(1.0)
+  , CurrentDistortionMap(nullptr)
+  , DistortionMapUseCount(0)
+  , MaximumNumberOfDistortionMaps(8)
+{
+  this->SetNumberOfInputPorts(2);
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraOverlayFilter::~vtkSlicerVideoCameraOverlayFilter()
+{
+  this->SetVideoCameraNode(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraOverlayFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "VideoCameraNode: " << (this->VideoCameraNode ? this->VideoCameraNode->GetID() : "(none)") << std::endl;
+  os << indent << "OverlayRowsBottomUp: " << (this->OverlayRowsBottomUp ? "On" : "Off") << std::endl;
+  os << indent << "Opacity: " << this->Opacity << std::endl;
+  os << indent << "MaximumNumberOfDistortionMaps: " << this->MaximumNumberOfDistortionMaps << std::endl;
+  os << indent << "Cached distortion maps: " << this->DistortionMaps.size() << std::endl;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraOverlayFilter::SetVideoCameraNode(vtkMRMLVideoCameraNode* node)
+{
+  if (this->VideoCameraNode == node)
+  {
+    return;
+  }
+
+  if (this->VideoCameraNode != nullptr)
+  {
+    this->VideoCameraNode->UnRegister(this);
+  }
+
+  this->VideoCameraNode = node;
+
+  if (this->VideoCameraNode != nullptr)
+  {
+    this->VideoCameraNode->Register(this);
+  }
+
+  this->InvalidateDistortionMap();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraOverlayFilter::SetVideoInputData(vtkDataObject* input)
+{
+  this->SetInputData(0, input);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraOverlayFilter::SetVideoInputConnection(vtkAlgorithmOutput* input)
+{
+  this->SetInputConnection(0, input);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraOverlayFilter::SetOverlayInputData(vtkDataObject* input)
+{
+  this->SetInputData(1, input);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraOverlayFilter::SetOverlayInputConnection(vtkAlgorithmOutput* input)
+{
+  this->SetInputConnection(1, input);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraOverlayFilter::InvalidateDistortionMap()
+{
+  this->DistortionMaps.clear();
+  this->CurrentDistortionMap = nullptr;
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkSlicerVideoCameraOverlayFilter::GetMTime()
+{
+  return std::max(this->Superclass::GetMTime(), this->GetCalibrationMTime());
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkSlicerVideoCameraOverlayFilter::GetCalibrationMTime()
+{
+  vtkMTimeType mTime = 0;
+
+  // Only the calibration parameters matter, not every change to the node
+  if (this->VideoCameraNode != nullptr)
+  {
+    if (this->VideoCameraNode->GetIntrinsicMatrix() != nullptr)
+    {
+      mTime = std::max(mTime, this->VideoCameraNode->GetIntrinsicMatrix()->GetMTime());
+    }
+    if (this->VideoCameraNode->GetDistortionCoefficients() != nullptr)
+    {
+      mTime = std::max(mTime, this->VideoCameraNode->GetDistortionCoefficients()->GetMTime());
+    }
+  }
+
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraOverlayFilter::FillInputPortInformation(int port, vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  if (port == 1)
+  {
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+  }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraOverlayFilter::RequestUpdateExtent(vtkInformation* vtkNotUsed(request),
+    vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkInformation* videoInfo = inputVector[0]->GetInformationObject(0);
+
+  int updateExtent[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), updateExtent);
+  videoInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), updateExtent, 6);
+
+  // Any raw pixel may sample anywhere in the overlay
+  vtkInformation* overlayInfo = inputVector[1]->GetInformationObject(0);
+  if (overlayInfo != nullptr)
+  {
+    overlayInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
+                     overlayInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()), 6);
+  }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraOverlayFilter::RequestData(vtkInformation* request,
+    vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector)
+{
+  vtkInformation* videoInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation* overlayInfo = inputVector[1]->GetInformationObject(0);
+  vtkImageData* video = vtkImageData::SafeDownCast(videoInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkImageData* overlay = overlayInfo ? vtkImageData::SafeDownCast(overlayInfo->Get(vtkDataObject::DATA_OBJECT())) : nullptr;
+
+  if (overlay != nullptr)
+  {
+    if (overlay->GetScalarType() != video->GetScalarType())
+    {
+      vtkErrorMacro("Overlay scalar type " << overlay->GetScalarTypeAsString() << " does not match video scalar type " << video->GetScalarTypeAsString());
+      return 0;
+    }
+    if (overlay->GetNumberOfScalarComponents() > 4)
+    {
+      vtkErrorMacro("Overlay must have at most 4 components.");
+      return 0;
+    }
+
+    int videoWholeExtent[6];
+    videoInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), videoWholeExtent);
+    if (!this->UpdateDistortionMap(videoWholeExtent, overlay->GetExtent()))
+    {
+      return 0;
+    }
+  }
+
+  return this->Superclass::RequestData(request, inputVector, outputVector);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraOverlayFilter::UpdateDistortionMap(const int videoExtent[6], const int overlayExtent[6])
+{
+  this->CurrentDistortionMap = nullptr;
+  if (this->VideoCameraNode == nullptr || this->VideoCameraNode->GetIntrinsicMatrix() == nullptr)
+  {
+    vtkErrorMacro("A video camera node with intrinsics is required to warp the overlay.");
+    return false;
+  }
+
+  const int overlayWidth = overlayExtent[1] - overlayExtent[0] + 1;
+  const int overlayHeight = overlayExtent[3] - overlayExtent[2] + 1;
+
+  cv::Mat intrinsics(3, 3, CV_64F);
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      intrinsics.at<double>(i, j) = this->VideoCameraNode->GetIntrinsicMatrix()->GetElement(i, j);
+    }
+  }
+  cv::Mat distCoeffs = DistortionCoefficientsToMat(this->VideoCameraNode->GetDistortionCoefficients());
+
+  std::vector<double> parameters(intrinsics.begin<double>(), intrinsics.end<double>());
+  parameters.insert(parameters.end(), distCoeffs.begin<double>(), distCoeffs.end<double>());
+  parameters.push_back(this->VideoCameraNode->GetCameraModel());
+  parameters.push_back(this->VideoCameraNode->GetXi());
+  parameters.push_back(this->OverlayRowsBottomUp ? 1.0 : 0.0);
+
+  // one map per zoom bucket, a single map (key VTK_INT_MIN) without bucketing
+  DistortionMap& map = this->DistortionMaps[this->VideoCameraNode->GetEncoderBucket()];
+  map.LastUsed = ++this->DistortionMapUseCount;
+  if (!map.X.empty()
+      && map.Parameters == parameters
+      && std::equal(videoExtent, videoExtent + 4, map.VideoExtent)
+      && map.OverlaySize[0] == overlayWidth
+      && map.OverlaySize[1] == overlayHeight)
+  {
+    this->CurrentDistortionMap = &map;
+    return true;
+  }
+
+  const int width = videoExtent[1] - videoExtent[0] + 1;
+  const int height = videoExtent[3] - videoExtent[2] + 1;
+
+  // Ideal (undistorted) pixel location of every raw pixel center, with the kernel of the camera model
+  vtkNew<vtkFloatArray> idealPixels;
+  if (!vtkSlicerVideoCameraProjection::ComputeIdealPixelMap(this->VideoCameraNode, width, height, idealPixels.GetPointer()))
+  {
+    vtkErrorMacro("Unable to compute the distortion map of the video camera.");
+    return false;
+  }
+
+  // The overlay may be rendered at a different resolution than the video
+  const float scaleX = static_cast<float>(overlayWidth) / width;
+  const float scaleY = static_cast<float>(overlayHeight) / height;
+  const float* ideal = idealPixels->GetPointer(0);
+  const float lastOverlayRow = static_cast<float>(overlayHeight - 1);
+  map.X.resize(idealPixels->GetNumberOfTuples());
+  map.Y.resize(idealPixels->GetNumberOfTuples());
+  for (size_t i = 0; i < map.X.size(); ++i)
+  {
+    // pixels the ideal camera cannot see fall outside of the overlay
+    const bool valid = !std::isnan(ideal[2 * i]);
+    map.X[i] = valid ? ideal[2 * i] * scaleX : -1.0f;
+    const float y = ideal[2 * i + 1] * scaleY;
+    map.Y[i] = valid ? (this->OverlayRowsBottomUp ? lastOverlayRow - y : y) : -1.0f;
+  }
+
+  std::copy(videoExtent, videoExtent + 6, map.VideoExtent);
+  map.OverlaySize[0] = overlayWidth;
+  map.OverlaySize[1] = overlayHeight;
+  map.Parameters = parameters;
+  this->CurrentDistortionMap = &map;
+
+  // Drop the least recently used zoom buckets
+  while (static_cast<int>(this->DistortionMaps.size()) > this->MaximumNumberOfDistortionMaps)
+  {
+    std::map<int, DistortionMap>::iterator oldest = this->DistortionMaps.begin();
+    for (std::map<int, DistortionMap>::iterator it = this->DistortionMaps.begin(); it != this->DistortionMaps.end(); ++it)
+    {
+      if (it->second.LastUsed < oldest->second.LastUsed)
+      {
+        oldest = it;
+      }
+    }
+    this->DistortionMaps.erase(oldest);
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraOverlayFilter::ThreadedRequestData(vtkInformation* vtkNotUsed(request),
+    vtkInformationVector** vtkNotUsed(inputVector),
+    vtkInformationVector* vtkNotUsed(outputVector),
+    vtkImageData*** inData,
+    vtkImageData** outData,
+    int outExt[6], int vtkNotUsed(threadId))
+{
+  vtkImageData* video = inData[0][0];
+  vtkImageData* overlay = (inData[1] != nullptr) ? inData[1][0] : nullptr;
+
+  const DistortionMap* map = this->CurrentDistortionMap;
+  if (overlay == nullptr || map == nullptr)
+  {
+    switch (video->GetScalarType())
+    {
+      vtkTemplateMacro(vtkSlicerVideoCameraOverlayFilterCopy(video, outData[0], outExt, static_cast<VTK_TT*>(nullptr)));
+      default:
+        vtkErrorMacro("Unknown video scalar type");
+        return;
+    }
+    return;
+  }
+
+  switch (video->GetScalarType())
+  {
+    vtkTemplateMacro(vtkSlicerVideoCameraOverlayFilterExecute(video, overlay, outData[0], outExt,
+                     &map->X[0], &map->Y[0], map->VideoExtent,
+                     this->Opacity, static_cast<VTK_TT*>(nullptr)));
+    default:
+      vtkErrorMacro("Unknown video scalar type");
+      return;
+  }
+}
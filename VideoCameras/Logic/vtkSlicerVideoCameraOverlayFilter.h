@@ -0,0 +1,138 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraOverlayFilter.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraOverlayFilter - blend an undistorted rendering onto raw video
+// .SECTION Description
+// Warps an overlay rendered with an ideal pinhole camera (input port 1) onto the raw,
+// distorted video frame (input port 0) and alpha-blends the two in a single threaded pass.
+// The distortion remap is derived from the camera node's intrinsics and distortion
+// coefficients and is cached until either of them changes, so the background video never
+// needs to be undistorted. Maps are cached per zoom bucket of the camera node so that
+// returning to a previous zoom setting does not rebuild the map.
+//
+// Both inputs follow the pixel convention of vtkSlicerVideoCameraProjection.h (buffer row v is
+// image row v). Renderings captured from a render window are stored bottom up, set
+// OverlayRowsBottomUp for them instead of flipping every overlay frame.
+
+#ifndef __vtkSlicerVideoCameraOverlayFilter_h
+#define __vtkSlicerVideoCameraOverlayFilter_h
+
+// VTK includes
+#include <vtkThreadedImageAlgorithm.h>
+
+// STD includes
+#include <map>
+#include <vector>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkMRMLVideoCameraNode;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraOverlayFilter : public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkSlicerVideoCameraOverlayFilter* New();
+  vtkTypeMacro(vtkSlicerVideoCameraOverlayFilter, vtkThreadedImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Camera whose intrinsics and distortion coefficients define the warp
+  void SetVideoCameraNode(vtkMRMLVideoCameraNode* node);
+  vtkGetObjectMacro(VideoCameraNode, vtkMRMLVideoCameraNode);
+
+  ///
+  /// Raw (distorted) video frame, port 0
+  void SetVideoInputData(vtkDataObject* input);
+  void SetVideoInputConnection(vtkAlgorithmOutput* input);
+
+  ///
+  /// Overlay rendered with the camera intrinsics and no distortion, port 1
+  /// If the overlay has 2 or 4 components the last one is used as alpha
+  void SetOverlayInputData(vtkDataObject* input);
+  void SetOverlayInputConnection(vtkAlgorithmOutput* input);
+
+  ///
+  /// The overlay rows are stored bottom up, e.g. captured with vtkWindowToImageFilter
+  /// Its last buffer row is then sampled as image row 0. Off by default.
+  vtkSetMacro(OverlayRowsBottomUp, bool);
+  vtkGetMacro(OverlayRowsBottomUp, bool);
+  vtkBooleanMacro(OverlayRowsBottomUp, bool);
+
+  ///
+  /// Global opacity of the overlay, multiplied with the overlay alpha channel if present
+  vtkSetClampMacro(Opacity, double, 0.0, 1.0);
+  vtkGetMacro(Opacity, double);
+
+  ///
+  /// Maximum number of zoom buckets for which a distortion remap is kept
+  vtkSetClampMacro(MaximumNumberOfDistortionMaps, int, 1, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfDistortionMaps, int);
+
+  ///
+  /// Discard all cached distortion remaps
+  void InvalidateDistortionMap();
+
+  virtual vtkMTimeType GetMTime() VTK_OVERRIDE;
+
+protected:
+  vtkSlicerVideoCameraOverlayFilter();
+  virtual ~vtkSlicerVideoCameraOverlayFilter();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info) VTK_OVERRIDE;
+  virtual int RequestUpdateExtent(vtkInformation*, vtkInformationVector**, vtkInformationVector*) VTK_OVERRIDE;
+  virtual int RequestData(vtkInformation*, vtkInformationVector**, vtkInformationVector*) VTK_OVERRIDE;
+  virtual void ThreadedRequestData(vtkInformation* request,
+                                   vtkInformationVector** inputVector,
+                                   vtkInformationVector* outputVector,
+                                   vtkImageData*** inData,
+                                   vtkImageData** outData,
+                                   int outExt[6], int threadId) VTK_OVERRIDE;
+
+  /// Latest modification time of the intrinsics or distortion coefficients
+  vtkMTimeType GetCalibrationMTime();
+
+  /// Select the raw pixel -> overlay pixel map for the current zoom bucket, rebuilding it
+  /// if the calibration or frame size changed
+  bool UpdateDistortionMap(const int videoExtent[6], const int overlayExtent[6]);
+
+  struct DistortionMap
+  {
+    /// Overlay sample position for every raw video pixel, in overlay pixel units
+    std::vector<float>    X;
+    std::vector<float>    Y;
+    int                   VideoExtent[6];
+    int                   OverlaySize[2];
+    /// Intrinsics, distortion coefficients, camera model and overlay row order the map was computed from
+    std::vector<double>   Parameters;
+    unsigned long         LastUsed;
+  };
+
+protected:
+  vtkMRMLVideoCameraNode* VideoCameraNode;
+  bool                    OverlayRowsBottomUp;
+  double                  Opacity;
+
+  /// Distortion remaps keyed by zoom bucket (GetEncoderBucket(), VTK_INT_MIN without bucketing)
+  std::map<int, DistortionMap>  DistortionMaps;
+  DistortionMap*                CurrentDistortionMap;
+  unsigned long                 DistortionMapUseCount;
+  int                           MaximumNumberOfDistortionMaps;
+
+private:
+  vtkSlicerVideoCameraOverlayFilter(const vtkSlicerVideoCameraOverlayFilter&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraOverlayFilter&); // Not implemented
+};
+
+#endif
@@ -0,0 +1,275 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraProjection.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraProjection.h"
+#include "vtkSlicerVideoCameraProjectionKernels.h"
+#include "vtkMRMLVideoCameraNode.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkMatrix3x3.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraProjection);
+
+namespace
+{
+  using namespace vtkSlicerVideoCameraProjectionKernels;
+
+  //----------------------------------------------------------------------------
+  void CopyCoefficients(vtkDoubleArray* array, double* coefficients, int size)
+  {
+    const int count = array ? static_cast<int>(array->GetNumberOfValues()) : 0;
+    std::fill(coefficients, coefficients + size, 0.0);
+    for (int i = 0; i < std::min(count, size); ++i)
+    {
+      coefficients[i] = array->GetValue(i);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Resolve the camera model (and pinhole coefficient count) of the node once, convert its
+  // parameters to T and run the batch with the matching kernel
+  template <class T, class Batch>
+  bool Dispatch(vtkMRMLVideoCameraNode* node, const Batch& batch)
+  {
+    if (node == nullptr || node->GetIntrinsicMatrix() == nullptr)
+    {
+      return false;
+    }
+
+    vtkMatrix3x3* matrix = node->GetIntrinsicMatrix();
+    if (matrix->GetElement(0, 0) == 0.0 || matrix->GetElement(1, 1) == 0.0)
+    {
+      return false;
+    }
+    Intrinsics<T> intrinsics;
+    intrinsics.Set(matrix->GetElement(0, 0), matrix->GetElement(1, 1), matrix->GetElement(0, 2), matrix->GetElement(1, 2), matrix->GetElement(0, 1));
+
+    vtkDoubleArray* distCoeffs = node->GetDistortionCoefficients();
+    const int count = distCoeffs ? static_cast<int>(distCoeffs->GetNumberOfValues()) : 0;
+    double coefficients[14];
+    CopyCoefficients(distCoeffs, coefficients, 14);
+
+    switch (node->GetCameraModel())
+    {
+      case vtkMRMLVideoCameraNode::PinholeCameraModel:
+      {
+        // smallest OpenCV coefficient count holding all the coefficients of the node
+        if (count <= 4)
+        {
+          PinholeModel<4, T> model;
+          model.SetCoefficients(coefficients, count);
+          batch(intrinsics, model);
+        }
+        else if (count <= 5)
+        {
+          PinholeModel<5, T> model;
+          model.SetCoefficients(coefficients, count);
+          batch(intrinsics, model);
+        }
+        else if (count <= 8)
+        {
+          PinholeModel<8, T> model;
+          model.SetCoefficients(coefficients, count);
+          batch(intrinsics, model);
+        }
+        else if (count <= 12)
+        {
+          PinholeModel<12, T> model;
+          model.SetCoefficients(coefficients, count);
+          batch(intrinsics, model);
+        }
+        else
+        {
+          PinholeModel<14, T> model;
+          model.SetCoefficients(coefficients, count);
+          batch(intrinsics, model);
+        }
+        return true;
+      }
+      case vtkMRMLVideoCameraNode::FisheyeCameraModel:
+      {
+        FisheyeModel<T> model;
+        model.SetCoefficients(coefficients, count);
+        batch(intrinsics, model);
+        return true;
+      }
+      case vtkMRMLVideoCameraNode::OmnidirectionalCameraModel:
+      {
+        OmnidirectionalModel<T> model;
+        model.SetCoefficients(node->GetXi(), coefficients, count);
+        batch(intrinsics, model);
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template <class T>
+  struct ProjectBatch
+  {
+    const T* Points;
+    vtkIdType NumberOfPoints;
+    T* Pixels;
+
+    template <class Model>
+    void operator()(const Intrinsics<T>& intrinsics, const Model& model) const
+    {
+      vtkSlicerVideoCameraProjectionKernels::ProjectPoints(intrinsics, model, this->Points, this->NumberOfPoints, this->Pixels);
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  template <class T>
+  struct BackProjectBatch
+  {
+    const T* Pixels;
+    vtkIdType NumberOfPixels;
+    T* Rays;
+
+    template <class Model>
+    void operator()(const Intrinsics<T>& intrinsics, const Model& model) const
+    {
+      vtkSlicerVideoCameraProjectionKernels::BackProjectPixels(intrinsics, model, this->Pixels, this->NumberOfPixels, this->Rays);
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  struct MapBatch
+  {
+    bool Inverse;
+    int Width;
+    int Height;
+    float* Map;
+
+    template <class Model>
+    void operator()(const Intrinsics<typename Model::ValueType>& intrinsics, const Model& model) const
+    {
+      // the undistorted image keeps the camera matrix of the raw image
+      if (this->Inverse)
+      {
+        ComputeIdealPixelMap(intrinsics, model, intrinsics, this->Width, this->Height, this->Map);
+      }
+      else
+      {
+        ComputeUndistortMap(intrinsics, model, intrinsics, this->Width, this->Height, this->Map);
+      }
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  template <class T, class ArrayType>
+  bool Project(vtkMRMLVideoCameraNode* node, ArrayType* points, ArrayType* pixels)
+  {
+    if (points == nullptr || pixels == nullptr || points->GetNumberOfComponents() != 3)
+    {
+      vtkGenericWarningMacro("ProjectPoints: points must have 3 components");
+      return false;
+    }
+    pixels->SetNumberOfComponents(2);
+    pixels->SetNumberOfTuples(points->GetNumberOfTuples());
+    ProjectBatch<T> batch = { points->GetPointer(0), points->GetNumberOfTuples(), pixels->GetPointer(0) };
+    return Dispatch<T>(node, batch);
+  }
+
+  //----------------------------------------------------------------------------
+  template <class T, class ArrayType>
+  bool BackProject(vtkMRMLVideoCameraNode* node, ArrayType* pixels, ArrayType* rays)
+  {
+    if (pixels == nullptr || rays == nullptr || pixels->GetNumberOfComponents() != 2)
+    {
+      vtkGenericWarningMacro("BackProjectPixels: pixels must have 2 components");
+      return false;
+    }
+    rays->SetNumberOfComponents(3);
+    rays->SetNumberOfTuples(pixels->GetNumberOfTuples());
+    BackProjectBatch<T> batch = { pixels->GetPointer(0), pixels->GetNumberOfTuples(), rays->GetPointer(0) };
+    return Dispatch<T>(node, batch);
+  }
+
+  //----------------------------------------------------------------------------
+  // Remap tables are float and only need float accuracy, they are computed in single precision
+  bool ComputeMap(vtkMRMLVideoCameraNode* node, int width, int height, vtkFloatArray* map, bool inverse)
+  {
+    if (map == nullptr || width <= 0 || height <= 0)
+    {
+      return false;
+    }
+    map->SetNumberOfComponents(2);
+    map->SetNumberOfTuples(static_cast<vtkIdType>(width) * height);
+    MapBatch batch = { inverse, width, height, map->GetPointer(0) };
+    return Dispatch<float>(node, batch);
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraProjection::vtkSlicerVideoCameraProjection()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraProjection::~vtkSlicerVideoCameraProjection()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraProjection::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraProjection::ProjectPoints(vtkMRMLVideoCameraNode* node, vtkDoubleArray* points, vtkDoubleArray* pixels)
+{
+  return Project<double>(node, points, pixels);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraProjection::ProjectPoints(vtkMRMLVideoCameraNode* node, vtkFloatArray* points, vtkFloatArray* pixels)
+{
+  return Project<float>(node, points, pixels);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraProjection::BackProjectPixels(vtkMRMLVideoCameraNode* node, vtkDoubleArray* pixels, vtkDoubleArray* rays)
+{
+  return BackProject<double>(node, pixels, rays);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraProjection::BackProjectPixels(vtkMRMLVideoCameraNode* node, vtkFloatArray* pixels, vtkFloatArray* rays)
+{
+  return BackProject<float>(node, pixels, rays);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraProjection::ComputeUndistortMap(vtkMRMLVideoCameraNode* node, int width, int height, vtkFloatArray* map)
+{
+  return ComputeMap(node, width, height, map, false);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraProjection::ComputeIdealPixelMap(vtkMRMLVideoCameraNode* node, int width, int height, vtkFloatArray* map)
+{
+  return ComputeMap(node, width, height, map, true);
+}
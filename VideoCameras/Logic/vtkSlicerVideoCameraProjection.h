@@ -0,0 +1,81 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraProjection.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraProjection - batch projection through a video camera node
+// .SECTION Description
+// Projects, back-projects and builds undistortion maps with the camera model of a node. The
+// model is resolved once per call and the batch runs the matching kernel of
+// vtkSlicerVideoCameraProjectionKernels.h, so no per point work depends on the model.
+//
+// Pixel convention of all VideoCameras classes and modules: pixel (u, v) is column u and row v
+// of the image buffer, i.e. point (u, v, 0) of the vtkImageData and element (v, u) of the
+// cv::Mat sharing its scalars. Frames are never flipped: buffer row 0 is the first row delivered
+// by the camera (first row of an image file or video frame), and intrinsics, detections and
+// picked pixels all refer to these rows.
+
+#ifndef __vtkSlicerVideoCameraProjection_h
+#define __vtkSlicerVideoCameraProjection_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkDoubleArray;
+class vtkFloatArray;
+class vtkMRMLVideoCameraNode;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraProjection : public vtkObject
+{
+public:
+  static vtkSlicerVideoCameraProjection* New();
+  vtkTypeMacro(vtkSlicerVideoCameraProjection, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Camera space points (3 components) to raw image pixels (2 components)
+  /// Points the camera model cannot image are set to NaN.
+  /// The float overload runs the single precision kernels (parameters are converted once per call),
+  /// the double overload is the one to use for calibration and registration.
+  static bool ProjectPoints(vtkMRMLVideoCameraNode* node, vtkDoubleArray* points, vtkDoubleArray* pixels);
+  static bool ProjectPoints(vtkMRMLVideoCameraNode* node, vtkFloatArray* points, vtkFloatArray* pixels);
+
+  ///
+  /// Raw image pixels (2 components) to unit viewing rays in camera space (3 components)
+  /// Pixels outside the domain of the model are set to NaN.
+  static bool BackProjectPixels(vtkMRMLVideoCameraNode* node, vtkDoubleArray* pixels, vtkDoubleArray* rays);
+  static bool BackProjectPixels(vtkMRMLVideoCameraNode* node, vtkFloatArray* pixels, vtkFloatArray* rays);
+
+  ///
+  /// Remap table (2 components, width x height tuples) of the raw pixel sampled by every pixel
+  /// of the undistorted image, which uses the intrinsics of the node without distortion
+  /// Maps are computed in single precision.
+  static bool ComputeUndistortMap(vtkMRMLVideoCameraNode* node, int width, int height, vtkFloatArray* map);
+
+  ///
+  /// Undistorted image position (2 components, width x height tuples) of every raw pixel, the
+  /// inverse of the undistort map. NaN where a raw pixel looks behind the undistorted camera.
+  static bool ComputeIdealPixelMap(vtkMRMLVideoCameraNode* node, int width, int height, vtkFloatArray* map);
+
+protected:
+  vtkSlicerVideoCameraProjection();
+  virtual ~vtkSlicerVideoCameraProjection();
+
+private:
+  vtkSlicerVideoCameraProjection(const vtkSlicerVideoCameraProjection&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraProjection&); // Not implemented
+};
+
+#endif
@@ -0,0 +1,518 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraProjectionKernels.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraProjectionKernels - per camera model projection kernels
+// .SECTION Description
+// Header only, not wrapped. Each camera model is a small struct with inline Project/BackProject
+// between camera space and normalized distorted image coordinates. The batch functions are
+// templated on the model, and the pinhole model on its number of distortion coefficients, so both
+// are resolved once per batch (see vtkSlicerVideoCameraProjection) and the per point loops do not
+// branch on either.
+//
+// Every kernel is also templated on its scalar type T. Parameters are converted to T once when the
+// model is built, so the float instantiations run entirely in single precision (overlay and remap
+// tables) while the double ones keep full precision for calibration and registration.
+
+#ifndef __vtkSlicerVideoCameraProjectionKernels_h
+#define __vtkSlicerVideoCameraProjectionKernels_h
+
+// VTK includes
+#include <vtkSMPTools.h>
+#include <vtkType.h>
+
+// STD includes
+#include <cmath>
+#include <limits>
+
+namespace vtkSlicerVideoCameraProjectionKernels
+{
+  /// Fixed point / Newton iterations used to invert the distortion models
+  const int UndistortIterations = 20;
+
+  //----------------------------------------------------------------------------
+  /// Camera matrix [Fx Skew Cx; 0 Fy Cy; 0 0 1]
+  template <class T>
+  struct Intrinsics
+  {
+    typedef T ValueType;
+
+    T Fx;
+    T Fy;
+    T Cx;
+    T Cy;
+    T Skew;
+
+    void Set(double fx, double fy, double cx, double cy, double skew)
+    {
+      this->Fx = static_cast<T>(fx);
+      this->Fy = static_cast<T>(fy);
+      this->Cx = static_cast<T>(cx);
+      this->Cy = static_cast<T>(cy);
+      this->Skew = static_cast<T>(skew);
+    }
+
+    void ToPixel(T x, T y, T& u, T& v) const
+    {
+      u = this->Fx * x + this->Skew * y + this->Cx;
+      v = this->Fy * y + this->Cy;
+    }
+
+    void FromPixel(T u, T v, T& x, T& y) const
+    {
+      y = (v - this->Cy) / this->Fy;
+      x = (u - this->Cx - this->Skew * y) / this->Fx;
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  /// OpenCV pinhole model specialised on the number of distortion coefficients N (4, 5, 8, 12 or
+  /// 14): (k1, k2, p1, p2[, k3[, k4, k5, k6[, s1, s2, s3, s4[, tauX, tauY]]]]). Terms a size does
+  /// not have are removed at compile time, the polynomials are fixed length and fully unrolled.
+  template <int N, class T>
+  struct PinholeModel
+  {
+    typedef T ValueType;
+
+    /// Coefficients padded with zeros to 14
+    T K[14];
+    /// Tilted sensor projection (N == 14) and its inverse, row major
+    T Tilt[9];
+    T InverseTilt[9];
+
+    /// Copy up to N coefficients, the others are 0
+    void SetCoefficients(const double* coefficients, int count)
+    {
+      for (int i = 0; i < 14; ++i)
+      {
+        this->K[i] = static_cast<T>((i < N && i < count) ? coefficients[i] : 0.0);
+      }
+      double tilt[9];
+      double inverseTilt[9];
+      // a missing tauY is 0 like any other coefficient, tauX alone still tilts the sensor
+      ComputeTilt((N >= 14 && count > 12) ? coefficients[12] : 0.0, (N >= 14 && count > 13) ? coefficients[13] : 0.0, tilt, inverseTilt);
+      for (int i = 0; i < 9; ++i)
+      {
+        this->Tilt[i] = static_cast<T>(tilt[i]);
+        this->InverseTilt[i] = static_cast<T>(inverseTilt[i]);
+      }
+    }
+
+    /// Same tilt matrix as cv::detail::computeTiltProjectionMatrix, always in double
+    static void ComputeTilt(double tauX, double tauY, double tilt[9], double inverseTilt[9])
+    {
+      const double cTauX = std::cos(tauX);
+      const double sTauX = std::sin(tauX);
+      const double cTauY = std::cos(tauY);
+      const double sTauY = std::sin(tauY);
+      // RotY(tauY) * RotX(tauX)
+      const double rot[9] = { cTauY, sTauY * sTauX, -sTauY * cTauX,
+                              0.0, cTauX, sTauX,
+                              sTauY, -cTauY * sTauX, cTauY * cTauX };
+      // projection back on the z = 1 plane
+      const double projZ[9] = { rot[8], 0.0, -rot[2],
+                                0.0, rot[8], -rot[5],
+                                0.0, 0.0, 1.0 };
+      for (int i = 0; i < 3; ++i)
+      {
+        for (int j = 0; j < 3; ++j)
+        {
+          tilt[3 * i + j] = projZ[3 * i] * rot[j] + projZ[3 * i + 1] * rot[3 + j] + projZ[3 * i + 2] * rot[6 + j];
+        }
+      }
+      const double* m = tilt;
+      const double determinant = m[0] * (m[4] * m[8] - m[5] * m[7]) - m[1] * (m[3] * m[8] - m[5] * m[6]) + m[2] * (m[3] * m[7] - m[4] * m[6]);
+      const double inverse[9] = { m[4] * m[8] - m[5] * m[7], m[2] * m[7] - m[1] * m[8], m[1] * m[5] - m[2] * m[4],
+                                  m[5] * m[6] - m[3] * m[8], m[0] * m[8] - m[2] * m[6], m[2] * m[3] - m[0] * m[5],
+                                  m[3] * m[7] - m[4] * m[6], m[1] * m[6] - m[0] * m[7], m[0] * m[4] - m[1] * m[3] };
+      for (int i = 0; i < 9; ++i)
+      {
+        inverseTilt[i] = inverse[i] / determinant;
+      }
+    }
+
+    static void ApplyHomography(const T h[9], T& x, T& y)
+    {
+      const T w = h[6] * x + h[7] * y + h[8];
+      const T inverseW = w != T(0) ? T(1) / w : T(1);
+      const T tx = (h[0] * x + h[1] * y + h[2]) * inverseW;
+      y = (h[3] * x + h[4] * y + h[5]) * inverseW;
+      x = tx;
+    }
+
+    T RadialFactor(T r2) const
+    {
+      T numerator = T(1) + r2 * (this->K[0] + r2 * this->K[1]);
+      if (N >= 5)
+      {
+        numerator = T(1) + r2 * (this->K[0] + r2 * (this->K[1] + r2 * this->K[4]));
+      }
+      if (N >= 8)
+      {
+        return numerator / (T(1) + r2 * (this->K[5] + r2 * (this->K[6] + r2 * this->K[7])));
+      }
+      return numerator;
+    }
+
+    void Tangential(T x, T y, T r2, T& deltaX, T& deltaY) const
+    {
+      deltaX = T(2) * this->K[2] * x * y + this->K[3] * (r2 + T(2) * x * x);
+      deltaY = this->K[2] * (r2 + T(2) * y * y) + T(2) * this->K[3] * x * y;
+      if (N >= 12)
+      {
+        deltaX += r2 * (this->K[8] + r2 * this->K[9]);
+        deltaY += r2 * (this->K[10] + r2 * this->K[11]);
+      }
+    }
+
+    void Distort(T x, T y, T& xd, T& yd) const
+    {
+      const T r2 = x * x + y * y;
+      const T radial = this->RadialFactor(r2);
+      T deltaX, deltaY;
+      this->Tangential(x, y, r2, deltaX, deltaY);
+      xd = x * radial + deltaX;
+      yd = y * radial + deltaY;
+      if (N >= 14)
+      {
+        ApplyHomography(this->Tilt, xd, yd);
+      }
+    }
+
+    /// Same fixed point iteration as cv::undistortPoints, false if it leaves the valid domain
+    bool Undistort(T xd, T yd, T& x, T& y) const
+    {
+      if (N >= 14)
+      {
+        ApplyHomography(this->InverseTilt, xd, yd);
+      }
+      x = xd;
+      y = yd;
+      for (int i = 0; i < UndistortIterations; ++i)
+      {
+        const T r2 = x * x + y * y;
+        const T radial = this->RadialFactor(r2);
+        if (radial <= T(0))
+        {
+          return false;
+        }
+        T deltaX, deltaY;
+        this->Tangential(x, y, r2, deltaX, deltaY);
+        x = (xd - deltaX) / radial;
+        y = (yd - deltaY) / radial;
+      }
+      return true;
+    }
+
+    /// Camera space point to normalized distorted coordinates, false behind the camera
+    bool Project(const T point[3], T& xd, T& yd) const
+    {
+      if (point[2] <= T(0))
+      {
+        return false;
+      }
+      this->Distort(point[0] / point[2], point[1] / point[2], xd, yd);
+      return true;
+    }
+
+    /// Normalized distorted coordinates to a (non unit) viewing ray
+    bool BackProject(T xd, T yd, T ray[3]) const
+    {
+      ray[2] = T(1);
+      return this->Undistort(xd, yd, ray[0], ray[1]);
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  /// Kannala-Brandt equidistant fisheye model, distortion (k1, k2, k3, k4) on the incidence angle.
+  /// Rays up to and beyond 90 degrees from the optical axis are supported.
+  template <class T>
+  struct FisheyeModel
+  {
+    typedef T ValueType;
+
+    T K[4];
+
+    void SetCoefficients(const double* coefficients, int count)
+    {
+      for (int i = 0; i < 4; ++i)
+      {
+        this->K[i] = static_cast<T>(i < count ? coefficients[i] : 0.0);
+      }
+    }
+
+    T DistortAngle(T theta) const
+    {
+      const T theta2 = theta * theta;
+      return theta * (T(1) + theta2 * (this->K[0] + theta2 * (this->K[1] + theta2 * (this->K[2] + theta2 * this->K[3]))));
+    }
+
+    bool Project(const T point[3], T& xd, T& yd) const
+    {
+      const T r = std::sqrt(point[0] * point[0] + point[1] * point[1]);
+      if (r < std::numeric_limits<T>::min())
+      {
+        xd = T(0);
+        yd = T(0);
+        return point[2] > T(0);
+      }
+      const T scale = this->DistortAngle(std::atan2(r, point[2])) / r;
+      xd = point[0] * scale;
+      yd = point[1] * scale;
+      return true;
+    }
+
+    /// Newton iterations on the distorted angle, the returned ray has unit length
+    bool BackProject(T xd, T yd, T ray[3]) const
+    {
+      const T tolerance = T(4) * std::numeric_limits<T>::epsilon();
+      const T thetaD = std::sqrt(xd * xd + yd * yd);
+      T theta = thetaD;
+      for (int i = 0; i < UndistortIterations; ++i)
+      {
+        const T theta2 = theta * theta;
+        const T derivative = T(1) + theta2 * (T(3) * this->K[0] + theta2 * (T(5) * this->K[1] + theta2 * (T(7) * this->K[2] + theta2 * T(9) * this->K[3])));
+        const T step = (this->DistortAngle(theta) - thetaD) / derivative;
+        theta -= step;
+        if (std::abs(step) <= tolerance * theta)
+        {
+          break;
+        }
+      }
+      if (!(theta >= T(0) && theta < T(3.14159265358979323846)))
+      {
+        return false;
+      }
+      const T scale = thetaD > std::numeric_limits<T>::min() ? std::sin(theta) / thetaD : T(1);
+      ray[0] = xd * scale;
+      ray[1] = yd * scale;
+      ray[2] = std::cos(theta);
+      return true;
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  /// Mei unified omnidirectional model: the point is projected on the unit sphere, then from a
+  /// center shifted by Xi along the optical axis, then distorted by (k1, k2, p1, p2)
+  template <class T>
+  struct OmnidirectionalModel
+  {
+    typedef T ValueType;
+
+    T Xi;
+    PinholeModel<4, T> Distortion;
+
+    void SetCoefficients(double xi, const double* coefficients, int count)
+    {
+      this->Xi = static_cast<T>(xi);
+      this->Distortion.SetCoefficients(coefficients, count < 4 ? count : 4);
+    }
+
+    bool Project(const T point[3], T& xd, T& yd) const
+    {
+      const T norm = std::sqrt(point[0] * point[0] + point[1] * point[1] + point[2] * point[2]);
+      const T z = point[2] + this->Xi * norm;
+      if (norm == T(0) || z <= std::numeric_limits<T>::epsilon() * norm)
+      {
+        return false;
+      }
+      this->Distortion.Distort(point[0] / z, point[1] / z, xd, yd);
+      return true;
+    }
+
+    /// Lift the undistorted coordinates back on the unit sphere, the returned ray has unit length
+    bool BackProject(T xd, T yd, T ray[3]) const
+    {
+      T x, y;
+      if (!this->Distortion.Undistort(xd, yd, x, y))
+      {
+        return false;
+      }
+      const T r2 = x * x + y * y;
+      const T discriminant = T(1) + (T(1) - this->Xi * this->Xi) * r2;
+      if (discriminant < T(0))
+      {
+        return false;
+      }
+      const T factor = (this->Xi + std::sqrt(discriminant)) / (r2 + T(1));
+      ray[0] = factor * x;
+      ray[1] = factor * y;
+      ray[2] = factor - this->Xi;
+      return true;
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  /// Camera space points (3 values each) to raw image pixels (2 values each), NaN for points the
+  /// model cannot image
+  template <class Model>
+  void ProjectPoints(const Intrinsics<typename Model::ValueType>& intrinsics, const Model& model,
+                     const typename Model::ValueType* points, vtkIdType numberOfPoints, typename Model::ValueType* pixels)
+  {
+    typedef typename Model::ValueType T;
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+      T xd, yd;
+      if (model.Project(points + 3 * i, xd, yd))
+      {
+        intrinsics.ToPixel(xd, yd, pixels[2 * i], pixels[2 * i + 1]);
+      }
+      else
+      {
+        pixels[2 * i] = pixels[2 * i + 1] = nan;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Raw image pixels to unit viewing rays in camera space, NaN where the model cannot be inverted
+  template <class Model>
+  void BackProjectPixels(const Intrinsics<typename Model::ValueType>& intrinsics, const Model& model,
+                         const typename Model::ValueType* pixels, vtkIdType numberOfPixels, typename Model::ValueType* rays)
+  {
+    typedef typename Model::ValueType T;
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    for (vtkIdType i = 0; i < numberOfPixels; ++i)
+    {
+      T xd, yd;
+      intrinsics.FromPixel(pixels[2 * i], pixels[2 * i + 1], xd, yd);
+      T* ray = rays + 3 * i;
+      if (model.BackProject(xd, yd, ray))
+      {
+        const T inverseNorm = T(1) / std::sqrt(ray[0] * ray[0] + ray[1] * ray[1] + ray[2] * ray[2]);
+        ray[0] *= inverseNorm;
+        ray[1] *= inverseNorm;
+        ray[2] *= inverseNorm;
+      }
+      else
+      {
+        ray[0] = ray[1] = ray[2] = nan;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Rows of the undistort map: raw pixel sampled by every pixel of an ideal pinhole image
+  template <class Model>
+  class UndistortMapFunctor
+  {
+  public:
+    typedef typename Model::ValueType T;
+
+    UndistortMapFunctor(const Intrinsics<T>& raw, const Model& model, const Intrinsics<T>& ideal, int width, float* map)
+      : Raw(raw), CameraModel(model), Ideal(ideal), Width(width), Map(map)
+    {
+    }
+
+    void operator()(vtkIdType beginRow, vtkIdType endRow) const
+    {
+      for (vtkIdType v = beginRow; v < endRow; ++v)
+      {
+        float* out = this->Map + 2 * v * this->Width;
+        for (int u = 0; u < this->Width; ++u, out += 2)
+        {
+          T point[3] = { T(0), T(0), T(1) };
+          this->Ideal.FromPixel(static_cast<T>(u), static_cast<T>(v), point[0], point[1]);
+          T xd, yd, rawU, rawV;
+          if (this->CameraModel.Project(point, xd, yd))
+          {
+            this->Raw.ToPixel(xd, yd, rawU, rawV);
+            out[0] = static_cast<float>(rawU);
+            out[1] = static_cast<float>(rawV);
+          }
+          else
+          {
+            out[0] = out[1] = -1.0f;
+          }
+        }
+      }
+    }
+
+  protected:
+    const Intrinsics<T>& Raw;
+    const Model& CameraModel;
+    const Intrinsics<T>& Ideal;
+    int Width;
+    float* Map;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Rows of the ideal pixel map: ideal pinhole image position of every raw pixel
+  template <class Model>
+  class IdealPixelMapFunctor
+  {
+  public:
+    typedef typename Model::ValueType T;
+
+    IdealPixelMapFunctor(const Intrinsics<T>& raw, const Model& model, const Intrinsics<T>& ideal, int width, float* map)
+      : Raw(raw), CameraModel(model), Ideal(ideal), Width(width), Map(map)
+    {
+    }
+
+    void operator()(vtkIdType beginRow, vtkIdType endRow) const
+    {
+      const float nan = std::numeric_limits<float>::quiet_NaN();
+      for (vtkIdType v = beginRow; v < endRow; ++v)
+      {
+        float* out = this->Map + 2 * v * this->Width;
+        for (int u = 0; u < this->Width; ++u, out += 2)
+        {
+          T xd, yd, ray[3], idealU, idealV;
+          this->Raw.FromPixel(static_cast<T>(u), static_cast<T>(v), xd, yd);
+          if (this->CameraModel.BackProject(xd, yd, ray) && ray[2] > T(0))
+          {
+            this->Ideal.ToPixel(ray[0] / ray[2], ray[1] / ray[2], idealU, idealV);
+            out[0] = static_cast<float>(idealU);
+            out[1] = static_cast<float>(idealV);
+          }
+          else
+          {
+            out[0] = out[1] = nan;
+          }
+        }
+      }
+    }
+
+  protected:
+    const Intrinsics<T>& Raw;
+    const Model& CameraModel;
+    const Intrinsics<T>& Ideal;
+    int Width;
+    float* Map;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Interleaved (x, y) cv::remap table undistorting a raw image to the ideal camera, -1 where
+  /// the ideal ray cannot be imaged
+  template <class Model>
+  void ComputeUndistortMap(const Intrinsics<typename Model::ValueType>& raw, const Model& model,
+                           const Intrinsics<typename Model::ValueType>& ideal, int width, int height, float* map)
+  {
+    UndistortMapFunctor<Model> functor(raw, model, ideal, width, map);
+    vtkSMPTools::For(0, height, functor);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Interleaved (x, y) ideal camera position of every raw pixel, NaN where the raw pixel does not
+  /// see in front of the ideal camera
+  template <class Model>
+  void ComputeIdealPixelMap(const Intrinsics<typename Model::ValueType>& raw, const Model& model,
+                            const Intrinsics<typename Model::ValueType>& ideal, int width, int height, float* map)
+  {
+    IdealPixelMapFunctor<Model> functor(raw, model, ideal, width, map);
+    vtkSMPTools::For(0, height, functor);
+  }
+}
+
+#endif
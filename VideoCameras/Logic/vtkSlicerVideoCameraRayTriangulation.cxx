@@ -0,0 +1,395 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraRayTriangulation.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraRayTriangulation.h"
+#include "vtkSlicerVideoCameraProjection.h"
+#include "vtkMRMLVideoCameraNode.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
+#include <vtkStringArray.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraRayTriangulation);
+
+namespace
+{
+  /// Rays are stored as origin, unit direction
+  const int RaySize = 6;
+
+  //----------------------------------------------------------------------------
+  struct Target
+  {
+    Target()
+      : Dirty(false)
+      , Valid(false)
+      , Error(0.0)
+    {
+      std::fill(this->Normal, this->Normal + 6, 0.0);
+      std::fill(this->RightHandSide, this->RightHandSide + 3, 0.0);
+      std::fill(this->Point, this->Point + 3, 0.0);
+    }
+
+    std::string         Name;
+    std::vector<double> Rays;
+    /// Upper triangle of sum(I - d d^T): xx, xy, xz, yy, yz, zz
+    double              Normal[6];
+    /// sum((I - d d^T) o)
+    double              RightHandSide[3];
+    bool                Dirty;
+    bool                Valid;
+    double              Point[3];
+    double              Error;
+  };
+
+  //----------------------------------------------------------------------------
+  double DistanceToRay(const double* ray, const double point[3])
+  {
+    const double v[3] = { point[0] - ray[0], point[1] - ray[1], point[2] - ray[2] };
+    const double t = v[0] * ray[3] + v[1] * ray[4] + v[2] * ray[5];
+    const double r[3] = { v[0] - t * ray[3], v[1] - t * ray[4], v[2] - t * ray[5] };
+    return std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+  }
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCameraRayTriangulation::vtkInternal
+{
+public:
+  int GetOrCreateTarget(const std::string& name);
+  void AddRay(int target, const double origin[3], const double direction[3]);
+
+  std::vector<Target>        Targets;
+  std::map<std::string, int> TargetIndices;
+};
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraRayTriangulation::vtkInternal::GetOrCreateTarget(const std::string& name)
+{
+  std::map<std::string, int>::const_iterator it = this->TargetIndices.find(name);
+  if (it != this->TargetIndices.end())
+  {
+    return it->second;
+  }
+  const int index = static_cast<int>(this->Targets.size());
+  this->Targets.push_back(Target());
+  this->Targets.back().Name = name;
+  this->TargetIndices[name] = index;
+  return index;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraRayTriangulation::vtkInternal::AddRay(int index, const double origin[3], const double d[3])
+{
+  Target& target = this->Targets[index];
+  target.Rays.insert(target.Rays.end(), origin, origin + 3);
+  target.Rays.insert(target.Rays.end(), d, d + 3);
+
+  const double projector[6] = { 1.0 - d[0] * d[0], -d[0] * d[1], -d[0] * d[2], 1.0 - d[1] * d[1], -d[1] * d[2], 1.0 - d[2] * d[2] };
+  for (int i = 0; i < 6; ++i)
+  {
+    target.Normal[i] += projector[i];
+  }
+  target.RightHandSide[0] += projector[0] * origin[0] + projector[1] * origin[1] + projector[2] * origin[2];
+  target.RightHandSide[1] += projector[1] * origin[0] + projector[3] * origin[1] + projector[4] * origin[2];
+  target.RightHandSide[2] += projector[2] * origin[0] + projector[4] * origin[1] + projector[5] * origin[2];
+  target.Dirty = true;
+}
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  struct SolveFunctor
+  {
+    std::vector<Target>& Targets;
+    const std::vector<int>& Indices;
+    int MinimumNumberOfRays;
+
+    SolveFunctor(std::vector<Target>& targets, const std::vector<int>& indices, int minimumNumberOfRays)
+      : Targets(targets)
+      , Indices(indices)
+      , MinimumNumberOfRays(minimumNumberOfRays)
+    {
+    }
+
+    void operator()(vtkIdType begin, vtkIdType end) const
+    {
+      for (vtkIdType i = begin; i < end; ++i)
+      {
+        Target& target = this->Targets[this->Indices[i]];
+        target.Dirty = false;
+        target.Valid = false;
+
+        const int numberOfRays = static_cast<int>(target.Rays.size() / RaySize);
+        if (numberOfRays < this->MinimumNumberOfRays)
+        {
+          continue;
+        }
+
+        const double* n = target.Normal;
+        double A[3][3] = { { n[0], n[1], n[2] }, { n[1], n[3], n[4] }, { n[2], n[4], n[5] } };
+
+        // all rays (nearly) parallel: the normal matrix loses rank
+        const double scale = (n[0] + n[3] + n[5]) / 3.0;
+        if (vtkMath::Determinant3x3(A) <= 1e-12 * scale * scale * scale)
+        {
+          continue;
+        }
+
+        double AInverse[3][3];
+        vtkMath::Invert3x3(A, AInverse);
+        vtkMath::Multiply3x3(AInverse, target.RightHandSide, target.Point);
+
+        double sum = 0.0;
+        for (int r = 0; r < numberOfRays; ++r)
+        {
+          sum += DistanceToRay(&target.Rays[r * RaySize], target.Point);
+        }
+        target.Error = sum / numberOfRays;
+        target.Valid = true;
+      }
+    }
+  };
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraRayTriangulation::vtkSlicerVideoCameraRayTriangulation()
+  : Internal(new vtkInternal())
+  , MinimumNumberOfRays(3)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraRayTriangulation::~vtkSlicerVideoCameraRayTriangulation()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraRayTriangulation::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "MinimumNumberOfRays: " << this->MinimumNumberOfRays << std::endl;
+  os << indent << "NumberOfTargets: " << this->GetNumberOfTargets() << std::endl;
+  for (std::vector<Target>::const_iterator it = this->Internal->Targets.begin(); it != this->Internal->Targets.end(); ++it)
+  {
+    os << indent.GetNextIndent() << it->Name << ": " << it->Rays.size() / RaySize << " rays";
+    if (it->Valid)
+    {
+      os << ", point " << it->Point[0] << " " << it->Point[1] << " " << it->Point[2] << ", error " << it->Error;
+    }
+    os << std::endl;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraRayTriangulation::Reset()
+{
+  this->Internal->Targets.clear();
+  this->Internal->TargetIndices.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraRayTriangulation::AddRay(const char* target, const double origin[3], const double direction[3])
+{
+  if (target == nullptr)
+  {
+    vtkErrorMacro("AddRay: target name is required");
+    return -1;
+  }
+
+  double d[3] = { direction[0], direction[1], direction[2] };
+  if (vtkMath::Normalize(d) == 0.0)
+  {
+    vtkErrorMacro("AddRay: null direction for target " << target);
+    return -1;
+  }
+
+  const int index = this->Internal->GetOrCreateTarget(target);
+  this->Internal->AddRay(index, origin, d);
+  this->Modified();
+  return index;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraRayTriangulation::AddFrameRays(vtkMRMLVideoCameraNode* camera, vtkMatrix4x4* cameraToReference, vtkDoubleArray* pixels, vtkStringArray* labels)
+{
+  if (camera == nullptr || cameraToReference == nullptr || pixels == nullptr || labels == nullptr)
+  {
+    vtkErrorMacro("AddFrameRays: camera, pose, pixels and labels are required");
+    return 0;
+  }
+  if (labels->GetNumberOfValues() != pixels->GetNumberOfTuples())
+  {
+    vtkErrorMacro("AddFrameRays: " << pixels->GetNumberOfTuples() << " pixels but " << labels->GetNumberOfValues() << " labels");
+    return 0;
+  }
+
+  vtkNew<vtkDoubleArray> rays;
+  if (!vtkSlicerVideoCameraProjection::BackProjectPixels(camera, pixels, rays.GetPointer()))
+  {
+    vtkErrorMacro("AddFrameRays: camera " << (camera->GetName() ? camera->GetName() : "") << " has no valid intrinsics");
+    return 0;
+  }
+
+  // image sensor to reference, as in single target mode
+  vtkNew<vtkMatrix4x4> sensorToReference;
+  if (camera->GetMarkerToImageSensorTransform() != nullptr)
+  {
+    vtkMatrix4x4::Invert(camera->GetMarkerToImageSensorTransform(), sensorToReference.GetPointer());
+  }
+  vtkMatrix4x4::Multiply4x4(cameraToReference, sensorToReference.GetPointer(), sensorToReference.GetPointer());
+
+  double originSensor[4] = { 0.0, 0.0, 0.0, 1.0 };
+  vtkDoubleArray* offset = camera->GetCameraPlaneOffset();
+  for (int i = 0; offset != nullptr && i < 3 && i < offset->GetNumberOfValues(); ++i)
+  {
+    originSensor[i] = offset->GetValue(i);
+  }
+  double origin[4];
+  sensorToReference->MultiplyPoint(originSensor, origin);
+
+  int added = 0;
+  const double* ray = rays->GetPointer(0);
+  for (vtkIdType i = 0; i < pixels->GetNumberOfTuples(); ++i, ray += 3)
+  {
+    if (vtkMath::IsNan(ray[0]) || labels->GetValue(i).empty())
+    {
+      continue;
+    }
+    const double directionSensor[4] = { ray[0], ray[1], ray[2], 0.0 };
+    double direction[4];
+    sensorToReference->MultiplyPoint(directionSensor, direction);
+    if (vtkMath::Normalize(direction) == 0.0)
+    {
+      continue;
+    }
+
+    const int index = this->Internal->GetOrCreateTarget(labels->GetValue(i));
+    this->Internal->AddRay(index, origin, direction);
+    ++added;
+  }
+
+  if (added > 0)
+  {
+    this->Modified();
+  }
+  return added;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraRayTriangulation::GetNumberOfTargets() const
+{
+  return static_cast<int>(this->Internal->Targets.size());
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerVideoCameraRayTriangulation::GetTargetName(int target) const
+{
+  if (target < 0 || target >= this->GetNumberOfTargets())
+  {
+    return nullptr;
+  }
+  return this->Internal->Targets[target].Name.c_str();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraRayTriangulation::GetTargetIndex(const char* target) const
+{
+  if (target == nullptr)
+  {
+    return -1;
+  }
+  std::map<std::string, int>::const_iterator it = this->Internal->TargetIndices.find(target);
+  return it == this->Internal->TargetIndices.end() ? -1 : it->second;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraRayTriangulation::GetNumberOfRays(int target) const
+{
+  if (target < 0 || target >= this->GetNumberOfTargets())
+  {
+    return 0;
+  }
+  return static_cast<int>(this->Internal->Targets[target].Rays.size() / RaySize);
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraRayTriangulation::Solve()
+{
+  std::vector<int> dirty;
+  for (int i = 0; i < this->GetNumberOfTargets(); ++i)
+  {
+    if (this->Internal->Targets[i].Dirty)
+    {
+      dirty.push_back(i);
+    }
+  }
+
+  SolveFunctor functor(this->Internal->Targets, dirty, this->MinimumNumberOfRays);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(dirty.size()), functor);
+
+  int valid = 0;
+  for (std::vector<Target>::const_iterator it = this->Internal->Targets.begin(); it != this->Internal->Targets.end(); ++it)
+  {
+    valid += it->Valid ? 1 : 0;
+  }
+  return valid;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraRayTriangulation::IsTargetValid(int target) const
+{
+  return target >= 0 && target < this->GetNumberOfTargets() && this->Internal->Targets[target].Valid;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraRayTriangulation::GetTargetPoint(int target, double point[3]) const
+{
+  if (!this->IsTargetValid(target))
+  {
+    return false;
+  }
+  const Target& t = this->Internal->Targets[target];
+  point[0] = t.Point[0];
+  point[1] = t.Point[1];
+  point[2] = t.Point[2];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraRayTriangulation::GetTargetError(int target) const
+{
+  if (!this->IsTargetValid(target))
+  {
+    return 0.0;
+  }
+  return this->Internal->Targets[target].Error;
+}
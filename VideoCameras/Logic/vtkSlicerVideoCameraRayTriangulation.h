@@ -0,0 +1,106 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraRayTriangulation.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraRayTriangulation - least-squares intersection of many labelled targets
+// .SECTION Description
+// Collects viewing rays in reference space for any number of named targets and computes, for
+// every target, the point closest to all of its rays. Each ray only adds its projector
+// (I - d d^T) to the 3x3 normal equations of its target, so adding rays is constant time and
+// solving is one 3x3 system per target. Targets are solved in parallel with vtkSMPTools, and
+// only the targets that received rays since the last solve are recomputed.
+//
+// A tracked frame contributes the rays of all its labelled pixels in one call: the pixels are
+// back-projected in one batch through the camera model of the node and moved to reference
+// space with the camera pose of that frame.
+
+#ifndef __vtkSlicerVideoCameraRayTriangulation_h
+#define __vtkSlicerVideoCameraRayTriangulation_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkDoubleArray;
+class vtkMatrix4x4;
+class vtkMRMLVideoCameraNode;
+class vtkStringArray;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraRayTriangulation : public vtkObject
+{
+public:
+  static vtkSlicerVideoCameraRayTriangulation* New();
+  vtkTypeMacro(vtkSlicerVideoCameraRayTriangulation, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Remove all targets and rays
+  void Reset();
+
+  ///
+  /// Add a ray (reference space) to a target, the target is created on first use
+  /// Returns the target index, -1 if the direction is null.
+  int AddRay(const char* target, const double origin[3], const double direction[3]);
+
+  ///
+  /// Add the rays of one tracked frame
+  /// pixels: raw image positions (2 components), labels: target name of every pixel
+  /// cameraToReference: pose of the tracked camera (marker) at the time of the frame
+  /// Rays start at the camera plane offset of the node and are moved to reference space with
+  /// cameraToReference * inverse(MarkerToImageSensorTransform), as in single target mode.
+  /// Returns the number of rays added, pixels outside the domain of the camera model are skipped.
+  int AddFrameRays(vtkMRMLVideoCameraNode* camera, vtkMatrix4x4* cameraToReference, vtkDoubleArray* pixels, vtkStringArray* labels);
+
+  ///
+  /// Targets, in order of creation
+  int GetNumberOfTargets() const;
+  const char* GetTargetName(int target) const;
+  int GetTargetIndex(const char* target) const;
+  int GetNumberOfRays(int target) const;
+
+  ///
+  /// Solve every target that received rays since the last call
+  /// Returns the number of targets with a valid intersection.
+  int Solve();
+
+  ///
+  /// Results of the last solve
+  /// A target is valid when it has at least MinimumNumberOfRays rays that are not all parallel.
+  /// The error is the mean distance from the point to the rays of the target.
+  bool IsTargetValid(int target) const;
+  bool GetTargetPoint(int target, double point[3]) const;
+  double GetTargetError(int target) const;
+
+  ///
+  /// Rays needed before a target is solved (default 3, as in single target mode)
+  vtkSetClampMacro(MinimumNumberOfRays, int, 2, VTK_INT_MAX);
+  vtkGetMacro(MinimumNumberOfRays, int);
+
+protected:
+  vtkSlicerVideoCameraRayTriangulation();
+  virtual ~vtkSlicerVideoCameraRayTriangulation();
+
+protected:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  int MinimumNumberOfRays;
+
+private:
+  vtkSlicerVideoCameraRayTriangulation(const vtkSlicerVideoCameraRayTriangulation&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraRayTriangulation&); // Not implemented
+};
+
+#endif
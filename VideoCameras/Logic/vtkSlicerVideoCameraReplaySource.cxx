@@ -0,0 +1,776 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraReplaySource.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraReplaySource.h"
+#include "vtkSlicerVideoCameraFrameProcessor.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// OpenCV includes
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraReplaySource);
+
+namespace
+{
+  typedef std::chrono::steady_clock Clock;
+
+  //----------------------------------------------------------------------------
+  double SecondsBetween(const Clock::time_point& from, const Clock::time_point& to)
+  {
+    return std::chrono::duration<double>(to - from).count();
+  }
+
+  //----------------------------------------------------------------------------
+  struct TrackerPose
+  {
+    double  Timestamp;
+    int     Tool;
+    double  Matrix[16];
+  };
+
+  //----------------------------------------------------------------------------
+  bool PoseBefore(const TrackerPose& a, const TrackerPose& b)
+  {
+    return a.Timestamp < b.Timestamp;
+  }
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCameraReplaySource::vtkInternal
+{
+public:
+  vtkInternal();
+
+  void CloseSource();
+  /// Read frame index into Frame, converted to RGB(A)
+  bool ReadFrame(int index);
+  void CopyFrameToImage();
+  void ApplyPoses(double trackerTime, vtkMRMLScene* scene);
+
+  // Source
+  cv::VideoCapture              Capture;
+  int                           CaptureIndex;
+  std::vector<std::string>      ImageFiles;
+  std::ifstream                 RawFile;
+  int                           RawSize[3];
+  int                           NumberOfFrames;
+  cv::Mat                       Frame;
+  vtkSmartPointer<vtkImageData> Image;
+
+  // Tracker log
+  std::vector<TrackerPose>      Poses;
+  std::vector<std::string>      ToolNames;
+  std::map<std::string, vtkWeakPointer<vtkMRMLLinearTransformNode> > ToolNodes;
+  size_t                        NextPose;
+
+  // Replay state
+  Clock::time_point             StartTime;
+  Clock::time_point             LastDeliveryTime;
+  int                           NextFrame;
+  int                           LoopBase;
+  double                        ReplayTime;
+  vtkIdType                     ProcessorDroppedAtStart;
+
+  // Statistics
+  int                           DeliveredFrames;
+  int                           SkippedFrames;
+  double                        TotalLateness;
+  double                        MaximumLateness;
+  double                        TotalFrameTime;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraReplaySource::vtkInternal::vtkInternal()
+  : CaptureIndex(0)
+  , NumberOfFrames(0)
+  , Image(vtkSmartPointer<vtkImageData>::New())
+  , NextPose(0)
+  , NextFrame(0)
+  , LoopBase(0)
+  , ReplayTime(0.0)
+  , ProcessorDroppedAtStart(0)
+  , DeliveredFrames(0)
+  , SkippedFrames(0)
+  , TotalLateness(0.0)
+  , MaximumLateness(0.0)
+  , TotalFrameTime(0.0)
+{
+  this->RawSize[0] = this->RawSize[1] = this->RawSize[2] = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::vtkInternal::CloseSource()
+{
+  this->Capture.release();
+  this->CaptureIndex = 0;
+  this->ImageFiles.clear();
+  if (this->RawFile.is_open())
+  {
+    this->RawFile.close();
+  }
+  this->RawFile.clear();
+  this->RawSize[0] = this->RawSize[1] = this->RawSize[2] = 0;
+  this->NumberOfFrames = 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReplaySource::vtkInternal::ReadFrame(int index)
+{
+  cv::Mat frame;
+  if (this->Capture.isOpened())
+  {
+    if (index < this->CaptureIndex)
+    {
+      this->Capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+      this->CaptureIndex = 0;
+    }
+    // grab without decoding the frames that are skipped
+    while (this->CaptureIndex < index)
+    {
+      if (!this->Capture.grab())
+      {
+        return false;
+      }
+      ++this->CaptureIndex;
+    }
+    if (!this->Capture.read(frame))
+    {
+      return false;
+    }
+    ++this->CaptureIndex;
+  }
+  else if (!this->ImageFiles.empty())
+  {
+    if (index < 0 || index >= static_cast<int>(this->ImageFiles.size()))
+    {
+      return false;
+    }
+    frame = cv::imread(this->ImageFiles[index], cv::IMREAD_UNCHANGED);
+  }
+  else if (this->RawFile.is_open())
+  {
+    // raw frames are stored as they are written to the volume, no color conversion
+    const std::streamoff frameBytes = static_cast<std::streamoff>(this->RawSize[0]) * this->RawSize[1] * this->RawSize[2];
+    this->Frame.create(this->RawSize[1], this->RawSize[0], CV_8UC(this->RawSize[2]));
+    this->RawFile.clear();
+    this->RawFile.seekg(frameBytes * index, std::ios::beg);
+    this->RawFile.read(reinterpret_cast<char*>(this->Frame.data), frameBytes);
+    return this->RawFile.gcount() == frameBytes;
+  }
+
+  if (frame.empty() || frame.depth() != CV_8U)
+  {
+    return false;
+  }
+  switch (frame.channels())
+  {
+    case 1:
+      this->Frame = frame;
+      break;
+    case 3:
+      cv::cvtColor(frame, this->Frame, cv::COLOR_BGR2RGB);
+      break;
+    case 4:
+      cv::cvtColor(frame, this->Frame, cv::COLOR_BGRA2RGBA);
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::vtkInternal::CopyFrameToImage()
+{
+  const int components = this->Frame.channels();
+  int* dimensions = this->Image->GetDimensions();
+  if (dimensions[0] != this->Frame.cols || dimensions[1] != this->Frame.rows || dimensions[2] != 1 ||
+      this->Image->GetNumberOfScalarComponents() != components || this->Image->GetScalarType() != VTK_UNSIGNED_CHAR)
+  {
+    this->Image->SetDimensions(this->Frame.cols, this->Frame.rows, 1);
+    this->Image->AllocateScalars(VTK_UNSIGNED_CHAR, components);
+  }
+
+  // rows are copied in order, frame row j is buffer row j (pixel convention of
+  // vtkSlicerVideoCameraProjection.h), as for live frames and the calibration images
+  const size_t rowBytes = static_cast<size_t>(this->Frame.cols) * components;
+  for (int row = 0; row < this->Frame.rows; ++row)
+  {
+    std::memcpy(this->Image->GetScalarPointer(0, row, 0), this->Frame.ptr(row), rowBytes);
+  }
+  this->Image->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::vtkInternal::ApplyPoses(double trackerTime, vtkMRMLScene* scene)
+{
+  // only the latest pose of each tool is applied
+  std::vector<int> latest(this->ToolNames.size(), -1);
+  while (this->NextPose < this->Poses.size() && this->Poses[this->NextPose].Timestamp <= trackerTime)
+  {
+    latest[this->Poses[this->NextPose].Tool] = static_cast<int>(this->NextPose);
+    ++this->NextPose;
+  }
+
+  vtkNew<vtkMatrix4x4> matrix;
+  for (size_t tool = 0; tool < latest.size(); ++tool)
+  {
+    if (latest[tool] < 0)
+    {
+      continue;
+    }
+    vtkWeakPointer<vtkMRMLLinearTransformNode>& node = this->ToolNodes[this->ToolNames[tool]];
+    if (node == nullptr)
+    {
+      if (scene == nullptr)
+      {
+        continue;
+      }
+      node = vtkMRMLLinearTransformNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLLinearTransformNode", this->ToolNames[tool]));
+    }
+    matrix->DeepCopy(this->Poses[latest[tool]].Matrix);
+    node->SetMatrixTransformToParent(matrix.GetPointer());
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraReplaySource::vtkSlicerVideoCameraReplaySource()
+  : SourceType(NoSource)
+  , OutputVolumeNode(nullptr)
+  , FrameProcessor(nullptr)
+  , FrameRate(30.0)
+  , PlaybackRate(1.0)
+  , Loop(false)
+  , Playing(false)
+  , AlignFirstPose(false)
+  , TrackerTimeOffset(0.0)
+  , Internal(new vtkInternal)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraReplaySource::~vtkSlicerVideoCameraReplaySource()
+{
+  this->Close();
+  this->SetOutputVolumeNode(nullptr);
+  this->SetFrameProcessor(nullptr);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "SourceType: " << this->SourceType << std::endl;
+  os << indent << "NumberOfFrames: " << this->GetNumberOfFrames() << std::endl;
+  os << indent << "NumberOfTrackerPoses: " << this->GetNumberOfTrackerPoses() << std::endl;
+  os << indent << "OutputVolumeNode: " << (this->OutputVolumeNode ? this->OutputVolumeNode->GetID() : "(none)") << std::endl;
+  os << indent << "FrameProcessor: " << this->FrameProcessor << std::endl;
+  os << indent << "FrameRate: " << this->FrameRate << std::endl;
+  os << indent << "PlaybackRate: " << this->PlaybackRate << std::endl;
+  os << indent << "Loop: " << this->Loop << std::endl;
+  os << indent << "Playing: " << this->Playing << std::endl;
+  os << indent << "AlignFirstPose: " << this->AlignFirstPose << std::endl;
+  os << indent << "TrackerTimeOffset: " << this->TrackerTimeOffset << std::endl;
+  os << indent << "DeliveredFrames: " << this->GetNumberOfDeliveredFrames() << std::endl;
+  os << indent << "SkippedFrames: " << this->GetNumberOfSkippedFrames() << std::endl;
+  os << indent << "MeanLateness: " << this->GetMeanLateness() << std::endl;
+  os << indent << "MaximumLateness: " << this->GetMaximumLateness() << std::endl;
+  os << indent << "MeanFrameTime: " << this->GetMeanFrameTime() << std::endl;
+  os << indent << "AchievedFrameRate: " << this->GetAchievedFrameRate() << std::endl;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReplaySource::OpenVideoFile(const char* fileName)
+{
+  this->Close();
+  if (fileName == nullptr || !this->Internal->Capture.open(fileName))
+  {
+    vtkErrorMacro("OpenVideoFile: cannot open " << (fileName ? fileName : "(null)"));
+    return false;
+  }
+
+  // the frame count is an estimate for some containers, the end is also detected on read
+  const double frameCount = this->Internal->Capture.get(cv::CAP_PROP_FRAME_COUNT);
+  this->Internal->NumberOfFrames = frameCount > 0 ? static_cast<int>(frameCount) : std::numeric_limits<int>::max();
+  const double fps = this->Internal->Capture.get(cv::CAP_PROP_FPS);
+  if (fps > 0.0)
+  {
+    this->SetFrameRate(fps);
+  }
+  this->SourceType = VideoFileSource;
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReplaySource::OpenImageDirectory(const char* directory)
+{
+  this->Close();
+  vtksys::Directory dir;
+  if (directory == nullptr || !dir.Load(directory))
+  {
+    vtkErrorMacro("OpenImageDirectory: cannot read " << (directory ? directory : "(null)"));
+    return false;
+  }
+
+  for (unsigned long i = 0; i < dir.GetNumberOfFiles(); ++i)
+  {
+    const std::string extension = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(dir.GetFile(i)));
+    if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" ||
+        extension == ".tif" || extension == ".tiff")
+    {
+      this->Internal->ImageFiles.push_back(std::string(directory) + "/" + dir.GetFile(i));
+    }
+  }
+  if (this->Internal->ImageFiles.empty())
+  {
+    vtkErrorMacro("OpenImageDirectory: no images in " << directory);
+    return false;
+  }
+
+  std::sort(this->Internal->ImageFiles.begin(), this->Internal->ImageFiles.end());
+  this->Internal->NumberOfFrames = static_cast<int>(this->Internal->ImageFiles.size());
+  this->SourceType = ImageDirectorySource;
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReplaySource::OpenRawFrames(const char* fileName, int width, int height, int components)
+{
+  this->Close();
+  if (width <= 0 || height <= 0 || components < 1 || components > 4)
+  {
+    vtkErrorMacro("OpenRawFrames: invalid frame size " << width << "x" << height << "x" << components);
+    return false;
+  }
+  if (fileName != nullptr)
+  {
+    this->Internal->RawFile.open(fileName, std::ios::in | std::ios::binary);
+  }
+  if (!this->Internal->RawFile.is_open())
+  {
+    vtkErrorMacro("OpenRawFrames: cannot open " << (fileName ? fileName : "(null)"));
+    return false;
+  }
+
+  const std::streamoff frameBytes = static_cast<std::streamoff>(width) * height * components;
+  this->Internal->RawFile.seekg(0, std::ios::end);
+  const std::streamoff fileBytes = this->Internal->RawFile.tellg();
+  if (fileBytes < frameBytes)
+  {
+    vtkErrorMacro("OpenRawFrames: " << fileName << " is smaller than one frame");
+    this->Internal->CloseSource();
+    return false;
+  }
+  if (fileBytes % frameBytes != 0)
+  {
+    vtkWarningMacro("OpenRawFrames: " << fileName << " ends with a partial frame, it is ignored");
+  }
+
+  this->Internal->RawSize[0] = width;
+  this->Internal->RawSize[1] = height;
+  this->Internal->RawSize[2] = components;
+  this->Internal->NumberOfFrames = static_cast<int>(fileBytes / frameBytes);
+  this->SourceType = RawFrameSource;
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::Close()
+{
+  this->Stop();
+  this->Internal->CloseSource();
+  if (this->SourceType != NoSource)
+  {
+    this->SourceType = NoSource;
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraReplaySource::GetNumberOfFrames() const
+{
+  return this->Internal->NumberOfFrames;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReplaySource::LoadTrackerLog(const char* fileName)
+{
+  std::ifstream file;
+  if (fileName != nullptr)
+  {
+    file.open(fileName);
+  }
+  if (!file.is_open())
+  {
+    vtkErrorMacro("LoadTrackerLog: cannot open " << (fileName ? fileName : "(null)"));
+    return false;
+  }
+
+  std::vector<TrackerPose> poses;
+  std::vector<std::string> toolNames;
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(file, line))
+  {
+    ++lineNumber;
+    const std::string::size_type first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#')
+    {
+      continue;
+    }
+
+    std::istringstream stream(line);
+    TrackerPose pose;
+    std::string toolName;
+    stream >> pose.Timestamp >> toolName;
+    for (int i = 0; i < 16; ++i)
+    {
+      stream >> pose.Matrix[i];
+    }
+    if (stream.fail())
+    {
+      vtkErrorMacro("LoadTrackerLog: " << fileName << ":" << lineNumber << ": expected timestamp, tool name and 16 matrix values");
+      return false;
+    }
+
+    std::vector<std::string>::iterator it = std::find(toolNames.begin(), toolNames.end(), toolName);
+    pose.Tool = static_cast<int>(it - toolNames.begin());
+    if (it == toolNames.end())
+    {
+      toolNames.push_back(toolName);
+    }
+    poses.push_back(pose);
+  }
+
+  std::stable_sort(poses.begin(), poses.end(), PoseBefore);
+  this->Internal->Poses.swap(poses);
+  this->Internal->ToolNames.swap(toolNames);
+  this->Internal->NextPose = 0;
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraReplaySource::GetNumberOfTrackerPoses() const
+{
+  return static_cast<int>(this->Internal->Poses.size());
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraReplaySource::GetTrackerTime(double replayTime) const
+{
+  if (!this->AlignFirstPose)
+  {
+    return replayTime + this->TrackerTimeOffset;
+  }
+  // poses are sorted by timestamp
+  return replayTime + (this->Internal->Poses.empty() ? 0.0 : this->Internal->Poses.front().Timestamp);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::SetToolTransformNode(const char* toolName, vtkMRMLLinearTransformNode* node)
+{
+  if (toolName == nullptr)
+  {
+    return;
+  }
+  this->Internal->ToolNodes[toolName] = node;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLLinearTransformNode* vtkSlicerVideoCameraReplaySource::GetToolTransformNode(const char* toolName) const
+{
+  if (toolName == nullptr)
+  {
+    return nullptr;
+  }
+  std::map<std::string, vtkWeakPointer<vtkMRMLLinearTransformNode> >::const_iterator it = this->Internal->ToolNodes.find(toolName);
+  return it != this->Internal->ToolNodes.end() ? it->second.GetPointer() : nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::SetOutputVolumeNode(vtkMRMLScalarVolumeNode* node)
+{
+  if (this->OutputVolumeNode == node)
+  {
+    return;
+  }
+
+  if (this->OutputVolumeNode != nullptr)
+  {
+    this->OutputVolumeNode->UnRegister(this);
+  }
+
+  this->OutputVolumeNode = node;
+
+  if (this->OutputVolumeNode != nullptr)
+  {
+    this->OutputVolumeNode->Register(this);
+  }
+
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::SetFrameProcessor(vtkSlicerVideoCameraFrameProcessor* processor)
+{
+  if (this->FrameProcessor == processor)
+  {
+    return;
+  }
+
+  if (this->FrameProcessor != nullptr)
+  {
+    this->FrameProcessor->UnRegister(this);
+  }
+
+  this->FrameProcessor = processor;
+
+  if (this->FrameProcessor != nullptr)
+  {
+    this->FrameProcessor->Register(this);
+  }
+
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReplaySource::Start()
+{
+  if (this->SourceType == NoSource)
+  {
+    vtkErrorMacro("Start: no frame source is open");
+    return false;
+  }
+
+  this->Internal->NextFrame = 0;
+  this->Internal->LoopBase = 0;
+  this->Internal->NextPose = 0;
+  this->Internal->ReplayTime = 0.0;
+  this->ResetStatistics();
+  this->Internal->StartTime = Clock::now();
+  this->Internal->LastDeliveryTime = this->Internal->StartTime;
+  this->Playing = true;
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::Stop()
+{
+  if (this->Playing)
+  {
+    this->Playing = false;
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraReplaySource::Update()
+{
+  if (!this->Playing)
+  {
+    return 0;
+  }
+
+  vtkInternal* internal = this->Internal;
+  const Clock::time_point now = Clock::now();
+  vtkMRMLScene* scene = this->OutputVolumeNode ? this->OutputVolumeNode->GetScene() : nullptr;
+
+  // frame due now, relative to the current loop
+  int target = internal->NextFrame;
+  if (this->PlaybackRate > 0.0)
+  {
+    const double elapsed = SecondsBetween(internal->StartTime, now) * this->PlaybackRate;
+    internal->ReplayTime = elapsed - internal->LoopBase / this->FrameRate;
+    target = static_cast<int>(std::floor(elapsed * this->FrameRate)) - internal->LoopBase;
+  }
+
+  while (target >= internal->NumberOfFrames)
+  {
+    if (!this->Loop)
+    {
+      internal->ApplyPoses(std::numeric_limits<double>::infinity(), scene);
+      this->Stop();
+      return 0;
+    }
+    internal->SkippedFrames += internal->NumberOfFrames - internal->NextFrame;
+    internal->LoopBase += internal->NumberOfFrames;
+    internal->ReplayTime -= internal->NumberOfFrames / this->FrameRate;
+    internal->NextFrame = 0;
+    internal->NextPose = 0;
+    target -= internal->NumberOfFrames;
+  }
+  if (this->PlaybackRate <= 0.0)
+  {
+    internal->ReplayTime = target / this->FrameRate;
+  }
+
+  internal->ApplyPoses(this->GetTrackerTime(internal->ReplayTime), scene);
+
+  if (target < internal->NextFrame)
+  {
+    // next frame not due yet
+    return 0;
+  }
+
+  if (!internal->ReadFrame(target))
+  {
+    if (this->SourceType == VideoFileSource && target > 0)
+    {
+      // the container overestimated the frame count, the next Update handles the end
+      internal->NumberOfFrames = target;
+      return 0;
+    }
+    vtkErrorMacro("Update: cannot read frame " << target);
+    this->Stop();
+    return 0;
+  }
+
+  internal->SkippedFrames += target - internal->NextFrame;
+  internal->NextFrame = target + 1;
+
+  internal->CopyFrameToImage();
+  if (this->OutputVolumeNode != nullptr && this->OutputVolumeNode->GetImageData() != internal->Image)
+  {
+    this->OutputVolumeNode->SetAndObserveImageData(internal->Image);
+  }
+  if (this->FrameProcessor != nullptr)
+  {
+    this->FrameProcessor->PushFrame(internal->Image, (internal->LoopBase + target) / this->FrameRate);
+  }
+
+  const Clock::time_point done = Clock::now();
+  if (this->PlaybackRate > 0.0)
+  {
+    const double due = (internal->LoopBase + target) / (this->FrameRate * this->PlaybackRate);
+    const double lateness = std::max(0.0, SecondsBetween(internal->StartTime, now) - due);
+    internal->TotalLateness += lateness;
+    internal->MaximumLateness = std::max(internal->MaximumLateness, lateness);
+  }
+  internal->TotalFrameTime += SecondsBetween(now, done);
+  internal->LastDeliveryTime = done;
+  ++internal->DeliveredFrames;
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraReplaySource::GetReplayTime() const
+{
+  return this->Internal->ReplayTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraReplaySource::GetNumberOfDeliveredFrames() const
+{
+  return this->Internal->DeliveredFrames;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraReplaySource::GetNumberOfSkippedFrames() const
+{
+  return this->Internal->SkippedFrames;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraReplaySource::GetMeanLateness() const
+{
+  return this->Internal->DeliveredFrames > 0 ? this->Internal->TotalLateness / this->Internal->DeliveredFrames : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraReplaySource::GetMaximumLateness() const
+{
+  return this->Internal->MaximumLateness;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraReplaySource::GetMeanFrameTime() const
+{
+  return this->Internal->DeliveredFrames > 0 ? this->Internal->TotalFrameTime / this->Internal->DeliveredFrames : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraReplaySource::GetAchievedFrameRate() const
+{
+  const double elapsed = SecondsBetween(this->Internal->StartTime, this->Internal->LastDeliveryTime);
+  return elapsed > 0.0 ? this->Internal->DeliveredFrames / elapsed : 0.0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReplaySource::IsKeepingUp() const
+{
+  if (this->Internal->DeliveredFrames == 0 || this->Internal->SkippedFrames > 0)
+  {
+    return false;
+  }
+  // frames the pipeline dropped at its input were not kept up with either
+  if (this->FrameProcessor != nullptr &&
+      this->FrameProcessor->GetNumberOfDroppedFrames() > this->Internal->ProcessorDroppedAtStart)
+  {
+    return false;
+  }
+  if (this->PlaybackRate <= 0.0)
+  {
+    return this->GetAchievedFrameRate() >= this->FrameRate;
+  }
+  return this->GetMeanFrameTime() < 1.0 / (this->FrameRate * this->PlaybackRate);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReplaySource::ResetStatistics()
+{
+  this->Internal->DeliveredFrames = 0;
+  this->Internal->SkippedFrames = 0;
+  this->Internal->TotalLateness = 0.0;
+  this->Internal->MaximumLateness = 0.0;
+  this->Internal->TotalFrameTime = 0.0;
+  this->Internal->ProcessorDroppedAtStart = this->FrameProcessor ? this->FrameProcessor->GetNumberOfDroppedFrames() : 0;
+}
@@ -0,0 +1,177 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraReplaySource.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraReplaySource - plays recorded video and tracking for load testing
+// .SECTION Description
+// Replays a video file, a directory of images or a raw frame dump into a scalar volume node (and
+// optionally a frame processor), together with a timestamped tracker pose log played into linear
+// transform nodes, at real time or an accelerated rate. Update must be called periodically on the
+// main thread (e.g. from a timer); it delivers the frame due at the current replay time. Frames
+// that became due while the previous Update was still running are skipped and counted, so the
+// statistics tell whether the extension keeps up with the configured rate.
+//
+// Frame i is due at i / FrameRate seconds of replay time. The pose log is a text file with one
+// pose per line: timestamp (seconds, in the time base of the tracker), tool name and the 16
+// values of the row major 4x4 ToolToReference matrix. Lines starting with # are ignored. The
+// poses applied with a frame are those up to the tracker time of the frame, its replay time plus
+// the tracker time of the first frame: TrackerTimeOffset, or the timestamp of the first pose with
+// AlignFirstPose so that logs with absolute tracker timestamps start with the video.
+//
+// A raw frame dump is the concatenation of width x height x components unsigned char frames.
+// Frames are delivered without flipping: the first row of a frame is row 0 of the image buffer.
+
+#ifndef __vtkSlicerVideoCameraReplaySource_h
+#define __vtkSlicerVideoCameraReplaySource_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkMRMLLinearTransformNode;
+class vtkMRMLScalarVolumeNode;
+class vtkSlicerVideoCameraFrameProcessor;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraReplaySource : public vtkObject
+{
+public:
+  enum SourceType
+  {
+    NoSource = 0,
+    VideoFileSource,
+    ImageDirectorySource,
+    RawFrameSource
+  };
+
+  static vtkSlicerVideoCameraReplaySource* New();
+  vtkTypeMacro(vtkSlicerVideoCameraReplaySource, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Open a frame source, replacing the current one. FrameRate is set from the video file.
+  bool OpenVideoFile(const char* fileName);
+  /// Images (png, jpg, bmp, tif) of a directory, in file name order
+  bool OpenImageDirectory(const char* directory);
+  bool OpenRawFrames(const char* fileName, int width, int height, int components);
+  void Close();
+  vtkGetMacro(SourceType, int);
+  int GetNumberOfFrames() const;
+
+  ///
+  /// Read a tracker pose log, replacing the current one
+  bool LoadTrackerLog(const char* fileName);
+  int GetNumberOfTrackerPoses() const;
+
+  ///
+  /// Tracker time of the first frame is the timestamp of the first pose of the log (default off)
+  /// Only correct when the tracker and the video started recording together.
+  vtkSetMacro(AlignFirstPose, bool);
+  vtkGetMacro(AlignFirstPose, bool);
+  vtkBooleanMacro(AlignFirstPose, bool);
+
+  ///
+  /// Tracker time of the first frame when AlignFirstPose is off (default 0, i.e. the log uses
+  /// replay time), e.g. the tracker time the video started at
+  vtkSetMacro(TrackerTimeOffset, double);
+  vtkGetMacro(TrackerTimeOffset, double);
+
+  ///
+  /// Time in the pose log that corresponds to a replay time
+  double GetTrackerTime(double replayTime) const;
+
+  ///
+  /// Transform node a tool is played into. Tools without a node get a new one, named after the
+  /// tool, in the scene of the output volume node.
+  void SetToolTransformNode(const char* toolName, vtkMRMLLinearTransformNode* node);
+  vtkMRMLLinearTransformNode* GetToolTransformNode(const char* toolName) const;
+
+  ///
+  /// Volume the frames are written to
+  void SetOutputVolumeNode(vtkMRMLScalarVolumeNode* node);
+  vtkGetObjectMacro(OutputVolumeNode, vtkMRMLScalarVolumeNode);
+
+  ///
+  /// Optional pipeline every delivered frame is also pushed to
+  void SetFrameProcessor(vtkSlicerVideoCameraFrameProcessor* processor);
+  vtkGetObjectMacro(FrameProcessor, vtkSlicerVideoCameraFrameProcessor);
+
+  ///
+  /// Frames per second of the recording (default 30)
+  vtkSetClampMacro(FrameRate, double, 0.001, 10000.0);
+  vtkGetMacro(FrameRate, double);
+
+  ///
+  /// Replay speed: 1 is real time, 2 twice as fast. 0 delivers the next frame on every Update,
+  /// as fast as the caller can go, without skipping.
+  vtkSetClampMacro(PlaybackRate, double, 0.0, 1000.0);
+  vtkGetMacro(PlaybackRate, double);
+
+  vtkSetMacro(Loop, bool);
+  vtkGetMacro(Loop, bool);
+  vtkBooleanMacro(Loop, bool);
+
+  ///
+  /// Start replaying from the first frame, resets the statistics
+  bool Start();
+  void Stop();
+  vtkGetMacro(Playing, bool);
+
+  ///
+  /// Deliver the frame and poses due at the current replay time, returns the number of frames
+  /// delivered (0 or 1). Stops at the end of the recording unless looping.
+  int Update();
+
+  ///
+  /// Replay time, in seconds of recording
+  double GetReplayTime() const;
+
+  ///
+  /// Statistics since Start
+  /// Lateness is how long after its due time a frame was delivered, frame time how long delivering
+  /// it took (decode, MRML update and observers).
+  int GetNumberOfDeliveredFrames() const;
+  int GetNumberOfSkippedFrames() const;
+  double GetMeanLateness() const;
+  double GetMaximumLateness() const;
+  double GetMeanFrameTime() const;
+  double GetAchievedFrameRate() const;
+  /// True when no frame was skipped and delivering a frame takes less than a frame period
+  bool IsKeepingUp() const;
+  void ResetStatistics();
+
+protected:
+  vtkSlicerVideoCameraReplaySource();
+  virtual ~vtkSlicerVideoCameraReplaySource();
+
+protected:
+  int                                 SourceType;
+  vtkMRMLScalarVolumeNode*            OutputVolumeNode;
+  vtkSlicerVideoCameraFrameProcessor* FrameProcessor;
+  double                              FrameRate;
+  double                              PlaybackRate;
+  bool                                Loop;
+  bool                                Playing;
+  bool                                AlignFirstPose;
+  double                              TrackerTimeOffset;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSlicerVideoCameraReplaySource(const vtkSlicerVideoCameraReplaySource&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraReplaySource&); // Not implemented
+};
+
+#endif
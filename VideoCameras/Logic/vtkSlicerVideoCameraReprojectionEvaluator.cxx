@@ -0,0 +1,398 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraReprojectionEvaluator.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraReprojectionEvaluator.h"
+#include "vtkSlicerVideoCameraProjection.h"
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkVideoCameraObservations.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix3x3.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// OpenCV includes
+#include <opencv2/calib3d.hpp>
+
+// STD includes
+#include <cmath>
+#include <limits>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraReprojectionEvaluator);
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Coefficient counts cv::solvePnP accepts for the pinhole model
+  bool IsPnPDistortionCount(int count)
+  {
+    return count == 0 || count == 4 || count == 5 || count == 8 || count == 12 || count == 14;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Per thread buffers of one view
+  struct ViewScratch
+  {
+    vtkSmartPointer<vtkDoubleArray> Pixels;
+    vtkSmartPointer<vtkDoubleArray> Rays;
+    vtkSmartPointer<vtkDoubleArray> CameraPoints;
+    vtkSmartPointer<vtkDoubleArray> Projected;
+    std::vector<cv::Point3d>        PnPObjectPoints;
+    std::vector<cv::Point2d>        PnPImagePoints;
+
+    ViewScratch()
+      : Pixels(vtkSmartPointer<vtkDoubleArray>::New())
+      , Rays(vtkSmartPointer<vtkDoubleArray>::New())
+      , CameraPoints(vtkSmartPointer<vtkDoubleArray>::New())
+      , Projected(vtkSmartPointer<vtkDoubleArray>::New())
+    {
+      this->Pixels->SetNumberOfComponents(2);
+      this->CameraPoints->SetNumberOfComponents(3);
+    }
+  };
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCameraReprojectionEvaluator::vtkInternal
+{
+public:
+  vtkInternal();
+
+  /// Evaluate one view, returns false if it has too few usable points or PnP failed
+  bool EvaluateView(vtkMRMLVideoCameraNode* camera, vtkVideoCameraObservations* observations, int view, ViewScratch& scratch);
+
+  vtkSmartPointer<vtkDoubleArray> CornerResiduals;
+  vtkSmartPointer<vtkDoubleArray> ViewErrors;
+
+  /// Board to camera (row major 3x4) of every view
+  std::vector<double> ViewPoses;
+  /// Sum of squared residuals and number of finite residuals of every view
+  std::vector<double> ViewSquaredSums;
+  std::vector<vtkIdType> ViewCounts;
+
+  /// Settings of the current evaluation
+  int MinimumNumberOfPoints;
+  bool UsePixels;
+  cv::Mat CameraMatrix;
+  cv::Mat DistortionCoefficients;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraReprojectionEvaluator::vtkInternal::vtkInternal()
+  : CornerResiduals(vtkSmartPointer<vtkDoubleArray>::New())
+  , ViewErrors(vtkSmartPointer<vtkDoubleArray>::New())
+  , MinimumNumberOfPoints(4)
+  , UsePixels(true)
+{
+  this->CornerResiduals->SetNumberOfComponents(2);
+  this->CornerResiduals->SetName("CornerResiduals");
+  this->ViewErrors->SetName("ViewErrors");
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReprojectionEvaluator::vtkInternal::EvaluateView(vtkMRMLVideoCameraNode* camera, vtkVideoCameraObservations* observations, int view, ViewScratch& scratch)
+{
+  const vtkIdType offset = observations->GetViewPointOffset(view);
+  const vtkIdType numberOfPoints = observations->GetViewNumberOfPoints(view);
+  if (numberOfPoints < this->MinimumNumberOfPoints)
+  {
+    return false;
+  }
+
+  // object points are read in place, either per view or through the board ids
+  const float* imagePoints = observations->GetImagePoints()->GetPointer(2 * offset);
+  const float* objectPoints = nullptr;
+  const int* ids = nullptr;
+  const float* boardPoints = nullptr;
+  vtkIdType numberOfBoardPoints = 0;
+  if (observations->GetObjectPoints()->GetNumberOfTuples() > 0)
+  {
+    objectPoints = observations->GetObjectPoints()->GetPointer(3 * offset);
+  }
+  else
+  {
+    ids = observations->GetIds()->GetPointer(offset);
+    boardPoints = observations->GetBoardPoints()->GetPointer(0);
+    numberOfBoardPoints = observations->GetBoardPoints()->GetNumberOfTuples();
+    for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+      if (ids[i] < 0 || ids[i] >= numberOfBoardPoints)
+      {
+        return false;
+      }
+    }
+  }
+
+  double* pixels = scratch.Pixels->WritePointer(0, 2 * numberOfPoints);
+  for (vtkIdType i = 0; i < 2 * numberOfPoints; ++i)
+  {
+    pixels[i] = imagePoints[i];
+  }
+
+  // PnP on the raw pixels with the distortion of the node, or on the normalized rays
+  const double* rays = nullptr;
+  if (!this->UsePixels)
+  {
+    if (!vtkSlicerVideoCameraProjection::BackProjectPixels(camera, scratch.Pixels, scratch.Rays))
+    {
+      return false;
+    }
+    rays = scratch.Rays->GetPointer(0);
+  }
+  scratch.PnPObjectPoints.clear();
+  scratch.PnPImagePoints.clear();
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    const float* objectPoint = objectPoints != nullptr ? objectPoints + 3 * i : boardPoints + 3 * ids[i];
+    if (rays == nullptr)
+    {
+      scratch.PnPImagePoints.push_back(cv::Point2d(pixels[2 * i], pixels[2 * i + 1]));
+    }
+    else if (!vtkMath::IsNan(rays[3 * i]) && rays[3 * i + 2] > 0.0)
+    {
+      scratch.PnPImagePoints.push_back(cv::Point2d(rays[3 * i] / rays[3 * i + 2], rays[3 * i + 1] / rays[3 * i + 2]));
+    }
+    else
+    {
+      continue;
+    }
+    scratch.PnPObjectPoints.push_back(cv::Point3d(objectPoint[0], objectPoint[1], objectPoint[2]));
+  }
+  if (static_cast<int>(scratch.PnPObjectPoints.size()) < this->MinimumNumberOfPoints)
+  {
+    return false;
+  }
+
+  cv::Mat rvec;
+  cv::Mat tvec;
+  const bool solved = rays == nullptr
+    ? cv::solvePnP(scratch.PnPObjectPoints, scratch.PnPImagePoints, this->CameraMatrix, this->DistortionCoefficients, rvec, tvec)
+    : cv::solvePnP(scratch.PnPObjectPoints, scratch.PnPImagePoints, cv::Mat::eye(3, 3, CV_64F), cv::Mat(), rvec, tvec);
+  if (!solved)
+  {
+    return false;
+  }
+  cv::Mat rotation;
+  cv::Rodrigues(rvec, rotation);
+  double* pose = &this->ViewPoses[12 * view];
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      pose[4 * i + j] = rotation.at<double>(i, j);
+    }
+    pose[4 * i + 3] = tvec.at<double>(i, 0);
+  }
+
+  // project every board point of the view with the full camera model
+  double* cameraPoints = scratch.CameraPoints->WritePointer(0, 3 * numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    const float* p = objectPoints != nullptr ? objectPoints + 3 * i : boardPoints + 3 * ids[i];
+    for (int k = 0; k < 3; ++k)
+    {
+      cameraPoints[3 * i + k] = pose[4 * k] * p[0] + pose[4 * k + 1] * p[1] + pose[4 * k + 2] * p[2] + pose[4 * k + 3];
+    }
+  }
+  if (!vtkSlicerVideoCameraProjection::ProjectPoints(camera, scratch.CameraPoints, scratch.Projected))
+  {
+    return false;
+  }
+
+  // residuals of the view go to its own range of the packed array
+  const double* projected = scratch.Projected->GetPointer(0);
+  double* residuals = this->CornerResiduals->GetPointer(2 * offset);
+  for (vtkIdType i = 0; i < 2 * numberOfPoints; ++i)
+  {
+    residuals[i] = projected[i] - pixels[i];
+  }
+  double sum = 0.0;
+  vtkIdType count = 0;
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    const double squared = residuals[2 * i] * residuals[2 * i] + residuals[2 * i + 1] * residuals[2 * i + 1];
+    if (!vtkMath::IsNan(squared))
+    {
+      sum += squared;
+      ++count;
+    }
+  }
+  if (count == 0)
+  {
+    return false;
+  }
+  this->ViewSquaredSums[view] = sum;
+  this->ViewCounts[view] = count;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraReprojectionEvaluator::vtkSlicerVideoCameraReprojectionEvaluator()
+  : MinimumNumberOfPoints(4)
+  , RMSError(-1.0)
+  , NumberOfEvaluatedViews(0)
+  , NumberOfEvaluatedPoints(0)
+  , Internal(new vtkInternal())
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraReprojectionEvaluator::~vtkSlicerVideoCameraReprojectionEvaluator()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraReprojectionEvaluator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MinimumNumberOfPoints: " << this->MinimumNumberOfPoints << std::endl;
+  os << indent << "RMSError: " << this->RMSError << std::endl;
+  os << indent << "NumberOfEvaluatedViews: " << this->NumberOfEvaluatedViews << std::endl;
+  os << indent << "NumberOfEvaluatedPoints: " << this->NumberOfEvaluatedPoints << std::endl;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReprojectionEvaluator::Evaluate(vtkMRMLVideoCameraNode* camera, vtkVideoCameraObservations* observations)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const int numberOfViews = observations != nullptr ? observations->GetNumberOfViews() : 0;
+  const vtkIdType numberOfPoints = observations != nullptr ? observations->GetNumberOfPoints() : 0;
+
+  this->RMSError = -1.0;
+  this->NumberOfEvaluatedViews = 0;
+  this->NumberOfEvaluatedPoints = 0;
+  this->Internal->CornerResiduals->SetNumberOfTuples(numberOfPoints);
+  this->Internal->CornerResiduals->FillComponent(0, nan);
+  this->Internal->CornerResiduals->FillComponent(1, nan);
+  this->Internal->ViewErrors->SetNumberOfTuples(numberOfViews);
+  this->Internal->ViewErrors->FillComponent(0, -1.0);
+  this->Internal->ViewPoses.assign(12 * numberOfViews, 0.0);
+  this->Internal->ViewSquaredSums.assign(numberOfViews, 0.0);
+  this->Internal->ViewCounts.assign(numberOfViews, 0);
+  this->Modified();
+
+  if (camera == nullptr || camera->GetIntrinsicMatrix() == nullptr || numberOfViews == 0)
+  {
+    vtkErrorMacro("Evaluate: a camera with intrinsics and observations with views are required");
+    return false;
+  }
+  if (observations->GetObjectPoints()->GetNumberOfTuples() == 0 &&
+    (observations->GetBoardPoints() == nullptr || observations->GetIds()->GetNumberOfTuples() == 0))
+  {
+    vtkErrorMacro("Evaluate: the observations have neither object points nor board points");
+    return false;
+  }
+
+  vtkMatrix3x3* intrinsics = camera->GetIntrinsicMatrix();
+  vtkDoubleArray* coefficients = camera->GetDistortionCoefficients();
+  const int numberOfCoefficients = coefficients != nullptr ? static_cast<int>(coefficients->GetNumberOfTuples() * coefficients->GetNumberOfComponents()) : 0;
+  this->Internal->MinimumNumberOfPoints = this->MinimumNumberOfPoints;
+  this->Internal->UsePixels = camera->GetCameraModel() == vtkMRMLVideoCameraNode::PinholeCameraModel && IsPnPDistortionCount(numberOfCoefficients);
+  this->Internal->CameraMatrix = cv::Mat(3, 3, CV_64F);
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      this->Internal->CameraMatrix.at<double>(i, j) = intrinsics->GetElement(i, j);
+    }
+  }
+  this->Internal->DistortionCoefficients = cv::Mat();
+  if (numberOfCoefficients > 0)
+  {
+    this->Internal->DistortionCoefficients = cv::Mat(1, numberOfCoefficients, CV_64F);
+    for (int i = 0; i < numberOfCoefficients; ++i)
+    {
+      this->Internal->DistortionCoefficients.at<double>(0, i) = coefficients->GetValue(i);
+    }
+  }
+
+  // views are independent and write disjoint ranges of the outputs
+  vtkSMPThreadLocal<ViewScratch> scratch;
+  std::vector<char> evaluated(numberOfViews, 0);
+  vtkSMPTools::For(0, numberOfViews, [this, camera, observations, &scratch, &evaluated](vtkIdType begin, vtkIdType end)
+  {
+    ViewScratch& local = scratch.Local();
+    for (vtkIdType view = begin; view < end; ++view)
+    {
+      evaluated[view] = this->Internal->EvaluateView(camera, observations, static_cast<int>(view), local) ? 1 : 0;
+    }
+  });
+
+  double sum = 0.0;
+  for (int view = 0; view < numberOfViews; ++view)
+  {
+    if (!evaluated[view])
+    {
+      this->Internal->ViewCounts[view] = 0;
+      continue;
+    }
+    const double squaredSum = this->Internal->ViewSquaredSums[view];
+    const vtkIdType count = this->Internal->ViewCounts[view];
+    this->Internal->ViewErrors->SetValue(view, std::sqrt(squaredSum / count));
+    sum += squaredSum;
+    this->NumberOfEvaluatedPoints += count;
+    ++this->NumberOfEvaluatedViews;
+  }
+  if (this->NumberOfEvaluatedViews == 0)
+  {
+    vtkErrorMacro("Evaluate: no view could be evaluated");
+    return false;
+  }
+  this->RMSError = std::sqrt(sum / this->NumberOfEvaluatedPoints);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkDoubleArray* vtkSlicerVideoCameraReprojectionEvaluator::GetCornerResiduals() const
+{
+  return this->Internal->CornerResiduals;
+}
+
+//----------------------------------------------------------------------------
+vtkDoubleArray* vtkSlicerVideoCameraReprojectionEvaluator::GetViewErrors() const
+{
+  return this->Internal->ViewErrors;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraReprojectionEvaluator::GetViewPose(int view, vtkMatrix4x4* boardToCamera) const
+{
+  if (boardToCamera == nullptr || view < 0 || view >= static_cast<int>(this->Internal->ViewCounts.size()) ||
+    this->Internal->ViewCounts[view] == 0)
+  {
+    return false;
+  }
+  const double* pose = &this->Internal->ViewPoses[12 * view];
+  boardToCamera->Identity();
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      boardToCamera->SetElement(i, j, pose[4 * i + j]);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,96 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraReprojectionEvaluator.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraReprojectionEvaluator - reprojection error of a camera on an observation set
+// .SECTION Description
+// Validates the calibration of a video camera node against a set of observations (e.g. views
+// that were not used to calibrate): the board pose of every view is estimated with PnP using the
+// fixed intrinsics and distortion of the node, the board points are projected with the camera
+// model of the node and compared with the detections. Views are evaluated in parallel with
+// vtkSMPTools, reading the packed observation arrays in place.
+//
+// Pinhole cameras solve PnP on the raw pixels with their distortion coefficients. The other
+// models solve it on the back-projected (normalized) detections.
+//
+// Views need object points, either their own or board points referenced by id; sets with
+// neither cannot be evaluated.
+
+#ifndef __vtkSlicerVideoCameraReprojectionEvaluator_h
+#define __vtkSlicerVideoCameraReprojectionEvaluator_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkDoubleArray;
+class vtkMatrix4x4;
+class vtkMRMLVideoCameraNode;
+class vtkVideoCameraObservations;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraReprojectionEvaluator : public vtkObject
+{
+public:
+  static vtkSlicerVideoCameraReprojectionEvaluator* New();
+  vtkTypeMacro(vtkSlicerVideoCameraReprojectionEvaluator, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Evaluate the camera on all views of the observations, false if no view could be evaluated
+  bool Evaluate(vtkMRMLVideoCameraNode* camera, vtkVideoCameraObservations* observations);
+
+  ///
+  /// Views with fewer points are not evaluated (default 4, the PnP minimum)
+  vtkSetClampMacro(MinimumNumberOfPoints, int, 4, VTK_INT_MAX);
+  vtkGetMacro(MinimumNumberOfPoints, int);
+
+  ///
+  /// Residual (projected - detected, pixels, 2 components) of every packed observation point,
+  /// NaN for points of views that were not evaluated
+  vtkDoubleArray* GetCornerResiduals() const;
+
+  ///
+  /// RMS error of every view, in pixels, -1 for views that were not evaluated
+  vtkDoubleArray* GetViewErrors() const;
+
+  ///
+  /// RMS error over all points of the evaluated views, in pixels, -1 if none
+  vtkGetMacro(RMSError, double);
+  vtkGetMacro(NumberOfEvaluatedViews, int);
+  vtkGetMacro(NumberOfEvaluatedPoints, vtkIdType);
+
+  ///
+  /// Estimated board to camera pose of a view, false if the view was not evaluated
+  bool GetViewPose(int view, vtkMatrix4x4* boardToCamera) const;
+
+protected:
+  vtkSlicerVideoCameraReprojectionEvaluator();
+  virtual ~vtkSlicerVideoCameraReprojectionEvaluator();
+
+protected:
+  int       MinimumNumberOfPoints;
+  double    RMSError;
+  int       NumberOfEvaluatedViews;
+  vtkIdType NumberOfEvaluatedPoints;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSlicerVideoCameraReprojectionEvaluator(const vtkSlicerVideoCameraReprojectionEvaluator&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraReprojectionEvaluator&); // Not implemented
+};
+
+#endif
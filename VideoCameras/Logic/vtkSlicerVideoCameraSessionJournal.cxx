@@ -0,0 +1,390 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraSessionJournal.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraSessionJournal.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkObjectFactory.h>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraSessionJournal);
+
+namespace
+{
+  const char JournalMagic[4] = { 'S', 'V', 'C', 'J' };
+  const vtkTypeUInt32 JournalVersion = 1;
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCameraSessionJournal::vtkInternal
+{
+public:
+  struct Record
+  {
+    vtkTypeUInt32       Type;
+    vtkTypeUInt32       NumberOfTuples;
+    vtkTypeUInt32       NumberOfComponents;
+    std::vector<double> Values;
+  };
+
+  vtkInternal();
+
+  static bool ReadRecords(const char* fileName, std::vector<Record>& records);
+  static void WriteHeader(std::ofstream& stream);
+  static void WriteRecord(std::ofstream& stream, const Record& record);
+
+  void StartWriter();
+  void StopWriter();
+  void WriterLoop();
+
+public:
+  std::vector<Record>     LoadedRecords;
+
+  std::ofstream           Stream;
+  std::thread             Writer;
+  std::mutex              Mutex;
+  std::condition_variable QueueCondition;
+  std::condition_variable WrittenCondition;
+  std::deque<Record>      Queue;
+  /// Records taken from the queue but not yet flushed
+  size_t                  InFlight;
+  bool                    StopRequested;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraSessionJournal::vtkInternal::vtkInternal()
+  : InFlight(0)
+  , StopRequested(false)
+{
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraSessionJournal::vtkInternal::ReadRecords(const char* fileName, std::vector<Record>& records)
+{
+  records.clear();
+  std::ifstream stream(fileName, std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+  {
+    return false;
+  }
+
+  // records are checked against the size of the file, a corrupted header must not allocate
+  // more values than the file can hold
+  stream.seekg(0, std::ios::end);
+  const vtkTypeUInt64 fileSize = static_cast<vtkTypeUInt64>(stream.tellg());
+  stream.seekg(0, std::ios::beg);
+
+  char magic[4] = { 0 };
+  vtkTypeUInt32 version = 0;
+  stream.read(magic, sizeof(magic));
+  stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+  if (!stream || std::memcmp(magic, JournalMagic, sizeof(magic)) != 0 || version != JournalVersion)
+  {
+    return false;
+  }
+
+  while (true)
+  {
+    Record record;
+    vtkTypeUInt32 header[3];
+    if (!stream.read(reinterpret_cast<char*>(header), sizeof(header)))
+    {
+      // end of file or a header cut short by a crash
+      break;
+    }
+    record.Type = header[0];
+    record.NumberOfTuples = header[1];
+    record.NumberOfComponents = header[2];
+    const vtkTypeUInt64 payloadSize = static_cast<vtkTypeUInt64>(record.NumberOfTuples) * record.NumberOfComponents * sizeof(double);
+    const vtkTypeUInt64 remainingSize = fileSize - static_cast<vtkTypeUInt64>(stream.tellg());
+    if (payloadSize > remainingSize)
+    {
+      // corrupted header or values cut short by a crash
+      break;
+    }
+    record.Values.resize(static_cast<size_t>(record.NumberOfTuples) * record.NumberOfComponents);
+    if (!record.Values.empty() && !stream.read(reinterpret_cast<char*>(&record.Values[0]), record.Values.size() * sizeof(double)))
+    {
+      break;
+    }
+    records.push_back(record);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraSessionJournal::vtkInternal::WriteHeader(std::ofstream& stream)
+{
+  stream.write(JournalMagic, sizeof(JournalMagic));
+  stream.write(reinterpret_cast<const char*>(&JournalVersion), sizeof(JournalVersion));
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraSessionJournal::vtkInternal::WriteRecord(std::ofstream& stream, const Record& record)
+{
+  const vtkTypeUInt32 header[3] = { record.Type, record.NumberOfTuples, record.NumberOfComponents };
+  stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+  if (!record.Values.empty())
+  {
+    stream.write(reinterpret_cast<const char*>(&record.Values[0]), record.Values.size() * sizeof(double));
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraSessionJournal::vtkInternal::StartWriter()
+{
+  this->StopRequested = false;
+  this->Writer = std::thread(&vtkInternal::WriterLoop, this);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraSessionJournal::vtkInternal::StopWriter()
+{
+  if (!this->Writer.joinable())
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->StopRequested = true;
+  }
+  this->QueueCondition.notify_one();
+  this->Writer.join();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraSessionJournal::vtkInternal::WriterLoop()
+{
+  std::deque<Record> batch;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(this->Mutex);
+      this->QueueCondition.wait(lock, [this] { return this->StopRequested || !this->Queue.empty(); });
+      if (this->Queue.empty() && this->StopRequested)
+      {
+        return;
+      }
+      batch.swap(this->Queue);
+      this->InFlight = batch.size();
+    }
+
+    // write the whole batch outside of the lock, then flush so a crash loses at most this batch
+    for (std::deque<Record>::const_iterator it = batch.begin(); it != batch.end(); ++it)
+    {
+      WriteRecord(this->Stream, *it);
+    }
+    this->Stream.flush();
+    batch.clear();
+
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->InFlight = 0;
+    }
+    this->WrittenCondition.notify_all();
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraSessionJournal::vtkSlicerVideoCameraSessionJournal()
+  : Internal(new vtkInternal)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraSessionJournal::~vtkSlicerVideoCameraSessionJournal()
+{
+  this->Close();
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraSessionJournal::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Open: " << (this->IsOpen() ? "true" : "false") << std::endl;
+  os << indent << "NumberOfRecords: " << this->GetNumberOfRecords() << std::endl;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraSessionJournal::Open(const char* fileName, bool append)
+{
+  if (fileName == nullptr)
+  {
+    vtkErrorMacro("Open: invalid file name");
+    return false;
+  }
+  this->Close();
+
+  if (append && vtksys::SystemTools::FileExists(fileName, true))
+  {
+    std::vector<vtkInternal::Record> existingRecords;
+    if (!vtkInternal::ReadRecords(fileName, existingRecords))
+    {
+      vtkErrorMacro("Open: " << fileName << " is not a video camera session journal, it is left unchanged");
+      return false;
+    }
+
+    // Rewrite the complete records into a new file that replaces the journal only once it is
+    // complete, so a tail truncated by a crash is dropped and a crash while resuming loses nothing
+    const std::string resumedFileName = std::string(fileName) + ".resume";
+    std::ofstream resumed(resumedFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    vtkInternal::WriteHeader(resumed);
+    for (std::vector<vtkInternal::Record>::const_iterator it = existingRecords.begin(); it != existingRecords.end(); ++it)
+    {
+      vtkInternal::WriteRecord(resumed, *it);
+    }
+    resumed.close();
+    if (!resumed || !vtksys::SystemTools::RenameFile(resumedFileName.c_str(), fileName))
+    {
+      vtksys::SystemTools::RemoveFile(resumedFileName);
+      vtkErrorMacro("Open: unable to rewrite " << fileName << ", it is left unchanged");
+      return false;
+    }
+
+    this->Internal->Stream.open(fileName, std::ios::out | std::ios::binary | std::ios::app);
+  }
+  else
+  {
+    this->Internal->Stream.open(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    vtkInternal::WriteHeader(this->Internal->Stream);
+  }
+  if (!this->Internal->Stream.is_open())
+  {
+    vtkErrorMacro("Open: unable to open " << fileName << " for writing");
+    return false;
+  }
+  this->Internal->Stream.flush();
+
+  this->Internal->StartWriter();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraSessionJournal::IsOpen() const
+{
+  return this->Internal->Writer.joinable();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraSessionJournal::Close()
+{
+  this->Internal->StopWriter();
+  if (this->Internal->Stream.is_open())
+  {
+    this->Internal->Stream.close();
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraSessionJournal::AppendRecord(int type, vtkDataArray* values)
+{
+  if (!this->IsOpen())
+  {
+    vtkErrorMacro("AppendRecord: journal is not open");
+    return false;
+  }
+
+  vtkInternal::Record record;
+  record.Type = static_cast<vtkTypeUInt32>(type);
+  record.NumberOfTuples = values ? static_cast<vtkTypeUInt32>(values->GetNumberOfTuples()) : 0;
+  record.NumberOfComponents = values ? static_cast<vtkTypeUInt32>(values->GetNumberOfComponents()) : 0;
+  record.Values.resize(static_cast<size_t>(record.NumberOfTuples) * record.NumberOfComponents);
+  for (vtkTypeUInt32 t = 0; t < record.NumberOfTuples; ++t)
+  {
+    for (vtkTypeUInt32 c = 0; c < record.NumberOfComponents; ++c)
+    {
+      record.Values[t * record.NumberOfComponents + c] = values->GetComponent(t, c);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    this->Internal->Queue.push_back(std::move(record));
+  }
+  this->Internal->QueueCondition.notify_one();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraSessionJournal::Flush()
+{
+  if (!this->IsOpen())
+  {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->WrittenCondition.wait(lock, [this] { return this->Internal->Queue.empty() && this->Internal->InFlight == 0; });
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraSessionJournal::Load(const char* fileName)
+{
+  if (fileName == nullptr || !vtkInternal::ReadRecords(fileName, this->Internal->LoadedRecords))
+  {
+    vtkErrorMacro("Load: " << (fileName ? fileName : "(null)") << " is not a video camera session journal");
+    return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraSessionJournal::GetNumberOfRecords() const
+{
+  return static_cast<int>(this->Internal->LoadedRecords.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraSessionJournal::GetRecordType(int record) const
+{
+  if (record < 0 || record >= this->GetNumberOfRecords())
+  {
+    return 0;
+  }
+  return static_cast<int>(this->Internal->LoadedRecords[record].Type);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraSessionJournal::GetRecordValues(int record, vtkDoubleArray* values) const
+{
+  if (values == nullptr || record < 0 || record >= this->GetNumberOfRecords())
+  {
+    return false;
+  }
+
+  const vtkInternal::Record& entry = this->Internal->LoadedRecords[record];
+  values->SetNumberOfComponents(entry.NumberOfComponents > 0 ? entry.NumberOfComponents : 1);
+  values->SetNumberOfTuples(entry.NumberOfTuples);
+  if (!entry.Values.empty())
+  {
+    std::copy(entry.Values.begin(), entry.Values.end(), values->GetPointer(0));
+  }
+  values->Modified();
+  return true;
+}
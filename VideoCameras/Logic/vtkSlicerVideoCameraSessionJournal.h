@@ -0,0 +1,104 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraSessionJournal.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraSessionJournal - crash-safe log of calibration observations
+// .SECTION Description
+// Appends every accepted calibration observation to a compact binary file. Records are
+// queued by AppendRecord and written and flushed by a background thread, so capturing never
+// waits on the disk. Load reads back every complete record; a record truncated by a crash is
+// ignored, so a session can be resumed up to the last observation that reached the disk.
+//
+// File layout: "SVCJ", uint32 version, then per record uint32 type, uint32 number of tuples,
+// uint32 number of components and the values as doubles (native byte order).
+
+#ifndef __vtkSlicerVideoCameraSessionJournal_h
+#define __vtkSlicerVideoCameraSessionJournal_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkDataArray;
+class vtkDoubleArray;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraSessionJournal : public vtkObject
+{
+public:
+  /// BoardTypeRecord and ArucoDictionaryRecord hold text, one character code per tuple.
+  /// BoardRecord (rows, columns, the two board parameters) follows them and applies the board.
+  enum RecordType
+  {
+    ImageSizeRecord = 1,
+    ObjectPointsRecord,
+    ImagePointsRecord,
+    ArucoCornersRecord,
+    ArucoIdsRecord,
+    CharucoCornersRecord,
+    CharucoIdsRecord,
+    PointLinePairRecord,
+    ResetIntrinsicRecord,
+    ResetMarkerToSensorRecord,
+    BoardTypeRecord,
+    ArucoDictionaryRecord,
+    BoardRecord
+  };
+
+  static vtkSlicerVideoCameraSessionJournal* New();
+  vtkTypeMacro(vtkSlicerVideoCameraSessionJournal, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Start writing to a journal file, either truncating it or appending to its existing records
+  /// Appending drops a record truncated by a crash: the complete records are copied to
+  /// "<fileName>.resume", which then replaces the journal. A file that is not a journal is left
+  /// unchanged and not opened.
+  bool Open(const char* fileName, bool append);
+  bool IsOpen() const;
+
+  ///
+  /// Write all queued records and stop the writer thread
+  void Close();
+
+  ///
+  /// Queue a record, values may be null for records without payload
+  /// The values are copied, the call does not wait for the disk.
+  bool AppendRecord(int type, vtkDataArray* values);
+
+  ///
+  /// Block until every queued record has been written and flushed
+  void Flush();
+
+  ///
+  /// Read all complete records of a journal file
+  bool Load(const char* fileName);
+  int GetNumberOfRecords() const;
+  int GetRecordType(int record) const;
+  bool GetRecordValues(int record, vtkDoubleArray* values) const;
+
+protected:
+  vtkSlicerVideoCameraSessionJournal();
+  virtual ~vtkSlicerVideoCameraSessionJournal();
+
+protected:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSlicerVideoCameraSessionJournal(const vtkSlicerVideoCameraSessionJournal&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraSessionJournal&); // Not implemented
+};
+
+#endif
@@ -0,0 +1,589 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraUndistortionGrid.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCameraUndistortionGrid.h"
+#include "vtkSlicerVideoCameraProjection.h"
+#include "vtkMRMLVideoCameraNode.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix3x3.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkTimeStamp.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCameraUndistortionGrid);
+
+namespace
+{
+  /// Normalized coordinate step of the finite difference Jacobian of the Newton step
+  const double JacobianStep = 1e-7;
+
+  //----------------------------------------------------------------------------
+  struct CameraIntrinsics
+  {
+    double Fx;
+    double Fy;
+    double Cx;
+    double Cy;
+    double Skew;
+
+    void ToPixel(double x, double y, double& u, double& v) const
+    {
+      u = this->Fx * x + this->Skew * y + this->Cx;
+      v = this->Fy * y + this->Cy;
+    }
+
+    void FromPixel(double u, double v, double& x, double& y) const
+    {
+      y = (v - this->Cy) / this->Fy;
+      x = (u - this->Cx - this->Skew * y) / this->Fx;
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  /// Exact ideal pixels of raw pixels through the iterative inversion of the camera model
+  bool ExactIdealPixels(vtkMRMLVideoCameraNode* node, const CameraIntrinsics& intrinsics, vtkDoubleArray* pixels, vtkDoubleArray* rays, double* ideal)
+  {
+    if (!vtkSlicerVideoCameraProjection::BackProjectPixels(node, pixels, rays))
+    {
+      return false;
+    }
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double* ray = rays->GetPointer(0);
+    for (vtkIdType i = 0; i < pixels->GetNumberOfTuples(); ++i, ray += 3, ideal += 2)
+    {
+      if (vtkMath::IsNan(ray[0]) || ray[2] <= 0.0)
+      {
+        ideal[0] = ideal[1] = nan;
+        continue;
+      }
+      intrinsics.ToPixel(ray[0] / ray[2], ray[1] / ray[2], ideal[0], ideal[1]);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// One Newton step on raw = Project(ideal) for every estimate, in a single projection batch
+  void RefineIdealPixels(vtkMRMLVideoCameraNode* node, const CameraIntrinsics& intrinsics, const double* raw, double* ideal, vtkIdType count)
+  {
+    // the estimate and its two finite difference neighbours, in normalized camera coordinates
+    vtkNew<vtkDoubleArray> points;
+    points->SetNumberOfComponents(3);
+    points->SetNumberOfTuples(3 * count);
+    double* point = points->GetPointer(0);
+    for (vtkIdType i = 0; i < count; ++i, point += 9)
+    {
+      double x, y;
+      intrinsics.FromPixel(ideal[2 * i], ideal[2 * i + 1], x, y);
+      const double p[9] = { x, y, 1.0, x + JacobianStep, y, 1.0, x, y + JacobianStep, 1.0 };
+      std::copy(p, p + 9, point);
+    }
+
+    vtkNew<vtkDoubleArray> projected;
+    if (!vtkSlicerVideoCameraProjection::ProjectPoints(node, points.GetPointer(), projected.GetPointer()))
+    {
+      return;
+    }
+
+    const double* p = projected->GetPointer(0);
+    point = points->GetPointer(0);
+    for (vtkIdType i = 0; i < count; ++i, p += 6, point += 9)
+    {
+      // J = d raw / d (x, y), columns from the two neighbours
+      const double j00 = (p[2] - p[0]) / JacobianStep;
+      const double j10 = (p[3] - p[1]) / JacobianStep;
+      const double j01 = (p[4] - p[0]) / JacobianStep;
+      const double j11 = (p[5] - p[1]) / JacobianStep;
+      const double determinant = j00 * j11 - j01 * j10;
+      if (vtkMath::IsNan(determinant) || determinant == 0.0)
+      {
+        continue;
+      }
+      const double r0 = p[0] - raw[2 * i];
+      const double r1 = p[1] - raw[2 * i + 1];
+      const double x = point[0] - (j11 * r0 - j01 * r1) / determinant;
+      const double y = point[1] - (j00 * r1 - j10 * r0) / determinant;
+      intrinsics.ToPixel(x, y, ideal[2 * i], ideal[2 * i + 1]);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCameraUndistortionGrid::vtkInternal
+{
+public:
+  vtkInternal();
+
+  bool IsOutOfDate(vtkSlicerVideoCameraUndistortionGrid* self);
+  bool Build(double spacing);
+  /// Compare the lookup with the exact inversion at every cell center, once per build
+  void MeasureErrors();
+  /// Bilinear lookup, false outside the grid or next to a grid point the model cannot invert
+  bool Lookup(double u, double v, double& idealU, double& idealV) const;
+
+  vtkWeakPointer<vtkMRMLVideoCameraNode> Node;
+  int                                    Size[2];
+
+  // Grid, row major, interleaved ideal (u, v)
+  std::vector<float>                     Ideal;
+  int                                    Columns;
+  int                                    Rows;
+  double                                 Spacing;
+  CameraIntrinsics                       Intrinsics;
+  vtkTimeStamp                           BuildTime;
+  vtkMRMLVideoCameraNode*                BuiltNode;
+  // camera parameters the grid was built from, compared by value
+  std::shared_ptr<const vtkMRMLVideoCameraNode::ParameterBlock> BuiltParameters;
+  int                                    BuiltCameraModel;
+  double                                 BuiltXi;
+
+  bool                                   ErrorsMeasured;
+  double                                 MaximumInterpolationError;
+  double                                 MaximumRefinedError;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraUndistortionGrid::vtkInternal::vtkInternal()
+  : Columns(0)
+  , Rows(0)
+  , Spacing(0.0)
+  , BuiltNode(nullptr)
+  , BuiltCameraModel(vtkMRMLVideoCameraNode::PinholeCameraModel)
+  , BuiltXi(0.0)
+  , ErrorsMeasured(false)
+  , MaximumInterpolationError(0.0)
+  , MaximumRefinedError(0.0)
+{
+  this->Size[0] = this->Size[1] = 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraUndistortionGrid::vtkInternal::IsOutOfDate(vtkSlicerVideoCameraUndistortionGrid* self)
+{
+  vtkMRMLVideoCameraNode* node = this->Node;
+  if (this->Ideal.empty() || node != this->BuiltNode || self->GetMTime() > this->BuildTime)
+  {
+    return true;
+  }
+  if (node->GetCameraModel() != this->BuiltCameraModel || node->GetXi() != this->BuiltXi)
+  {
+    return true;
+  }
+  // other edits of the node (pose, plane offset, name, ...) leave the grid valid, and so do edits
+  // that restore the values it was built from (e.g. a calibration table bucket applied again)
+  std::shared_ptr<const vtkMRMLVideoCameraNode::ParameterBlock> parameters = node->GetParameters();
+  if (parameters == this->BuiltParameters)
+  {
+    return false;
+  }
+  if (!std::equal(parameters->Intrinsics, parameters->Intrinsics + 9, this->BuiltParameters->Intrinsics) ||
+      parameters->DistortionCoefficients != this->BuiltParameters->DistortionCoefficients)
+  {
+    return true;
+  }
+  this->BuiltParameters = parameters;
+  return false;
+}
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Exact ideal pixels of rows of a regular raw pixel lattice
+  class LatticeFunctor
+  {
+  public:
+    LatticeFunctor(vtkMRMLVideoCameraNode* node, const CameraIntrinsics& intrinsics, double origin, double spacing, int columns, double* ideal)
+      : Node(node), Intrinsics(intrinsics), Origin(origin), Spacing(spacing), Columns(columns), IdealPixels(ideal)
+    {
+    }
+
+    void Initialize()
+    {
+      vtkDoubleArray*& pixels = this->Pixels.Local();
+      pixels = vtkDoubleArray::New();
+      pixels->SetNumberOfComponents(2);
+      pixels->SetNumberOfTuples(this->Columns);
+      this->Rays.Local() = vtkDoubleArray::New();
+    }
+
+    void operator()(vtkIdType beginRow, vtkIdType endRow)
+    {
+      vtkDoubleArray* pixels = this->Pixels.Local();
+      vtkDoubleArray* rays = this->Rays.Local();
+      for (vtkIdType row = beginRow; row < endRow; ++row)
+      {
+        double* pixel = pixels->GetPointer(0);
+        for (int column = 0; column < this->Columns; ++column, pixel += 2)
+        {
+          pixel[0] = this->Origin + column * this->Spacing;
+          pixel[1] = this->Origin + row * this->Spacing;
+        }
+        ExactIdealPixels(this->Node, this->Intrinsics, pixels, rays, this->IdealPixels + 2 * row * this->Columns);
+      }
+    }
+
+    void Reduce()
+    {
+      for (vtkSMPThreadLocal<vtkDoubleArray*>::iterator it = this->Pixels.begin(); it != this->Pixels.end(); ++it)
+      {
+        (*it)->Delete();
+      }
+      for (vtkSMPThreadLocal<vtkDoubleArray*>::iterator it = this->Rays.begin(); it != this->Rays.end(); ++it)
+      {
+        (*it)->Delete();
+      }
+    }
+
+  protected:
+    vtkMRMLVideoCameraNode* Node;
+    const CameraIntrinsics& Intrinsics;
+    double Origin;
+    double Spacing;
+    int Columns;
+    double* IdealPixels;
+    vtkSMPThreadLocal<vtkDoubleArray*> Pixels;
+    vtkSMPThreadLocal<vtkDoubleArray*> Rays;
+  };
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraUndistortionGrid::vtkInternal::Build(double spacing)
+{
+  this->Ideal.clear();
+  this->ErrorsMeasured = false;
+  this->MaximumInterpolationError = 0.0;
+  this->MaximumRefinedError = 0.0;
+
+  vtkMRMLVideoCameraNode* node = this->Node;
+  if (node == nullptr || node->GetIntrinsicMatrix() == nullptr || this->Size[0] < 2 || this->Size[1] < 2)
+  {
+    return false;
+  }
+  vtkMatrix3x3* matrix = node->GetIntrinsicMatrix();
+  if (matrix->GetElement(0, 0) == 0.0 || matrix->GetElement(1, 1) == 0.0)
+  {
+    return false;
+  }
+  this->Intrinsics.Fx = matrix->GetElement(0, 0);
+  this->Intrinsics.Fy = matrix->GetElement(1, 1);
+  this->Intrinsics.Cx = matrix->GetElement(0, 2);
+  this->Intrinsics.Cy = matrix->GetElement(1, 2);
+  this->Intrinsics.Skew = matrix->GetElement(0, 1);
+  // the functors back-project through the node on the SMP threads, its views must exist before
+  node->GetDistortionCoefficients();
+
+  // grid points from pixel 0 to at least pixel size - 1
+  this->Spacing = spacing;
+  this->Columns = static_cast<int>(std::ceil((this->Size[0] - 1) / spacing)) + 1;
+  this->Rows = static_cast<int>(std::ceil((this->Size[1] - 1) / spacing)) + 1;
+
+  std::vector<double> ideal(2 * static_cast<size_t>(this->Columns) * this->Rows);
+  LatticeFunctor grid(node, this->Intrinsics, 0.0, spacing, this->Columns, ideal.data());
+  vtkSMPTools::For(0, this->Rows, grid);
+  this->Ideal.assign(ideal.begin(), ideal.end());
+
+  this->BuiltNode = node;
+  this->BuiltParameters = node->GetParameters();
+  this->BuiltCameraModel = node->GetCameraModel();
+  this->BuiltXi = node->GetXi();
+  this->BuildTime.Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraUndistortionGrid::vtkInternal::MeasureErrors()
+{
+  vtkMRMLVideoCameraNode* node = this->Node;
+  if (this->ErrorsMeasured || this->Ideal.empty() || node == nullptr)
+  {
+    return;
+  }
+  this->ErrorsMeasured = true;
+
+  // error bound: exact inversion against the lookup at every cell center
+  const double spacing = this->Spacing;
+  const int centerColumns = this->Columns - 1;
+  const int centerRows = this->Rows - 1;
+  std::vector<double> exact(2 * static_cast<size_t>(centerColumns) * centerRows);
+  LatticeFunctor centers(node, this->Intrinsics, 0.5 * spacing, spacing, centerColumns, exact.data());
+  vtkSMPTools::For(0, centerRows, centers);
+
+  std::vector<double> raw;
+  std::vector<double> estimates;
+  std::vector<double> reference;
+  for (int row = 0; row < centerRows; ++row)
+  {
+    for (int column = 0; column < centerColumns; ++column)
+    {
+      const double* e = &exact[2 * (static_cast<size_t>(row) * centerColumns + column)];
+      const double u = (column + 0.5) * spacing;
+      const double v = (row + 0.5) * spacing;
+      double idealU, idealV;
+      if (vtkMath::IsNan(e[0]) || !this->Lookup(u, v, idealU, idealV))
+      {
+        continue;
+      }
+      this->MaximumInterpolationError = std::max(this->MaximumInterpolationError, std::sqrt((idealU - e[0]) * (idealU - e[0]) + (idealV - e[1]) * (idealV - e[1])));
+      raw.push_back(u);
+      raw.push_back(v);
+      estimates.push_back(idealU);
+      estimates.push_back(idealV);
+      reference.push_back(e[0]);
+      reference.push_back(e[1]);
+    }
+  }
+  RefineIdealPixels(node, this->Intrinsics, raw.data(), estimates.data(), static_cast<vtkIdType>(raw.size() / 2));
+  for (size_t i = 0; i < estimates.size(); i += 2)
+  {
+    const double du = estimates[i] - reference[i];
+    const double dv = estimates[i + 1] - reference[i + 1];
+    this->MaximumRefinedError = std::max(this->MaximumRefinedError, std::sqrt(du * du + dv * dv));
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraUndistortionGrid::vtkInternal::Lookup(double u, double v, double& idealU, double& idealV) const
+{
+  const double gu = u / this->Spacing;
+  const double gv = v / this->Spacing;
+  if (!(gu >= 0.0 && gv >= 0.0))
+  {
+    return false;
+  }
+  const int column = std::min(static_cast<int>(gu), this->Columns - 2);
+  const int row = std::min(static_cast<int>(gv), this->Rows - 2);
+  const double fu = gu - column;
+  const double fv = gv - row;
+  if (fu > 1.0 || fv > 1.0)
+  {
+    return false;
+  }
+
+  const float* p00 = &this->Ideal[2 * (static_cast<size_t>(row) * this->Columns + column)];
+  const float* p01 = p00 + 2;
+  const float* p10 = p00 + 2 * this->Columns;
+  const float* p11 = p10 + 2;
+  for (int c = 0; c < 2; ++c)
+  {
+    const double top = p00[c] + fu * (p01[c] - p00[c]);
+    const double bottom = p10[c] + fu * (p11[c] - p10[c]);
+    (c == 0 ? idealU : idealV) = top + fv * (bottom - top);
+  }
+  return !vtkMath::IsNan(idealU) && !vtkMath::IsNan(idealV);
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraUndistortionGrid::vtkSlicerVideoCameraUndistortionGrid()
+  : GridSpacing(0.5)
+  , RefineSolution(true)
+  , Internal(new vtkInternal())
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCameraUndistortionGrid::~vtkSlicerVideoCameraUndistortionGrid()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraUndistortionGrid::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "CameraNode: " << (this->Internal->Node != nullptr && this->Internal->Node->GetID() ? this->Internal->Node->GetID() : "(none)") << std::endl;
+  os << indent << "ImageSize: " << this->Internal->Size[0] << " " << this->Internal->Size[1] << std::endl;
+  os << indent << "GridSpacing: " << this->GridSpacing << std::endl;
+  os << indent << "RefineSolution: " << (this->RefineSolution ? "true" : "false") << std::endl;
+  os << indent << "NumberOfGridPoints: " << this->GetNumberOfGridPoints() << std::endl;
+  if (this->Internal->ErrorsMeasured)
+  {
+    os << indent << "MaximumInterpolationError: " << this->Internal->MaximumInterpolationError << std::endl;
+    os << indent << "MaximumRefinedError: " << this->Internal->MaximumRefinedError << std::endl;
+  }
+  else
+  {
+    os << indent << "MaximumInterpolationError: (not measured)" << std::endl;
+    os << indent << "MaximumRefinedError: (not measured)" << std::endl;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraUndistortionGrid::SetCameraNode(vtkMRMLVideoCameraNode* node)
+{
+  if (this->Internal->Node == node)
+  {
+    return;
+  }
+  this->Internal->Node = node;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* vtkSlicerVideoCameraUndistortionGrid::GetCameraNode() const
+{
+  return this->Internal->Node;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCameraUndistortionGrid::SetImageSize(int width, int height)
+{
+  if (this->Internal->Size[0] == width && this->Internal->Size[1] == height)
+  {
+    return;
+  }
+  this->Internal->Size[0] = width;
+  this->Internal->Size[1] = height;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraUndistortionGrid::GetImageWidth() const
+{
+  return this->Internal->Size[0];
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraUndistortionGrid::GetImageHeight() const
+{
+  return this->Internal->Size[1];
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraUndistortionGrid::Update()
+{
+  if (!this->Internal->IsOutOfDate(this))
+  {
+    return true;
+  }
+  if (!this->Internal->Build(this->GridSpacing))
+  {
+    vtkErrorMacro("Update: a camera node with valid intrinsics and an image size of at least 2 x 2 are required");
+    return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCameraUndistortionGrid::UndistortPoints(vtkDoubleArray* pixels, vtkDoubleArray* idealPixels)
+{
+  if (pixels == nullptr || idealPixels == nullptr || pixels->GetNumberOfComponents() != 2)
+  {
+    vtkErrorMacro("UndistortPoints: pixels must have 2 components");
+    return false;
+  }
+  if (!this->Update())
+  {
+    return false;
+  }
+
+  const vtkIdType count = pixels->GetNumberOfTuples();
+  idealPixels->SetNumberOfComponents(2);
+  idealPixels->SetNumberOfTuples(count);
+  const double* raw = pixels->GetPointer(0);
+  double* ideal = idealPixels->GetPointer(0);
+
+  std::vector<vtkIdType> fallback;
+  std::vector<vtkIdType> refined;
+  for (vtkIdType i = 0; i < count; ++i)
+  {
+    if (this->Internal->Lookup(raw[2 * i], raw[2 * i + 1], ideal[2 * i], ideal[2 * i + 1]))
+    {
+      refined.push_back(i);
+    }
+    else
+    {
+      fallback.push_back(i);
+    }
+  }
+
+  vtkMRMLVideoCameraNode* node = this->Internal->Node;
+  if (this->RefineSolution && !refined.empty())
+  {
+    std::vector<double> targets(2 * refined.size());
+    std::vector<double> estimates(2 * refined.size());
+    for (size_t k = 0; k < refined.size(); ++k)
+    {
+      std::copy(raw + 2 * refined[k], raw + 2 * refined[k] + 2, &targets[2 * k]);
+      std::copy(ideal + 2 * refined[k], ideal + 2 * refined[k] + 2, &estimates[2 * k]);
+    }
+    RefineIdealPixels(node, this->Internal->Intrinsics, targets.data(), estimates.data(), static_cast<vtkIdType>(refined.size()));
+    for (size_t k = 0; k < refined.size(); ++k)
+    {
+      std::copy(&estimates[2 * k], &estimates[2 * k] + 2, ideal + 2 * refined[k]);
+    }
+  }
+
+  if (!fallback.empty())
+  {
+    vtkNew<vtkDoubleArray> outside;
+    outside->SetNumberOfComponents(2);
+    outside->SetNumberOfTuples(static_cast<vtkIdType>(fallback.size()));
+    for (size_t k = 0; k < fallback.size(); ++k)
+    {
+      outside->SetTypedTuple(static_cast<vtkIdType>(k), raw + 2 * fallback[k]);
+    }
+    vtkNew<vtkDoubleArray> rays;
+    std::vector<double> exact(2 * fallback.size());
+    ExactIdealPixels(node, this->Internal->Intrinsics, outside.GetPointer(), rays.GetPointer(), exact.data());
+    for (size_t k = 0; k < fallback.size(); ++k)
+    {
+      std::copy(&exact[2 * k], &exact[2 * k] + 2, ideal + 2 * fallback[k]);
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraUndistortionGrid::GetMaximumInterpolationError()
+{
+  if (!this->Update())
+  {
+    return 0.0;
+  }
+  this->Internal->MeasureErrors();
+  return this->Internal->MaximumInterpolationError;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerVideoCameraUndistortionGrid::GetMaximumRefinedError()
+{
+  if (!this->Update())
+  {
+    return 0.0;
+  }
+  this->Internal->MeasureErrors();
+  return this->Internal->MaximumRefinedError;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerVideoCameraUndistortionGrid::GetNumberOfGridPoints() const
+{
+  return static_cast<vtkIdType>(this->Internal->Ideal.size() / 2);
+}
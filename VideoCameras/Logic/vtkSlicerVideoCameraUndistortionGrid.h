@@ -0,0 +1,110 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraUndistortionGrid.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCameraUndistortionGrid - cached inverse distortion of a video camera
+// .SECTION Description
+// Tabulates the undistorted (ideal) pixel position of raw image positions on a regular grid
+// covering the image, GridSpacing pixels apart. Undistorting a point is then a bilinear lookup,
+// optionally followed by one Newton step on the forward camera model, instead of the iterative
+// inversion of cv::undistortPoints. The ideal image uses the intrinsics of the camera without
+// distortion (P = K in cv::undistortPoints).
+//
+// The grid is rebuilt by Update (called by UndistortPoints) when the values of the intrinsics,
+// distortion coefficients or model of the camera node, the image size or the spacing change;
+// other modifications of the node keep it.
+//
+// Error bound: the lookup is compared with the exact inversion at the center of every grid cell,
+// where the bilinear error of a smooth distortion field peaks. The largest differences, with and
+// without the Newton step, are reported by GetMaximumInterpolationError and GetMaximumRefinedError,
+// in pixels. The comparison costs about as much as building the grid again and is only done on the
+// first of these calls after a rebuild. Points outside the grid, or in cells the model cannot
+// invert, fall back to the exact inversion.
+
+#ifndef __vtkSlicerVideoCameraUndistortionGrid_h
+#define __vtkSlicerVideoCameraUndistortionGrid_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkDoubleArray;
+class vtkMRMLVideoCameraNode;
+
+/// \ingroup Slicer_QtModules_VideoCameras
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCameraUndistortionGrid : public vtkObject
+{
+public:
+  static vtkSlicerVideoCameraUndistortionGrid* New();
+  vtkTypeMacro(vtkSlicerVideoCameraUndistortionGrid, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Camera the grid is computed for
+  void SetCameraNode(vtkMRMLVideoCameraNode* node);
+  vtkMRMLVideoCameraNode* GetCameraNode() const;
+
+  ///
+  /// Raw image size, in pixels, covered by the grid
+  void SetImageSize(int width, int height);
+  int GetImageWidth() const;
+  int GetImageHeight() const;
+
+  ///
+  /// Distance between grid points, in pixels (default 0.5). The error decreases with the square of
+  /// the spacing, memory grows with its inverse square (8 bytes per grid point, 66 MB for a
+  /// 1920 x 1080 image at the default spacing).
+  vtkSetClampMacro(GridSpacing, double, 0.1, 64.0);
+  vtkGetMacro(GridSpacing, double);
+
+  ///
+  /// Apply one Newton step on the forward model after the lookup (default on)
+  vtkSetMacro(RefineSolution, bool);
+  vtkGetMacro(RefineSolution, bool);
+  vtkBooleanMacro(RefineSolution, bool);
+
+  ///
+  /// Rebuild the grid if it is out of date, false if the camera has no valid intrinsics
+  bool Update();
+
+  ///
+  /// Raw image pixels (2 components) to ideal pixels (2 components), NaN where the camera model
+  /// cannot be inverted
+  bool UndistortPoints(vtkDoubleArray* pixels, vtkDoubleArray* idealPixels);
+
+  ///
+  /// Measured error bounds of the grid, in pixels, 0 if it cannot be built
+  /// Updates the grid and measures the bounds if they were not measured since the last rebuild.
+  double GetMaximumInterpolationError();
+  double GetMaximumRefinedError();
+
+  vtkIdType GetNumberOfGridPoints() const;
+
+protected:
+  vtkSlicerVideoCameraUndistortionGrid();
+  virtual ~vtkSlicerVideoCameraUndistortionGrid();
+
+protected:
+  double  GridSpacing;
+  bool    RefineSolution;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSlicerVideoCameraUndistortionGrid(const vtkSlicerVideoCameraUndistortionGrid&); // Not implemented
+  void operator=(const vtkSlicerVideoCameraUndistortionGrid&); // Not implemented
+};
+
+#endif
@@ -1,151 +1,892 @@
-/*=auto=========================================================================
-
-Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
-
-See COPYRIGHT.txt
-or http://www.slicer.org/copyright/copyright.txt for details.
-
-Program:   3D Slicer
-Module:    $RCSfile: vtkSlicerVideoCamerasLogic.cxx,v $
-Date:      $Date: 2018/6/16 10:54:09 $
-Version:   $Revision: 1.0 $
-
-=========================================================================auto=*/
-
-// VideoCameras Logic includes
-#include "vtkSlicerVideoCamerasLogic.h"
-#include "vtkMRMLVideoCameraNode.h"
-#include "vtkMRMLVideoCameraStorageNode.h"
-
-// MRML includes
-#include <vtkMRMLScene.h>
-
-// VTK includes
-#include <vtkIntArray.h>
-#include <vtkNew.h>
-#include <vtkObjectFactory.h>
-
-// STD includes
-#include <cassert>
-
-// ITK includes
-#include <itksys/Directory.hxx>
-#include <itksys/SystemTools.hxx>
-
-//----------------------------------------------------------------------------
-vtkStandardNewMacro(vtkSlicerVideoCamerasLogic);
-
-//----------------------------------------------------------------------------
-vtkSlicerVideoCamerasLogic::vtkSlicerVideoCamerasLogic()
-{
-}
-
-//----------------------------------------------------------------------------
-vtkSlicerVideoCamerasLogic::~vtkSlicerVideoCamerasLogic()
-{
-}
-
-//----------------------------------------------------------------------------
-void vtkSlicerVideoCamerasLogic::PrintSelf(ostream& os, vtkIndent indent)
-{
-  this->Superclass::PrintSelf(os, indent);
-}
-
-//----------------------------------------------------------------------------
-vtkMRMLVideoCameraNode* vtkSlicerVideoCamerasLogic::AddVideoCamera(const char* filename, const char* nodeName /*= NULL*/)
-{
-  if (this->GetMRMLScene() == NULL || filename == NULL)
-  {
-    return NULL;
-  }
-  vtkNew<vtkMRMLVideoCameraNode> videoCameraNode;
-  vtkNew<vtkMRMLVideoCameraStorageNode> mStorageNode;
-  vtkSmartPointer<vtkMRMLStorageNode> storageNode;
-
-  mStorageNode->SetFileName(filename);
-
-  const std::string fname(filename);
-  // the VideoCamera node name is based on the file name (itksys call should work even if file is not on disk yet)
-  std::string name = itksys::SystemTools::GetFilenameName(fname);
-
-  // check to see which node can read this type of file
-  if (mStorageNode->SupportedFileType(name.c_str()))
-  {
-    storageNode = mStorageNode.GetPointer();
-  }
-
-  if (storageNode != NULL)
-  {
-    std::string baseName = itksys::SystemTools::GetFilenameWithoutExtension(fname);
-    std::string uname(this->GetMRMLScene()->GetUniqueNameByString(baseName.c_str()));
-    videoCameraNode->SetName(uname.c_str());
-
-    this->GetMRMLScene()->SaveStateForUndo();
-
-    this->GetMRMLScene()->AddNode(storageNode.GetPointer());
-
-    // Set the scene so that SetAndObserve[Display|Storage]NodeID can find the
-    // node in the scene (so that DisplayNodes return something not empty)
-    videoCameraNode->SetScene(this->GetMRMLScene());
-    videoCameraNode->SetAndObserveStorageNodeID(storageNode->GetID());
-
-    this->GetMRMLScene()->AddNode(videoCameraNode.GetPointer());
-
-    // now set up the reading
-    vtkDebugMacro("AddVideoCamera: calling read on the storage node");
-    int retval = storageNode->ReadData(videoCameraNode.GetPointer());
-    if (retval != 1)
-    {
-      vtkErrorMacro("AddVideoCamera: error reading " << filename);
-      this->GetMRMLScene()->RemoveNode(videoCameraNode.GetPointer());
-      return NULL;
-    }
-  }
-  else
-  {
-    vtkErrorMacro("Couldn't read file: " << filename);
-    return NULL;
-  }
-
-  return videoCameraNode.GetPointer();
-}
-
-//---------------------------------------------------------------------------
-void vtkSlicerVideoCamerasLogic::SetMRMLSceneInternal(vtkMRMLScene* newScene)
-{
-  vtkNew<vtkIntArray> events;
-  events->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
-  events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
-  events->InsertNextValue(vtkMRMLScene::EndBatchProcessEvent);
-  this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer());
-}
-
-//-----------------------------------------------------------------------------
-void vtkSlicerVideoCamerasLogic::RegisterNodes()
-{
-  assert(this->GetMRMLScene() != 0);
-
-  vtkMRMLScene* scene = this->GetMRMLScene();
-
-  // Nodes
-  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLVideoCameraNode>::New());
-  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLVideoCameraStorageNode>::New());
-}
-
-//---------------------------------------------------------------------------
-void vtkSlicerVideoCamerasLogic::UpdateFromMRMLScene()
-{
-  assert(this->GetMRMLScene() != 0);
-}
-
-//---------------------------------------------------------------------------
-void vtkSlicerVideoCamerasLogic
-::OnMRMLSceneNodeAdded(vtkMRMLNode* vtkNotUsed(node))
-{
-}
-
-//---------------------------------------------------------------------------
-void vtkSlicerVideoCamerasLogic
-::OnMRMLSceneNodeRemoved(vtkMRMLNode* vtkNotUsed(node))
-{
-}
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCamerasLogic.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras Logic includes
+#include "vtkSlicerVideoCamerasLogic.h"
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkMRMLVideoCameraStorageNode.h"
+#include "vtkVideoCameraRegistry.h"
+#include "vtkVideoCameraRig.h"
+
+// MRML includes
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// ITK includes
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
+//----------------------------------------------------------------------------
+class vtkSlicerVideoCamerasLogic::vtkInternal
+{
+public:
+  /// Everything needed to restore or recreate a camera node
+  /// The encoder value is runtime state streamed from the lens (and the intrinsics and distortion
+  /// follow it when the camera has a calibration table), it is not part of the recorded state.
+  struct CameraState
+  {
+    struct TableEntry
+    {
+      double              EncoderValue;
+      double              Intrinsics[9];
+      std::vector<double> DistortionCoefficients;
+    };
+
+    std::string             Name;
+    std::string             StorageFileName;
+    int                     CameraModel;
+    double                  Xi;
+    double                  Intrinsics[9];
+    std::vector<double>     DistortionCoefficients;
+    std::vector<double>     CameraPlaneOffset;
+    double                  MarkerToImageSensor[16];
+    double                  ReprojectionError;
+    double                  RegistrationError;
+    std::vector<TableEntry> CalibrationTable;
+    double                  EncoderBucketSize;
+  };
+
+  /// Transform node added together with cameras, e.g. the extrinsics of a rig
+  struct TransformState
+  {
+    std::string Name;
+    double      Matrix[16];
+  };
+
+  struct Operation
+  {
+    enum OperationType
+    {
+      AddNode,
+      RemoveNode,
+      ModifyNode,
+      AddTransformNode,
+      /// Operations undone and redone as one step
+      Batch
+    };
+
+    OperationType Type;
+    std::string   NodeID;
+    /// State before the operation, unused for AddNode
+    CameraState   Before;
+    /// State after the operation, unused for RemoveNode
+    CameraState   After;
+    /// Added transform, AddTransformNode only
+    TransformState Transform;
+    /// Batch only, applied in order and reverted in reverse order
+    std::vector<Operation> Operations;
+  };
+
+  static void GetState(vtkMRMLVideoCameraNode* node, CameraState& state);
+  static void SetState(vtkMRMLVideoCameraNode* node, const CameraState& state);
+  static bool HaveSameParameters(const CameraState& a, const CameraState& b);
+  /// True if a sequence browser writes the node, e.g. a proxy node replaying recorded cameras
+  static bool IsSequenceProxyNode(vtkMRMLNode* node);
+
+  /// Recreate a removed camera node (and its storage node), returns the new node
+  static vtkMRMLVideoCameraNode* AddCameraNode(vtkMRMLScene* scene, const CameraState& state);
+  static void RemoveCameraNode(vtkMRMLScene* scene, vtkMRMLVideoCameraNode* node);
+
+  void Push(const Operation& operation, int maximumNumberOfLevels);
+  /// Node IDs are not preserved when a node is recreated, update the recorded operations
+  void RenameNodeID(const std::string& oldID, const std::string& newID);
+  static void RenameNodeID(Operation& operation, const std::string& oldID, const std::string& newID);
+  /// Revert (undo) or replay (redo) an operation, without recording it
+  bool Apply(vtkMRMLScene* scene, Operation& operation, bool undo);
+
+public:
+  std::deque<Operation>               UndoStack;
+  std::deque<Operation>               RedoStack;
+  /// Last known state of every camera node in the scene, keyed by node ID
+  std::map<std::string, CameraState>  CurrentStates;
+  /// Recording is suspended while the logic itself adds or modifies cameras
+  int                                 SuspendRecording = 0;
+
+  vtkSmartPointer<vtkVideoCameraRegistry> Registry = vtkSmartPointer<vtkVideoCameraRegistry>::New();
+};
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::vtkInternal::GetState(vtkMRMLVideoCameraNode* node, CameraState& state)
+{
+  state.Name = node->GetName() ? node->GetName() : "";
+  state.StorageFileName.clear();
+  if (node->GetScene() != nullptr && node->GetStorageNode() != nullptr && node->GetStorageNode()->GetFileName() != nullptr)
+  {
+    state.StorageFileName = node->GetStorageNode()->GetFileName();
+  }
+
+  state.CameraModel = node->GetCameraModel();
+  state.Xi = node->GetXi();
+
+  for (int i = 0; i < 9; ++i)
+  {
+    state.Intrinsics[i] = node->GetIntrinsicMatrix() ? node->GetIntrinsicMatrix()->GetElement(i / 3, i % 3) : (i % 4 == 0 ? 1.0 : 0.0);
+  }
+  for (int i = 0; i < 16; ++i)
+  {
+    state.MarkerToImageSensor[i] = node->GetMarkerToImageSensorTransform() ? node->GetMarkerToImageSensorTransform()->GetElement(i / 4, i % 4) : (i % 5 == 0 ? 1.0 : 0.0);
+  }
+
+  state.DistortionCoefficients.clear();
+  vtkDoubleArray* distCoeffs = node->GetDistortionCoefficients();
+  for (vtkIdType i = 0; distCoeffs != nullptr && i < distCoeffs->GetNumberOfTuples(); ++i)
+  {
+    state.DistortionCoefficients.push_back(distCoeffs->GetValue(i));
+  }
+  state.CameraPlaneOffset.clear();
+  vtkDoubleArray* planeOffset = node->GetCameraPlaneOffset();
+  for (vtkIdType i = 0; planeOffset != nullptr && i < planeOffset->GetNumberOfTuples(); ++i)
+  {
+    state.CameraPlaneOffset.push_back(planeOffset->GetValue(i));
+  }
+
+  state.ReprojectionError = node->GetReprojectionError();
+  state.RegistrationError = node->GetRegistrationError();
+  state.EncoderBucketSize = node->GetEncoderBucketSize();
+
+  state.CalibrationTable.resize(node->GetNumberOfCalibrationTableEntries());
+  vtkNew<vtkMatrix3x3> intrinsics;
+  vtkNew<vtkDoubleArray> entryCoeffs;
+  for (int i = 0; i < node->GetNumberOfCalibrationTableEntries(); ++i)
+  {
+    CameraState::TableEntry& entry = state.CalibrationTable[i];
+    node->GetCalibrationTableEntry(i, intrinsics.GetPointer(), entryCoeffs.GetPointer());
+    entry.EncoderValue = node->GetCalibrationTableEncoderValue(i);
+    for (int j = 0; j < 9; ++j)
+    {
+      entry.Intrinsics[j] = intrinsics->GetElement(j / 3, j % 3);
+    }
+    entry.DistortionCoefficients.assign(entryCoeffs->GetPointer(0), entryCoeffs->GetPointer(0) + entryCoeffs->GetNumberOfTuples());
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::vtkInternal::SetState(vtkMRMLVideoCameraNode* node, const CameraState& state)
+{
+  int wasModifying = node->StartModify();
+
+  node->RemoveAllCalibrationTableEntries();
+  vtkNew<vtkMatrix3x3> entryIntrinsics;
+  vtkNew<vtkDoubleArray> entryCoeffs;
+  for (std::vector<CameraState::TableEntry>::const_iterator it = state.CalibrationTable.begin(); it != state.CalibrationTable.end(); ++it)
+  {
+    entryIntrinsics->DeepCopy(it->Intrinsics);
+    entryCoeffs->SetNumberOfValues(static_cast<vtkIdType>(it->DistortionCoefficients.size()));
+    for (size_t i = 0; i < it->DistortionCoefficients.size(); ++i)
+    {
+      entryCoeffs->SetValue(static_cast<vtkIdType>(i), it->DistortionCoefficients[i]);
+    }
+    node->AddCalibrationTableEntry(it->EncoderValue, entryIntrinsics.GetPointer(), entryCoeffs.GetPointer());
+  }
+  node->SetEncoderBucketSize(state.EncoderBucketSize);
+
+  node->SetCameraModel(state.CameraModel);
+  node->SetXi(state.Xi);
+
+  if (state.CalibrationTable.empty())
+  {
+    vtkNew<vtkMatrix3x3> intrinsics;
+    intrinsics->DeepCopy(state.Intrinsics);
+    node->SetAndObserveIntrinsicMatrix(intrinsics.GetPointer());
+
+    vtkNew<vtkDoubleArray> distCoeffs;
+    for (std::vector<double>::const_iterator it = state.DistortionCoefficients.begin(); it != state.DistortionCoefficients.end(); ++it)
+    {
+      distCoeffs->InsertNextValue(*it);
+    }
+    node->SetAndObserveDistortionCoefficients(distCoeffs.GetPointer());
+  }
+  else
+  {
+    // intrinsics and distortion follow the restored table at the current encoder value
+    node->SetEncoderValue(node->GetEncoderValue());
+  }
+
+  vtkNew<vtkDoubleArray> planeOffset;
+  for (std::vector<double>::const_iterator it = state.CameraPlaneOffset.begin(); it != state.CameraPlaneOffset.end(); ++it)
+  {
+    planeOffset->InsertNextValue(*it);
+  }
+  node->SetAndObserveCameraPlaneOffset(planeOffset.GetPointer());
+
+  vtkNew<vtkMatrix4x4> markerToImageSensor;
+  markerToImageSensor->DeepCopy(state.MarkerToImageSensor);
+  node->SetAndObserveMarkerToImageSensorTransform(markerToImageSensor.GetPointer());
+
+  node->SetReprojectionError(state.ReprojectionError);
+  node->SetRegistrationError(state.RegistrationError);
+
+  node->EndModify(wasModifying);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCamerasLogic::vtkInternal::HaveSameParameters(const CameraState& a, const CameraState& b)
+{
+  if (a.CameraModel != b.CameraModel ||
+      a.Xi != b.Xi ||
+      !std::equal(a.MarkerToImageSensor, a.MarkerToImageSensor + 16, b.MarkerToImageSensor) ||
+      a.CameraPlaneOffset != b.CameraPlaneOffset ||
+      a.ReprojectionError != b.ReprojectionError ||
+      a.RegistrationError != b.RegistrationError ||
+      a.EncoderBucketSize != b.EncoderBucketSize ||
+      a.CalibrationTable.size() != b.CalibrationTable.size())
+  {
+    return false;
+  }
+  // with a calibration table, intrinsics and distortion are applied from the table when the
+  // encoder value changes: zoom updates are not recorded, table edits are
+  if (a.CalibrationTable.empty() &&
+      (!std::equal(a.Intrinsics, a.Intrinsics + 9, b.Intrinsics) || a.DistortionCoefficients != b.DistortionCoefficients))
+  {
+    return false;
+  }
+  for (size_t i = 0; i < a.CalibrationTable.size(); ++i)
+  {
+    if (a.CalibrationTable[i].EncoderValue != b.CalibrationTable[i].EncoderValue ||
+        !std::equal(a.CalibrationTable[i].Intrinsics, a.CalibrationTable[i].Intrinsics + 9, b.CalibrationTable[i].Intrinsics) ||
+        a.CalibrationTable[i].DistortionCoefficients != b.CalibrationTable[i].DistortionCoefficients)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCamerasLogic::vtkInternal::IsSequenceProxyNode(vtkMRMLNode* node)
+{
+  vtkMRMLScene* scene = node->GetScene();
+  if (scene == nullptr)
+  {
+    return false;
+  }
+  // by class name, the Sequences module is not a dependency
+  std::vector<vtkMRMLNode*> referencingNodes;
+  scene->GetReferencingNodes(node, referencingNodes);
+  for (std::vector<vtkMRMLNode*>::iterator it = referencingNodes.begin(); it != referencingNodes.end(); ++it)
+  {
+    if ((*it)->IsA("vtkMRMLSequenceBrowserNode"))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* vtkSlicerVideoCamerasLogic::vtkInternal::AddCameraNode(vtkMRMLScene* scene, const CameraState& state)
+{
+  vtkNew<vtkMRMLVideoCameraNode> videoCameraNode;
+  videoCameraNode->SetName(state.Name.c_str());
+  vtkInternal::SetState(videoCameraNode.GetPointer(), state);
+
+  if (!state.StorageFileName.empty())
+  {
+    vtkSmartPointer<vtkMRMLStorageNode> storageNode = vtkSmartPointer<vtkMRMLStorageNode>::Take(videoCameraNode->CreateDefaultStorageNode());
+    storageNode->SetFileName(state.StorageFileName.c_str());
+    scene->AddNode(storageNode);
+    videoCameraNode->SetScene(scene);
+    videoCameraNode->SetAndObserveStorageNodeID(storageNode->GetID());
+  }
+
+  scene->AddNode(videoCameraNode.GetPointer());
+  return videoCameraNode.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::vtkInternal::RemoveCameraNode(vtkMRMLScene* scene, vtkMRMLVideoCameraNode* node)
+{
+  vtkSmartPointer<vtkMRMLStorageNode> storageNode = node->GetStorageNode();
+  scene->RemoveNode(node);
+  if (storageNode != nullptr)
+  {
+    scene->RemoveNode(storageNode);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::vtkInternal::Push(const Operation& operation, int maximumNumberOfLevels)
+{
+  this->UndoStack.push_back(operation);
+  while (static_cast<int>(this->UndoStack.size()) > maximumNumberOfLevels)
+  {
+    this->UndoStack.pop_front();
+  }
+  this->RedoStack.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::vtkInternal::RenameNodeID(const std::string& oldID, const std::string& newID)
+{
+  for (std::deque<Operation>::iterator it = this->UndoStack.begin(); it != this->UndoStack.end(); ++it)
+  {
+    RenameNodeID(*it, oldID, newID);
+  }
+  for (std::deque<Operation>::iterator it = this->RedoStack.begin(); it != this->RedoStack.end(); ++it)
+  {
+    RenameNodeID(*it, oldID, newID);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::vtkInternal::RenameNodeID(Operation& operation, const std::string& oldID, const std::string& newID)
+{
+  if (operation.NodeID == oldID)
+  {
+    operation.NodeID = newID;
+  }
+  for (std::vector<Operation>::iterator it = operation.Operations.begin(); it != operation.Operations.end(); ++it)
+  {
+    RenameNodeID(*it, oldID, newID);
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVideoCamerasLogic::vtkInternal::Apply(vtkMRMLScene* scene, Operation& operation, bool undo)
+{
+  if (operation.Type == Operation::Batch)
+  {
+    for (size_t i = 0; i < operation.Operations.size(); ++i)
+    {
+      if (!this->Apply(scene, operation.Operations[undo ? operation.Operations.size() - 1 - i : i], undo))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  if (operation.Type == Operation::AddTransformNode)
+  {
+    if (undo)
+    {
+      vtkMRMLNode* transformNode = scene->GetNodeByID(operation.NodeID.c_str());
+      if (transformNode == nullptr)
+      {
+        vtkErrorWithObjectMacro(scene, "Apply: transform node " << operation.NodeID << " is no longer in the scene");
+        return false;
+      }
+      scene->RemoveNode(transformNode);
+    }
+    else
+    {
+      vtkNew<vtkMRMLLinearTransformNode> transformNode;
+      transformNode->SetName(operation.Transform.Name.c_str());
+      vtkNew<vtkMatrix4x4> matrix;
+      matrix->DeepCopy(operation.Transform.Matrix);
+      transformNode->SetMatrixTransformToParent(matrix.GetPointer());
+      scene->AddNode(transformNode.GetPointer());
+      std::string oldID = operation.NodeID;
+      this->RenameNodeID(oldID, transformNode->GetID());
+      operation.NodeID = transformNode->GetID();
+    }
+    return true;
+  }
+
+  vtkMRMLVideoCameraNode* videoCameraNode = vtkMRMLVideoCameraNode::SafeDownCast(scene->GetNodeByID(operation.NodeID.c_str()));
+
+  bool addNode = (operation.Type == Operation::AddNode && !undo) || (operation.Type == Operation::RemoveNode && undo);
+  if (!addNode && videoCameraNode == nullptr)
+  {
+    vtkErrorWithObjectMacro(scene, "Apply: camera node " << operation.NodeID << " is no longer in the scene");
+    return false;
+  }
+
+  this->SuspendRecording++;
+  if (operation.Type == Operation::ModifyNode)
+  {
+    SetState(videoCameraNode, undo ? operation.Before : operation.After);
+  }
+  else if (addNode)
+  {
+    videoCameraNode = AddCameraNode(scene, undo ? operation.Before : operation.After);
+    std::string oldID = operation.NodeID;
+    this->RenameNodeID(oldID, videoCameraNode->GetID());
+    operation.NodeID = videoCameraNode->GetID();
+  }
+  else
+  {
+    RemoveCameraNode(scene, videoCameraNode);
+  }
+  this->SuspendRecording--;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVideoCamerasLogic);
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCamerasLogic::vtkSlicerVideoCamerasLogic()
+  : Internal(new vtkInternal)
+  , MaximumNumberOfUndoLevels(100)
+  , UndoEnabled(true)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVideoCamerasLogic::~vtkSlicerVideoCamerasLogic()
+{
+  vtkVideoCameraRegistry::SetSceneRegistry(this->GetMRMLScene(), nullptr);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "UndoEnabled: " << (this->UndoEnabled ? "true" : "false") << std::endl;
+  os << indent << "MaximumNumberOfUndoLevels: " << this->MaximumNumberOfUndoLevels << std::endl;
+  os << indent << "NumberOfUndoLevels: " << this->GetNumberOfUndoLevels() << std::endl;
+  os << indent << "NumberOfRedoLevels: " << this->GetNumberOfRedoLevels() << std::endl;
+  os << indent << "NumberOfRegisteredCameras: " << this->Internal->Registry->GetNumberOfNodes() << std::endl;
+}
+
+//----------------------------------------------------------------------------
+vtkVideoCameraRegistry* vtkSlicerVideoCamerasLogic::GetRegistry() const
+{
+  return this->Internal->Registry;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* vtkSlicerVideoCamerasLogic::AddVideoCamera(const char* filename, const char* nodeName /*= NULL*/)
+{
+  if (this->GetMRMLScene() == NULL || filename == NULL)
+  {
+    return NULL;
+  }
+  vtkNew<vtkMRMLVideoCameraNode> videoCameraNode;
+  vtkNew<vtkMRMLVideoCameraStorageNode> mStorageNode;
+  vtkSmartPointer<vtkMRMLStorageNode> storageNode;
+
+  mStorageNode->SetFileName(filename);
+
+  const std::string fname(filename);
+  // the VideoCamera node name is based on the file name (itksys call should work even if file is not on disk yet)
+  std::string name = itksys::SystemTools::GetFilenameName(fname);
+
+  // check to see which node can read this type of file
+  if (mStorageNode->SupportedFileType(name.c_str()))
+  {
+    storageNode = mStorageNode.GetPointer();
+  }
+
+  if (storageNode != NULL)
+  {
+    std::string baseName = itksys::SystemTools::GetFilenameWithoutExtension(fname);
+    std::string uname(this->GetMRMLScene()->GetUniqueNameByString(baseName.c_str()));
+    videoCameraNode->SetName(uname.c_str());
+
+    // record the load as a single camera operation instead of snapshotting the whole scene
+    bool recordUndo = this->IsUndoRecording();
+    this->Internal->SuspendRecording++;
+
+    this->GetMRMLScene()->AddNode(storageNode.GetPointer());
+
+    // Set the scene so that SetAndObserve[Display|Storage]NodeID can find the
+    // node in the scene (so that DisplayNodes return something not empty)
+    videoCameraNode->SetScene(this->GetMRMLScene());
+    videoCameraNode->SetAndObserveStorageNodeID(storageNode->GetID());
+
+    this->GetMRMLScene()->AddNode(videoCameraNode.GetPointer());
+
+    // now set up the reading
+    vtkDebugMacro("AddVideoCamera: calling read on the storage node");
+    int retval = storageNode->ReadData(videoCameraNode.GetPointer());
+    if (retval != 1)
+    {
+      vtkErrorMacro("AddVideoCamera: error reading " << filename);
+      this->GetMRMLScene()->RemoveNode(videoCameraNode.GetPointer());
+      this->Internal->SuspendRecording--;
+      return NULL;
+    }
+
+    this->Internal->SuspendRecording--;
+    if (recordUndo)
+    {
+      vtkInternal::Operation operation;
+      operation.Type = vtkInternal::Operation::AddNode;
+      operation.NodeID = videoCameraNode->GetID();
+      vtkInternal::GetState(videoCameraNode.GetPointer(), operation.After);
+      this->Internal->Push(operation, this->MaximumNumberOfUndoLevels);
+      this->Modified();
+    }
+  }
+  else
+  {
+    vtkErrorMacro("Couldn't read file: " << filename);
+    return NULL;
+  }
+
+  return videoCameraNode.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCamerasLogic::AddVideoCameraRig(const char* filename, vtkCollection* addedNodes /*= NULL*/)
+{
+  if (this->GetMRMLScene() == NULL || filename == NULL)
+  {
+    return -1;
+  }
+
+  vtkNew<vtkVideoCameraRig> rig;
+  if (!vtkMRMLVideoCameraStorageNode::ReadRig(filename, rig.GetPointer()))
+  {
+    vtkErrorMacro("AddVideoCameraRig: error reading " << filename);
+    return -1;
+  }
+
+  // record the load as camera operations instead of snapshotting the whole scene
+  bool recordUndo = this->IsUndoRecording();
+  this->Internal->SuspendRecording++;
+  this->GetMRMLScene()->StartState(vtkMRMLScene::BatchProcessState);
+
+  // the whole rig is a single undo step
+  vtkInternal::Operation batch;
+  batch.Type = vtkInternal::Operation::Batch;
+
+  std::vector<vtkMRMLVideoCameraNode*> cameras;
+  for (int i = 0; i < rig->GetNumberOfCameras(); ++i)
+  {
+    vtkMRMLVideoCameraNode* videoCameraNode = rig->GetCamera(i);
+    videoCameraNode->SetName(this->GetMRMLScene()->GetUniqueNameByString(rig->GetCameraName(i)).c_str());
+    this->GetMRMLScene()->AddNode(videoCameraNode);
+    cameras.push_back(videoCameraNode);
+    if (addedNodes != NULL)
+    {
+      addedNodes->AddItem(videoCameraNode);
+    }
+
+    vtkInternal::Operation operation;
+    operation.Type = vtkInternal::Operation::AddNode;
+    operation.NodeID = videoCameraNode->GetID();
+    vtkInternal::GetState(videoCameraNode, operation.After);
+    batch.Operations.push_back(operation);
+  }
+
+  vtkNew<vtkMatrix4x4> fromToTo;
+  for (int i = 0; i < rig->GetNumberOfExtrinsics(); ++i)
+  {
+    rig->GetExtrinsics(i, fromToTo.GetPointer());
+    // named after the camera nodes, which may have been renamed to be unique in the scene
+    std::string from = rig->GetExtrinsicsFrom(i);
+    std::string to = rig->GetExtrinsicsTo(i);
+    const int fromIndex = rig->GetCameraIndex(from.c_str());
+    const int toIndex = rig->GetCameraIndex(to.c_str());
+    if (fromIndex >= 0 && fromIndex < static_cast<int>(cameras.size()))
+    {
+      from = cameras[fromIndex]->GetName();
+    }
+    if (toIndex >= 0 && toIndex < static_cast<int>(cameras.size()))
+    {
+      to = cameras[toIndex]->GetName();
+    }
+    vtkNew<vtkMRMLLinearTransformNode> transformNode;
+    transformNode->SetName(this->GetMRMLScene()->GetUniqueNameByString((from + "To" + to).c_str()).c_str());
+    transformNode->SetMatrixTransformToParent(fromToTo.GetPointer());
+    this->GetMRMLScene()->AddNode(transformNode.GetPointer());
+    if (addedNodes != NULL)
+    {
+      addedNodes->AddItem(transformNode.GetPointer());
+    }
+
+    vtkInternal::Operation operation;
+    operation.Type = vtkInternal::Operation::AddTransformNode;
+    operation.NodeID = transformNode->GetID();
+    operation.Transform.Name = transformNode->GetName();
+    for (int j = 0; j < 16; ++j)
+    {
+      operation.Transform.Matrix[j] = fromToTo->GetElement(j / 4, j % 4);
+    }
+    batch.Operations.push_back(operation);
+  }
+
+  this->GetMRMLScene()->EndState(vtkMRMLScene::BatchProcessState);
+  this->Internal->SuspendRecording--;
+
+  if (recordUndo && !batch.Operations.empty())
+  {
+    this->Internal->Push(batch, this->MaximumNumberOfUndoLevels);
+    this->Modified();
+  }
+
+  return static_cast<int>(cameras.size());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::SetMRMLSceneInternal(vtkMRMLScene* newScene)
+{
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
+  events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
+  events->InsertNextValue(vtkMRMLScene::EndBatchProcessEvent);
+  events->InsertNextValue(vtkMRMLScene::EndCloseEvent);
+
+  vtkVideoCameraRegistry::SetSceneRegistry(this->GetMRMLScene(), nullptr);
+  this->Internal->Registry->RemoveAllNodes();
+  this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer());
+  vtkVideoCameraRegistry::SetSceneRegistry(newScene, this->Internal->Registry);
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::RegisterNodes()
+{
+  assert(this->GetMRMLScene() != 0);
+
+  vtkMRMLScene* scene = this->GetMRMLScene();
+
+  // Nodes
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLVideoCameraNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLVideoCameraStorageNode>::New());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::UpdateFromMRMLScene()
+{
+  assert(this->GetMRMLScene() != 0);
+
+  // pick up cameras added while the logic was not observing (e.g. during batch processing)
+  std::vector<vtkMRMLNode*> nodes;
+  this->GetMRMLScene()->GetNodesByClass("vtkMRMLVideoCameraNode", nodes);
+  for (std::vector<vtkMRMLNode*>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+  {
+    vtkMRMLVideoCameraNode* videoCameraNode = vtkMRMLVideoCameraNode::SafeDownCast(*it);
+    if (videoCameraNode == nullptr || this->Internal->CurrentStates.count(videoCameraNode->GetID()) > 0)
+    {
+      continue;
+    }
+    this->Internal->Registry->UpdateNode(videoCameraNode);
+    vtkNew<vtkIntArray> events;
+    events->InsertNextValue(vtkCommand::ModifiedEvent);
+    vtkObserveMRMLNodeEventsMacro(videoCameraNode, events.GetPointer());
+    vtkInternal::GetState(videoCameraNode, this->Internal->CurrentStates[videoCameraNode->GetID()]);
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic
+::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
+{
+  vtkMRMLVideoCameraNode* videoCameraNode = vtkMRMLVideoCameraNode::SafeDownCast(node);
+  if (videoCameraNode == nullptr || videoCameraNode->GetID() == nullptr)
+  {
+    return;
+  }
+
+  this->Internal->Registry->UpdateNode(videoCameraNode);
+
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkCommand::ModifiedEvent);
+  vtkObserveMRMLNodeEventsMacro(videoCameraNode, events.GetPointer());
+
+  vtkInternal::CameraState& state = this->Internal->CurrentStates[videoCameraNode->GetID()];
+  vtkInternal::GetState(videoCameraNode, state);
+
+  if (this->IsUndoRecording(videoCameraNode))
+  {
+    vtkInternal::Operation operation;
+    operation.Type = vtkInternal::Operation::AddNode;
+    operation.NodeID = videoCameraNode->GetID();
+    operation.After = state;
+    this->Internal->Push(operation, this->MaximumNumberOfUndoLevels);
+    this->Modified();
+  }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic
+::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  vtkMRMLVideoCameraNode* videoCameraNode = vtkMRMLVideoCameraNode::SafeDownCast(node);
+  if (videoCameraNode == nullptr || videoCameraNode->GetID() == nullptr)
+  {
+    return;
+  }
+
+  vtkUnObserveMRMLNodeMacro(videoCameraNode);
+  this->Internal->Registry->RemoveNode(videoCameraNode);
+
+  std::map<std::string, vtkInternal::CameraState>::iterator it = this->Internal->CurrentStates.find(videoCameraNode->GetID());
+  if (it == this->Internal->CurrentStates.end())
+  {
+    return;
+  }
+
+  if (this->IsUndoRecording(videoCameraNode))
+  {
+    // the storage node may already be gone, so the last known state is recorded
+    vtkInternal::Operation operation;
+    operation.Type = vtkInternal::Operation::RemoveNode;
+    operation.NodeID = it->first;
+    operation.Before = it->second;
+    this->Internal->Push(operation, this->MaximumNumberOfUndoLevels);
+    this->Modified();
+  }
+  this->Internal->CurrentStates.erase(it);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::OnMRMLSceneEndClose()
+{
+  this->Internal->CurrentStates.clear();
+  this->Internal->Registry->RemoveAllNodes();
+  this->ClearUndoStack();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  this->Superclass::ProcessMRMLNodesEvents(caller, event, callData);
+
+  vtkMRMLVideoCameraNode* videoCameraNode = vtkMRMLVideoCameraNode::SafeDownCast(caller);
+  if (videoCameraNode == nullptr || event != vtkCommand::ModifiedEvent || videoCameraNode->GetID() == nullptr)
+  {
+    return;
+  }
+
+  // name, storage node or serial may have changed
+  this->Internal->Registry->UpdateNode(videoCameraNode);
+
+  std::map<std::string, vtkInternal::CameraState>::iterator it = this->Internal->CurrentStates.find(videoCameraNode->GetID());
+  if (it == this->Internal->CurrentStates.end())
+  {
+    return;
+  }
+
+  vtkInternal::Operation operation;
+  vtkInternal::GetState(videoCameraNode, operation.After);
+  if (vtkInternal::HaveSameParameters(it->second, operation.After))
+  {
+    // name or storage change only, not recorded
+    it->second = operation.After;
+    return;
+  }
+
+  // changes that are not recorded still update the state later edits are undone to
+  if (this->IsUndoRecording(videoCameraNode))
+  {
+    operation.Type = vtkInternal::Operation::ModifyNode;
+    operation.NodeID = it->first;
+    operation.Before = it->second;
+    this->Internal->Push(operation, this->MaximumNumberOfUndoLevels);
+    this->Modified();
+  }
+  it->second = operation.After;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVideoCamerasLogic::IsUndoRecording()
+{
+  vtkMRMLScene* scene = this->GetMRMLScene();
+  return this->UndoEnabled && this->Internal->SuspendRecording == 0 && scene != nullptr &&
+         !scene->IsImporting() && !scene->IsRestoring() && !scene->IsClosing();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVideoCamerasLogic::IsUndoRecording(vtkMRMLVideoCameraNode* node)
+{
+  return this->IsUndoRecording() && node->GetUndoEnabled() && !vtkInternal::IsSequenceProxyNode(node);
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVideoCamerasLogic::Undo()
+{
+  if (this->GetMRMLScene() == nullptr || this->Internal->UndoStack.empty())
+  {
+    return false;
+  }
+
+  vtkInternal::Operation operation = this->Internal->UndoStack.back();
+  this->Internal->UndoStack.pop_back();
+  if (!this->Internal->Apply(this->GetMRMLScene(), operation, true))
+  {
+    // kept, e.g. to be undone once its node is back in the scene
+    this->Internal->UndoStack.push_back(operation);
+    return false;
+  }
+  this->Internal->RedoStack.push_back(operation);
+  this->Modified();
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerVideoCamerasLogic::Redo()
+{
+  if (this->GetMRMLScene() == nullptr || this->Internal->RedoStack.empty())
+  {
+    return false;
+  }
+
+  vtkInternal::Operation operation = this->Internal->RedoStack.back();
+  this->Internal->RedoStack.pop_back();
+  if (!this->Internal->Apply(this->GetMRMLScene(), operation, false))
+  {
+    this->Internal->RedoStack.push_back(operation);
+    return false;
+  }
+  this->Internal->UndoStack.push_back(operation);
+  this->Modified();
+  return true;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerVideoCamerasLogic::GetNumberOfUndoLevels() const
+{
+  return static_cast<int>(this->Internal->UndoStack.size());
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerVideoCamerasLogic::GetNumberOfRedoLevels() const
+{
+  return static_cast<int>(this->Internal->RedoStack.size());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::ClearUndoStack()
+{
+  this->Internal->UndoStack.clear();
+  this->Internal->RedoStack.clear();
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerVideoCamerasLogic::SetMaximumNumberOfUndoLevels(int levels)
+{
+  levels = std::max(levels, 0);
+  if (this->MaximumNumberOfUndoLevels == levels)
+  {
+    return;
+  }
+
+  this->MaximumNumberOfUndoLevels = levels;
+  while (static_cast<int>(this->Internal->UndoStack.size()) > levels)
+  {
+    this->Internal->UndoStack.pop_front();
+  }
+  this->Modified();
+}
@@ -1,67 +1,122 @@
-/*=auto=========================================================================
-
-Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
-
-See COPYRIGHT.txt
-or http://www.slicer.org/copyright/copyright.txt for details.
-
-Program:   3D Slicer
-Module:    $RCSfile: vtkSlicerVideoCamerasLogic.h,v $
-Date:      $Date: 2018/6/16 10:54:09 $
-Version:   $Revision: 1.0 $
-
-=========================================================================auto=*/
-
-// .NAME vtkSlicerVideoCamerasLogic - slicer logic class for volumes manipulation
-// .SECTION Description
-// This class manages the logic associated with reading, saving,
-// and changing propertied of the volumes
-
-
-#ifndef __vtkSlicerVideoCamerasLogic_h
-#define __vtkSlicerVideoCamerasLogic_h
-
-// Slicer includes
-#include "vtkSlicerModuleLogic.h"
-
-// MRML includes
-
-// STD includes
-#include <cstdlib>
-
-#include "vtkSlicerVideoCamerasModuleLogicExport.h"
-
-class vtkMRMLVideoCameraNode;
-
-/// \ingroup Slicer_QtModules_ExtensionTemplate
-class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCamerasLogic :
-  public vtkSlicerModuleLogic
-{
-public:
-  static vtkSlicerVideoCamerasLogic* New();
-  vtkTypeMacro(vtkSlicerVideoCamerasLogic, vtkSlicerModuleLogic);
-  void PrintSelf(ostream& os, vtkIndent indent);
-
-  ///
-  /// Add into the scene a new mrml videoCamera node and
-  /// read it's properties from a specified file
-  /// A storage node is also added into the scene
-  vtkMRMLVideoCameraNode* AddVideoCamera(const char* filename, const char* nodeName = NULL);
-
-protected:
-  vtkSlicerVideoCamerasLogic();
-  virtual ~vtkSlicerVideoCamerasLogic();
-
-  virtual void SetMRMLSceneInternal(vtkMRMLScene* newScene);
-  /// Register MRML Node classes to Scene. Gets called automatically when the MRMLScene is attached to this logic class.
-  virtual void RegisterNodes();
-  virtual void UpdateFromMRMLScene();
-  virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
-  virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
-private:
-
-  vtkSlicerVideoCamerasLogic(const vtkSlicerVideoCamerasLogic&); // Not implemented
-  void operator=(const vtkSlicerVideoCamerasLogic&); // Not implemented
-};
-
-#endif
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCamerasLogic.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkSlicerVideoCamerasLogic - slicer logic class for volumes manipulation
+// .SECTION Description
+// This class manages the logic associated with reading, saving,
+// and changing propertied of the volumes
+
+
+#ifndef __vtkSlicerVideoCamerasLogic_h
+#define __vtkSlicerVideoCamerasLogic_h
+
+// Slicer includes
+#include "vtkSlicerModuleLogic.h"
+
+// MRML includes
+
+// STD includes
+#include <cstdlib>
+
+#include "vtkSlicerVideoCamerasModuleLogicExport.h"
+
+class vtkCollection;
+class vtkMRMLVideoCameraNode;
+class vtkVideoCameraRegistry;
+
+/// \ingroup Slicer_QtModules_ExtensionTemplate
+class VTK_SLICER_VIDEOCAMERAS_MODULE_LOGIC_EXPORT vtkSlicerVideoCamerasLogic :
+  public vtkSlicerModuleLogic
+{
+public:
+  static vtkSlicerVideoCamerasLogic* New();
+  vtkTypeMacro(vtkSlicerVideoCamerasLogic, vtkSlicerModuleLogic);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  ///
+  /// Add into the scene a new mrml videoCamera node and
+  /// read it's properties from a specified file
+  /// A storage node is also added into the scene
+  vtkMRMLVideoCameraNode* AddVideoCamera(const char* filename, const char* nodeName = NULL);
+
+  ///
+  /// Add into the scene all cameras of a rig file (see vtkMRMLVideoCameraStorageNode::ReadRig),
+  /// and a linear transform node "<From>To<To>" for every extrinsics entry
+  /// The file is read once and the nodes are added in a single scene batch and a single undo
+  /// step. Transforms are named after the camera nodes, which get unique names in the scene. The
+  /// added camera and transform nodes are appended to addedNodes if not null. Returns the number
+  /// of cameras added, -1 on error.
+  int AddVideoCameraRig(const char* filename, vtkCollection* addedNodes = NULL);
+
+  ///
+  /// Index of the camera nodes of the scene by ID, name, storage node ID and device serial
+  /// Kept up to date from scene and node events, and attached to the scene for the storage nodes.
+  vtkVideoCameraRegistry* GetRegistry() const;
+
+  ///
+  /// Camera undo/redo
+  /// Only video camera node additions, removals and parameter changes are recorded, as compact
+  /// parameter snapshots, so that camera loads and calibration edits do not snapshot the whole scene.
+  /// Edits done between StartModify/EndModify of a camera node are recorded as a single step.
+  /// Nodes with undo disabled (vtkMRMLNode::SetUndoEnabled) and proxy nodes of a sequence browser
+  /// are not recorded. An operation that cannot be applied stays on its stack.
+  bool Undo();
+  bool Redo();
+  int GetNumberOfUndoLevels() const;
+  int GetNumberOfRedoLevels() const;
+  void ClearUndoStack();
+
+  ///
+  /// Maximum number of recorded camera operations, older operations are discarded (default 100)
+  void SetMaximumNumberOfUndoLevels(int levels);
+  vtkGetMacro(MaximumNumberOfUndoLevels, int);
+
+  ///
+  /// Enable/disable recording of camera operations (enabled by default)
+  vtkSetMacro(UndoEnabled, bool);
+  vtkGetMacro(UndoEnabled, bool);
+  vtkBooleanMacro(UndoEnabled, bool);
+
+protected:
+  vtkSlicerVideoCamerasLogic();
+  virtual ~vtkSlicerVideoCamerasLogic();
+
+  virtual void SetMRMLSceneInternal(vtkMRMLScene* newScene);
+  /// Register MRML Node classes to Scene. Gets called automatically when the MRMLScene is attached to this logic class.
+  virtual void RegisterNodes();
+  virtual void UpdateFromMRMLScene();
+  virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
+  virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
+  virtual void OnMRMLSceneEndClose();
+  virtual void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData);
+
+  /// True if camera operations should be recorded (enabled, not suspended, scene not being loaded or closed)
+  bool IsUndoRecording();
+  /// True if operations of this camera node should be recorded
+  bool IsUndoRecording(vtkMRMLVideoCameraNode* node);
+
+protected:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  int   MaximumNumberOfUndoLevels;
+  bool  UndoEnabled;
+
+private:
+
+  vtkSlicerVideoCamerasLogic(const vtkSlicerVideoCamerasLogic&); // Not implemented
+  void operator=(const vtkSlicerVideoCamerasLogic&); // Not implemented
+};
+
+#endif
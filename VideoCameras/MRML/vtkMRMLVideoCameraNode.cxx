@@ -1,210 +1,1091 @@
-/*=auto=========================================================================
-
-CLortions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
-
-See COPYRIGHT.txt
-or http://www.slicer.org/copyright/copyright.txt for details.
-
-Program:   3D Slicer
-Module:    $RCSfile: vtkMRMLVideoCameraNode.cxx,v $
-Date:      $Date: 2018/6/16 10:54:09 $
-Version:   $Revision: 1.0 $
-
-=========================================================================auto=*/
-
-#include "vtkMRMLVideoCameraNode.h"
-#include "vtkMRMLVideoCameraStorageNode.h"
-
-// VTK includes
-#include <vtkCallbackCommand.h>
-#include <vtkCommand.h>
-#include <vtkObjectFactory.h>
-#include <vtkXMLUtilities.h>
-
-// STL includes
-#include <sstream>
-
-//----------------------------------------------------------------------------
-
-vtkMRMLNodeNewMacro(vtkMRMLVideoCameraNode);
-
-//----------------------------------------------------------------------------
-
-//-----------------------------------------------------------------------------
-vtkMRMLVideoCameraNode::vtkMRMLVideoCameraNode()
-  : vtkMRMLStorableNode()
-  , IntrinsicMatrix(nullptr)
-  , DistortionCoefficients(nullptr)
-  , MarkerToImageSensorTransform(nullptr)
-  , CameraPlaneOffset(nullptr)
-  , ReprojectionError(-1.0)
-  , RegistrationError(-1.0)
-{
-  this->SetAndObserveIntrinsicMatrix(vtkSmartPointer<vtkMatrix3x3>::New());
-  this->SetAndObserveDistortionCoefficients(vtkSmartPointer<vtkDoubleArray>::New());
-  this->GetDistortionCoefficients()->SetNumberOfValues(5);
-  this->GetDistortionCoefficients()->FillValue(0.0);
-  this->SetAndObserveMarkerToImageSensorTransform(vtkSmartPointer<vtkMatrix4x4>::New());
-  this->SetAndObserveCameraPlaneOffset(vtkSmartPointer<vtkDoubleArray>::New());
-  this->GetCameraPlaneOffset()->SetNumberOfValues(3);
-  this->GetCameraPlaneOffset()->FillValue(0.0);
-}
-
-//-----------------------------------------------------------------------------
-vtkMRMLVideoCameraNode::~vtkMRMLVideoCameraNode()
-{
-  this->SetAndObserveIntrinsicMatrix(nullptr);
-  this->SetAndObserveDistortionCoefficients(nullptr);
-  this->SetAndObserveMarkerToImageSensorTransform(nullptr);
-  this->SetAndObserveCameraPlaneOffset(nullptr);
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::Copy(vtkMRMLNode* anode)
-{
-  int disabledModify = this->StartModify();
-  Superclass::Copy(anode);
-  vtkMRMLVideoCameraNode* node = vtkMRMLVideoCameraNode::SafeDownCast(anode);
-
-  this->GetIntrinsicMatrix()->DeepCopy(node->GetIntrinsicMatrix());
-  this->GetDistortionCoefficients()->DeepCopy(node->GetDistortionCoefficients());
-  this->GetMarkerToImageSensorTransform()->DeepCopy(node->GetMarkerToImageSensorTransform());
-  this->GetCameraPlaneOffset()->DeepCopy(node->GetCameraPlaneOffset());
-  this->SetReprojectionError(node->GetReprojectionError());
-  this->SetRegistrationError(node->GetRegistrationError());
-
-  this->EndModify(disabledModify);
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::SetAndObserveIntrinsicMatrix(vtkMatrix3x3* intrinsicMatrix)
-{
-  if (this->IntrinsicMatrix != NULL)
-  {
-    this->IntrinsicMatrix->RemoveObserver(this->IntrinsicObserverObserverTag);
-  }
-
-  this->SetIntrinsicMatrix(intrinsicMatrix);
-
-  if (this->IntrinsicMatrix != NULL)
-  {
-    this->IntrinsicObserverObserverTag = this->IntrinsicMatrix->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnIntrinsicsModified);
-  }
-
-  this->InvokeEvent(vtkMRMLVideoCameraNode::IntrinsicsModifiedEvent);
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::SetAndObserveDistortionCoefficients(vtkDoubleArray* distCoeffs)
-{
-  if (this->DistortionCoefficients != NULL)
-  {
-    this->DistortionCoefficients->RemoveObserver(this->DistortionCoefficientsObserverTag);
-  }
-
-  this->SetDistortionCoefficients(distCoeffs);
-
-  if (this->DistortionCoefficients != NULL)
-  {
-    this->DistortionCoefficientsObserverTag = this->DistortionCoefficients->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnDistortionCoefficientsModified);
-  }
-
-  this->InvokeEvent(vtkMRMLVideoCameraNode::DistortionCoefficientsModifiedEvent);
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::SetAndObserveCameraPlaneOffset(vtkDoubleArray* planeOffset)
-{
-  if (this->CameraPlaneOffset != NULL)
-  {
-    this->CameraPlaneOffset->RemoveObserver(this->CameraPlaneOffsetObserverTag);
-  }
-
-  this->SetCameraPlaneOffset(planeOffset);
-
-  if (this->CameraPlaneOffset != NULL)
-  {
-    this->CameraPlaneOffsetObserverTag = this->CameraPlaneOffset->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnCameraPlaneOffsetModified);
-  }
-
-  this->InvokeEvent(vtkMRMLVideoCameraNode::CameraPlaneOffsetModifiedEvent);
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::SetAndObserveMarkerToImageSensorTransform(vtkMatrix4x4* markerToImageSensorTransform)
-{
-  if (this->MarkerToImageSensorTransform != NULL)
-  {
-    this->MarkerToImageSensorTransform->RemoveObserver(this->MarkerTransformObserverTag);
-  }
-
-  this->SetMarkerToImageSensorTransform(markerToImageSensorTransform);
-
-  if (this->MarkerToImageSensorTransform != NULL)
-  {
-    this->MarkerTransformObserverTag = this->MarkerToImageSensorTransform->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnMarkerTransformModified);
-  }
-
-  this->InvokeEvent(vtkMRMLVideoCameraNode::MarkerToSensorTransformModifiedEvent);
-}
-
-//----------------------------------------------------------------------------
-vtkMRMLStorageNode* vtkMRMLVideoCameraNode::CreateDefaultStorageNode()
-{
-  return vtkMRMLVideoCameraStorageNode::New();
-}
-
-//----------------------------------------------------------------------------
-bool vtkMRMLVideoCameraNode::IsReprojectionErrorValid() const
-{
-  return this->ReprojectionError != -1.0;
-}
-
-//----------------------------------------------------------------------------
-bool vtkMRMLVideoCameraNode::IsRegistrationErrorValid() const
-{
-  return this->RegistrationError != -1.0;
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::OnIntrinsicsModified(vtkObject* caller, unsigned long event, void* data)
-{
-  this->InvokeEvent(IntrinsicsModifiedEvent);
-  this->Modified();
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::OnDistortionCoefficientsModified(vtkObject* caller, unsigned long event, void* data)
-{
-  this->InvokeEvent(DistortionCoefficientsModifiedEvent);
-  this->Modified();
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::OnCameraPlaneOffsetModified(vtkObject* caller, unsigned long event, void* data)
-{
-  this->InvokeEvent(CameraPlaneOffsetModifiedEvent);
-  this->Modified();
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::OnMarkerTransformModified(vtkObject* caller, unsigned long event, void* data)
-{
-  this->InvokeEvent(MarkerToSensorTransformModifiedEvent);
-  this->Modified();
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraNode::PrintSelf(ostream& os, vtkIndent indent)
-{
-  Superclass::PrintSelf(os, indent);
-
-  os << "Intrinsics: " << std::endl;
-  this->IntrinsicMatrix->PrintSelf(os, indent);
-  os << "Distortion Coefficients: " << std::endl;
-  this->DistortionCoefficients->PrintSelf(os, indent);
-  os << "MarkerToSensor Transform: " << std::endl;
-  this->MarkerToImageSensorTransform->PrintSelf(os, indent);
-  os << "Camera Plane Offset: " << std::endl;
-  this->CameraPlaneOffset->PrintSelf(os, indent);
-}
+/*=auto=========================================================================
+
+CLortions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkMRMLVideoCameraNode.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkMRMLVideoCameraStorageNode.h"
+#include "vtkVideoCameraObservations.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkXMLUtilities.h>
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+
+//----------------------------------------------------------------------------
+
+vtkMRMLNodeNewMacro(vtkMRMLVideoCameraNode);
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Space separated values, written with enough digits to read back the same doubles
+  std::string ToAttribute(const std::vector<double>& values)
+  {
+    std::ostringstream stream;
+    stream.precision(17);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+      stream << (i > 0 ? " " : "") << values[i];
+    }
+    return stream.str();
+  }
+
+  //----------------------------------------------------------------------------
+  std::vector<double> FromAttribute(const std::string& text)
+  {
+    std::vector<double> values;
+    std::istringstream stream(text);
+    double value;
+    while (stream >> value)
+    {
+      values.push_back(value);
+    }
+    return values;
+  }
+
+  //----------------------------------------------------------------------------
+  bool HasValues(vtkDoubleArray* array, const std::vector<double>& values)
+  {
+    if (array->GetNumberOfValues() != static_cast<vtkIdType>(values.size()))
+    {
+      return false;
+    }
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+      if (array->GetValue(static_cast<vtkIdType>(i)) != values[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void GetValues(vtkDoubleArray* array, std::vector<double>& values)
+  {
+    values.resize(static_cast<size_t>(array->GetNumberOfValues()));
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+      values[i] = array->GetValue(static_cast<vtkIdType>(i));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void SetValues(vtkDoubleArray* array, const std::vector<double>& values)
+  {
+    array->SetNumberOfValues(static_cast<vtkIdType>(values.size()));
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+      array->SetValue(static_cast<vtkIdType>(i), values[i]);
+    }
+    array->Modified();
+  }
+
+  //----------------------------------------------------------------------------
+  bool HasElements(vtkMatrix3x3* matrix, const double* elements)
+  {
+    for (int i = 0; i < 9; ++i)
+    {
+      if (matrix->GetElement(i / 3, i % 3) != elements[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool HasElements(vtkMatrix4x4* matrix, const double* elements)
+  {
+    for (int i = 0; i < 16; ++i)
+    {
+      if (matrix->GetElement(i / 4, i % 4) != elements[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode::ParameterBlock::ParameterBlock()
+  : DistortionCoefficients(5, 0.0)
+  , CameraPlaneOffset(3, 0.0)
+{
+  vtkMatrix3x3::Identity(this->Intrinsics);
+  vtkMatrix4x4::Identity(this->MarkerToImageSensorTransform);
+}
+
+//----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode::vtkMRMLVideoCameraNode()
+  : vtkMRMLStorableNode()
+  , Parameters(std::make_shared<ParameterBlock>())
+  , UpdatingViews(false)
+  , IntrinsicMatrix(nullptr)
+  , DistortionCoefficients(nullptr)
+  , MarkerToImageSensorTransform(nullptr)
+  , CameraPlaneOffset(nullptr)
+  , Observations(nullptr)
+  , CameraModel(PinholeCameraModel)
+  , Xi(0.0)
+  , InlineParameters(false)
+  , ReprojectionError(-1.0)
+  , RegistrationError(-1.0)
+  , EncoderValue(0.0)
+  , EncoderBucketSize(0.0)
+  , AppliedEncoderValue(std::numeric_limits<double>::quiet_NaN())
+{
+  // recorded by the camera undo of the module logic unless disabled
+  this->UndoEnabled = true;
+}
+
+//-----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode::~vtkMRMLVideoCameraNode()
+{
+  this->SetAndObserveIntrinsicMatrix(nullptr);
+  this->SetAndObserveDistortionCoefficients(nullptr);
+  this->SetAndObserveMarkerToImageSensorTransform(nullptr);
+  this->SetAndObserveCameraPlaneOffset(nullptr);
+  this->SetAndObserveObservations(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::Copy(vtkMRMLNode* anode)
+{
+  int disabledModify = this->StartModify();
+  Superclass::Copy(anode);
+  vtkMRMLVideoCameraNode* node = vtkMRMLVideoCameraNode::SafeDownCast(anode);
+
+  // share the parameter block, it is duplicated by whichever node is edited first
+  // both nodes may have views edited in place, e.g. this node still sharing the block of node
+  this->SynchronizeParameters();
+  node->SynchronizeParameters();
+  if (this->Parameters != node->Parameters)
+  {
+    this->Parameters = node->Parameters;
+    this->UpdateViews();
+    this->InvokeEvent(IntrinsicsModifiedEvent);
+    this->InvokeEvent(DistortionCoefficientsModifiedEvent);
+    this->InvokeEvent(CameraPlaneOffsetModifiedEvent);
+    this->InvokeEvent(MarkerToSensorTransformModifiedEvent);
+    this->InvokeEvent(CalibrationTableModifiedEvent);
+    this->Modified();
+  }
+  this->SetReprojectionError(node->GetReprojectionError());
+  this->SetRegistrationError(node->GetRegistrationError());
+  this->SetCameraModel(node->GetCameraModel());
+  this->SetXi(node->GetXi());
+  this->InlineParameters = node->InlineParameters;
+  this->EncoderValue = node->EncoderValue;
+  this->EncoderBucketSize = node->EncoderBucketSize;
+  this->AppliedEncoderValue = node->AppliedEncoderValue;
+  if (node->HasDeferredObservations())
+  {
+    // still unparsed, both nodes share the section and each parses it on first access
+    this->SetDeferredObservations(node->DeferredObservations);
+  }
+  else if (node->GetObservations() != nullptr)
+  {
+    // the points are shared until either node adds or removes views
+    vtkSmartPointer<vtkVideoCameraObservations> observations = vtkSmartPointer<vtkVideoCameraObservations>::New();
+    observations->ShallowCopy(node->GetObservations());
+    this->SetAndObserveObservations(observations);
+  }
+  else
+  {
+    this->SetAndObserveObservations(nullptr);
+  }
+
+  this->EndModify(disabledModify);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::ReadXMLAttributes(const char** atts)
+{
+  int disabledModify = this->StartModify();
+  Superclass::ReadXMLAttributes(atts);
+
+  std::map<std::string, std::string> attributes;
+  while (*atts != NULL)
+  {
+    const char* attName = *(atts++);
+    const char* attValue = *(atts++);
+    attributes[attName] = attValue;
+  }
+  if (attributes["inlineParameters"] != "true")
+  {
+    this->EndModify(disabledModify);
+    return;
+  }
+  this->InlineParameters = true;
+  if (attributes["pixelConvention"].empty())
+  {
+    vtkWarningMacro("ReadXMLAttributes: camera has no pixelConvention, if it was calibrated with the VideoCameraCalibration module "
+                    "its principal point and tangential distortion are for frames rotated by 180 degrees and it must be recalibrated.");
+  }
+
+  int cameraModel = GetCameraModelFromString(attributes["cameraModel"].c_str());
+  if (cameraModel < 0)
+  {
+    vtkErrorMacro("ReadXMLAttributes: unknown cameraModel '" << attributes["cameraModel"] << "', assuming pinhole.");
+    cameraModel = PinholeCameraModel;
+  }
+  this->SetCameraModel(cameraModel);
+  std::vector<double> values = FromAttribute(attributes["xi"]);
+  this->SetXi(values.size() == 1 ? values[0] : 0.0);
+
+  // the parameters are read into the block, views are only created if they are requested
+  ParameterBlock& parameters = this->EditParameters();
+  values = FromAttribute(attributes["intrinsicMatrix"]);
+  if (values.size() == 9)
+  {
+    std::copy(values.begin(), values.end(), parameters.Intrinsics);
+  }
+  else
+  {
+    vtkErrorMacro("ReadXMLAttributes: intrinsicMatrix needs 9 values.");
+  }
+
+  parameters.DistortionCoefficients = FromAttribute(attributes["distortionCoefficients"]);
+
+  values = FromAttribute(attributes["markerToImageSensorTransform"]);
+  if (values.size() == 16)
+  {
+    std::copy(values.begin(), values.end(), parameters.MarkerToImageSensorTransform);
+  }
+  else
+  {
+    vtkErrorMacro("ReadXMLAttributes: markerToImageSensorTransform needs 16 values.");
+  }
+
+  parameters.CameraPlaneOffset = FromAttribute(attributes["cameraPlaneOffset"]);
+  this->UpdateViews();
+  this->InvokeEvent(IntrinsicsModifiedEvent);
+  this->InvokeEvent(DistortionCoefficientsModifiedEvent);
+  this->InvokeEvent(CameraPlaneOffsetModifiedEvent);
+  this->InvokeEvent(MarkerToSensorTransformModifiedEvent);
+
+  values = FromAttribute(attributes["reprojectionError"]);
+  this->SetReprojectionError(values.size() == 1 ? values[0] : -1.0);
+  values = FromAttribute(attributes["registrationError"]);
+  this->SetRegistrationError(values.size() == 1 ? values[0] : -1.0);
+
+  // entries are separated by ';', each holds the encoder value, 9 intrinsics and the coefficients
+  this->RemoveAllCalibrationTableEntries();
+  std::istringstream table(attributes["calibrationTable"]);
+  std::string entryText;
+  vtkNew<vtkMatrix3x3> entryIntrinsics;
+  vtkNew<vtkDoubleArray> entryDistCoeffs;
+  while (std::getline(table, entryText, ';'))
+  {
+    values = FromAttribute(entryText);
+    if (values.size() < 10)
+    {
+      vtkErrorMacro("ReadXMLAttributes: invalid calibrationTable entry, skipping.");
+      continue;
+    }
+    entryIntrinsics->DeepCopy(&values[1]);
+    entryDistCoeffs->SetNumberOfValues(static_cast<vtkIdType>(values.size() - 10));
+    for (size_t i = 10; i < values.size(); ++i)
+    {
+      entryDistCoeffs->SetValue(static_cast<vtkIdType>(i - 10), values[i]);
+    }
+    this->AddCalibrationTableEntry(values[0], entryIntrinsics.GetPointer(), entryDistCoeffs.GetPointer());
+  }
+  if (!this->Parameters->CalibrationTable.empty())
+  {
+    values = FromAttribute(attributes["encoderBucketSize"]);
+    this->SetEncoderBucketSize(values.size() == 1 ? values[0] : 0.0);
+    values = FromAttribute(attributes["encoderValue"]);
+    this->SetEncoderValue(values.size() == 1 ? values[0] : 0.0);
+  }
+
+  this->EndModify(disabledModify);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::WriteXML(ostream& of, int nIndent)
+{
+  Superclass::WriteXML(of, nIndent);
+  if (!this->InlineParameters)
+  {
+    return;
+  }
+
+  std::shared_ptr<const ParameterBlock> parameters = this->GetParameters();
+  std::vector<double> values;
+  of << " inlineParameters=\"true\"";
+  of << " pixelConvention=\"" << static_cast<int>(PixelConventionVersion) << "\"";
+  of << " cameraModel=\"" << GetCameraModelAsString(this->CameraModel) << "\"";
+  of << " xi=\"" << ToAttribute(std::vector<double>(1, this->Xi)) << "\"";
+
+  values.assign(parameters->Intrinsics, parameters->Intrinsics + 9);
+  of << " intrinsicMatrix=\"" << ToAttribute(values) << "\"";
+  of << " distortionCoefficients=\"" << ToAttribute(parameters->DistortionCoefficients) << "\"";
+  values.assign(parameters->MarkerToImageSensorTransform, parameters->MarkerToImageSensorTransform + 16);
+  of << " markerToImageSensorTransform=\"" << ToAttribute(values) << "\"";
+  of << " cameraPlaneOffset=\"" << ToAttribute(parameters->CameraPlaneOffset) << "\"";
+
+  of << " reprojectionError=\"" << ToAttribute(std::vector<double>(1, this->ReprojectionError)) << "\"";
+  of << " registrationError=\"" << ToAttribute(std::vector<double>(1, this->RegistrationError)) << "\"";
+
+  if (!parameters->CalibrationTable.empty())
+  {
+    of << " encoderValue=\"" << ToAttribute(std::vector<double>(1, this->EncoderValue)) << "\"";
+    of << " encoderBucketSize=\"" << ToAttribute(std::vector<double>(1, this->EncoderBucketSize)) << "\"";
+    of << " calibrationTable=\"";
+    for (std::vector<CalibrationTableEntry>::const_iterator it = parameters->CalibrationTable.begin(); it != parameters->CalibrationTable.end(); ++it)
+    {
+      values.assign(1, it->EncoderValue);
+      values.insert(values.end(), it->Intrinsics, it->Intrinsics + 9);
+      values.insert(values.end(), it->DistortionCoefficients.begin(), it->DistortionCoefficients.end());
+      of << (it != parameters->CalibrationTable.begin() ? ";" : "") << ToAttribute(values);
+    }
+    of << "\"";
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetInlineParameters(bool inlineParameters)
+{
+  if (this->InlineParameters == inlineParameters)
+  {
+    return;
+  }
+
+  this->InlineParameters = inlineParameters;
+  if (inlineParameters && this->GetStorageNodeID() != NULL && !this->HasObservationData())
+  {
+    // the parameters are saved with the scene, the camera file is no longer referenced
+    this->SetAndObserveStorageNodeID(NULL);
+  }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+std::shared_ptr<const vtkMRMLVideoCameraNode::ParameterBlock> vtkMRMLVideoCameraNode::GetParameters()
+{
+  this->SynchronizeParameters();
+  return this->Parameters;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraNode::SharesParametersWith(vtkMRMLVideoCameraNode* node)
+{
+  if (node == nullptr)
+  {
+    return false;
+  }
+  this->SynchronizeParameters();
+  node->SynchronizeParameters();
+  return this->Parameters == node->Parameters;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode::ParameterBlock& vtkMRMLVideoCameraNode::EditParameters()
+{
+  if (this->Parameters.use_count() > 1)
+  {
+    // shared with copies of this node or readers of GetParameters(), edit a duplicate
+    this->Parameters = std::make_shared<ParameterBlock>(*this->Parameters);
+  }
+  return *this->Parameters;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SynchronizeParameters()
+{
+  if (this->IntrinsicMatrix != nullptr && !HasElements(this->IntrinsicMatrix, this->Parameters->Intrinsics))
+  {
+    ParameterBlock& parameters = this->EditParameters();
+    for (int i = 0; i < 9; ++i)
+    {
+      parameters.Intrinsics[i] = this->IntrinsicMatrix->GetElement(i / 3, i % 3);
+    }
+  }
+  if (this->DistortionCoefficients != nullptr && !HasValues(this->DistortionCoefficients, this->Parameters->DistortionCoefficients))
+  {
+    GetValues(this->DistortionCoefficients, this->EditParameters().DistortionCoefficients);
+  }
+  if (this->CameraPlaneOffset != nullptr && !HasValues(this->CameraPlaneOffset, this->Parameters->CameraPlaneOffset))
+  {
+    GetValues(this->CameraPlaneOffset, this->EditParameters().CameraPlaneOffset);
+  }
+  if (this->MarkerToImageSensorTransform != nullptr && !HasElements(this->MarkerToImageSensorTransform, this->Parameters->MarkerToImageSensorTransform))
+  {
+    ParameterBlock& parameters = this->EditParameters();
+    for (int i = 0; i < 16; ++i)
+    {
+      parameters.MarkerToImageSensorTransform[i] = this->MarkerToImageSensorTransform->GetElement(i / 4, i % 4);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::UpdateViews()
+{
+  this->UpdatingViews = true;
+  if (this->IntrinsicMatrix != nullptr && !HasElements(this->IntrinsicMatrix, this->Parameters->Intrinsics))
+  {
+    this->IntrinsicMatrix->DeepCopy(this->Parameters->Intrinsics);
+  }
+  if (this->DistortionCoefficients != nullptr && !HasValues(this->DistortionCoefficients, this->Parameters->DistortionCoefficients))
+  {
+    SetValues(this->DistortionCoefficients, this->Parameters->DistortionCoefficients);
+  }
+  if (this->CameraPlaneOffset != nullptr && !HasValues(this->CameraPlaneOffset, this->Parameters->CameraPlaneOffset))
+  {
+    SetValues(this->CameraPlaneOffset, this->Parameters->CameraPlaneOffset);
+  }
+  if (this->MarkerToImageSensorTransform != nullptr && !HasElements(this->MarkerToImageSensorTransform, this->Parameters->MarkerToImageSensorTransform))
+  {
+    this->MarkerToImageSensorTransform->DeepCopy(this->Parameters->MarkerToImageSensorTransform);
+  }
+  this->UpdatingViews = false;
+}
+
+//----------------------------------------------------------------------------
+vtkMatrix3x3* vtkMRMLVideoCameraNode::GetIntrinsicMatrix()
+{
+  if (this->IntrinsicMatrix == nullptr)
+  {
+    // Creating the view does not modify the node, it is attached without events
+    this->IntrinsicMatrix = vtkMatrix3x3::New();
+    this->IntrinsicMatrix->DeepCopy(this->Parameters->Intrinsics);
+    this->IntrinsicObserverObserverTag = this->IntrinsicMatrix->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnIntrinsicsModified);
+  }
+  return this->IntrinsicMatrix;
+}
+
+//----------------------------------------------------------------------------
+vtkDoubleArray* vtkMRMLVideoCameraNode::GetDistortionCoefficients()
+{
+  if (this->DistortionCoefficients == nullptr)
+  {
+    this->DistortionCoefficients = vtkDoubleArray::New();
+    SetValues(this->DistortionCoefficients, this->Parameters->DistortionCoefficients);
+    this->DistortionCoefficientsObserverTag = this->DistortionCoefficients->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnDistortionCoefficientsModified);
+  }
+  return this->DistortionCoefficients;
+}
+
+//----------------------------------------------------------------------------
+vtkDoubleArray* vtkMRMLVideoCameraNode::GetCameraPlaneOffset()
+{
+  if (this->CameraPlaneOffset == nullptr)
+  {
+    this->CameraPlaneOffset = vtkDoubleArray::New();
+    SetValues(this->CameraPlaneOffset, this->Parameters->CameraPlaneOffset);
+    this->CameraPlaneOffsetObserverTag = this->CameraPlaneOffset->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnCameraPlaneOffsetModified);
+  }
+  return this->CameraPlaneOffset;
+}
+
+//----------------------------------------------------------------------------
+vtkMatrix4x4* vtkMRMLVideoCameraNode::GetMarkerToImageSensorTransform()
+{
+  if (this->MarkerToImageSensorTransform == nullptr)
+  {
+    this->MarkerToImageSensorTransform = vtkMatrix4x4::New();
+    this->MarkerToImageSensorTransform->DeepCopy(this->Parameters->MarkerToImageSensorTransform);
+    this->MarkerTransformObserverTag = this->MarkerToImageSensorTransform->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnMarkerTransformModified);
+  }
+  return this->MarkerToImageSensorTransform;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetAndObserveIntrinsicMatrix(vtkMatrix3x3* intrinsicMatrix)
+{
+  if (this->IntrinsicMatrix != NULL)
+  {
+    this->IntrinsicMatrix->RemoveObserver(this->IntrinsicObserverObserverTag);
+  }
+
+  this->SetIntrinsicMatrix(intrinsicMatrix);
+
+  if (this->IntrinsicMatrix != NULL)
+  {
+    this->IntrinsicObserverObserverTag = this->IntrinsicMatrix->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnIntrinsicsModified);
+  }
+  this->SynchronizeParameters();
+
+  this->InvokeEvent(vtkMRMLVideoCameraNode::IntrinsicsModifiedEvent);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetAndObserveDistortionCoefficients(vtkDoubleArray* distCoeffs)
+{
+  if (this->DistortionCoefficients != NULL)
+  {
+    this->DistortionCoefficients->RemoveObserver(this->DistortionCoefficientsObserverTag);
+  }
+
+  this->SetDistortionCoefficients(distCoeffs);
+
+  if (this->DistortionCoefficients != NULL)
+  {
+    this->DistortionCoefficientsObserverTag = this->DistortionCoefficients->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnDistortionCoefficientsModified);
+  }
+  this->SynchronizeParameters();
+
+  this->InvokeEvent(vtkMRMLVideoCameraNode::DistortionCoefficientsModifiedEvent);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetAndObserveCameraPlaneOffset(vtkDoubleArray* planeOffset)
+{
+  if (this->CameraPlaneOffset != NULL)
+  {
+    this->CameraPlaneOffset->RemoveObserver(this->CameraPlaneOffsetObserverTag);
+  }
+
+  this->SetCameraPlaneOffset(planeOffset);
+
+  if (this->CameraPlaneOffset != NULL)
+  {
+    this->CameraPlaneOffsetObserverTag = this->CameraPlaneOffset->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnCameraPlaneOffsetModified);
+  }
+  this->SynchronizeParameters();
+
+  this->InvokeEvent(vtkMRMLVideoCameraNode::CameraPlaneOffsetModifiedEvent);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetAndObserveMarkerToImageSensorTransform(vtkMatrix4x4* markerToImageSensorTransform)
+{
+  if (this->MarkerToImageSensorTransform != NULL)
+  {
+    this->MarkerToImageSensorTransform->RemoveObserver(this->MarkerTransformObserverTag);
+  }
+
+  this->SetMarkerToImageSensorTransform(markerToImageSensorTransform);
+
+  if (this->MarkerToImageSensorTransform != NULL)
+  {
+    this->MarkerTransformObserverTag = this->MarkerToImageSensorTransform->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnMarkerTransformModified);
+  }
+  this->SynchronizeParameters();
+
+  this->InvokeEvent(vtkMRMLVideoCameraNode::MarkerToSensorTransformModifiedEvent);
+}
+
+//----------------------------------------------------------------------------
+vtkCxxSetObjectMacro(vtkMRMLVideoCameraNode, Observations, vtkVideoCameraObservations);
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetAndObserveObservations(vtkVideoCameraObservations* observations)
+{
+  this->DeferredObservations.reset();
+  if (this->Observations != NULL)
+  {
+    this->Observations->RemoveObserver(this->ObservationsObserverTag);
+  }
+
+  this->SetObservations(observations);
+
+  if (this->Observations != NULL)
+  {
+    this->ObservationsObserverTag = this->Observations->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnObservationsModified);
+  }
+
+  this->InvokeEvent(vtkMRMLVideoCameraNode::ObservationsModifiedEvent);
+}
+
+//----------------------------------------------------------------------------
+vtkVideoCameraObservations* vtkMRMLVideoCameraNode::GetObservations()
+{
+  if (this->DeferredObservations != nullptr)
+  {
+    this->LoadDeferredObservations();
+  }
+  return this->Observations;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetDeferredObservations(const std::string& section)
+{
+  this->SetDeferredObservations(section.empty() ? nullptr : std::make_shared<const std::string>(section));
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetDeferredObservations(std::shared_ptr<const std::string> section)
+{
+  if (this->Observations != NULL)
+  {
+    this->Observations->RemoveObserver(this->ObservationsObserverTag);
+  }
+  this->SetObservations(nullptr);
+  this->DeferredObservations = section;
+
+  this->InvokeEvent(vtkMRMLVideoCameraNode::ObservationsModifiedEvent);
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraNode::HasDeferredObservations() const
+{
+  return this->DeferredObservations != nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraNode::HasObservationData() const
+{
+  return this->Observations != NULL || this->HasDeferredObservations();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::LoadDeferredObservations()
+{
+  std::shared_ptr<const std::string> section;
+  section.swap(this->DeferredObservations);
+
+  vtkSmartPointer<vtkVideoCameraObservations> observations = vtkSmartPointer<vtkVideoCameraObservations>::New();
+  if (!vtkMRMLVideoCameraStorageNode::ReadObservationsSection(*section, observations))
+  {
+    vtkErrorMacro("Deferred observations are invalid, skipping.");
+    return;
+  }
+
+  // Parsing on first access does not modify the node, the observations are attached without events
+  this->Observations = observations;
+  this->Observations->Register(this);
+  this->ObservationsObserverTag = this->Observations->AddObserver(vtkCommand::ModifiedEvent, this, &vtkMRMLVideoCameraNode::OnObservationsModified);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetCameraModel(int model)
+{
+  if (model < 0 || model >= CameraModel_Last)
+  {
+    vtkErrorMacro("SetCameraModel: invalid camera model " << model);
+    return;
+  }
+  if (this->CameraModel == model)
+  {
+    return;
+  }
+
+  this->CameraModel = model;
+  this->InvokeEvent(vtkMRMLVideoCameraNode::IntrinsicsModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+const char* vtkMRMLVideoCameraNode::GetCameraModelAsString(int model)
+{
+  switch (model)
+  {
+    case PinholeCameraModel:
+      return "Pinhole";
+    case FisheyeCameraModel:
+      return "Fisheye";
+    case OmnidirectionalCameraModel:
+      return "Omnidirectional";
+    default:
+      return "";
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVideoCameraNode::GetCameraModelFromString(const char* name)
+{
+  if (name == nullptr)
+  {
+    return -1;
+  }
+  for (int model = 0; model < CameraModel_Last; ++model)
+  {
+    if (strcmp(name, GetCameraModelAsString(model)) == 0)
+    {
+      return model;
+    }
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetXi(double xi)
+{
+  if (this->Xi == xi)
+  {
+    return;
+  }
+
+  this->Xi = xi;
+  this->InvokeEvent(vtkMRMLVideoCameraNode::IntrinsicsModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLStorageNode* vtkMRMLVideoCameraNode::CreateDefaultStorageNode()
+{
+  if (this->InlineParameters && !this->HasObservationData())
+  {
+    return NULL;
+  }
+  return vtkMRMLVideoCameraStorageNode::New();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraNode::IsReprojectionErrorValid() const
+{
+  return this->ReprojectionError != -1.0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraNode::IsRegistrationErrorValid() const
+{
+  return this->RegistrationError != -1.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::AddCalibrationTableEntry(double encoderValue, vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs)
+{
+  if (intrinsics == nullptr)
+  {
+    vtkErrorMacro("AddCalibrationTableEntry: intrinsics are required.");
+    return;
+  }
+
+  CalibrationTableEntry entry;
+  entry.EncoderValue = encoderValue;
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      entry.Intrinsics[i * 3 + j] = intrinsics->GetElement(i, j);
+    }
+  }
+  if (distCoeffs != nullptr)
+  {
+    for (vtkIdType i = 0; i < distCoeffs->GetNumberOfValues(); ++i)
+    {
+      entry.DistortionCoefficients.push_back(distCoeffs->GetValue(i));
+    }
+  }
+
+  std::vector<CalibrationTableEntry>& table = this->EditParameters().CalibrationTable;
+  auto it = std::lower_bound(table.begin(), table.end(), encoderValue,
+                             [](const CalibrationTableEntry & e, double value) { return e.EncoderValue < value; });
+  if (it != table.end() && it->EncoderValue == encoderValue)
+  {
+    *it = entry;
+  }
+  else
+  {
+    table.insert(it, entry);
+  }
+
+  this->AppliedEncoderValue = std::numeric_limits<double>::quiet_NaN();
+  this->InvokeEvent(CalibrationTableModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::RemoveCalibrationTableEntry(int index)
+{
+  if (index < 0 || index >= static_cast<int>(this->Parameters->CalibrationTable.size()))
+  {
+    vtkErrorMacro("RemoveCalibrationTableEntry: index " << index << " out of range.");
+    return;
+  }
+
+  std::vector<CalibrationTableEntry>& table = this->EditParameters().CalibrationTable;
+  table.erase(table.begin() + index);
+  this->AppliedEncoderValue = std::numeric_limits<double>::quiet_NaN();
+  this->InvokeEvent(CalibrationTableModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::RemoveAllCalibrationTableEntries()
+{
+  if (this->Parameters->CalibrationTable.empty())
+  {
+    return;
+  }
+
+  this->EditParameters().CalibrationTable.clear();
+  this->AppliedEncoderValue = std::numeric_limits<double>::quiet_NaN();
+  this->InvokeEvent(CalibrationTableModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVideoCameraNode::GetNumberOfCalibrationTableEntries() const
+{
+  return static_cast<int>(this->Parameters->CalibrationTable.size());
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLVideoCameraNode::GetCalibrationTableEncoderValue(int index) const
+{
+  if (index < 0 || index >= static_cast<int>(this->Parameters->CalibrationTable.size()))
+  {
+    return 0.0;
+  }
+  return this->Parameters->CalibrationTable[index].EncoderValue;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraNode::GetCalibrationTableEntry(int index, vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs) const
+{
+  if (index < 0 || index >= static_cast<int>(this->Parameters->CalibrationTable.size()))
+  {
+    return false;
+  }
+
+  const CalibrationTableEntry& entry = this->Parameters->CalibrationTable[index];
+  if (intrinsics != nullptr)
+  {
+    intrinsics->DeepCopy(entry.Intrinsics);
+  }
+  if (distCoeffs != nullptr)
+  {
+    distCoeffs->SetNumberOfValues(static_cast<vtkIdType>(entry.DistortionCoefficients.size()));
+    for (size_t i = 0; i < entry.DistortionCoefficients.size(); ++i)
+    {
+      distCoeffs->SetValue(static_cast<vtkIdType>(i), entry.DistortionCoefficients[i]);
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraNode::InterpolateCalibration(double encoderValue, vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs) const
+{
+  if (this->Parameters->CalibrationTable.empty())
+  {
+    return false;
+  }
+
+  // Binary search for the first entry above the encoder value, interpolate with its predecessor
+  auto upper = std::upper_bound(this->Parameters->CalibrationTable.begin(), this->Parameters->CalibrationTable.end(), encoderValue,
+                                [](double value, const CalibrationTableEntry & e) { return value < e.EncoderValue; });
+  if (upper == this->Parameters->CalibrationTable.begin())
+  {
+    return this->GetCalibrationTableEntry(0, intrinsics, distCoeffs);
+  }
+  if (upper == this->Parameters->CalibrationTable.end())
+  {
+    return this->GetCalibrationTableEntry(this->GetNumberOfCalibrationTableEntries() - 1, intrinsics, distCoeffs);
+  }
+
+  const CalibrationTableEntry& lower = *(upper - 1);
+  const double t = (encoderValue - lower.EncoderValue) / (upper->EncoderValue - lower.EncoderValue);
+
+  if (intrinsics != nullptr)
+  {
+    double elements[9];
+    for (int i = 0; i < 9; ++i)
+    {
+      elements[i] = lower.Intrinsics[i] + t * (upper->Intrinsics[i] - lower.Intrinsics[i]);
+    }
+    intrinsics->DeepCopy(elements);
+  }
+
+  if (distCoeffs != nullptr)
+  {
+    // Models with fewer coefficients are equivalent to trailing zeros
+    const size_t count = std::max(lower.DistortionCoefficients.size(), upper->DistortionCoefficients.size());
+    distCoeffs->SetNumberOfValues(static_cast<vtkIdType>(count));
+    for (size_t i = 0; i < count; ++i)
+    {
+      double a = i < lower.DistortionCoefficients.size() ? lower.DistortionCoefficients[i] : 0.0;
+      double b = i < upper->DistortionCoefficients.size() ? upper->DistortionCoefficients[i] : 0.0;
+      distCoeffs->SetValue(static_cast<vtkIdType>(i), a + t * (b - a));
+    }
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetEncoderValue(double encoderValue)
+{
+  if (this->EncoderValue == encoderValue && !std::isnan(this->AppliedEncoderValue))
+  {
+    return;
+  }
+
+  this->EncoderValue = encoderValue;
+  // streamed encoder values mostly stay within the current bucket, only a new calibration modifies the node
+  if (this->UpdateCalibrationFromTable())
+  {
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::SetEncoderBucketSize(double bucketSize)
+{
+  bucketSize = std::max(bucketSize, 0.0);
+  if (this->EncoderBucketSize == bucketSize)
+  {
+    return;
+  }
+
+  this->EncoderBucketSize = bucketSize;
+  this->AppliedEncoderValue = std::numeric_limits<double>::quiet_NaN();
+  this->UpdateCalibrationFromTable();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraNode::IsEncoderBucketingEnabled() const
+{
+  return this->EncoderBucketSize > 0.0 && !this->Parameters->CalibrationTable.empty();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVideoCameraNode::GetEncoderBucket() const
+{
+  if (!this->IsEncoderBucketingEnabled())
+  {
+    return VTK_INT_MIN;
+  }
+  // VTK_INT_MIN is reserved for "no bucketing"
+  const double bucket = std::floor(this->EncoderValue / this->EncoderBucketSize);
+  return static_cast<int>(std::max(std::min(bucket, static_cast<double>(VTK_INT_MAX)), static_cast<double>(VTK_INT_MIN + 1)));
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraNode::UpdateCalibrationFromTable()
+{
+  if (this->Parameters->CalibrationTable.empty())
+  {
+    return false;
+  }
+
+  double value = this->EncoderValue;
+  if (this->EncoderBucketSize > 0.0)
+  {
+    value = (this->GetEncoderBucket() + 0.5) * this->EncoderBucketSize;
+  }
+  if (value == this->AppliedEncoderValue)
+  {
+    // Same bucket, parameters are already up to date
+    return false;
+  }
+
+  vtkNew<vtkMatrix3x3> intrinsics;
+  vtkNew<vtkDoubleArray> distCoeffs;
+  if (!this->InterpolateCalibration(value, intrinsics.GetPointer(), distCoeffs.GetPointer()))
+  {
+    return false;
+  }
+  this->AppliedEncoderValue = value;
+
+  // keep the edits of the other views, the table only overrides intrinsics and distortion
+  this->SynchronizeParameters();
+  ParameterBlock& parameters = this->EditParameters();
+  for (int i = 0; i < 9; ++i)
+  {
+    parameters.Intrinsics[i] = intrinsics->GetElement(i / 3, i % 3);
+  }
+  GetValues(distCoeffs.GetPointer(), parameters.DistortionCoefficients);
+  this->UpdateViews();
+  this->InvokeEvent(IntrinsicsModifiedEvent);
+  this->InvokeEvent(DistortionCoefficientsModifiedEvent);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::OnIntrinsicsModified(vtkObject* caller, unsigned long event, void* data)
+{
+  if (this->UpdatingViews)
+  {
+    return;
+  }
+  this->InvokeEvent(IntrinsicsModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::OnDistortionCoefficientsModified(vtkObject* caller, unsigned long event, void* data)
+{
+  if (this->UpdatingViews)
+  {
+    return;
+  }
+  this->InvokeEvent(DistortionCoefficientsModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::OnCameraPlaneOffsetModified(vtkObject* caller, unsigned long event, void* data)
+{
+  if (this->UpdatingViews)
+  {
+    return;
+  }
+  this->InvokeEvent(CameraPlaneOffsetModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::OnMarkerTransformModified(vtkObject* caller, unsigned long event, void* data)
+{
+  if (this->UpdatingViews)
+  {
+    return;
+  }
+  this->InvokeEvent(MarkerToSensorTransformModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::OnObservationsModified(vtkObject* caller, unsigned long event, void* data)
+{
+  this->InvokeEvent(ObservationsModifiedEvent);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraNode::PrintSelf(ostream& os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Camera Model: " << GetCameraModelAsString(this->CameraModel) << std::endl;
+  os << indent << "Xi: " << this->Xi << std::endl;
+  os << indent << "Inline Parameters: " << (this->InlineParameters ? "true" : "false") << std::endl;
+  std::shared_ptr<const ParameterBlock> parameters = this->GetParameters();
+  os << indent << "Parameter Block: " << parameters.get() << " (" << parameters.use_count() - 1 << " other references)" << std::endl;
+  os << indent << "Intrinsics: " << ToAttribute(std::vector<double>(parameters->Intrinsics, parameters->Intrinsics + 9)) << std::endl;
+  os << indent << "Distortion Coefficients: " << ToAttribute(parameters->DistortionCoefficients) << std::endl;
+  os << indent << "MarkerToSensor Transform: " << ToAttribute(std::vector<double>(parameters->MarkerToImageSensorTransform, parameters->MarkerToImageSensorTransform + 16)) << std::endl;
+  os << indent << "Camera Plane Offset: " << ToAttribute(parameters->CameraPlaneOffset) << std::endl;
+  os << indent << "Calibration Table Entries: " << parameters->CalibrationTable.size() << std::endl;
+  os << indent << "Encoder Value: " << this->EncoderValue << std::endl;
+  os << indent << "Encoder Bucket Size: " << this->EncoderBucketSize << std::endl;
+  if (this->HasDeferredObservations())
+  {
+    os << indent << "Observation Views: not loaded" << std::endl;
+  }
+  else
+  {
+    os << indent << "Observation Views: " << (this->Observations ? this->Observations->GetNumberOfViews() : 0) << std::endl;
+  }
+}
@@ -1,109 +1,308 @@
-/*=auto=========================================================================
-
-Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
-
-See COPYRIGHT.txt
-or http://www.slicer.org/copyright/copyright.txt for details.
-
-Program:   3D Slicer
-Module:    $RCSfile: vtkMRMLVideoCameraNode.h,v $
-Date:      $Date: 2018/6/16 10:54:09 $
-Version:   $Revision: 1.0 $
-
-=========================================================================auto=*/
-
-#ifndef __vtkMRMLVideoCameraNode_h
-#define __vtkMRMLVideoCameraNode_h
-
-// MRML includes
-#include "vtkSlicerVideoCamerasModuleMRMLExport.h"
-
-// MRML includes
-#include <vtkMRMLStorableNode.h>
-
-// VTK includes
-#include <vtkDoubleArray.h>
-#include <vtkMatrix3x3.h>
-#include <vtkMatrix4x4.h>
-
-class VTK_SLICER_VIDEOCAMERAS_MODULE_MRML_EXPORT vtkMRMLVideoCameraNode : public vtkMRMLStorableNode
-{
-public:
-  enum
-  {
-    IntrinsicsModifiedEvent = 404001,
-    DistortionCoefficientsModifiedEvent,
-    CameraPlaneOffsetModifiedEvent,
-    MarkerToSensorTransformModifiedEvent
-  };
-
-public:
-  static vtkMRMLVideoCameraNode* New();
-  vtkTypeMacro(vtkMRMLVideoCameraNode, vtkMRMLStorableNode);
-  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
-
-  virtual vtkMRMLNode* CreateNodeInstance() VTK_OVERRIDE;
-
-  ///
-  /// Copy the node's attributes to this object
-  virtual void Copy(vtkMRMLNode* node) VTK_OVERRIDE;
-
-  ///
-  /// Get node XML tag name (like Volume, Model)
-  virtual const char* GetNodeTagName() VTK_OVERRIDE {return "VideoCamera";};
-
-  ///
-  /// Set intrinsic matrix
-  vtkGetObjectMacro(IntrinsicMatrix, vtkMatrix3x3);
-  void SetAndObserveIntrinsicMatrix(vtkMatrix3x3* intrinsicMatrix);
-
-  vtkGetObjectMacro(DistortionCoefficients, vtkDoubleArray);
-  void SetAndObserveDistortionCoefficients(vtkDoubleArray* distCoeffs);
-
-  vtkGetObjectMacro(CameraPlaneOffset, vtkDoubleArray);
-  void SetAndObserveCameraPlaneOffset(vtkDoubleArray* planeOffset);
-
-  vtkGetObjectMacro(MarkerToImageSensorTransform, vtkMatrix4x4);
-  void SetAndObserveMarkerToImageSensorTransform(vtkMatrix4x4* markerToImageSensorTransform);
-
-  virtual vtkMRMLStorageNode* CreateDefaultStorageNode() VTK_OVERRIDE;
-
-  bool IsReprojectionErrorValid() const;
-  vtkSetMacro(ReprojectionError, double);
-  vtkGetMacro(ReprojectionError, double);
-
-  bool IsRegistrationErrorValid() const;
-  vtkSetMacro(RegistrationError, double);
-  vtkGetMacro(RegistrationError, double);
-
-protected:
-  vtkSetObjectMacro(IntrinsicMatrix, vtkMatrix3x3);
-  vtkSetObjectMacro(DistortionCoefficients, vtkDoubleArray);
-  vtkSetObjectMacro(MarkerToImageSensorTransform, vtkMatrix4x4);
-  vtkSetObjectMacro(CameraPlaneOffset, vtkDoubleArray);
-
-  unsigned long IntrinsicObserverObserverTag;
-  unsigned long DistortionCoefficientsObserverTag;
-  unsigned long CameraPlaneOffsetObserverTag;
-  unsigned long MarkerTransformObserverTag;
-
-  void OnIntrinsicsModified(vtkObject* caller, unsigned long event, void* data);
-  void OnDistortionCoefficientsModified(vtkObject* caller, unsigned long event, void* data);
-  void OnCameraPlaneOffsetModified(vtkObject* caller, unsigned long event, void* data);
-  void OnMarkerTransformModified(vtkObject* caller, unsigned long event, void* data);
-
-protected:
-  vtkMRMLVideoCameraNode();
-  ~vtkMRMLVideoCameraNode();
-  vtkMRMLVideoCameraNode(const vtkMRMLVideoCameraNode&);
-  void operator=(const vtkMRMLVideoCameraNode&);
-
-  vtkMatrix3x3*       IntrinsicMatrix;
-  vtkDoubleArray*     DistortionCoefficients;
-  double              ReprojectionError;
-  double              RegistrationError;
-  vtkDoubleArray*     CameraPlaneOffset;
-  vtkMatrix4x4*       MarkerToImageSensorTransform;
-};
-
-#endif
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkMRMLVideoCameraNode.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+#ifndef __vtkMRMLVideoCameraNode_h
+#define __vtkMRMLVideoCameraNode_h
+
+// MRML includes
+#include "vtkSlicerVideoCamerasModuleMRMLExport.h"
+
+// MRML includes
+#include <vtkMRMLStorableNode.h>
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMatrix3x3.h>
+#include <vtkMatrix4x4.h>
+
+class vtkVideoCameraObservations;
+
+// STD includes
+#include <string>
+#include <vector>
+#if !defined(__VTK_WRAP__)
+#include <memory>
+#endif
+
+class VTK_SLICER_VIDEOCAMERAS_MODULE_MRML_EXPORT vtkMRMLVideoCameraNode : public vtkMRMLStorableNode
+{
+public:
+  enum
+  {
+    IntrinsicsModifiedEvent = 404001,
+    DistortionCoefficientsModifiedEvent,
+    CameraPlaneOffsetModifiedEvent,
+    MarkerToSensorTransformModifiedEvent,
+    CalibrationTableModifiedEvent,
+    ObservationsModifiedEvent
+  };
+
+  /// Projection model the intrinsics and distortion coefficients belong to
+  enum CameraModelType
+  {
+    /// Pinhole with OpenCV radial/tangential distortion (k1, k2, p1, p2[, k3[, k4, k5, k6]])
+    PinholeCameraModel = 0,
+    /// Kannala-Brandt equidistant fisheye (k1, k2, k3, k4)
+    FisheyeCameraModel,
+    /// Mei unified omnidirectional model, mirror parameter Xi and distortion (k1, k2, p1, p2)
+    OmnidirectionalCameraModel,
+    CameraModel_Last
+  };
+
+  /// Version of the pixel convention (see vtkSlicerVideoCameraProjection.h) written with the
+  /// parameters. Cameras written without it were calibrated on frames rotated by 180 degrees.
+  enum
+  {
+    PixelConventionVersion = 1
+  };
+
+public:
+  static vtkMRMLVideoCameraNode* New();
+  vtkTypeMacro(vtkMRMLVideoCameraNode, vtkMRMLStorableNode);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  virtual vtkMRMLNode* CreateNodeInstance() VTK_OVERRIDE;
+
+  ///
+  /// Copy the node's attributes to this object
+  /// The calibration parameters are not duplicated, both nodes share them until one is edited.
+  virtual void Copy(vtkMRMLNode* node) VTK_OVERRIDE;
+
+  ///
+  /// Read/write the camera parameters as node attributes when InlineParameters is on
+  virtual void ReadXMLAttributes(const char** atts) VTK_OVERRIDE;
+  virtual void WriteXML(ostream& of, int indent) VTK_OVERRIDE;
+
+  ///
+  /// Get node XML tag name (like Volume, Model)
+  virtual const char* GetNodeTagName() VTK_OVERRIDE {return "VideoCamera";};
+
+  ///
+  /// Keep the camera parameters in the scene file instead of a camera file (default off)
+  /// Inline cameras are written as node attributes of the .mrml file and need no storage node:
+  /// turning the mode on drops the storage node reference and no default storage node is created.
+  /// Observations are bulk data and are not written inline, a camera with observations keeps
+  /// its storage node (and gets a default one) so they are still saved to the camera file.
+  void SetInlineParameters(bool inlineParameters);
+  vtkGetMacro(InlineParameters, bool);
+  vtkBooleanMacro(InlineParameters, bool);
+
+#if !defined(__VTK_WRAP__)
+  struct CalibrationTableEntry
+  {
+    double              EncoderValue;
+    double              Intrinsics[9];
+    std::vector<double> DistortionCoefficients;
+  };
+
+  ///
+  /// Calibration parameters of a camera, shared by the node and its copies
+  /// A block is never modified while it is shared: the node editing its parameters first
+  /// duplicates the block if other nodes (or holders of GetParameters()) still refer to it.
+  struct ParameterBlock
+  {
+    ParameterBlock();
+
+    double                              Intrinsics[9];
+    std::vector<double>                 DistortionCoefficients;
+    std::vector<double>                 CameraPlaneOffset;
+    double                              MarkerToImageSensorTransform[16];
+    std::vector<CalibrationTableEntry>  CalibrationTable;
+  };
+
+  ///
+  /// Current parameters, read-only
+  /// Unlike the Get...() accessors below this never allocates VTK objects, the returned block
+  /// stays valid and unchanged whatever happens to the node afterwards.
+  std::shared_ptr<const ParameterBlock> GetParameters();
+#endif
+
+  ///
+  /// True if both nodes refer to the same parameter block (e.g. after Copy, until either is edited)
+  bool SharesParametersWith(vtkMRMLVideoCameraNode* node);
+
+  ///
+  /// Set intrinsic matrix
+  /// The Get...() objects are editable views of the parameter block, created on first access.
+  /// Creating a view invokes no event and leaves the MTime unchanged but is not thread safe,
+  /// get the views before the node is read from other threads.
+  /// Setting an object makes it the view of this node and copies its values into the block.
+  vtkMatrix3x3* GetIntrinsicMatrix();
+  void SetAndObserveIntrinsicMatrix(vtkMatrix3x3* intrinsicMatrix);
+
+  vtkDoubleArray* GetDistortionCoefficients();
+  void SetAndObserveDistortionCoefficients(vtkDoubleArray* distCoeffs);
+
+  vtkDoubleArray* GetCameraPlaneOffset();
+  void SetAndObserveCameraPlaneOffset(vtkDoubleArray* planeOffset);
+
+  vtkMatrix4x4* GetMarkerToImageSensorTransform();
+  void SetAndObserveMarkerToImageSensorTransform(vtkMatrix4x4* markerToImageSensorTransform);
+
+  ///
+  /// Raw observations the calibration was computed from, null if they are not kept
+  /// Observations deferred by the storage node are parsed on the first call, without events.
+  virtual vtkVideoCameraObservations* GetObservations();
+  void SetAndObserveObservations(vtkVideoCameraObservations* observations);
+
+  ///
+  /// Observations section of a camera file, kept unparsed until the first GetObservations()
+  /// Set by the storage node when lazy loading, discarded by SetAndObserveObservations.
+  void SetDeferredObservations(const std::string& section);
+  bool HasDeferredObservations() const;
+
+  ///
+  /// True if the camera has observations, parsed or deferred, without parsing them
+  bool HasObservationData() const;
+
+  ///
+  /// Projection model, pinhole by default
+  /// Changing the model invokes IntrinsicsModifiedEvent as the coefficients are reinterpreted.
+  void SetCameraModel(int model);
+  vtkGetMacro(CameraModel, int);
+  static const char* GetCameraModelAsString(int model);
+  static int GetCameraModelFromString(const char* name);
+
+  ///
+  /// Mirror parameter of the omnidirectional model, ignored by the other models
+  void SetXi(double xi);
+  vtkGetMacro(Xi, double);
+
+  ///
+  /// Camera file storage node, null for inline cameras
+  virtual vtkMRMLStorageNode* CreateDefaultStorageNode() VTK_OVERRIDE;
+
+  bool IsReprojectionErrorValid() const;
+  vtkSetMacro(ReprojectionError, double);
+  vtkGetMacro(ReprojectionError, double);
+
+  bool IsRegistrationErrorValid() const;
+  vtkSetMacro(RegistrationError, double);
+  vtkGetMacro(RegistrationError, double);
+
+  ///
+  /// Calibration table indexed by zoom/focus encoder value
+  /// Each entry holds the intrinsics and distortion coefficients calibrated at one encoder value.
+  /// Entries are kept sorted by encoder value, adding an existing encoder value replaces the entry.
+  void AddCalibrationTableEntry(double encoderValue, vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs);
+  void RemoveCalibrationTableEntry(int index);
+  void RemoveAllCalibrationTableEntries();
+  int GetNumberOfCalibrationTableEntries() const;
+  double GetCalibrationTableEncoderValue(int index) const;
+  bool GetCalibrationTableEntry(int index, vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs) const;
+
+  ///
+  /// Linearly interpolate intrinsics and distortion coefficients for an encoder value
+  /// Values outside of the table are clamped to the first/last entry. Lookup is O(log n).
+  bool InterpolateCalibration(double encoderValue, vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs) const;
+
+  ///
+  /// Set the current encoder value
+  /// If the calibration table is not empty, IntrinsicMatrix and DistortionCoefficients are
+  /// updated from the table. The parameters are only recomputed when the zoom bucket changes.
+  void SetEncoderValue(double encoderValue);
+  vtkGetMacro(EncoderValue, double);
+
+  ///
+  /// Width of a zoom bucket, in encoder units
+  /// When positive, encoder values are snapped to the center of their bucket before interpolating,
+  /// so that every encoder value within a bucket yields identical parameters and derived caches
+  /// (e.g. remap tables) can be kept per bucket. 0 (default) disables bucketing.
+  void SetEncoderBucketSize(double bucketSize);
+  vtkGetMacro(EncoderBucketSize, double);
+
+  ///
+  /// True if the bucket size is positive and the calibration table is not empty
+  bool IsEncoderBucketingEnabled() const;
+
+  ///
+  /// Zoom bucket of the current encoder value, may be negative
+  /// Only meaningful if IsEncoderBucketingEnabled(), VTK_INT_MIN otherwise.
+  int GetEncoderBucket() const;
+
+protected:
+  vtkSetObjectMacro(IntrinsicMatrix, vtkMatrix3x3);
+  vtkSetObjectMacro(DistortionCoefficients, vtkDoubleArray);
+  vtkSetObjectMacro(MarkerToImageSensorTransform, vtkMatrix4x4);
+  vtkSetObjectMacro(CameraPlaneOffset, vtkDoubleArray);
+  void SetObservations(vtkVideoCameraObservations* observations);
+
+  unsigned long IntrinsicObserverObserverTag;
+  unsigned long DistortionCoefficientsObserverTag;
+  unsigned long CameraPlaneOffsetObserverTag;
+  unsigned long MarkerTransformObserverTag;
+  unsigned long ObservationsObserverTag;
+
+  void OnIntrinsicsModified(vtkObject* caller, unsigned long event, void* data);
+  void OnDistortionCoefficientsModified(vtkObject* caller, unsigned long event, void* data);
+  void OnCameraPlaneOffsetModified(vtkObject* caller, unsigned long event, void* data);
+  void OnMarkerTransformModified(vtkObject* caller, unsigned long event, void* data);
+  void OnObservationsModified(vtkObject* caller, unsigned long event, void* data);
+
+  /// Recompute IntrinsicMatrix and DistortionCoefficients from the calibration table
+  /// Returns true if the parameters were changed.
+  bool UpdateCalibrationFromTable();
+
+  /// Parse the deferred observations section into Observations
+  void LoadDeferredObservations();
+
+#if !defined(__VTK_WRAP__)
+  /// Set the deferred section without copying it, it is shared with the copies of the node
+  void SetDeferredObservations(std::shared_ptr<const std::string> section);
+#endif
+
+#if !defined(__VTK_WRAP__)
+  /// Parameter block to modify, duplicated first if it is shared
+  ParameterBlock& EditParameters();
+#endif
+
+  /// Copy the values of the views into the parameter block
+  /// Views may be edited without a modified event (e.g. vtkDoubleArray::SetValue), they are
+  /// compared to the block whenever it is read as a whole.
+  void SynchronizeParameters();
+
+  /// Copy the parameter block into the views, without events
+  void UpdateViews();
+
+protected:
+  vtkMRMLVideoCameraNode();
+  ~vtkMRMLVideoCameraNode();
+  vtkMRMLVideoCameraNode(const vtkMRMLVideoCameraNode&);
+  void operator=(const vtkMRMLVideoCameraNode&);
+
+#if !defined(__VTK_WRAP__)
+  std::shared_ptr<ParameterBlock> Parameters;
+#endif
+  bool                UpdatingViews;
+
+  vtkMatrix3x3*       IntrinsicMatrix;
+  vtkDoubleArray*     DistortionCoefficients;
+  double              ReprojectionError;
+  double              RegistrationError;
+  vtkDoubleArray*     CameraPlaneOffset;
+  vtkMatrix4x4*       MarkerToImageSensorTransform;
+  vtkVideoCameraObservations* Observations;
+#if !defined(__VTK_WRAP__)
+  std::shared_ptr<const std::string> DeferredObservations;
+#endif
+  int                 CameraModel;
+  double              Xi;
+  bool                InlineParameters;
+
+  double                              EncoderValue;
+  double                              EncoderBucketSize;
+  double                              AppliedEncoderValue;
+};
+
+#endif
@@ -1,322 +1,1219 @@
-/*=auto=========================================================================
-
-  Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
-
-  See COPYRIGHT.txt
-  or http://www.slicer.org/copyright/copyright.txt for details.
-
-  Program:   3D Slicer
-  Module:    $RCSfile: vtkMRMLVideoCameraStorageNode.cxx,v $
-  Date:      $Date: 2018/6/16 10:54:09 $
-  Version:   $Revision: 1.0 $
-
-=========================================================================auto=*/
-
-#include "vtkMRMLVideoCameraNode.h"
-#include "vtkMRMLVideoCameraStorageNode.h"
-#include "vtkMRMLScene.h"
-
-// VTK includes
-#include <vtkObjectFactory.h>
-#include <vtkStringArray.h>
-#include <vtkVersion.h>
-#include <vtksys/SystemTools.hxx>
-
-// OpenCV includes
-#include <opencv2/videoio.hpp>
-#include <opencv2/core/persistence.hpp>
-
-//----------------------------------------------------------------------------
-
-vtkMRMLNodeNewMacro(vtkMRMLVideoCameraStorageNode);
-
-//----------------------------------------------------------------------------
-vtkMRMLVideoCameraStorageNode::vtkMRMLVideoCameraStorageNode()
-{
-  this->DefaultWriteFileExtension = "xml";
-}
-
-//----------------------------------------------------------------------------
-vtkMRMLVideoCameraStorageNode::~vtkMRMLVideoCameraStorageNode()
-{
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraStorageNode::PrintSelf(ostream& os, vtkIndent indent)
-{
-  vtkMRMLStorageNode::PrintSelf(os, indent);
-}
-
-//----------------------------------------------------------------------------
-bool vtkMRMLVideoCameraStorageNode::CanReadInReferenceNode(vtkMRMLNode* refNode)
-{
-  return refNode->IsA("vtkMRMLVideoCameraNode");
-}
-
-//----------------------------------------------------------------------------
-int vtkMRMLVideoCameraStorageNode::ReadDataInternal(vtkMRMLNode* refNode)
-{
-  vtkMRMLVideoCameraNode* cameraNode = dynamic_cast <vtkMRMLVideoCameraNode*>(refNode);
-
-  std::string fullName = this->GetFullNameFromFileName();
-  if (fullName.empty())
-  {
-    vtkErrorMacro("File name not specified");
-    return 0;
-  }
-
-  // check that the file exists
-  if (vtksys::SystemTools::FileExists(fullName.c_str()) == false)
-  {
-    vtkErrorMacro("Camera file '" << fullName.c_str() << "' not found.");
-    return 0;
-  }
-
-  // compute file prefix
-  cv::FileStorage fs(fullName, cv::FileStorage::READ);
-  if (!fs.isOpened())
-  {
-    vtkErrorMacro("File cannot be opened for reading.");
-    return 0;
-  }
-
-  cv::Mat intrinMat;
-  cv::Mat distCoeffs;
-  cv::Mat markerToSensor;
-  cv::Mat cameraPlaneOffset;
-  cv::FileNode intrinNode = fs["IntrinsicMatrix"];
-  if (intrinNode.empty())
-  {
-    vtkErrorMacro("Camera file does not contain IntrinsicMatrix cv::Mat.");
-    intrinMat = cv::Mat::eye(3, 3, CV_64F);
-  }
-  else
-  {
-    intrinNode >> intrinMat;
-  }
-
-  cv::FileNode distCoeffsNode = fs["DistortionCoefficients"];
-  if (distCoeffsNode.empty())
-  {
-    vtkErrorMacro("Camera file does not contain DistortionCoefficients cv::Mat.");
-    distCoeffs = cv::Mat::zeros(5, 1, CV_64F);
-  }
-  else
-  {
-    distCoeffsNode >> distCoeffs;
-  }
-
-  cv::FileNode markerToSensorNode = fs["MarkerToSensor"];
-  if (markerToSensorNode.empty())
-  {
-    vtkErrorMacro("Camera file does not contain MarkerToSensor cv::Mat.");
-    markerToSensor = cv::Mat::eye(4, 4, CV_64F);
-  }
-  else
-  {
-    markerToSensorNode >> markerToSensor;
-  }
-
-  cv::FileNode cameraPlaneNode = fs["CameraPlaneOffset"];
-  if (cameraPlaneNode.empty())
-  {
-    vtkErrorMacro("Camera file does not contain CameraPlaneOffset cv::Mat.");
-    cameraPlaneOffset = cv::Mat::zeros(3, 1, CV_64F);
-  }
-  else
-  {
-    cameraPlaneNode >> cameraPlaneOffset;
-  }
-
-  if (!fs["ReprojectionError"].empty())
-  {
-    cameraNode->SetReprojectionError((double)fs["ReprojectionError"]);
-  }
-
-  if (!fs["RegistrationError"].empty())
-  {
-    cameraNode->SetRegistrationError((double)fs["RegistrationError"]);
-  }
-
-  intrinMat.convertTo(intrinMat, CV_64F);
-  distCoeffs.convertTo(distCoeffs, CV_64F);
-  markerToSensor.convertTo(markerToSensor, CV_64F);
-  cameraPlaneOffset.convertTo(cameraPlaneOffset, CV_64F);
-
-  vtkNew<vtkMatrix3x3> mat;
-  for (int i = 0; i < 3; ++i)
-  {
-    for (int j = 0; j < 3; ++j)
-    {
-      mat->SetElement(i, j, intrinMat.at<double>(i, j));
-    }
-  }
-  cameraNode->SetAndObserveIntrinsicMatrix(mat);
-
-  {
-    vtkNew<vtkDoubleArray> array;
-    for (int i = 0; i < distCoeffs.rows; ++i)
-    {
-      array->InsertNextValue(distCoeffs.at<double>(i, 0));
-    }
-    cameraNode->SetAndObserveDistortionCoefficients(array);
-  }
-
-  vtkNew<vtkMatrix4x4> markerToImageSensor;
-  for (int i = 0; i < 4; ++i)
-  {
-    for (int j = 0; j < 4; ++j)
-    {
-      markerToImageSensor->SetElement(i, j, markerToSensor.at<double>(i, j));
-    }
-  }
-  cameraNode->SetAndObserveMarkerToImageSensorTransform(markerToImageSensor);
-
-  {
-    vtkNew<vtkDoubleArray> array;
-    for (int i = 0; i < cameraPlaneOffset.rows; ++i)
-    {
-      array->InsertNextValue(cameraPlaneOffset.at<double>(i, 0));
-    }
-    cameraNode->SetAndObserveCameraPlaneOffset(array);
-  }
-
-  return 1;
-}
-
-//----------------------------------------------------------------------------
-int vtkMRMLVideoCameraStorageNode::WriteDataInternal(vtkMRMLNode* refNode)
-{
-  vtkMRMLVideoCameraNode* videoCameraNode = vtkMRMLVideoCameraNode::SafeDownCast(refNode);
-
-  std::string fullName = this->GetFullNameFromFileName();
-  if (fullName.empty())
-  {
-    vtkErrorMacro("File name not specified");
-    return 0;
-  }
-
-  cv::FileStorage fs(fullName, cv::FileStorage::WRITE);
-
-  if (!fs.isOpened())
-  {
-    vtkErrorMacro("Cannot open " << fullName << " for writing.");
-    return 0;
-  }
-
-  if (videoCameraNode->GetIntrinsicMatrix() == NULL)
-  {
-    vtkInfoMacro("Intrinsincs have not been determined for this camera.");
-    fs << "IntrinsicMatrix" << cv::Mat::eye(3, 3, CV_64F);
-  }
-  else
-  {
-    cv::Mat intrinMat(3, 3, CV_64F);
-    for (int i = 0; i < 3; ++i)
-    {
-      for (int j = 0; j < 3; ++j)
-      {
-        intrinMat.at<double>(i, j) = videoCameraNode->GetIntrinsicMatrix()->GetElement(i, j);
-      }
-    }
-    fs << "IntrinsicMatrix" << intrinMat;
-  }
-
-  if (videoCameraNode->GetDistortionCoefficients() == NULL)
-  {
-    vtkInfoMacro("Distortion coefficients have not been determined for this camera.");
-    fs << "DistortionCoefficients" << cv::Mat::zeros(5, 1, CV_64F);
-  }
-  else
-  {
-    cv::Mat distCoeffs(videoCameraNode->GetDistortionCoefficients()->GetSize(), 1, CV_64F);
-    for (int i = 0; i < videoCameraNode->GetDistortionCoefficients()->GetSize(); ++i)
-    {
-      distCoeffs.at<double>(i, 0) = videoCameraNode->GetDistortionCoefficients()->GetValue(i);
-    }
-    fs << "DistortionCoefficients" << distCoeffs;
-  }
-
-  if (videoCameraNode->GetMarkerToImageSensorTransform() == NULL)
-  {
-    vtkInfoMacro("MarkerToImageSensor matrix has not been determined for this camera.");
-    fs << "MarkerToSensor" << cv::Mat::eye(4, 4, CV_64F);
-  }
-  else
-  {
-    cv::Mat mat(4, 4, CV_64F);
-    for (int i = 0; i < 4; ++i)
-    {
-      for (int j = 0; j < 4; ++j)
-      {
-        mat.at<double>(i, j) = videoCameraNode->GetMarkerToImageSensorTransform()->GetElement(i, j);
-      }
-    }
-    fs << "MarkerToSensor" << mat;
-  }
-
-  if (videoCameraNode->GetCameraPlaneOffset() == NULL)
-  {
-    vtkInfoMacro("Camera plane offsets have not been determined for this camera.");
-    fs << "CameraPlaneOffset" << cv::Mat::zeros(3, 1, CV_64F);
-  }
-  else
-  {
-    cv::Mat planeOffsets(3, 1, CV_64F);
-    for (int i = 0; i < 3; ++i)
-    {
-      planeOffsets.at<double>(i, 0) = videoCameraNode->GetCameraPlaneOffset()->GetValue(i);
-    }
-    fs << "CameraPlaneOffset" << planeOffsets;
-  }
-
-  if (videoCameraNode->IsReprojectionErrorValid())
-  {
-    fs << "ReprojectionError" << videoCameraNode->GetReprojectionError();
-  }
-
-  if (videoCameraNode->IsRegistrationErrorValid())
-  {
-    fs << "RegistrationError" << videoCameraNode->GetRegistrationError();
-  }
-
-  return 1;
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraStorageNode::InitializeSupportedReadFileTypes()
-{
-  this->SupportedReadFileTypes->InsertNextValue("OpenCV XML (.xml)");
-}
-
-//----------------------------------------------------------------------------
-void vtkMRMLVideoCameraStorageNode::InitializeSupportedWriteFileTypes()
-{
-  this->SupportedWriteFileTypes->InsertNextValue("OpenCV XML (.xml)");
-}
-
-//----------------------------------------------------------------------------
-vtkMRMLVideoCameraNode* vtkMRMLVideoCameraStorageNode::GetAssociatedDataNode()
-{
-  if (!this->GetScene())
-  {
-    return NULL;
-  }
-
-  std::vector<vtkMRMLNode*> nodes;
-  unsigned int numberOfNodes = this->GetScene()->GetNodesByClass("vtkMRMLVideoCameraNode", nodes);
-  for (unsigned int nodeIndex = 0; nodeIndex < numberOfNodes; nodeIndex++)
-  {
-    vtkMRMLVideoCameraNode* node = vtkMRMLVideoCameraNode::SafeDownCast(nodes[nodeIndex]);
-    if (node)
-    {
-      const char* storageNodeID = node->GetStorageNodeID();
-      if (storageNodeID && !strcmp(storageNodeID, this->ID))
-      {
-        return vtkMRMLVideoCameraNode::SafeDownCast(node);
-      }
-    }
-  }
-
-  return NULL;
-}
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+  Module:    $RCSfile: vtkMRMLVideoCameraStorageNode.cxx,v $
+  Date:      $Date: 2018/6/16 10:54:09 $
+  Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkMRMLVideoCameraStorageNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkVideoCameraObservations.h"
+#include "vtkVideoCameraRegistry.h"
+#include "vtkVideoCameraRig.h"
+
+// VTK includes
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkStringArray.h>
+#include <vtkVersion.h>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+// OpenCV includes
+#include <opencv2/videoio.hpp>
+#include <opencv2/core/persistence.hpp>
+
+//----------------------------------------------------------------------------
+
+vtkMRMLNodeNewMacro(vtkMRMLVideoCameraStorageNode);
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  cv::Mat ToMat(vtkMatrix3x3* matrix)
+  {
+    cv::Mat mat(3, 3, CV_64F);
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        mat.at<double>(i, j) = matrix->GetElement(i, j);
+      }
+    }
+    return mat;
+  }
+
+  //----------------------------------------------------------------------------
+  cv::Mat ToMat(vtkDoubleArray* array)
+  {
+    cv::Mat mat(static_cast<int>(array->GetNumberOfValues()), 1, CV_64F);
+    for (int i = 0; i < mat.rows; ++i)
+    {
+      mat.at<double>(i, 0) = array->GetValue(i);
+    }
+    return mat;
+  }
+
+  //----------------------------------------------------------------------------
+  void FromMat(cv::Mat mat, vtkMatrix3x3* matrix)
+  {
+    mat.convertTo(mat, CV_64F);
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        matrix->SetElement(i, j, mat.at<double>(i, j));
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void FromMat(cv::Mat mat, vtkDoubleArray* array)
+  {
+    mat.convertTo(mat, CV_64F);
+    mat = mat.reshape(1, static_cast<int>(mat.total()));
+    array->SetNumberOfValues(mat.rows);
+    for (int i = 0; i < mat.rows; ++i)
+    {
+      array->SetValue(i, mat.at<double>(i, 0));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Packed points as one row per tuple
+  cv::Mat ToPackedMat(vtkDataArray* array, int type)
+  {
+    cv::Mat mat(static_cast<int>(array->GetNumberOfTuples()), array->GetNumberOfComponents(), type);
+    for (int i = 0; i < mat.rows; ++i)
+    {
+      for (int j = 0; j < mat.cols; ++j)
+      {
+        if (type == CV_32S)
+        {
+          mat.at<int>(i, j) = static_cast<int>(array->GetComponent(i, j));
+        }
+        else
+        {
+          mat.at<double>(i, j) = array->GetComponent(i, j);
+        }
+      }
+    }
+    return mat;
+  }
+
+  //----------------------------------------------------------------------------
+  void FromPackedMat(cv::Mat mat, vtkDataArray* array)
+  {
+    mat.convertTo(mat, CV_64F);
+    array->SetNumberOfTuples(mat.rows);
+    for (int i = 0; i < mat.rows; ++i)
+    {
+      for (int j = 0; j < array->GetNumberOfComponents() && j < mat.cols; ++j)
+      {
+        array->SetComponent(i, j, mat.at<double>(i, j));
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void WriteObservations(cv::FileStorage& fs, vtkVideoCameraObservations* observations)
+  {
+    fs << "Observations" << "{";
+    fs << "BoardType" << std::string(observations->GetBoardType() ? observations->GetBoardType() : "");
+    fs << "BoardRows" << observations->GetBoardRows();
+    fs << "BoardColumns" << observations->GetBoardColumns();
+    fs << "BoardParameters" << cv::Mat(2, 1, CV_64F, observations->GetBoardParameters()).clone();
+    fs << "DictionaryName" << std::string(observations->GetDictionaryName() ? observations->GetDictionaryName() : "");
+    fs << "ImageSize" << cv::Mat(2, 1, CV_32S, observations->GetImageSize()).clone();
+    if (observations->GetBoardPoints() != nullptr)
+    {
+      fs << "BoardPoints" << ToPackedMat(observations->GetBoardPoints(), CV_64F);
+    }
+    fs << "ViewOffsets" << ToPackedMat(observations->GetViewOffsets(), CV_32S);
+    fs << "ImagePoints" << ToPackedMat(observations->GetImagePoints(), CV_64F);
+    if (observations->GetObjectPoints()->GetNumberOfTuples() > 0)
+    {
+      fs << "ObjectPoints" << ToPackedMat(observations->GetObjectPoints(), CV_64F);
+    }
+    if (observations->GetIds()->GetNumberOfTuples() > 0)
+    {
+      fs << "Ids" << ToPackedMat(observations->GetIds(), CV_32S);
+    }
+    fs << "}";
+  }
+
+  //----------------------------------------------------------------------------
+  bool ReadObservations(cv::FileNode node, vtkVideoCameraObservations* observations)
+  {
+    if (node["ViewOffsets"].empty() || node["ImagePoints"].empty())
+    {
+      return false;
+    }
+
+    std::string text;
+    node["BoardType"] >> text;
+    observations->SetBoardType(text.empty() ? nullptr : text.c_str());
+    node["DictionaryName"] >> text;
+    observations->SetDictionaryName(text.empty() ? nullptr : text.c_str());
+    observations->SetBoardRows((int)node["BoardRows"]);
+    observations->SetBoardColumns((int)node["BoardColumns"]);
+
+    cv::Mat mat;
+    if (!node["BoardParameters"].empty())
+    {
+      node["BoardParameters"] >> mat;
+      mat.convertTo(mat, CV_64F);
+      observations->SetBoardParameters(mat.at<double>(0), mat.at<double>(1));
+    }
+    if (!node["ImageSize"].empty())
+    {
+      node["ImageSize"] >> mat;
+      mat.convertTo(mat, CV_32S);
+      observations->SetImageSize(mat.at<int>(0), mat.at<int>(1));
+    }
+    observations->SetBoardPoints(nullptr);
+    if (!node["BoardPoints"].empty())
+    {
+      vtkNew<vtkFloatArray> boardPoints;
+      boardPoints->SetNumberOfComponents(3);
+      node["BoardPoints"] >> mat;
+      FromPackedMat(mat, boardPoints.GetPointer());
+      observations->SetBoardPoints(boardPoints.GetPointer());
+    }
+
+    // rebuild the views through AddView so the packed arrays are validated
+    cv::Mat offsets;
+    node["ViewOffsets"] >> offsets;
+    offsets.convertTo(offsets, CV_32S);
+    vtkNew<vtkDoubleArray> imagePoints;
+    imagePoints->SetNumberOfComponents(2);
+    node["ImagePoints"] >> mat;
+    FromPackedMat(mat, imagePoints.GetPointer());
+    vtkNew<vtkDoubleArray> objectPoints;
+    objectPoints->SetNumberOfComponents(3);
+    if (!node["ObjectPoints"].empty())
+    {
+      node["ObjectPoints"] >> mat;
+      FromPackedMat(mat, objectPoints.GetPointer());
+    }
+    vtkNew<vtkIntArray> ids;
+    if (!node["Ids"].empty())
+    {
+      node["Ids"] >> mat;
+      FromPackedMat(mat, ids.GetPointer());
+    }
+
+    observations->RemoveAllViews();
+    vtkNew<vtkDoubleArray> viewImagePoints;
+    viewImagePoints->SetNumberOfComponents(2);
+    vtkNew<vtkDoubleArray> viewObjectPoints;
+    viewObjectPoints->SetNumberOfComponents(3);
+    vtkNew<vtkIntArray> viewIds;
+    for (int view = 0; view + 1 < static_cast<int>(offsets.total()); ++view)
+    {
+      const vtkIdType begin = offsets.at<int>(view);
+      const vtkIdType end = offsets.at<int>(view + 1);
+      if (begin < 0 || end < begin || end > imagePoints->GetNumberOfTuples())
+      {
+        return false;
+      }
+      viewImagePoints->SetNumberOfTuples(0);
+      viewObjectPoints->SetNumberOfTuples(0);
+      viewIds->SetNumberOfTuples(0);
+      for (vtkIdType i = begin; i < end; ++i)
+      {
+        viewImagePoints->InsertNextTuple(i, imagePoints.GetPointer());
+        if (objectPoints->GetNumberOfTuples() > 0)
+        {
+          viewObjectPoints->InsertNextTuple(i, objectPoints.GetPointer());
+        }
+        if (ids->GetNumberOfTuples() > 0)
+        {
+          viewIds->InsertNextValue(ids->GetValue(i));
+        }
+      }
+      if (observations->AddView(viewImagePoints.GetPointer(),
+                                objectPoints->GetNumberOfTuples() > 0 ? viewObjectPoints.GetPointer() : nullptr,
+                                ids->GetNumberOfTuples() > 0 ? viewIds.GetPointer() : nullptr) < 0)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Mirror the principal point and negate the distortion terms that are odd in x and y (p1, p2,
+  // s1..s4, tauX, tauY of the pinhole model, p1, p2 of the omnidirectional model): the parameters
+  // of frames rotated by 180 degrees then apply to the frames as delivered
+  void RotateParameters(vtkMatrix3x3* intrinsics, vtkDoubleArray* distCoeffs, int cameraModel, const int imageSize[2])
+  {
+    intrinsics->SetElement(0, 2, imageSize[0] - 1 - intrinsics->GetElement(0, 2));
+    intrinsics->SetElement(1, 2, imageSize[1] - 1 - intrinsics->GetElement(1, 2));
+    if (cameraModel == vtkMRMLVideoCameraNode::FisheyeCameraModel)
+    {
+      return;
+    }
+    for (vtkIdType i = 2; i < distCoeffs->GetNumberOfValues(); ++i)
+    {
+      if (i < 4 || i >= 8)
+      {
+        distCoeffs->SetValue(i, -distCoeffs->GetValue(i));
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Move a camera calibrated on frames rotated by 180 degrees, as the calibration module did before
+  // the pixel convention of vtkSlicerVideoCameraProjection.h, to the current convention
+  void RotatePixelConvention(vtkMRMLVideoCameraNode* cameraNode, vtkVideoCameraObservations* observations)
+  {
+    const int* imageSize = observations->GetImageSize();
+    const int cameraModel = cameraNode->GetCameraModel();
+    vtkNew<vtkMatrix3x3> intrinsics;
+    vtkNew<vtkDoubleArray> distCoeffs;
+    for (int i = 0; i < cameraNode->GetNumberOfCalibrationTableEntries(); ++i)
+    {
+      cameraNode->GetCalibrationTableEntry(i, intrinsics.GetPointer(), distCoeffs.GetPointer());
+      RotateParameters(intrinsics.GetPointer(), distCoeffs.GetPointer(), cameraModel, imageSize);
+      // same encoder value, replaces the entry
+      cameraNode->AddCalibrationTableEntry(cameraNode->GetCalibrationTableEncoderValue(i), intrinsics.GetPointer(), distCoeffs.GetPointer());
+    }
+    RotateParameters(cameraNode->GetIntrinsicMatrix(), cameraNode->GetDistortionCoefficients(), cameraModel, imageSize);
+    if (cameraNode->GetNumberOfCalibrationTableEntries() > 0)
+    {
+      // the table was modified, apply it again
+      cameraNode->SetEncoderValue(cameraNode->GetEncoderValue());
+    }
+
+    vtkFloatArray* imagePoints = observations->GetImagePoints();
+    for (vtkIdType i = 0; i < imagePoints->GetNumberOfTuples(); ++i)
+    {
+      imagePoints->SetComponent(i, 0, imageSize[0] - 1 - imagePoints->GetComponent(i, 0));
+      imagePoints->SetComponent(i, 1, imageSize[1] - 1 - imagePoints->GetComponent(i, 1));
+    }
+    imagePoints->Modified();
+  }
+
+  //----------------------------------------------------------------------------
+  // Set the parameters of a camera node from the map of a camera file or of a rig camera section
+  void ReadCameraParameters(const cv::FileNode& root, vtkMRMLVideoCameraNode* cameraNode, const std::string& observationsSection, vtkObject* caller)
+  {
+    cv::Mat intrinMat;
+    cv::Mat distCoeffs;
+    cv::Mat markerToSensor;
+    cv::Mat cameraPlaneOffset;
+    cv::FileNode intrinNode = root["IntrinsicMatrix"];
+    if (intrinNode.empty())
+    {
+      vtkErrorWithObjectMacro(caller, "Camera file does not contain IntrinsicMatrix cv::Mat.");
+      intrinMat = cv::Mat::eye(3, 3, CV_64F);
+    }
+    else
+    {
+      intrinNode >> intrinMat;
+    }
+
+    cv::FileNode distCoeffsNode = root["DistortionCoefficients"];
+    if (distCoeffsNode.empty())
+    {
+      vtkErrorWithObjectMacro(caller, "Camera file does not contain DistortionCoefficients cv::Mat.");
+      distCoeffs = cv::Mat::zeros(5, 1, CV_64F);
+    }
+    else
+    {
+      distCoeffsNode >> distCoeffs;
+    }
+
+    cv::FileNode markerToSensorNode = root["MarkerToSensor"];
+    if (markerToSensorNode.empty())
+    {
+      vtkErrorWithObjectMacro(caller, "Camera file does not contain MarkerToSensor cv::Mat.");
+      markerToSensor = cv::Mat::eye(4, 4, CV_64F);
+    }
+    else
+    {
+      markerToSensorNode >> markerToSensor;
+    }
+
+    cv::FileNode cameraPlaneNode = root["CameraPlaneOffset"];
+    if (cameraPlaneNode.empty())
+    {
+      vtkErrorWithObjectMacro(caller, "Camera file does not contain CameraPlaneOffset cv::Mat.");
+      cameraPlaneOffset = cv::Mat::zeros(3, 1, CV_64F);
+    }
+    else
+    {
+      cameraPlaneNode >> cameraPlaneOffset;
+    }
+
+    if (!root["ReprojectionError"].empty())
+    {
+      cameraNode->SetReprojectionError((double)root["ReprojectionError"]);
+    }
+
+    if (!root["RegistrationError"].empty())
+    {
+      cameraNode->SetRegistrationError((double)root["RegistrationError"]);
+    }
+
+    // Files written before camera models were introduced are pinhole
+    int cameraModel = vtkMRMLVideoCameraNode::PinholeCameraModel;
+    if (!root["CameraModel"].empty())
+    {
+      std::string modelName;
+      root["CameraModel"] >> modelName;
+      cameraModel = vtkMRMLVideoCameraNode::GetCameraModelFromString(modelName.c_str());
+      if (cameraModel < 0)
+      {
+        vtkErrorWithObjectMacro(caller, "Camera file contains unknown CameraModel '" << modelName << "', assuming pinhole.");
+        cameraModel = vtkMRMLVideoCameraNode::PinholeCameraModel;
+      }
+    }
+    cameraNode->SetCameraModel(cameraModel);
+    cameraNode->SetXi(root["Xi"].empty() ? 0.0 : (double)root["Xi"]);
+
+    intrinMat.convertTo(intrinMat, CV_64F);
+    distCoeffs.convertTo(distCoeffs, CV_64F);
+    markerToSensor.convertTo(markerToSensor, CV_64F);
+    cameraPlaneOffset.convertTo(cameraPlaneOffset, CV_64F);
+
+    vtkNew<vtkMatrix3x3> mat;
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        mat->SetElement(i, j, intrinMat.at<double>(i, j));
+      }
+    }
+    cameraNode->SetAndObserveIntrinsicMatrix(mat);
+
+    {
+      vtkNew<vtkDoubleArray> array;
+      for (int i = 0; i < distCoeffs.rows; ++i)
+      {
+        array->InsertNextValue(distCoeffs.at<double>(i, 0));
+      }
+      cameraNode->SetAndObserveDistortionCoefficients(array);
+    }
+
+    vtkNew<vtkMatrix4x4> markerToImageSensor;
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        markerToImageSensor->SetElement(i, j, markerToSensor.at<double>(i, j));
+      }
+    }
+    cameraNode->SetAndObserveMarkerToImageSensorTransform(markerToImageSensor);
+
+    {
+      vtkNew<vtkDoubleArray> array;
+      for (int i = 0; i < cameraPlaneOffset.rows; ++i)
+      {
+        array->InsertNextValue(cameraPlaneOffset.at<double>(i, 0));
+      }
+      cameraNode->SetAndObserveCameraPlaneOffset(array);
+    }
+
+    // Optional zoom/focus calibration table
+    cameraNode->RemoveAllCalibrationTableEntries();
+    cv::FileNode tableNode = root["CalibrationTable"];
+    if (!tableNode.empty())
+    {
+      vtkNew<vtkMatrix3x3> entryIntrinsics;
+      vtkNew<vtkDoubleArray> entryDistCoeffs;
+      for (cv::FileNodeIterator it = tableNode.begin(); it != tableNode.end(); ++it)
+      {
+        cv::FileNode entryNode = *it;
+        if (entryNode["EncoderValue"].empty() || entryNode["IntrinsicMatrix"].empty())
+        {
+          vtkErrorWithObjectMacro(caller, "Calibration table entry is missing EncoderValue or IntrinsicMatrix, skipping.");
+          continue;
+        }
+
+        cv::Mat mat;
+        entryNode["IntrinsicMatrix"] >> mat;
+        FromMat(mat, entryIntrinsics.GetPointer());
+        entryDistCoeffs->Reset();
+        if (!entryNode["DistortionCoefficients"].empty())
+        {
+          entryNode["DistortionCoefficients"] >> mat;
+          FromMat(mat, entryDistCoeffs.GetPointer());
+        }
+        cameraNode->AddCalibrationTableEntry((double)entryNode["EncoderValue"], entryIntrinsics.GetPointer(), entryDistCoeffs.GetPointer());
+      }
+
+      if (!root["EncoderBucketSize"].empty())
+      {
+        cameraNode->SetEncoderBucketSize((double)root["EncoderBucketSize"]);
+      }
+      if (!root["EncoderValue"].empty())
+      {
+        cameraNode->SetEncoderValue((double)root["EncoderValue"]);
+      }
+    }
+
+    // Optional raw observations, parsed on first access when their section was cut from the text
+    cv::FileNode observationsNode = root["Observations"];
+    if (!observationsSection.empty())
+    {
+      cameraNode->SetDeferredObservations(observationsSection);
+    }
+    else if (!observationsNode.empty())
+    {
+      vtkSmartPointer<vtkVideoCameraObservations> observations = vtkSmartPointer<vtkVideoCameraObservations>::New();
+      if (ReadObservations(observationsNode, observations))
+      {
+        cameraNode->SetAndObserveObservations(observations);
+      }
+      else
+      {
+        vtkErrorWithObjectMacro(caller, "Camera file contains invalid Observations, skipping.");
+        cameraNode->SetAndObserveObservations(nullptr);
+      }
+    }
+    else
+    {
+      cameraNode->SetAndObserveObservations(nullptr);
+    }
+
+    // Cameras written without the pixel convention were calibrated on frames rotated by 180 degrees.
+    // They can only be moved to the current convention if the image size is known, i.e. if their
+    // observations were kept (which also means they come from the calibration module).
+    if (root["PixelConvention"].empty())
+    {
+      vtkVideoCameraObservations* observations = cameraNode->GetObservations();
+      if (observations != nullptr && observations->GetImageSize()[0] > 0 && observations->GetImageSize()[1] > 0)
+      {
+        RotatePixelConvention(cameraNode, observations);
+        vtkWarningWithObjectMacro(caller, "Camera file was calibrated on frames rotated by 180 degrees, its parameters and observations were converted to the current pixel convention.");
+      }
+      else
+      {
+        vtkWarningWithObjectMacro(caller, "Camera file has no PixelConvention: if it was calibrated with the VideoCameraCalibration module, "
+                                  "its principal point and tangential distortion are for frames rotated by 180 degrees and the camera must be recalibrated.");
+      }
+    }
+    else if ((int)root["PixelConvention"] > vtkMRMLVideoCameraNode::PixelConventionVersion)
+    {
+      vtkWarningWithObjectMacro(caller, "Camera file PixelConvention " << (int)root["PixelConvention"] << " is not supported, the latest is "
+                                << vtkMRMLVideoCameraNode::PixelConventionVersion << ".");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Write the parameters of a camera node at the current level of a file storage, unknown
+  // parameters are written as their defaults
+  void WriteCameraParameters(cv::FileStorage& fs, vtkMRMLVideoCameraNode* videoCameraNode)
+  {
+    if (videoCameraNode->GetIntrinsicMatrix() == NULL)
+    {
+      fs << "IntrinsicMatrix" << cv::Mat::eye(3, 3, CV_64F);
+    }
+    else
+    {
+      cv::Mat intrinMat(3, 3, CV_64F);
+      for (int i = 0; i < 3; ++i)
+      {
+        for (int j = 0; j < 3; ++j)
+        {
+          intrinMat.at<double>(i, j) = videoCameraNode->GetIntrinsicMatrix()->GetElement(i, j);
+        }
+      }
+      fs << "IntrinsicMatrix" << intrinMat;
+    }
+
+    if (videoCameraNode->GetDistortionCoefficients() == NULL)
+    {
+      fs << "DistortionCoefficients" << cv::Mat::zeros(5, 1, CV_64F);
+    }
+    else
+    {
+      cv::Mat distCoeffs(videoCameraNode->GetDistortionCoefficients()->GetSize(), 1, CV_64F);
+      for (int i = 0; i < videoCameraNode->GetDistortionCoefficients()->GetSize(); ++i)
+      {
+        distCoeffs.at<double>(i, 0) = videoCameraNode->GetDistortionCoefficients()->GetValue(i);
+      }
+      fs << "DistortionCoefficients" << distCoeffs;
+    }
+
+    if (videoCameraNode->GetMarkerToImageSensorTransform() == NULL)
+    {
+      fs << "MarkerToSensor" << cv::Mat::eye(4, 4, CV_64F);
+    }
+    else
+    {
+      cv::Mat mat(4, 4, CV_64F);
+      for (int i = 0; i < 4; ++i)
+      {
+        for (int j = 0; j < 4; ++j)
+        {
+          mat.at<double>(i, j) = videoCameraNode->GetMarkerToImageSensorTransform()->GetElement(i, j);
+        }
+      }
+      fs << "MarkerToSensor" << mat;
+    }
+
+    if (videoCameraNode->GetCameraPlaneOffset() == NULL)
+    {
+      fs << "CameraPlaneOffset" << cv::Mat::zeros(3, 1, CV_64F);
+    }
+    else
+    {
+      cv::Mat planeOffsets(3, 1, CV_64F);
+      for (int i = 0; i < 3; ++i)
+      {
+        planeOffsets.at<double>(i, 0) = videoCameraNode->GetCameraPlaneOffset()->GetValue(i);
+      }
+      fs << "CameraPlaneOffset" << planeOffsets;
+    }
+
+    if (videoCameraNode->IsReprojectionErrorValid())
+    {
+      fs << "ReprojectionError" << videoCameraNode->GetReprojectionError();
+    }
+
+    if (videoCameraNode->IsRegistrationErrorValid())
+    {
+      fs << "RegistrationError" << videoCameraNode->GetRegistrationError();
+    }
+
+    fs << "PixelConvention" << static_cast<int>(vtkMRMLVideoCameraNode::PixelConventionVersion);
+    fs << "CameraModel" << std::string(vtkMRMLVideoCameraNode::GetCameraModelAsString(videoCameraNode->GetCameraModel()));
+    if (videoCameraNode->GetCameraModel() == vtkMRMLVideoCameraNode::OmnidirectionalCameraModel)
+    {
+      fs << "Xi" << videoCameraNode->GetXi();
+    }
+
+    if (videoCameraNode->GetNumberOfCalibrationTableEntries() > 0)
+    {
+      fs << "EncoderValue" << videoCameraNode->GetEncoderValue();
+      fs << "EncoderBucketSize" << videoCameraNode->GetEncoderBucketSize();
+
+      vtkNew<vtkMatrix3x3> entryIntrinsics;
+      vtkNew<vtkDoubleArray> entryDistCoeffs;
+      fs << "CalibrationTable" << "[";
+      for (int i = 0; i < videoCameraNode->GetNumberOfCalibrationTableEntries(); ++i)
+      {
+        videoCameraNode->GetCalibrationTableEntry(i, entryIntrinsics.GetPointer(), entryDistCoeffs.GetPointer());
+        fs << "{";
+        fs << "EncoderValue" << videoCameraNode->GetCalibrationTableEncoderValue(i);
+        fs << "IntrinsicMatrix" << ToMat(entryIntrinsics.GetPointer());
+        fs << "DistortionCoefficients" << ToMat(entryDistCoeffs.GetPointer());
+        fs << "}";
+      }
+      fs << "]";
+    }
+
+    if (videoCameraNode->GetObservations() != nullptr && videoCameraNode->GetObservations()->GetNumberOfViews() > 0)
+    {
+      WriteObservations(fs, videoCameraNode->GetObservations());
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool ReadFileText(const std::string& fileName, std::string& text)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+      return false;
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    text = content.str();
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Cut the first <name>...</name> element out of XML text, false if it is not terminated
+  bool CutElement(std::string& text, const std::string& name, std::string& element)
+  {
+    element.clear();
+    const std::string beginTag = "<" + name + ">";
+    const std::string endTag = "</" + name + ">";
+    const std::string::size_type begin = text.find(beginTag);
+    if (begin == std::string::npos)
+    {
+      return true;
+    }
+    const std::string::size_type end = text.find(endTag, begin);
+    if (end == std::string::npos)
+    {
+      return false;
+    }
+    element = text.substr(begin, end + endTag.size() - begin);
+    text.erase(begin, end + endTag.size() - begin);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Split an OpenCV XML camera file into its core parameters and its Observations section.
+  // False if the file is not XML, the caller then parses the file in full.
+  bool SplitBulkSections(const std::string& fileName, std::string& core, std::string& observations)
+  {
+    observations.clear();
+    return ReadFileText(fileName, core) && core.compare(0, 5, "<?xml") == 0 && CutElement(core, "Observations", observations);
+  }
+
+  //----------------------------------------------------------------------------
+  // OpenCV XML document holding the given elements
+  std::string DocumentText(const std::string& elements)
+  {
+    return "<?xml version=\"1.0\"?>\n<opencv_storage>\n" + elements + "\n</opencv_storage>\n";
+  }
+
+  //----------------------------------------------------------------------------
+  // Text written to a memory storage, from its first element on and without the closing tag
+  std::string ElementsText(cv::FileStorage& fs, const std::string& firstElement)
+  {
+    const std::string text = fs.releaseAndGetString();
+    const std::string::size_type begin = text.find("<" + firstElement + ">");
+    const std::string::size_type end = text.rfind("</opencv_storage>");
+    if (begin == std::string::npos || end == std::string::npos || end < begin)
+    {
+      return std::string();
+    }
+    return text.substr(begin, end - begin);
+  }
+
+  const int RigVersion = 1;
+  const char* RigIndexEndTag = "</CameraIndex>";
+
+  //----------------------------------------------------------------------------
+  cv::Mat ToMat(vtkMatrix4x4* matrix)
+  {
+    cv::Mat mat(4, 4, CV_64F);
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        mat.at<double>(i, j) = matrix->GetElement(i, j);
+      }
+    }
+    return mat;
+  }
+
+  //----------------------------------------------------------------------------
+  // Rig version, extrinsics and camera index; the index is the last element of the header
+  std::string WriteRigHeader(vtkVideoCameraRig* rig, const std::vector<vtkIdType>& offsets, const std::vector<vtkIdType>& lengths)
+  {
+    cv::FileStorage fs(".xml", cv::FileStorage::WRITE | cv::FileStorage::MEMORY);
+    fs << "RigVersion" << RigVersion;
+
+    vtkNew<vtkMatrix4x4> fromToTo;
+    fs << "Extrinsics" << "[";
+    for (int i = 0; i < rig->GetNumberOfExtrinsics(); ++i)
+    {
+      rig->GetExtrinsics(i, fromToTo.GetPointer());
+      fs << "{";
+      fs << "From" << std::string(rig->GetExtrinsicsFrom(i));
+      fs << "To" << std::string(rig->GetExtrinsicsTo(i));
+      fs << "Transform" << ToMat(fromToTo.GetPointer());
+      fs << "}";
+    }
+    fs << "]";
+
+    fs << "CameraIndex" << "[";
+    for (int i = 0; i < rig->GetNumberOfCameras(); ++i)
+    {
+      std::ostringstream section;
+      section << "Camera" << i;
+      fs << "{";
+      fs << "Name" << std::string(rig->GetCameraName(i));
+      fs << "Section" << section.str();
+      fs << "Offset" << static_cast<int>(offsets[i]);
+      fs << "Length" << static_cast<int>(lengths[i]);
+      fs << "}";
+    }
+    fs << "]";
+
+    std::string text = fs.releaseAndGetString();
+    return text.substr(0, text.rfind(RigIndexEndTag) + strlen(RigIndexEndTag)) + "\n";
+  }
+
+  //----------------------------------------------------------------------------
+  // Read the extrinsics and camera index of a rig from the text of the file head
+  bool ParseRigHeader(const std::string& text, vtkVideoCameraRig* rig)
+  {
+    const std::string::size_type end = text.find(RigIndexEndTag);
+    if (text.compare(0, 5, "<?xml") != 0 || end == std::string::npos)
+    {
+      vtkErrorWithObjectMacro(rig, "Not a camera rig file.");
+      return false;
+    }
+    const std::string header = text.substr(0, end + strlen(RigIndexEndTag)) + "\n</opencv_storage>\n";
+    cv::FileStorage fs(header, cv::FileStorage::READ | cv::FileStorage::MEMORY);
+    if (!fs.isOpened() || fs["RigVersion"].empty())
+    {
+      vtkErrorWithObjectMacro(rig, "Not a camera rig file.");
+      return false;
+    }
+    if ((int)fs["RigVersion"] > RigVersion)
+    {
+      vtkErrorWithObjectMacro(rig, "Camera rig file version " << (int)fs["RigVersion"] << " is not supported, the latest is " << RigVersion << ".");
+      return false;
+    }
+
+    rig->RemoveAll();
+    vtkNew<vtkMatrix4x4> fromToTo;
+    cv::FileNode extrinsicsNode = fs["Extrinsics"];
+    for (cv::FileNodeIterator it = extrinsicsNode.begin(); it != extrinsicsNode.end(); ++it)
+    {
+      std::string from;
+      std::string to;
+      cv::Mat mat;
+      (*it)["From"] >> from;
+      (*it)["To"] >> to;
+      (*it)["Transform"] >> mat;
+      mat.convertTo(mat, CV_64F);
+      if (from.empty() || to.empty() || mat.rows != 4 || mat.cols != 4)
+      {
+        vtkErrorWithObjectMacro(rig, "Camera rig file contains invalid Extrinsics, skipping.");
+        continue;
+      }
+      for (int i = 0; i < 4; ++i)
+      {
+        for (int j = 0; j < 4; ++j)
+        {
+          fromToTo->SetElement(i, j, mat.at<double>(i, j));
+        }
+      }
+      rig->SetExtrinsics(from.c_str(), to.c_str(), fromToTo.GetPointer());
+    }
+
+    cv::FileNode indexNode = fs["CameraIndex"];
+    for (cv::FileNodeIterator it = indexNode.begin(); it != indexNode.end(); ++it)
+    {
+      std::string name;
+      (*it)["Name"] >> name;
+      const int camera = rig->AddCamera(name.c_str(), nullptr);
+      if (camera < 0)
+      {
+        return false;
+      }
+      rig->SetCameraSection(camera, (int)(*it)["Offset"], (int)(*it)["Length"]);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  // Read a camera from its rig section, "<CameraN>...</CameraN>"
+  bool ParseRigCameraSection(const std::string& section, vtkMRMLVideoCameraNode* camera, bool lazyLoading, vtkObject* caller)
+  {
+    const std::string::size_type nameEnd = section.find('>');
+    if (section.empty() || section[0] != '<' || nameEnd == std::string::npos)
+    {
+      return false;
+    }
+    const std::string name = section.substr(1, nameEnd - 1);
+    std::string text = section;
+    std::string observationsSection;
+    if (lazyLoading && !CutElement(text, "Observations", observationsSection))
+    {
+      return false;
+    }
+    try
+    {
+      cv::FileStorage fs(DocumentText(text), cv::FileStorage::READ | cv::FileStorage::MEMORY);
+      cv::FileNode root = fs[name];
+      if (!fs.isOpened() || !root.isMap())
+      {
+        return false;
+      }
+      ReadCameraParameters(root, camera, observationsSection, caller);
+    }
+    catch (const cv::Exception&)
+    {
+      return false;
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraStorageNode::vtkMRMLVideoCameraStorageNode()
+  : LazyLoading(true)
+{
+  this->DefaultWriteFileExtension = "xml";
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraStorageNode::~vtkMRMLVideoCameraStorageNode()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraStorageNode::PrintSelf(ostream& os, vtkIndent indent)
+{
+  vtkMRMLStorageNode::PrintSelf(os, indent);
+  os << indent << "LazyLoading: " << (this->LazyLoading ? "true" : "false") << std::endl;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraStorageNode::CanReadInReferenceNode(vtkMRMLNode* refNode)
+{
+  return refNode->IsA("vtkMRMLVideoCameraNode");
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVideoCameraStorageNode::ReadDataInternal(vtkMRMLNode* refNode)
+{
+  vtkMRMLVideoCameraNode* cameraNode = dynamic_cast <vtkMRMLVideoCameraNode*>(refNode);
+
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty())
+  {
+    vtkErrorMacro("File name not specified");
+    return 0;
+  }
+
+  // check that the file exists
+  if (vtksys::SystemTools::FileExists(fullName.c_str()) == false)
+  {
+    vtkErrorMacro("Camera file '" << fullName.c_str() << "' not found.");
+    return 0;
+  }
+
+  // the bulk sections are written last, the core parameters are parsed from the text before them
+  std::string coreText;
+  std::string observationsSection;
+  cv::FileStorage fs;
+  if (this->LazyLoading && SplitBulkSections(fullName, coreText, observationsSection))
+  {
+    fs.open(coreText, cv::FileStorage::READ | cv::FileStorage::MEMORY);
+  }
+  else
+  {
+    observationsSection.clear();
+    fs.open(fullName, cv::FileStorage::READ);
+  }
+  if (!fs.isOpened())
+  {
+    vtkErrorMacro("File cannot be opened for reading.");
+    return 0;
+  }
+
+  ReadCameraParameters(fs.root(), cameraNode, observationsSection, this);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraStorageNode::ReadObservationsSection(const std::string& section, vtkVideoCameraObservations* observations)
+{
+  if (observations == nullptr || section.empty())
+  {
+    return false;
+  }
+  try
+  {
+    cv::FileStorage fs(DocumentText(section), cv::FileStorage::READ | cv::FileStorage::MEMORY);
+    return fs.isOpened() && !fs["Observations"].empty() && ReadObservations(fs["Observations"], observations);
+  }
+  catch (const cv::Exception&)
+  {
+    return false;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraStorageNode::IsRigFile(const char* fileName)
+{
+  if (fileName == nullptr)
+  {
+    return false;
+  }
+  std::ifstream file(fileName, std::ios::in | std::ios::binary);
+  char head[1024];
+  file.read(head, sizeof(head));
+  // the rig version is the first element of a rig file
+  return std::string(head, static_cast<size_t>(file.gcount())).find("<RigVersion>") != std::string::npos;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraStorageNode::WriteRig(const char* fileName, vtkVideoCameraRig* rig)
+{
+  if (fileName == nullptr || rig == nullptr)
+  {
+    return false;
+  }
+
+  const int numberOfCameras = rig->GetNumberOfCameras();
+  std::vector<std::string> sections(numberOfCameras);
+  std::vector<vtkIdType> offsets(numberOfCameras, 0);
+  std::vector<vtkIdType> lengths(numberOfCameras, 0);
+  for (int i = 0; i < numberOfCameras; ++i)
+  {
+    vtkMRMLVideoCameraNode* camera = rig->GetCamera(i);
+    if (camera == nullptr)
+    {
+      vtkErrorWithObjectMacro(rig, "WriteRig: camera " << rig->GetCameraName(i) << " has no parameters.");
+      return false;
+    }
+    std::ostringstream name;
+    name << "Camera" << i;
+    cv::FileStorage fs(".xml", cv::FileStorage::WRITE | cv::FileStorage::MEMORY);
+    fs << name.str() << "{";
+    WriteCameraParameters(fs, camera);
+    fs << "}";
+    sections[i] = ElementsText(fs, name.str());
+    lengths[i] = static_cast<vtkIdType>(sections[i].size());
+  }
+
+  // The index holds the offsets of the sections that follow it, which depend on the length of
+  // the index itself: rewrite it until the offsets are stable (a few passes, as digits are added).
+  std::string header;
+  bool stable = false;
+  for (int pass = 0; pass < 10 && !stable; ++pass)
+  {
+    header = WriteRigHeader(rig, offsets, lengths);
+    stable = true;
+    vtkIdType offset = static_cast<vtkIdType>(header.size());
+    for (int i = 0; i < numberOfCameras; ++i)
+    {
+      stable = stable && offsets[i] == offset;
+      offsets[i] = offset;
+      offset += lengths[i];
+    }
+    if (offset > VTK_INT_MAX)
+    {
+      vtkErrorWithObjectMacro(rig, "WriteRig: rig file would exceed 2 GB.");
+      return false;
+    }
+  }
+  if (!stable)
+  {
+    vtkErrorWithObjectMacro(rig, "WriteRig: camera index did not converge.");
+    return false;
+  }
+
+  std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    vtkErrorWithObjectMacro(rig, "WriteRig: cannot open " << fileName << " for writing.");
+    return false;
+  }
+  file << header;
+  for (int i = 0; i < numberOfCameras; ++i)
+  {
+    file << sections[i];
+    rig->SetCameraSection(i, offsets[i], lengths[i]);
+  }
+  file << "</opencv_storage>\n";
+  return file.good();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraStorageNode::ReadRigIndex(const char* fileName, vtkVideoCameraRig* rig)
+{
+  if (fileName == nullptr || rig == nullptr)
+  {
+    return false;
+  }
+  std::ifstream file(fileName, std::ios::in | std::ios::binary);
+  if (!file.is_open())
+  {
+    vtkErrorWithObjectMacro(rig, "ReadRigIndex: cannot open " << fileName);
+    return false;
+  }
+
+  // only the head of the file, up to the end of the index, is read
+  std::string head;
+  char buffer[4096];
+  while (head.find(RigIndexEndTag) == std::string::npos && file.read(buffer, sizeof(buffer)).gcount() > 0)
+  {
+    head.append(buffer, static_cast<size_t>(file.gcount()));
+  }
+  try
+  {
+    return ParseRigHeader(head, rig);
+  }
+  catch (const cv::Exception& e)
+  {
+    vtkErrorWithObjectMacro(rig, "ReadRigIndex: " << e.what());
+    return false;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraStorageNode::ReadRigCamera(const char* fileName, vtkVideoCameraRig* rig, int index, vtkMRMLVideoCameraNode* camera, bool lazyLoading)
+{
+  if (fileName == nullptr || rig == nullptr || camera == nullptr)
+  {
+    return false;
+  }
+  if (rig->GetCameraSectionOffset(index) < 0)
+  {
+    vtkErrorWithObjectMacro(rig, "ReadRigCamera: camera " << index << " is not in the index, call ReadRigIndex first.");
+    return false;
+  }
+
+  std::ifstream file(fileName, std::ios::in | std::ios::binary);
+  std::string section(static_cast<size_t>(rig->GetCameraSectionLength(index)), '\0');
+  file.seekg(rig->GetCameraSectionOffset(index));
+  if (section.empty() || !file.read(&section[0], section.size()) ||
+      !ParseRigCameraSection(section, camera, lazyLoading, rig))
+  {
+    vtkErrorWithObjectMacro(rig, "ReadRigCamera: cannot read camera " << rig->GetCameraName(index) << " from " << fileName);
+    return false;
+  }
+  if (camera->GetName() == nullptr)
+  {
+    camera->SetName(rig->GetCameraName(index));
+  }
+  rig->SetCamera(index, camera);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVideoCameraStorageNode::ReadRig(const char* fileName, vtkVideoCameraRig* rig, bool lazyLoading)
+{
+  if (fileName == nullptr || rig == nullptr)
+  {
+    return false;
+  }
+
+  // one read of the whole file, the cameras are parsed from their sections in memory
+  std::string text;
+  if (!ReadFileText(fileName, text))
+  {
+    vtkErrorWithObjectMacro(rig, "ReadRig: cannot open " << fileName);
+    return false;
+  }
+  try
+  {
+    if (!ParseRigHeader(text, rig))
+    {
+      return false;
+    }
+  }
+  catch (const cv::Exception& e)
+  {
+    vtkErrorWithObjectMacro(rig, "ReadRig: " << e.what());
+    return false;
+  }
+
+  for (int i = 0; i < rig->GetNumberOfCameras(); ++i)
+  {
+    const vtkIdType offset = rig->GetCameraSectionOffset(i);
+    const vtkIdType length = rig->GetCameraSectionLength(i);
+    vtkSmartPointer<vtkMRMLVideoCameraNode> camera = vtkSmartPointer<vtkMRMLVideoCameraNode>::New();
+    camera->SetName(rig->GetCameraName(i));
+    if (offset < 0 || length <= 0 || static_cast<size_t>(offset + length) > text.size() ||
+        !ParseRigCameraSection(text.substr(static_cast<size_t>(offset), static_cast<size_t>(length)), camera, lazyLoading, rig))
+    {
+      vtkErrorWithObjectMacro(rig, "ReadRig: cannot read camera " << rig->GetCameraName(i) << " from " << fileName);
+      return false;
+    }
+    rig->SetCamera(i, camera);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVideoCameraStorageNode::WriteDataInternal(vtkMRMLNode* refNode)
+{
+  vtkMRMLVideoCameraNode* videoCameraNode = vtkMRMLVideoCameraNode::SafeDownCast(refNode);
+
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty())
+  {
+    vtkErrorMacro("File name not specified");
+    return 0;
+  }
+
+  cv::FileStorage fs(fullName, cv::FileStorage::WRITE);
+
+  if (!fs.isOpened())
+  {
+    vtkErrorMacro("Cannot open " << fullName << " for writing.");
+    return 0;
+  }
+
+  if (videoCameraNode->GetIntrinsicMatrix() == NULL)
+  {
+    vtkInfoMacro("Intrinsincs have not been determined for this camera.");
+  }
+  if (videoCameraNode->GetDistortionCoefficients() == NULL)
+  {
+    vtkInfoMacro("Distortion coefficients have not been determined for this camera.");
+  }
+  if (videoCameraNode->GetMarkerToImageSensorTransform() == NULL)
+  {
+    vtkInfoMacro("MarkerToImageSensor matrix has not been determined for this camera.");
+  }
+  if (videoCameraNode->GetCameraPlaneOffset() == NULL)
+  {
+    vtkInfoMacro("Camera plane offsets have not been determined for this camera.");
+  }
+  WriteCameraParameters(fs, videoCameraNode);
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraStorageNode::InitializeSupportedReadFileTypes()
+{
+  this->SupportedReadFileTypes->InsertNextValue("OpenCV XML (.xml)");
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVideoCameraStorageNode::InitializeSupportedWriteFileTypes()
+{
+  this->SupportedWriteFileTypes->InsertNextValue("OpenCV XML (.xml)");
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* vtkMRMLVideoCameraStorageNode::GetAssociatedDataNode()
+{
+  if (!this->GetScene())
+  {
+    return NULL;
+  }
+
+  // constant time lookup when the video cameras logic maintains a registry for this scene,
+  // the scene is still scanned on a miss, e.g. for a reference set while the registry was not observing
+  vtkVideoCameraRegistry* registry = vtkVideoCameraRegistry::GetSceneRegistry(this->GetScene());
+  if (registry != nullptr)
+  {
+    vtkMRMLVideoCameraNode* node = registry->GetNodeByStorageNodeID(this->ID);
+    if (node != nullptr)
+    {
+      return node;
+    }
+  }
+
+  std::vector<vtkMRMLNode*> nodes;
+  unsigned int numberOfNodes = this->GetScene()->GetNodesByClass("vtkMRMLVideoCameraNode", nodes);
+  for (unsigned int nodeIndex = 0; nodeIndex < numberOfNodes; nodeIndex++)
+  {
+    vtkMRMLVideoCameraNode* node = vtkMRMLVideoCameraNode::SafeDownCast(nodes[nodeIndex]);
+    if (node)
+    {
+      const char* storageNodeID = node->GetStorageNodeID();
+      if (storageNodeID && !strcmp(storageNodeID, this->ID))
+      {
+        return vtkMRMLVideoCameraNode::SafeDownCast(node);
+      }
+    }
+  }
+
+  return NULL;
+}
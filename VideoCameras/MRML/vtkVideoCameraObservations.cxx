@@ -0,0 +1,424 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkVideoCameraObservations.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+#include "vtkVideoCameraObservations.h"
+
+// VTK includes
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkVideoCameraObservations);
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Grow the array to hold count more tuples and return where they go, doubling the allocation so
+  // that appending is amortised constant time whatever the array's own growth policy
+  template<class ArrayType>
+  typename ArrayType::ValueType* AppendTuples(ArrayType* array, vtkIdType count)
+  {
+    const vtkIdType components = array->GetNumberOfComponents();
+    const vtkIdType offset = array->GetNumberOfTuples();
+    const vtkIdType capacity = array->GetSize() / components;
+    if (offset + count > capacity)
+    {
+      array->Resize(std::max(offset + count, 2 * capacity));
+    }
+    array->SetNumberOfTuples(offset + count);
+    return array->GetPointer(offset * components);
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkVideoCameraObservations::PackedPoints::PackedPoints()
+  : ImagePoints(vtkSmartPointer<vtkFloatArray>::New())
+  , ObjectPoints(vtkSmartPointer<vtkFloatArray>::New())
+  , Ids(vtkSmartPointer<vtkIntArray>::New())
+  , ViewOffsets(vtkSmartPointer<vtkIdTypeArray>::New())
+{
+  this->ImagePoints->SetNumberOfComponents(2);
+  this->ObjectPoints->SetNumberOfComponents(3);
+  this->Ids->SetNumberOfComponents(1);
+  this->ViewOffsets->InsertNextValue(0);
+}
+
+//----------------------------------------------------------------------------
+vtkVideoCameraObservations::vtkVideoCameraObservations()
+  : Points(std::make_shared<PackedPoints>())
+  , BoardType(nullptr)
+  , BoardRows(0)
+  , BoardColumns(0)
+  , DictionaryName(nullptr)
+{
+  this->BoardParameters[0] = this->BoardParameters[1] = 0.0;
+  this->ImageSize[0] = this->ImageSize[1] = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkVideoCameraObservations::~vtkVideoCameraObservations()
+{
+  this->SetBoardType(nullptr);
+  this->SetDictionaryName(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraObservations::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "BoardType: " << (this->BoardType ? this->BoardType : "(none)") << std::endl;
+  os << indent << "BoardRows: " << this->BoardRows << std::endl;
+  os << indent << "BoardColumns: " << this->BoardColumns << std::endl;
+  os << indent << "BoardParameters: " << this->BoardParameters[0] << " " << this->BoardParameters[1] << std::endl;
+  os << indent << "DictionaryName: " << (this->DictionaryName ? this->DictionaryName : "(none)") << std::endl;
+  os << indent << "ImageSize: " << this->ImageSize[0] << " " << this->ImageSize[1] << std::endl;
+  os << indent << "NumberOfViews: " << this->GetNumberOfViews() << std::endl;
+  os << indent << "NumberOfPoints: " << this->GetNumberOfPoints() << std::endl;
+  os << indent << "NumberOfBoardPoints: " << (this->BoardPoints ? this->BoardPoints->GetNumberOfTuples() : 0) << std::endl;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraObservations::DeepCopy(vtkVideoCameraObservations* source)
+{
+  if (source == nullptr)
+  {
+    return;
+  }
+
+  // new arrays, the current ones may be shared with a shallow copy
+  std::shared_ptr<PackedPoints> points = std::make_shared<PackedPoints>();
+  points->ImagePoints->DeepCopy(source->Points->ImagePoints);
+  points->ObjectPoints->DeepCopy(source->Points->ObjectPoints);
+  points->Ids->DeepCopy(source->Points->Ids);
+  points->ViewOffsets->DeepCopy(source->Points->ViewOffsets);
+  this->Points = points;
+  this->BoardPoints = nullptr;
+  if (source->BoardPoints != nullptr)
+  {
+    this->BoardPoints = vtkSmartPointer<vtkFloatArray>::New();
+    this->BoardPoints->DeepCopy(source->BoardPoints);
+  }
+  this->CopyBoard(source);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraObservations::ShallowCopy(vtkVideoCameraObservations* source)
+{
+  if (source == nullptr)
+  {
+    return;
+  }
+
+  this->Points = source->Points;
+  this->BoardPoints = source->BoardPoints;
+  this->CopyBoard(source);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraObservations::CopyBoard(vtkVideoCameraObservations* source)
+{
+  this->SetBoardType(source->BoardType);
+  this->BoardRows = source->BoardRows;
+  this->BoardColumns = source->BoardColumns;
+  this->BoardParameters[0] = source->BoardParameters[0];
+  this->BoardParameters[1] = source->BoardParameters[1];
+  this->SetDictionaryName(source->DictionaryName);
+  this->ImageSize[0] = source->ImageSize[0];
+  this->ImageSize[1] = source->ImageSize[1];
+}
+
+//----------------------------------------------------------------------------
+bool vtkVideoCameraObservations::SharesPointsWith(vtkVideoCameraObservations* observations) const
+{
+  return observations != nullptr && this->Points == observations->Points;
+}
+
+//----------------------------------------------------------------------------
+vtkVideoCameraObservations::PackedPoints& vtkVideoCameraObservations::EditPoints()
+{
+  if (this->Points.use_count() > 1)
+  {
+    std::shared_ptr<PackedPoints> points = std::make_shared<PackedPoints>();
+    points->ImagePoints->DeepCopy(this->Points->ImagePoints);
+    points->ObjectPoints->DeepCopy(this->Points->ObjectPoints);
+    points->Ids->DeepCopy(this->Points->Ids);
+    points->ViewOffsets->DeepCopy(this->Points->ViewOffsets);
+    this->Points = points;
+  }
+  return *this->Points;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraObservations::RemoveAllViews()
+{
+  if (this->Points.use_count() > 1)
+  {
+    // nothing to duplicate, the shared points are left to the other objects
+    this->Points = std::make_shared<PackedPoints>();
+    this->Modified();
+    return;
+  }
+  this->Points->ImagePoints->SetNumberOfTuples(0);
+  this->Points->ObjectPoints->SetNumberOfTuples(0);
+  this->Points->Ids->SetNumberOfTuples(0);
+  this->Points->ViewOffsets->SetNumberOfTuples(1);
+  this->Points->ViewOffsets->SetValue(0, 0);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraObservations::AddView(vtkDataArray* imagePoints, vtkDataArray* objectPoints, vtkDataArray* ids)
+{
+  if (imagePoints == nullptr || imagePoints->GetNumberOfComponents() != 2)
+  {
+    vtkErrorMacro("AddView: image points must have 2 components");
+    return -1;
+  }
+  const vtkIdType numberOfPoints = imagePoints->GetNumberOfTuples();
+  if (objectPoints != nullptr && (objectPoints->GetNumberOfComponents() != 3 || objectPoints->GetNumberOfTuples() != numberOfPoints))
+  {
+    vtkErrorMacro("AddView: object points must have 3 components and one tuple per image point");
+    return -1;
+  }
+  if (ids != nullptr && ids->GetNumberOfTuples() != numberOfPoints)
+  {
+    vtkErrorMacro("AddView: ids must have one tuple per image point");
+    return -1;
+  }
+
+  // the arrays may be of any type, convert once into contiguous buffers
+  std::vector<float> imageBuffer(2 * numberOfPoints);
+  std::vector<float> objectBuffer(objectPoints != nullptr ? 3 * numberOfPoints : 0);
+  std::vector<int> idBuffer(ids != nullptr ? numberOfPoints : 0);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    imageBuffer[2 * i] = static_cast<float>(imagePoints->GetComponent(i, 0));
+    imageBuffer[2 * i + 1] = static_cast<float>(imagePoints->GetComponent(i, 1));
+    if (objectPoints != nullptr)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        objectBuffer[3 * i + j] = static_cast<float>(objectPoints->GetComponent(i, j));
+      }
+    }
+    if (ids != nullptr)
+    {
+      idBuffer[i] = static_cast<int>(ids->GetComponent(i, 0));
+    }
+  }
+  return this->AddView(imageBuffer.data(),
+                       objectPoints != nullptr ? objectBuffer.data() : nullptr,
+                       ids != nullptr ? idBuffer.data() : nullptr,
+                       numberOfPoints);
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraObservations::AddView(const float* imagePoints, const float* objectPoints, const int* ids, vtkIdType numberOfPoints)
+{
+  if (numberOfPoints < 0 || (numberOfPoints > 0 && imagePoints == nullptr))
+  {
+    vtkErrorMacro("AddView: image points are required");
+    return -1;
+  }
+
+  // optional arrays are all or nothing so that the packed arrays stay aligned
+  const bool hasObjectPoints = this->Points->ObjectPoints->GetNumberOfTuples() > 0 || (this->GetNumberOfPoints() == 0 && objectPoints != nullptr);
+  const bool hasIds = this->Points->Ids->GetNumberOfTuples() > 0 || (this->GetNumberOfPoints() == 0 && ids != nullptr);
+  if (numberOfPoints > 0 && (hasObjectPoints != (objectPoints != nullptr) || hasIds != (ids != nullptr)))
+  {
+    vtkErrorMacro("AddView: views must all provide the same arrays");
+    return -1;
+  }
+
+  PackedPoints& points = this->EditPoints();
+  if (numberOfPoints > 0)
+  {
+    std::memcpy(AppendTuples(points.ImagePoints.GetPointer(), numberOfPoints), imagePoints, 2 * numberOfPoints * sizeof(float));
+    if (objectPoints != nullptr)
+    {
+      std::memcpy(AppendTuples(points.ObjectPoints.GetPointer(), numberOfPoints), objectPoints, 3 * numberOfPoints * sizeof(float));
+    }
+    if (ids != nullptr)
+    {
+      std::memcpy(AppendTuples(points.Ids.GetPointer(), numberOfPoints), ids, numberOfPoints * sizeof(int));
+    }
+  }
+  *AppendTuples(points.ViewOffsets.GetPointer(), 1) = points.ImagePoints->GetNumberOfTuples();
+  this->Modified();
+  return this->GetNumberOfViews() - 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraObservations::GetNumberOfViews() const
+{
+  return static_cast<int>(this->Points->ViewOffsets->GetNumberOfTuples()) - 1;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkVideoCameraObservations::GetNumberOfPoints() const
+{
+  return this->Points->ImagePoints->GetNumberOfTuples();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkVideoCameraObservations::GetViewPointOffset(int view) const
+{
+  if (view < 0 || view >= this->GetNumberOfViews())
+  {
+    return -1;
+  }
+  return this->Points->ViewOffsets->GetValue(view);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkVideoCameraObservations::GetViewNumberOfPoints(int view) const
+{
+  if (view < 0 || view >= this->GetNumberOfViews())
+  {
+    return 0;
+  }
+  return this->Points->ViewOffsets->GetValue(view + 1) - this->Points->ViewOffsets->GetValue(view);
+}
+
+//----------------------------------------------------------------------------
+bool vtkVideoCameraObservations::GetView(int view, vtkDataArray* imagePoints, vtkDataArray* objectPoints, vtkDataArray* ids) const
+{
+  if (view < 0 || view >= this->GetNumberOfViews())
+  {
+    return false;
+  }
+
+  const vtkIdType offset = this->Points->ViewOffsets->GetValue(view);
+  const vtkIdType numberOfPoints = this->GetViewNumberOfPoints(view);
+  if (imagePoints != nullptr)
+  {
+    imagePoints->SetNumberOfComponents(2);
+    imagePoints->SetNumberOfTuples(numberOfPoints);
+    for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+      imagePoints->SetTuple(i, offset + i, this->Points->ImagePoints);
+    }
+  }
+  if (objectPoints != nullptr)
+  {
+    const bool hasObjectPoints = this->Points->ObjectPoints->GetNumberOfTuples() > 0;
+    objectPoints->SetNumberOfComponents(3);
+    objectPoints->SetNumberOfTuples(hasObjectPoints ? numberOfPoints : 0);
+    for (vtkIdType i = 0; hasObjectPoints && i < numberOfPoints; ++i)
+    {
+      objectPoints->SetTuple(i, offset + i, this->Points->ObjectPoints);
+    }
+  }
+  if (ids != nullptr)
+  {
+    const bool hasIds = this->Points->Ids->GetNumberOfTuples() > 0;
+    ids->SetNumberOfComponents(1);
+    ids->SetNumberOfTuples(hasIds ? numberOfPoints : 0);
+    for (vtkIdType i = 0; hasIds && i < numberOfPoints; ++i)
+    {
+      ids->SetComponent(i, 0, this->Points->Ids->GetValue(offset + i));
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkVideoCameraObservations::GetViewObjectPoints(int view, vtkDataArray* objectPoints) const
+{
+  if (objectPoints == nullptr || view < 0 || view >= this->GetNumberOfViews())
+  {
+    return false;
+  }
+  if (this->Points->ObjectPoints->GetNumberOfTuples() > 0)
+  {
+    return this->GetView(view, nullptr, objectPoints, nullptr);
+  }
+  if (this->BoardPoints == nullptr || this->Points->Ids->GetNumberOfTuples() == 0)
+  {
+    return false;
+  }
+
+  const vtkIdType offset = this->Points->ViewOffsets->GetValue(view);
+  const vtkIdType numberOfPoints = this->GetViewNumberOfPoints(view);
+  const vtkIdType numberOfBoardPoints = this->BoardPoints->GetNumberOfTuples();
+  objectPoints->SetNumberOfComponents(3);
+  objectPoints->SetNumberOfTuples(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    const int id = this->Points->Ids->GetValue(offset + i);
+    if (id < 0 || id >= numberOfBoardPoints)
+    {
+      vtkErrorMacro("GetViewObjectPoints: id " << id << " is not a board point");
+      return false;
+    }
+    objectPoints->SetTuple(i, id, this->BoardPoints);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkFloatArray* vtkVideoCameraObservations::GetImagePoints() const
+{
+  return this->Points->ImagePoints;
+}
+
+//----------------------------------------------------------------------------
+vtkFloatArray* vtkVideoCameraObservations::GetObjectPoints() const
+{
+  return this->Points->ObjectPoints;
+}
+
+//----------------------------------------------------------------------------
+vtkIntArray* vtkVideoCameraObservations::GetIds() const
+{
+  return this->Points->Ids;
+}
+
+//----------------------------------------------------------------------------
+vtkIdTypeArray* vtkVideoCameraObservations::GetViewOffsets() const
+{
+  return this->Points->ViewOffsets;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraObservations::SetBoardPoints(vtkFloatArray* boardPoints)
+{
+  if (boardPoints != nullptr && boardPoints->GetNumberOfComponents() != 3)
+  {
+    vtkErrorMacro("SetBoardPoints: board points must have 3 components");
+    return;
+  }
+  if (this->BoardPoints == boardPoints)
+  {
+    return;
+  }
+  this->BoardPoints = boardPoints;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkFloatArray* vtkVideoCameraObservations::GetBoardPoints() const
+{
+  return this->BoardPoints;
+}
@@ -0,0 +1,170 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkVideoCameraObservations.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkVideoCameraObservations - raw calibration observations of a video camera
+// .SECTION Description
+// Keeps the board geometry and the per-view detections a calibration was computed from, so
+// that a camera can be re-solved with another distortion model or flag set without capturing
+// again. Points of all views are packed in single float arrays, indexed through per-view offsets,
+// so appending a view is amortised constant time per point and a solver can read the points of
+// any view in place (e.g. through numpy views of GetImagePoints). The packed arrays of a shallow
+// copy are shared with its source, like the parameter block of a copied camera node.
+//
+// Board points are the geometry shared by all views: a view that provides ids instead of object
+// points refers to the board point with that id, so the board is not copied per view.
+
+#ifndef __vtkVideoCameraObservations_h
+#define __vtkVideoCameraObservations_h
+
+// MRML includes
+#include "vtkSlicerVideoCamerasModuleMRMLExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <memory>
+
+class vtkDataArray;
+class vtkFloatArray;
+class vtkIdTypeArray;
+class vtkIntArray;
+
+class VTK_SLICER_VIDEOCAMERAS_MODULE_MRML_EXPORT vtkVideoCameraObservations : public vtkObject
+{
+public:
+  static vtkVideoCameraObservations* New();
+  vtkTypeMacro(vtkVideoCameraObservations, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  void DeepCopy(vtkVideoCameraObservations* source);
+
+  ///
+  /// Share the packed points of source instead of copying them
+  /// The arrays are duplicated by whichever object adds or removes views first; while they are
+  /// shared the arrays returned by GetImagePoints() and the like must not be edited in place.
+  void ShallowCopy(vtkVideoCameraObservations* source);
+
+  ///
+  /// True if the packed points are shared with another object (e.g. after ShallowCopy)
+  bool SharesPointsWith(vtkVideoCameraObservations* observations) const;
+
+  ///
+  /// Remove all views, the board geometry is kept
+  void RemoveAllViews();
+
+  ///
+  /// Append the detections of one view, returns the view index or -1
+  /// imagePoints has 2 components. objectPoints (3 components) and ids (1 component) are optional
+  /// but must then have one tuple per image point; views of a set must all provide the same arrays.
+  int AddView(vtkDataArray* imagePoints, vtkDataArray* objectPoints, vtkDataArray* ids);
+#if !defined(__VTK_WRAP__)
+  /// Append a view from raw buffers (x y pairs and ids, either may be null if unused), no copy
+  /// besides the one into the packed arrays
+  int AddView(const float* imagePoints, const float* objectPoints, const int* ids, vtkIdType numberOfPoints);
+#endif
+  int GetNumberOfViews() const;
+  vtkIdType GetNumberOfPoints() const;
+  vtkIdType GetViewPointOffset(int view) const;
+  vtkIdType GetViewNumberOfPoints(int view) const;
+
+  ///
+  /// Copy the detections of one view, arrays may be null
+  bool GetView(int view, vtkDataArray* imagePoints, vtkDataArray* objectPoints, vtkDataArray* ids) const;
+
+  ///
+  /// Object points of one view: its own object points if the views have them, otherwise the board
+  /// points its ids refer to. Returns false if neither is available.
+  bool GetViewObjectPoints(int view, vtkDataArray* objectPoints) const;
+
+  ///
+  /// Packed points of all views
+  vtkFloatArray* GetImagePoints() const;
+  vtkFloatArray* GetObjectPoints() const;
+  vtkIntArray* GetIds() const;
+  /// Number of views + 1 offsets into the packed arrays
+  vtkIdTypeArray* GetViewOffsets() const;
+
+  ///
+  /// Board geometry shared by the views (3 components, indexed by id), null if the views carry
+  /// their own object points. The array is referenced, not copied.
+  void SetBoardPoints(vtkFloatArray* boardPoints);
+  vtkFloatArray* GetBoardPoints() const;
+
+  ///
+  /// Board geometry: type ("checkerboard", "circlegrid", "aruco", "charuco"), number of rows and
+  /// columns, the two size parameters of the board (square/marker size, marker size/separation)
+  /// and the aruco dictionary name
+  vtkSetStringMacro(BoardType);
+  vtkGetStringMacro(BoardType);
+  vtkSetMacro(BoardRows, int);
+  vtkGetMacro(BoardRows, int);
+  vtkSetMacro(BoardColumns, int);
+  vtkGetMacro(BoardColumns, int);
+  vtkSetVector2Macro(BoardParameters, double);
+  vtkGetVector2Macro(BoardParameters, double);
+  vtkSetStringMacro(DictionaryName);
+  vtkGetStringMacro(DictionaryName);
+
+  ///
+  /// Size of the images the points were detected in, in pixels
+  vtkSetVector2Macro(ImageSize, int);
+  vtkGetVector2Macro(ImageSize, int);
+
+protected:
+  vtkVideoCameraObservations();
+  virtual ~vtkVideoCameraObservations();
+
+#if !defined(__VTK_WRAP__)
+  ///
+  /// Packed points of all views, shared by shallow copies
+  /// The arrays are never modified while they are shared: the object adding or removing views
+  /// first duplicates them if other objects still refer to them.
+  struct PackedPoints
+  {
+    PackedPoints();
+
+    vtkSmartPointer<vtkFloatArray>    ImagePoints;
+    vtkSmartPointer<vtkFloatArray>    ObjectPoints;
+    vtkSmartPointer<vtkIntArray>      Ids;
+    vtkSmartPointer<vtkIdTypeArray>   ViewOffsets;
+  };
+
+  /// Packed points to modify, duplicated first if they are shared
+  PackedPoints& EditPoints();
+#endif
+
+  /// Copy the board geometry and image size, not the points
+  void CopyBoard(vtkVideoCameraObservations* source);
+
+protected:
+#if !defined(__VTK_WRAP__)
+  std::shared_ptr<PackedPoints>     Points;
+#endif
+  vtkSmartPointer<vtkFloatArray>    BoardPoints;
+
+  char*   BoardType;
+  int     BoardRows;
+  int     BoardColumns;
+  double  BoardParameters[2];
+  char*   DictionaryName;
+  int     ImageSize[2];
+
+private:
+  vtkVideoCameraObservations(const vtkVideoCameraObservations&); // Not implemented
+  void operator=(const vtkVideoCameraObservations&); // Not implemented
+};
+
+#endif
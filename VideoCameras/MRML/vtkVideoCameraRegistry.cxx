@@ -0,0 +1,247 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkVideoCameraRegistry.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+#include "vtkVideoCameraRegistry.h"
+#include "vtkMRMLVideoCameraNode.h"
+
+// MRML includes
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <map>
+#include <string>
+#include <unordered_map>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkVideoCameraRegistry);
+
+namespace
+{
+  typedef std::unordered_multimap<std::string, vtkMRMLVideoCameraNode*> NodeIndex;
+
+  //----------------------------------------------------------------------------
+  void RemoveEntry(NodeIndex& index, const std::string& key, vtkMRMLVideoCameraNode* node)
+  {
+    std::pair<NodeIndex::iterator, NodeIndex::iterator> range = index.equal_range(key);
+    for (NodeIndex::iterator it = range.first; it != range.second; ++it)
+    {
+      if (it->second == node)
+      {
+        index.erase(it);
+        return;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  vtkMRMLVideoCameraNode* FindEntry(const NodeIndex& index, const char* key)
+  {
+    if (key == nullptr)
+    {
+      return nullptr;
+    }
+    NodeIndex::const_iterator it = index.find(key);
+    return it != index.end() ? it->second : nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  std::string ToString(const char* text)
+  {
+    return text ? text : "";
+  }
+
+  /// Registries attached to scenes
+  std::map<vtkMRMLScene*, vtkVideoCameraRegistry*> SceneRegistries;
+}
+
+//----------------------------------------------------------------------------
+class vtkVideoCameraRegistry::vtkInternal
+{
+public:
+  /// Keys a node is currently indexed under, to remove stale entries on update
+  struct Keys
+  {
+    std::string ID;
+    std::string Name;
+    std::string StorageNodeID;
+    std::string DeviceSerial;
+  };
+
+  std::unordered_map<vtkMRMLVideoCameraNode*, Keys> NodeKeys;
+  NodeIndex IDs;
+  NodeIndex Names;
+  NodeIndex StorageNodeIDs;
+  NodeIndex DeviceSerials;
+};
+
+//----------------------------------------------------------------------------
+vtkVideoCameraRegistry::vtkVideoCameraRegistry()
+  : Internal(new vtkInternal)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkVideoCameraRegistry::~vtkVideoCameraRegistry()
+{
+  for (std::map<vtkMRMLScene*, vtkVideoCameraRegistry*>::iterator it = SceneRegistries.begin(); it != SceneRegistries.end();)
+  {
+    if (it->second == this)
+    {
+      it = SceneRegistries.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRegistry::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfNodes: " << this->GetNumberOfNodes() << std::endl;
+}
+
+//----------------------------------------------------------------------------
+const char* vtkVideoCameraRegistry::GetDeviceSerialAttributeName()
+{
+  return "VideoCamera.DeviceSerial";
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRegistry::UpdateNode(vtkMRMLVideoCameraNode* node)
+{
+  if (node == nullptr || node->GetID() == nullptr)
+  {
+    return;
+  }
+
+  vtkInternal::Keys keys;
+  keys.ID = node->GetID();
+  keys.Name = ToString(node->GetName());
+  keys.StorageNodeID = ToString(node->GetStorageNodeID());
+  keys.DeviceSerial = ToString(node->GetAttribute(GetDeviceSerialAttributeName()));
+
+  std::unordered_map<vtkMRMLVideoCameraNode*, vtkInternal::Keys>::iterator it = this->Internal->NodeKeys.find(node);
+  if (it != this->Internal->NodeKeys.end())
+  {
+    const vtkInternal::Keys& old = it->second;
+    if (old.ID == keys.ID && old.Name == keys.Name && old.StorageNodeID == keys.StorageNodeID && old.DeviceSerial == keys.DeviceSerial)
+    {
+      return;
+    }
+    this->RemoveNode(node);
+  }
+
+  this->Internal->IDs.insert(std::make_pair(keys.ID, node));
+  this->Internal->Names.insert(std::make_pair(keys.Name, node));
+  if (!keys.StorageNodeID.empty())
+  {
+    this->Internal->StorageNodeIDs.insert(std::make_pair(keys.StorageNodeID, node));
+  }
+  if (!keys.DeviceSerial.empty())
+  {
+    this->Internal->DeviceSerials.insert(std::make_pair(keys.DeviceSerial, node));
+  }
+  this->Internal->NodeKeys[node] = keys;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRegistry::RemoveNode(vtkMRMLVideoCameraNode* node)
+{
+  std::unordered_map<vtkMRMLVideoCameraNode*, vtkInternal::Keys>::iterator it = this->Internal->NodeKeys.find(node);
+  if (it == this->Internal->NodeKeys.end())
+  {
+    return;
+  }
+
+  RemoveEntry(this->Internal->IDs, it->second.ID, node);
+  RemoveEntry(this->Internal->Names, it->second.Name, node);
+  RemoveEntry(this->Internal->StorageNodeIDs, it->second.StorageNodeID, node);
+  RemoveEntry(this->Internal->DeviceSerials, it->second.DeviceSerial, node);
+  this->Internal->NodeKeys.erase(it);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRegistry::RemoveAllNodes()
+{
+  this->Internal->NodeKeys.clear();
+  this->Internal->IDs.clear();
+  this->Internal->Names.clear();
+  this->Internal->StorageNodeIDs.clear();
+  this->Internal->DeviceSerials.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraRegistry::GetNumberOfNodes() const
+{
+  return static_cast<int>(this->Internal->NodeKeys.size());
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* vtkVideoCameraRegistry::GetNodeByID(const char* id) const
+{
+  return FindEntry(this->Internal->IDs, id);
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* vtkVideoCameraRegistry::GetNodeByName(const char* name) const
+{
+  return FindEntry(this->Internal->Names, name);
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* vtkVideoCameraRegistry::GetNodeByStorageNodeID(const char* storageNodeID) const
+{
+  return FindEntry(this->Internal->StorageNodeIDs, storageNodeID);
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* vtkVideoCameraRegistry::GetNodeByDeviceSerial(const char* serial) const
+{
+  return FindEntry(this->Internal->DeviceSerials, serial);
+}
+
+//----------------------------------------------------------------------------
+vtkVideoCameraRegistry* vtkVideoCameraRegistry::GetSceneRegistry(vtkMRMLScene* scene)
+{
+  std::map<vtkMRMLScene*, vtkVideoCameraRegistry*>::const_iterator it = SceneRegistries.find(scene);
+  return it != SceneRegistries.end() ? it->second : nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRegistry::SetSceneRegistry(vtkMRMLScene* scene, vtkVideoCameraRegistry* registry)
+{
+  if (scene == nullptr)
+  {
+    return;
+  }
+  if (registry == nullptr)
+  {
+    SceneRegistries.erase(scene);
+  }
+  else
+  {
+    SceneRegistries[scene] = registry;
+  }
+}
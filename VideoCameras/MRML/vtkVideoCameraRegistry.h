@@ -0,0 +1,77 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkVideoCameraRegistry.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkVideoCameraRegistry - hash index of the video camera nodes of a scene
+// .SECTION Description
+// Indexes camera nodes by ID, name, storage node ID and device serial attribute. The registry
+// does not observe anything: its owner (the video cameras logic) adds, updates and removes nodes
+// as the scene changes. A registry can be attached to a scene so that MRML classes, which cannot
+// depend on the logic, can look cameras up without scanning the scene.
+
+#ifndef __vtkVideoCameraRegistry_h
+#define __vtkVideoCameraRegistry_h
+
+// MRML includes
+#include "vtkSlicerVideoCamerasModuleMRMLExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkMRMLScene;
+class vtkMRMLVideoCameraNode;
+
+class VTK_SLICER_VIDEOCAMERAS_MODULE_MRML_EXPORT vtkVideoCameraRegistry : public vtkObject
+{
+public:
+  static vtkVideoCameraRegistry* New();
+  vtkTypeMacro(vtkVideoCameraRegistry, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Node attribute holding the serial number of the physical camera
+  static const char* GetDeviceSerialAttributeName();
+
+  ///
+  /// Add a node or refresh its keys after a name, storage node or attribute change
+  void UpdateNode(vtkMRMLVideoCameraNode* node);
+  void RemoveNode(vtkMRMLVideoCameraNode* node);
+  void RemoveAllNodes();
+  int GetNumberOfNodes() const;
+
+  ///
+  /// Lookups, null if not found. Names and serials need not be unique, any match is returned.
+  vtkMRMLVideoCameraNode* GetNodeByID(const char* id) const;
+  vtkMRMLVideoCameraNode* GetNodeByName(const char* name) const;
+  vtkMRMLVideoCameraNode* GetNodeByStorageNodeID(const char* storageNodeID) const;
+  vtkMRMLVideoCameraNode* GetNodeByDeviceSerial(const char* serial) const;
+
+  ///
+  /// Registry attached to a scene, null if none
+  static vtkVideoCameraRegistry* GetSceneRegistry(vtkMRMLScene* scene);
+  static void SetSceneRegistry(vtkMRMLScene* scene, vtkVideoCameraRegistry* registry);
+
+protected:
+  vtkVideoCameraRegistry();
+  virtual ~vtkVideoCameraRegistry();
+
+protected:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkVideoCameraRegistry(const vtkVideoCameraRegistry&); // Not implemented
+  void operator=(const vtkVideoCameraRegistry&); // Not implemented
+};
+
+#endif
@@ -0,0 +1,260 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkVideoCameraRig.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+#include "vtkVideoCameraRig.h"
+#include "vtkMRMLVideoCameraNode.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <map>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkVideoCameraRig);
+
+//----------------------------------------------------------------------------
+class vtkVideoCameraRig::vtkInternal
+{
+public:
+  struct Camera
+  {
+    std::string                             Name;
+    vtkSmartPointer<vtkMRMLVideoCameraNode> Node;
+    vtkIdType                               SectionOffset = -1;
+    vtkIdType                               SectionLength = 0;
+  };
+
+  struct Extrinsics
+  {
+    std::string From;
+    std::string To;
+    double      FromToTo[16];
+  };
+
+  std::vector<Camera>         Cameras;
+  std::map<std::string, int>  CameraIndices;
+  std::vector<Extrinsics>     ExtrinsicsList;
+
+  bool IsValid(int index) const
+  {
+    return index >= 0 && index < static_cast<int>(this->Cameras.size());
+  }
+};
+
+//----------------------------------------------------------------------------
+vtkVideoCameraRig::vtkVideoCameraRig()
+  : Internal(new vtkInternal)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkVideoCameraRig::~vtkVideoCameraRig()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRig::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Cameras: " << this->Internal->Cameras.size() << std::endl;
+  for (std::vector<vtkInternal::Camera>::const_iterator it = this->Internal->Cameras.begin(); it != this->Internal->Cameras.end(); ++it)
+  {
+    os << indent.GetNextIndent() << it->Name << (it->Node != nullptr ? "" : " (not read)") << std::endl;
+  }
+  os << indent << "Extrinsics: " << this->Internal->ExtrinsicsList.size() << std::endl;
+  for (std::vector<vtkInternal::Extrinsics>::const_iterator it = this->Internal->ExtrinsicsList.begin(); it != this->Internal->ExtrinsicsList.end(); ++it)
+  {
+    os << indent.GetNextIndent() << it->From << "To" << it->To << std::endl;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraRig::AddCamera(vtkMRMLVideoCameraNode* camera)
+{
+  if (camera == nullptr)
+  {
+    vtkErrorMacro("AddCamera: camera is null.");
+    return -1;
+  }
+  return this->AddCamera(camera->GetName(), camera);
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraRig::AddCamera(const char* name, vtkMRMLVideoCameraNode* camera)
+{
+  if (name == nullptr || *name == '\0')
+  {
+    vtkErrorMacro("AddCamera: rig cameras need a name.");
+    return -1;
+  }
+  if (this->Internal->CameraIndices.count(name) > 0)
+  {
+    vtkErrorMacro("AddCamera: the rig already has a camera named " << name);
+    return -1;
+  }
+
+  vtkInternal::Camera entry;
+  entry.Name = name;
+  entry.Node = camera;
+  this->Internal->Cameras.push_back(entry);
+  const int index = static_cast<int>(this->Internal->Cameras.size()) - 1;
+  this->Internal->CameraIndices[entry.Name] = index;
+  this->Modified();
+  return index;
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraRig::GetNumberOfCameras() const
+{
+  return static_cast<int>(this->Internal->Cameras.size());
+}
+
+//----------------------------------------------------------------------------
+const char* vtkVideoCameraRig::GetCameraName(int index) const
+{
+  return this->Internal->IsValid(index) ? this->Internal->Cameras[index].Name.c_str() : nullptr;
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraRig::GetCameraIndex(const char* name) const
+{
+  if (name == nullptr)
+  {
+    return -1;
+  }
+  std::map<std::string, int>::const_iterator it = this->Internal->CameraIndices.find(name);
+  return it != this->Internal->CameraIndices.end() ? it->second : -1;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* vtkVideoCameraRig::GetCamera(int index) const
+{
+  return this->Internal->IsValid(index) ? this->Internal->Cameras[index].Node.GetPointer() : nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRig::SetCamera(int index, vtkMRMLVideoCameraNode* camera)
+{
+  if (!this->Internal->IsValid(index))
+  {
+    vtkErrorMacro("SetCamera: index " << index << " out of range.");
+    return;
+  }
+  this->Internal->Cameras[index].Node = camera;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkVideoCameraRig::GetCameraSectionOffset(int index) const
+{
+  return this->Internal->IsValid(index) ? this->Internal->Cameras[index].SectionOffset : -1;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkVideoCameraRig::GetCameraSectionLength(int index) const
+{
+  return this->Internal->IsValid(index) ? this->Internal->Cameras[index].SectionLength : 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRig::SetCameraSection(int index, vtkIdType offset, vtkIdType length)
+{
+  if (!this->Internal->IsValid(index))
+  {
+    vtkErrorMacro("SetCameraSection: index " << index << " out of range.");
+    return;
+  }
+  this->Internal->Cameras[index].SectionOffset = offset;
+  this->Internal->Cameras[index].SectionLength = length;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRig::SetExtrinsics(const char* from, const char* to, vtkMatrix4x4* fromToTo)
+{
+  if (from == nullptr || to == nullptr || fromToTo == nullptr)
+  {
+    vtkErrorMacro("SetExtrinsics: camera names and transform are required.");
+    return;
+  }
+
+  vtkInternal::Extrinsics extrinsics;
+  extrinsics.From = from;
+  extrinsics.To = to;
+  vtkMatrix4x4::DeepCopy(extrinsics.FromToTo, fromToTo);
+
+  for (std::vector<vtkInternal::Extrinsics>::iterator it = this->Internal->ExtrinsicsList.begin(); it != this->Internal->ExtrinsicsList.end(); ++it)
+  {
+    if (it->From == extrinsics.From && it->To == extrinsics.To)
+    {
+      *it = extrinsics;
+      this->Modified();
+      return;
+    }
+  }
+  this->Internal->ExtrinsicsList.push_back(extrinsics);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraRig::GetNumberOfExtrinsics() const
+{
+  return static_cast<int>(this->Internal->ExtrinsicsList.size());
+}
+
+//----------------------------------------------------------------------------
+const char* vtkVideoCameraRig::GetExtrinsicsFrom(int index) const
+{
+  if (index < 0 || index >= this->GetNumberOfExtrinsics())
+  {
+    return nullptr;
+  }
+  return this->Internal->ExtrinsicsList[index].From.c_str();
+}
+
+//----------------------------------------------------------------------------
+const char* vtkVideoCameraRig::GetExtrinsicsTo(int index) const
+{
+  if (index < 0 || index >= this->GetNumberOfExtrinsics())
+  {
+    return nullptr;
+  }
+  return this->Internal->ExtrinsicsList[index].To.c_str();
+}
+
+//----------------------------------------------------------------------------
+bool vtkVideoCameraRig::GetExtrinsics(int index, vtkMatrix4x4* fromToTo) const
+{
+  if (index < 0 || index >= this->GetNumberOfExtrinsics() || fromToTo == nullptr)
+  {
+    return false;
+  }
+  fromToTo->DeepCopy(this->Internal->ExtrinsicsList[index].FromToTo);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkVideoCameraRig::RemoveAll()
+{
+  this->Internal->Cameras.clear();
+  this->Internal->CameraIndices.clear();
+  this->Internal->ExtrinsicsList.clear();
+  this->Modified();
+}
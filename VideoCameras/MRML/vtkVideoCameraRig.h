@@ -0,0 +1,85 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkVideoCameraRig.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// .NAME vtkVideoCameraRig - cameras of a multi-camera rig and the extrinsics between them
+// .SECTION Description
+// Content of a rig file (see vtkMRMLVideoCameraStorageNode::WriteRig/ReadRig): named camera
+// parameter sets and named inter-camera transforms. An extrinsics entry maps the coordinates of
+// its From camera to the coordinates of its To camera (FromToTo).
+//
+// Cameras of a rig whose index was read but whose parameters were not parsed yet have a name and
+// a file section but no node. Camera nodes held by a rig are not added to any scene.
+
+#ifndef __vtkVideoCameraRig_h
+#define __vtkVideoCameraRig_h
+
+// MRML includes
+#include "vtkSlicerVideoCamerasModuleMRMLExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkMatrix4x4;
+class vtkMRMLVideoCameraNode;
+
+class VTK_SLICER_VIDEOCAMERAS_MODULE_MRML_EXPORT vtkVideoCameraRig : public vtkObject
+{
+public:
+  static vtkVideoCameraRig* New();
+  vtkTypeMacro(vtkVideoCameraRig, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  ///
+  /// Add a camera under its node name, returns its index, -1 if the name is empty or already used
+  int AddCamera(vtkMRMLVideoCameraNode* camera);
+  int AddCamera(const char* name, vtkMRMLVideoCameraNode* camera);
+  int GetNumberOfCameras() const;
+  const char* GetCameraName(int index) const;
+  int GetCameraIndex(const char* name) const;
+
+  ///
+  /// Parameters of a camera, null if they were not read
+  vtkMRMLVideoCameraNode* GetCamera(int index) const;
+  void SetCamera(int index, vtkMRMLVideoCameraNode* camera);
+
+  ///
+  /// Location of the camera section in the rig file it was read from, in bytes
+  vtkIdType GetCameraSectionOffset(int index) const;
+  vtkIdType GetCameraSectionLength(int index) const;
+  void SetCameraSection(int index, vtkIdType offset, vtkIdType length);
+
+  ///
+  /// From camera to To camera transforms, setting an existing pair replaces its transform
+  void SetExtrinsics(const char* from, const char* to, vtkMatrix4x4* fromToTo);
+  int GetNumberOfExtrinsics() const;
+  const char* GetExtrinsicsFrom(int index) const;
+  const char* GetExtrinsicsTo(int index) const;
+  bool GetExtrinsics(int index, vtkMatrix4x4* fromToTo) const;
+
+  void RemoveAll();
+
+protected:
+  vtkVideoCameraRig();
+  virtual ~vtkVideoCameraRig();
+
+protected:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkVideoCameraRig(const vtkVideoCameraRig&); // Not implemented
+  void operator=(const vtkVideoCameraRig&); // Not implemented
+};
+
+#endif
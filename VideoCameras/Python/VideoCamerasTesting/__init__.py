@@ -0,0 +1,35 @@
+"""Baselines of the golden dataset tests of the VideoCameras scripted modules
+
+Python counterpart of VideoCameras/Testing/Cxx/vtkVideoCamerasTestingUtilities.h: baseline files
+hold "key value" lines, '#' starts a comment. Tests compare their errors with their tolerance
+entries and their wall-clock time with TimeFactor * "<Test>.Seconds";
+VIDEOCAMERAS_TEST_TIME_FACTOR overrides TimeFactor, 0 disables.
+"""
+import logging
+import os
+
+def readRecords(path):
+  """Fields of the lines of a golden dataset or baseline file, without comments and blank lines"""
+  records = []
+  with open(path) as f:
+    for line in f:
+      fields = line.split('#')[0].split()
+      if len(fields) > 0:
+        records.append(fields)
+  return records
+
+def readBaselines(path):
+  """Baseline values by key, TimeFactor overridden by VIDEOCAMERAS_TEST_TIME_FACTOR"""
+  baselines = {}
+  for fields in readRecords(path):
+    baselines[fields[0]] = float(fields[1])
+  if os.environ.get('VIDEOCAMERAS_TEST_TIME_FACTOR'):
+    baselines['TimeFactor'] = float(os.environ['VIDEOCAMERAS_TEST_TIME_FACTOR'])
+  return baselines
+
+def checkTime(testCase, baselines, test, seconds):
+  """Fail testCase if test ran slower than TimeFactor times its baseline"""
+  baseline = baselines[test + '.Seconds']
+  logging.info('{0}: {1:.3f} s (baseline {2:.3f} s)'.format(test, seconds, baseline))
+  if baselines['TimeFactor'] > 0:
+    testCase.assertLessEqual(seconds, baselines['TimeFactor'] * baseline, '{0} is slower than {1} times its baseline'.format(test, baselines['TimeFactor']))
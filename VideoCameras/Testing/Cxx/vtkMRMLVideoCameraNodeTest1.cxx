@@ -0,0 +1,189 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkMRMLVideoCameraNodeTest1.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras includes
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkVideoCameraObservations.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMatrix3x3.h>
+#include <vtkMRMLStorageNode.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+  const int NumberOfCopies = 1000;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVideoCameraNodeTest1(int, char*[])
+{
+  vtkNew<vtkMRMLVideoCameraNode> camera;
+  camera->GetIntrinsicMatrix()->SetElement(0, 0, 800.0);
+  // arrays can be edited without a modified event, the block must still pick the value up
+  camera->GetDistortionCoefficients()->SetValue(0, 0.1);
+  vtkNew<vtkMatrix3x3> intrinsics;
+  vtkNew<vtkDoubleArray> distCoeffs;
+  distCoeffs->InsertNextValue(0.2);
+  camera->AddCalibrationTableEntry(10.0, intrinsics.GetPointer(), distCoeffs.GetPointer());
+
+  // copies share the parameters of the original
+  std::vector<vtkSmartPointer<vtkMRMLVideoCameraNode> > copies;
+  for (int i = 0; i < NumberOfCopies; ++i)
+  {
+    vtkSmartPointer<vtkMRMLVideoCameraNode> copy = vtkSmartPointer<vtkMRMLVideoCameraNode>::New();
+    copy->Copy(camera.GetPointer());
+    copies.push_back(copy);
+  }
+  for (int i = 0; i < NumberOfCopies; ++i)
+  {
+    if (!copies[i]->SharesParametersWith(camera.GetPointer()))
+    {
+      std::cerr << "Copy " << i << " does not share the parameters of the original" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (copies[0]->GetIntrinsicMatrix()->GetElement(0, 0) != 800.0 ||
+      copies[0]->GetDistortionCoefficients()->GetValue(0) != 0.1 ||
+      copies[0]->GetNumberOfCalibrationTableEntries() != 1 ||
+      !copies[0]->SharesParametersWith(camera.GetPointer()))
+  {
+    std::cerr << "Parameters of the copy differ from the original" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // editing a copy duplicates its parameters and leaves the others unchanged
+  copies[0]->GetIntrinsicMatrix()->SetElement(0, 0, 900.0);
+  copies[1]->RemoveAllCalibrationTableEntries();
+  if (copies[0]->SharesParametersWith(camera.GetPointer()) || copies[1]->SharesParametersWith(camera.GetPointer()) ||
+      !copies[2]->SharesParametersWith(camera.GetPointer()) ||
+      camera->GetIntrinsicMatrix()->GetElement(0, 0) != 800.0 || camera->GetNumberOfCalibrationTableEntries() != 1 ||
+      copies[0]->GetParameters()->Intrinsics[0] != 900.0 || copies[1]->GetNumberOfCalibrationTableEntries() != 0)
+  {
+    std::cerr << "Editing a copy modified the original or the other copies" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // a block read from the node is a snapshot, later edits do not modify it
+  std::shared_ptr<const vtkMRMLVideoCameraNode::ParameterBlock> parameters = camera->GetParameters();
+  camera->GetCameraPlaneOffset()->SetValue(2, 5.0);
+  if (parameters->CameraPlaneOffset[2] != 0.0 || camera->GetParameters()->CameraPlaneOffset[2] != 5.0 ||
+      copies[2]->GetCameraPlaneOffset()->GetValue(2) != 0.0)
+  {
+    std::cerr << "Parameter block was modified while it was shared" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // copying into a node whose parameters are displayed updates its views
+  copies[0]->Copy(camera.GetPointer());
+  if (copies[0]->GetIntrinsicMatrix()->GetElement(0, 0) != 800.0 || copies[0]->GetCameraPlaneOffset()->GetValue(2) != 5.0 ||
+      !copies[0]->SharesParametersWith(camera.GetPointer()))
+  {
+    std::cerr << "Views of the copy were not updated" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // a copy sharing the parameters whose view was edited in place gets the values back by copying again
+  copies[2]->Copy(camera.GetPointer());
+  copies[2]->GetDistortionCoefficients()->SetValue(0, 0.3);
+  copies[2]->Copy(camera.GetPointer());
+  if (copies[2]->GetDistortionCoefficients()->GetValue(0) != 0.1 ||
+      !copies[2]->SharesParametersWith(camera.GetPointer()))
+  {
+    std::cerr << "Copy kept the values edited in the views of the destination" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // zoom buckets: negative encoder values have negative buckets, encoder values within the
+  // applied bucket do not modify the node
+  vtkNew<vtkMRMLVideoCameraNode> zoomCamera;
+  if (zoomCamera->IsEncoderBucketingEnabled())
+  {
+    std::cerr << "Bucketing is enabled without a calibration table" << std::endl;
+    return EXIT_FAILURE;
+  }
+  intrinsics->SetElement(0, 0, 500.0);
+  zoomCamera->AddCalibrationTableEntry(-10.0, intrinsics.GetPointer(), distCoeffs.GetPointer());
+  intrinsics->SetElement(0, 0, 1500.0);
+  zoomCamera->AddCalibrationTableEntry(10.0, intrinsics.GetPointer(), distCoeffs.GetPointer());
+  zoomCamera->SetEncoderBucketSize(1.0);
+  zoomCamera->SetEncoderValue(-0.75);
+  const vtkMTimeType appliedTime = zoomCamera->GetMTime();
+  zoomCamera->SetEncoderValue(-0.25);
+  if (!zoomCamera->IsEncoderBucketingEnabled() || zoomCamera->GetEncoderBucket() != -1 ||
+      zoomCamera->GetMTime() != appliedTime || zoomCamera->GetIntrinsicMatrix()->GetElement(0, 0) != 975.0)
+  {
+    std::cerr << "Encoder value -0.25 is not in the applied bucket -1" << std::endl;
+    return EXIT_FAILURE;
+  }
+  zoomCamera->SetEncoderValue(0.25);
+  if (zoomCamera->GetEncoderBucket() != 0 || zoomCamera->GetMTime() == appliedTime)
+  {
+    std::cerr << "Changing bucket did not modify the camera" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // copies share the observations, or their unparsed section, until either adds or removes views
+  vtkNew<vtkVideoCameraObservations> cameraObservations;
+  const float imagePoints[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+  const int ids[2] = { 0, 1 };
+  cameraObservations->AddView(imagePoints, nullptr, ids, 2);
+  camera->SetAndObserveObservations(cameraObservations.GetPointer());
+  copies[3]->Copy(camera.GetPointer());
+  if (copies[3]->GetObservations() == nullptr || !copies[3]->GetObservations()->SharesPointsWith(cameraObservations.GetPointer()))
+  {
+    std::cerr << "Copy does not share the observations of the original" << std::endl;
+    return EXIT_FAILURE;
+  }
+  copies[3]->GetObservations()->AddView(imagePoints, nullptr, ids, 2);
+  if (copies[3]->GetObservations()->SharesPointsWith(cameraObservations.GetPointer()) ||
+      copies[3]->GetObservations()->GetNumberOfViews() != 2 || cameraObservations->GetNumberOfViews() != 1)
+  {
+    std::cerr << "Adding a view to the copy modified the observations of the original" << std::endl;
+    return EXIT_FAILURE;
+  }
+  copies[4]->SetDeferredObservations("ViewOffsets: []");
+  copies[5]->Copy(copies[4]);
+  if (!copies[5]->HasDeferredObservations())
+  {
+    std::cerr << "Copy did not keep the deferred observations" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // inline cameras need no camera file unless they have observations, which are only written there
+  vtkNew<vtkMRMLVideoCameraNode> inlineCamera;
+  inlineCamera->InlineParametersOn();
+  vtkSmartPointer<vtkMRMLStorageNode> storageNode = vtkSmartPointer<vtkMRMLStorageNode>::Take(inlineCamera->CreateDefaultStorageNode());
+  if (storageNode != nullptr)
+  {
+    std::cerr << "Inline camera without observations has a default storage node" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkNew<vtkVideoCameraObservations> observations;
+  inlineCamera->SetAndObserveObservations(observations.GetPointer());
+  storageNode = vtkSmartPointer<vtkMRMLStorageNode>::Take(inlineCamera->CreateDefaultStorageNode());
+  if (storageNode == nullptr)
+  {
+    std::cerr << "Observations of an inline camera have no storage node to be saved with" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
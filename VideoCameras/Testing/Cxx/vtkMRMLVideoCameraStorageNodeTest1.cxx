@@ -0,0 +1,358 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkMRMLVideoCameraStorageNodeTest1.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras includes
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkMRMLVideoCameraStorageNode.h"
+#include "vtkVideoCameraObservations.h"
+#include "vtkVideoCamerasTestingUtilities.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkMatrix3x3.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+  const int Repetitions = 20;
+
+  //----------------------------------------------------------------------------
+  bool CheckValue(const char* name, double value, double expected, double tolerance)
+  {
+    if (!(std::fabs(value - expected) <= tolerance * std::max(1.0, std::fabs(expected))))
+    {
+      std::cerr << name << " is " << value << ", expected " << expected << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool CheckArray(const char* name, vtkDataArray* array, vtkDataArray* expected, double tolerance)
+  {
+    if (array == nullptr || expected == nullptr)
+    {
+      std::cerr << name << " is missing" << std::endl;
+      return false;
+    }
+    if (array->GetNumberOfValues() != expected->GetNumberOfValues())
+    {
+      std::cerr << name << " has " << array->GetNumberOfValues() << " values, expected " << expected->GetNumberOfValues() << std::endl;
+      return false;
+    }
+    const int components = expected->GetNumberOfComponents();
+    for (vtkIdType i = 0; i < expected->GetNumberOfValues(); ++i)
+    {
+      if (!CheckValue(name, array->GetComponent(i / components, i % components), expected->GetComponent(i / components, i % components), tolerance))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool CheckCamera(vtkMRMLVideoCameraNode* node, vtkMRMLVideoCameraNode* expected, double tolerance)
+  {
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        if (!CheckValue("IntrinsicMatrix", node->GetIntrinsicMatrix()->GetElement(i, j), expected->GetIntrinsicMatrix()->GetElement(i, j), tolerance))
+        {
+          return false;
+        }
+      }
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        if (!CheckValue("MarkerToImageSensorTransform", node->GetMarkerToImageSensorTransform()->GetElement(i, j), expected->GetMarkerToImageSensorTransform()->GetElement(i, j), tolerance))
+        {
+          return false;
+        }
+      }
+    }
+    if (!CheckArray("DistortionCoefficients", node->GetDistortionCoefficients(), expected->GetDistortionCoefficients(), tolerance) ||
+        !CheckArray("CameraPlaneOffset", node->GetCameraPlaneOffset(), expected->GetCameraPlaneOffset(), tolerance) ||
+        !CheckValue("ReprojectionError", node->GetReprojectionError(), expected->GetReprojectionError(), tolerance) ||
+        !CheckValue("RegistrationError", node->GetRegistrationError(), expected->GetRegistrationError(), tolerance) ||
+        !CheckValue("CameraModel", node->GetCameraModel(), expected->GetCameraModel(), 0.0) ||
+        !CheckValue("EncoderValue", node->GetEncoderValue(), expected->GetEncoderValue(), tolerance) ||
+        !CheckValue("EncoderBucketSize", node->GetEncoderBucketSize(), expected->GetEncoderBucketSize(), tolerance) ||
+        !CheckValue("CalibrationTable entries", node->GetNumberOfCalibrationTableEntries(), expected->GetNumberOfCalibrationTableEntries(), 0.0))
+    {
+      return false;
+    }
+
+    vtkNew<vtkMatrix3x3> entryIntrinsics;
+    vtkNew<vtkMatrix3x3> expectedIntrinsics;
+    vtkNew<vtkDoubleArray> entryDistCoeffs;
+    vtkNew<vtkDoubleArray> expectedDistCoeffs;
+    for (int entry = 0; entry < expected->GetNumberOfCalibrationTableEntries(); ++entry)
+    {
+      node->GetCalibrationTableEntry(entry, entryIntrinsics.GetPointer(), entryDistCoeffs.GetPointer());
+      expected->GetCalibrationTableEntry(entry, expectedIntrinsics.GetPointer(), expectedDistCoeffs.GetPointer());
+      if (!CheckValue("CalibrationTable encoder value", node->GetCalibrationTableEncoderValue(entry), expected->GetCalibrationTableEncoderValue(entry), tolerance) ||
+          !CheckValue("CalibrationTable focal length", entryIntrinsics->GetElement(0, 0), expectedIntrinsics->GetElement(0, 0), tolerance) ||
+          !CheckArray("CalibrationTable distortion", entryDistCoeffs.GetPointer(), expectedDistCoeffs.GetPointer(), tolerance))
+      {
+        return false;
+      }
+    }
+
+    vtkVideoCameraObservations* observations = node->GetObservations();
+    vtkVideoCameraObservations* expectedObservations = expected->GetObservations();
+    if (observations == nullptr || expectedObservations == nullptr)
+    {
+      std::cerr << "Observations are missing" << std::endl;
+      return false;
+    }
+    const std::string boardType = observations->GetBoardType() ? observations->GetBoardType() : "";
+    const std::string expectedBoardType = expectedObservations->GetBoardType() ? expectedObservations->GetBoardType() : "";
+    if (boardType != expectedBoardType)
+    {
+      std::cerr << "BoardType is " << boardType << ", expected " << expectedBoardType << std::endl;
+      return false;
+    }
+    // observation points are single precision, they must read back exactly
+    return CheckValue("Number of views", observations->GetNumberOfViews(), expectedObservations->GetNumberOfViews(), 0.0) &&
+           CheckValue("BoardRows", observations->GetBoardRows(), expectedObservations->GetBoardRows(), 0.0) &&
+           CheckValue("BoardColumns", observations->GetBoardColumns(), expectedObservations->GetBoardColumns(), 0.0) &&
+           CheckValue("BoardParameters", observations->GetBoardParameters()[0], expectedObservations->GetBoardParameters()[0], tolerance) &&
+           CheckValue("ImageSize", observations->GetImageSize()[0], expectedObservations->GetImageSize()[0], 0.0) &&
+           CheckValue("ImageSize", observations->GetImageSize()[1], expectedObservations->GetImageSize()[1], 0.0) &&
+           CheckArray("ViewOffsets", observations->GetViewOffsets(), expectedObservations->GetViewOffsets(), 0.0) &&
+           CheckArray("ImagePoints", observations->GetImagePoints(), expectedObservations->GetImagePoints(), 0.0) &&
+           CheckArray("Ids", observations->GetIds(), expectedObservations->GetIds(), 0.0) &&
+           CheckArray("BoardPoints", observations->GetBoardPoints(), expectedObservations->GetBoardPoints(), 0.0);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Content of GoldenCamera_v1.xml
+  void MakeGoldenCamera(vtkMRMLVideoCameraNode* node)
+  {
+    const double intrinsics[9] = { 812.5, 0.0, 318.25, 0.0, 809.75, 242.125, 0.0, 0.0, 1.0 };
+    const double distCoeffs[5] = { -0.1875, 0.0625, 0.00125, -0.0005, 0.015625 };
+    const double markerToSensor[16] = { 0.0, -1.0, 0.0, 12.5, 1.0, 0.0, 0.0, -3.25, 0.0, 0.0, 1.0, 41.0, 0.0, 0.0, 0.0, 1.0 };
+    const double planeOffset[3] = { 0.5, -0.25, 1.0 };
+
+    vtkNew<vtkMatrix3x3> matrix;
+    matrix->DeepCopy(intrinsics);
+    node->SetAndObserveIntrinsicMatrix(matrix.GetPointer());
+    vtkNew<vtkDoubleArray> coefficients;
+    for (int i = 0; i < 5; ++i)
+    {
+      coefficients->InsertNextValue(distCoeffs[i]);
+    }
+    node->SetAndObserveDistortionCoefficients(coefficients.GetPointer());
+    vtkNew<vtkMatrix4x4> transform;
+    transform->DeepCopy(markerToSensor);
+    node->SetAndObserveMarkerToImageSensorTransform(transform.GetPointer());
+    vtkNew<vtkDoubleArray> offset;
+    for (int i = 0; i < 3; ++i)
+    {
+      offset->InsertNextValue(planeOffset[i]);
+    }
+    node->SetAndObserveCameraPlaneOffset(offset.GetPointer());
+    node->SetReprojectionError(0.28125);
+    node->SetRegistrationError(0.75);
+    node->SetCameraModel(vtkMRMLVideoCameraNode::PinholeCameraModel);
+
+    // the table entries interpolate to the intrinsics above at the center of the encoder bucket
+    for (int entry = 0; entry < 2; ++entry)
+    {
+      const double sign = entry == 0 ? -1.0 : 1.0;
+      vtkNew<vtkMatrix3x3> entryIntrinsics;
+      entryIntrinsics->DeepCopy(intrinsics);
+      entryIntrinsics->SetElement(0, 0, intrinsics[0] + sign * 100.0);
+      entryIntrinsics->SetElement(1, 1, intrinsics[4] + sign * 100.0);
+      vtkNew<vtkDoubleArray> entryDistCoeffs;
+      entryDistCoeffs->DeepCopy(coefficients.GetPointer());
+      entryDistCoeffs->SetValue(0, distCoeffs[0] + sign * 0.0625);
+      entryDistCoeffs->SetValue(1, distCoeffs[1] + sign * 0.03125);
+      node->AddCalibrationTableEntry(entry == 0 ? 1.0 : 3.5, entryIntrinsics.GetPointer(), entryDistCoeffs.GetPointer());
+    }
+    node->SetEncoderBucketSize(0.5);
+    node->SetEncoderValue(2.0);
+
+    vtkNew<vtkVideoCameraObservations> observations;
+    observations->SetBoardType("checkerboard");
+    observations->SetBoardRows(3);
+    observations->SetBoardColumns(4);
+    observations->SetBoardParameters(30.0, 0.0);
+    observations->SetImageSize(640, 480);
+    vtkNew<vtkFloatArray> boardPoints;
+    boardPoints->SetNumberOfComponents(3);
+    for (int i = 0; i < 12; ++i)
+    {
+      boardPoints->InsertNextTuple3((i % 4) * 30.0, (i / 4) * 30.0, 0.0);
+    }
+    observations->SetBoardPoints(boardPoints.GetPointer());
+    const float imagePoints[54] =
+    {
+      264.62f, 183.88f, 319.75f, 198.14f, 375.67f, 212.7f, 432.09f, 227.49f, 251.49f, 238.7f, 305.97f, 253.27f,
+      361.27f, 268.04f, 417.07f, 282.93f, 238.75f, 292.4f, 292.51f, 307.24f, 347.08f, 322.17f, 402.18f, 337.13f,
+      206.42f, 212.82f, 322.06f, 204.45f, 213.11f, 266.03f, 325.96f, 258.12f, 219.63f, 316.62f, 329.66f, 309.14f,
+      415.56f, 123.41f, 214.26f, 250.39f, 286.55f, 232.52f, 360.1f, 214.42f, 434.23f, 196.24f, 231.27f, 323.3f,
+      304.11f, 306.05f, 378.19f, 288.32f, 452.77f, 270.28f
+    };
+    const int ids[27] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 2, 4, 6, 8, 10, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    observations->AddView(imagePoints, nullptr, ids, 12);
+    observations->AddView(imagePoints + 24, nullptr, ids + 12, 6);
+    observations->AddView(imagePoints + 36, nullptr, ids + 18, 9);
+    node->SetAndObserveObservations(observations.GetPointer());
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVideoCameraStorageNodeTest1(int argc, char* argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Usage: " << argv[0] << " GoldenCamera.xml Baselines.txt TemporaryDirectory" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkVideoCamerasTestingUtilities::BaselineMap baselines;
+  double tolerance = 0.0;
+  if (!vtkVideoCamerasTestingUtilities::ReadBaselines(argv[2], baselines) ||
+      !vtkVideoCamerasTestingUtilities::GetBaseline(baselines, "StorageRoundTrip.Tolerance", tolerance))
+  {
+    return EXIT_FAILURE;
+  }
+  const std::string roundTripFileName = std::string(argv[3]) + "/vtkMRMLVideoCameraStorageNodeTest1.xml";
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLVideoCameraNode> expected;
+  MakeGoldenCamera(expected.GetPointer());
+  vtkNew<vtkMRMLVideoCameraNode> golden;
+  vtkNew<vtkMRMLVideoCameraNode> roundTrip;
+  scene->AddNode(golden.GetPointer());
+  scene->AddNode(roundTrip.GetPointer());
+  vtkNew<vtkMRMLVideoCameraStorageNode> storageNode;
+  scene->AddNode(storageNode.GetPointer());
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int repetition = 0; repetition < Repetitions; ++repetition)
+  {
+    storageNode->SetFileName(argv[1]);
+    if (!storageNode->ReadData(golden.GetPointer()))
+    {
+      std::cerr << "Cannot read " << argv[1] << std::endl;
+      return EXIT_FAILURE;
+    }
+    storageNode->SetFileName(roundTripFileName.c_str());
+    if (!storageNode->WriteData(golden.GetPointer()) || !storageNode->ReadData(roundTrip.GetPointer()))
+    {
+      std::cerr << "Cannot write and read back " << roundTripFileName << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  timer->StopTimer();
+
+  // observations of a camera that was read but not accessed yet are not parsed
+  if (!roundTrip->HasDeferredObservations())
+  {
+    std::cerr << "Observations were parsed by ReadData with lazy loading" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkMRMLVideoCameraNode> eager;
+  scene->AddNode(eager.GetPointer());
+  storageNode->LazyLoadingOff();
+  if (!storageNode->ReadData(eager.GetPointer()) || eager->HasDeferredObservations())
+  {
+    std::cerr << "Cannot read " << roundTripFileName << " without lazy loading" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // the golden file holds the expected values, the written file must read back identically
+  if (!CheckCamera(golden.GetPointer(), expected.GetPointer(), tolerance) ||
+      !CheckCamera(roundTrip.GetPointer(), golden.GetPointer(), tolerance) ||
+      !CheckCamera(eager.GetPointer(), golden.GetPointer(), tolerance))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // a file written before the pixel convention was calibrated on frames rotated by 180 degrees,
+  // its observations give the image size it is converted with
+  std::ifstream goldenFile(argv[1], std::ios::in | std::ios::binary);
+  std::ostringstream goldenText;
+  goldenText << goldenFile.rdbuf();
+  std::string rotatedText = goldenText.str();
+  const std::string marker = "<PixelConvention>1</PixelConvention>";
+  if (rotatedText.find(marker) == std::string::npos)
+  {
+    std::cerr << argv[1] << " has no PixelConvention" << std::endl;
+    return EXIT_FAILURE;
+  }
+  rotatedText.erase(rotatedText.find(marker), marker.size());
+  const std::string rotatedFileName = std::string(argv[3]) + "/vtkMRMLVideoCameraStorageNodeTest1Rotated.xml";
+  std::ofstream(rotatedFileName.c_str(), std::ios::out | std::ios::binary) << rotatedText;
+  vtkNew<vtkMRMLVideoCameraNode> rotated;
+  scene->AddNode(rotated.GetPointer());
+  storageNode->LazyLoadingOn();
+  storageNode->SetFileName(rotatedFileName.c_str());
+  // the conversion is reported
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  const int rotatedRead = storageNode->ReadData(rotated.GetPointer());
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  vtkNew<vtkMatrix3x3> rotatedIntrinsics;
+  vtkNew<vtkDoubleArray> rotatedDistCoeffs;
+  if (!rotatedRead ||
+      !rotated->GetCalibrationTableEntry(0, rotatedIntrinsics.GetPointer(), rotatedDistCoeffs.GetPointer()) ||
+      !CheckValue("Converted cx", rotated->GetIntrinsicMatrix()->GetElement(0, 2), 639.0 - 318.25, tolerance) ||
+      !CheckValue("Converted cy", rotated->GetIntrinsicMatrix()->GetElement(1, 2), 479.0 - 242.125, tolerance) ||
+      !CheckValue("Converted fx", rotated->GetIntrinsicMatrix()->GetElement(0, 0), 812.5, tolerance) ||
+      !CheckValue("Converted k1", rotated->GetDistortionCoefficients()->GetValue(0), -0.1875, tolerance) ||
+      !CheckValue("Converted p1", rotated->GetDistortionCoefficients()->GetValue(2), -0.00125, tolerance) ||
+      !CheckValue("Converted p2", rotated->GetDistortionCoefficients()->GetValue(3), 0.0005, tolerance) ||
+      !CheckValue("Converted k3", rotated->GetDistortionCoefficients()->GetValue(4), 0.015625, tolerance) ||
+      !CheckValue("Converted table cx", rotatedIntrinsics->GetElement(0, 2), 639.0 - 318.25, tolerance) ||
+      !CheckValue("Converted table p1", rotatedDistCoeffs->GetValue(2), -0.00125, tolerance) ||
+      rotated->GetObservations() == nullptr ||
+      !CheckValue("Converted image point", rotated->GetObservations()->GetImagePoints()->GetComponent(0, 0), 639.0f - 264.62f, 0.0) ||
+      !CheckValue("Converted image point", rotated->GetObservations()->GetImagePoints()->GetComponent(0, 1), 479.0f - 183.88f, 0.0))
+  {
+    std::cerr << "Camera without PixelConvention was not converted" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (!vtkVideoCamerasTestingUtilities::CheckTime(baselines, "StorageRoundTrip", timer->GetElapsedTime()))
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
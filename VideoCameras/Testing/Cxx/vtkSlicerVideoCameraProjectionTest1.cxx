@@ -0,0 +1,362 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraProjectionTest1.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras includes
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkSlicerVideoCameraProjection.h"
+#include "vtkVideoCamerasTestingUtilities.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkMatrix3x3.h>
+#include <vtkNew.h>
+
+// OpenCV includes
+#include <opencv2/calib3d.hpp>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const int NumberOfPoints = 1000;
+  const int ImageWidth = 640;
+  const int ImageHeight = 480;
+
+  // no skew, cv::projectPoints ignores it
+  const double Fx = 800.0;
+  const double Fy = 780.0;
+  const double Cx = 319.5;
+  const double Cy = 239.5;
+
+  // (k1, k2, p1, p2, k3, k4, k5, k6, s1, s2, s3, s4, tauX, tauY), a node gets the first ones
+  const double PinholeCoefficients[14] = { -0.28, 0.09, 0.0012, -0.0008, -0.01, 0.02, -0.005, 0.001, 0.0005, -0.0003, 0.0004, -0.0002, 0.01, -0.008 };
+  const double FisheyeCoefficients[4] = { 0.08, -0.02, 0.004, -0.0005 };
+  const double OmnidirectionalCoefficients[4] = { -0.2, 0.05, 0.001, -0.0005 };
+  const double Xi = 0.8;
+
+  struct TestCase
+  {
+    std::string Name;
+    int CameraModel;
+    std::vector<double> Coefficients;
+    /// Largest angle of the test points from the optical axis, degrees
+    double FieldOfView;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Every pinhole coefficient count (each size the dispatch selects, and the counts it pads to
+  /// the next size), fisheye and omnidirectional
+  std::vector<TestCase> GetTestCases()
+  {
+    std::vector<TestCase> testCases;
+    for (int count = 0; count <= 14; ++count)
+    {
+      std::ostringstream name;
+      name << "Pinhole" << count;
+      TestCase testCase = { name.str(), vtkMRMLVideoCameraNode::PinholeCameraModel,
+                            std::vector<double>(PinholeCoefficients, PinholeCoefficients + count), 25.0 };
+      testCases.push_back(testCase);
+    }
+    TestCase fisheye = { "Fisheye", vtkMRMLVideoCameraNode::FisheyeCameraModel,
+                         std::vector<double>(FisheyeCoefficients, FisheyeCoefficients + 4), 70.0 };
+    testCases.push_back(fisheye);
+    TestCase omnidirectional = { "Omnidirectional", vtkMRMLVideoCameraNode::OmnidirectionalCameraModel,
+                                 std::vector<double>(OmnidirectionalCoefficients, OmnidirectionalCoefficients + 4), 80.0 };
+    testCases.push_back(omnidirectional);
+    return testCases;
+  }
+
+  //----------------------------------------------------------------------------
+  cv::Mat GetCameraMatrix()
+  {
+    return (cv::Mat_<double>(3, 3) << Fx, 0.0, Cx, 0.0, Fy, Cy, 0.0, 0.0, 1.0);
+  }
+
+  //----------------------------------------------------------------------------
+  /// OpenCV distortion vector: pinhole coefficients padded to the next size OpenCV accepts
+  cv::Mat GetDistortion(const TestCase& testCase)
+  {
+    std::vector<double> coefficients = testCase.Coefficients;
+    if (testCase.CameraModel == vtkMRMLVideoCameraNode::PinholeCameraModel && !coefficients.empty())
+    {
+      const size_t sizes[5] = { 4, 5, 8, 12, 14 };
+      coefficients.resize(*std::lower_bound(sizes, sizes + 5, coefficients.size()), 0.0);
+    }
+    return cv::Mat(coefficients, true);
+  }
+
+  //----------------------------------------------------------------------------
+  void SetCamera(vtkMRMLVideoCameraNode* node, const TestCase& testCase)
+  {
+    vtkMatrix3x3* matrix = node->GetIntrinsicMatrix();
+    matrix->SetElement(0, 0, Fx);
+    matrix->SetElement(1, 1, Fy);
+    matrix->SetElement(0, 2, Cx);
+    matrix->SetElement(1, 2, Cy);
+    vtkDoubleArray* distCoeffs = node->GetDistortionCoefficients();
+    distCoeffs->SetNumberOfValues(static_cast<vtkIdType>(testCase.Coefficients.size()));
+    for (size_t i = 0; i < testCase.Coefficients.size(); ++i)
+    {
+      distCoeffs->SetValue(static_cast<vtkIdType>(i), testCase.Coefficients[i]);
+    }
+    node->SetCameraModel(testCase.CameraModel);
+    node->SetXi(testCase.CameraModel == vtkMRMLVideoCameraNode::OmnidirectionalCameraModel ? Xi : 0.0);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Camera space points spread over the directions up to fieldOfView, 0.5 to 3 m deep
+  std::vector<cv::Point3d> GetPoints(double fieldOfView)
+  {
+    std::vector<cv::Point3d> points;
+    for (int i = 0; i < NumberOfPoints; ++i)
+    {
+      // additive recurrence, low discrepancy over the cap of directions
+      const double a = std::fmod(0.5 + i * 0.7548776662466927, 1.0);
+      const double b = std::fmod(0.5 + i * 0.5698402909980532, 1.0);
+      const double theta = std::acos(1.0 - a * (1.0 - std::cos(fieldOfView * CV_PI / 180.0)));
+      const double phi = 2.0 * CV_PI * b;
+      const double depth = 0.5 + 2.5 * std::fmod(i * 0.6180339887498949, 1.0);
+      points.push_back(cv::Point3d(depth * std::sin(theta) * std::cos(phi), depth * std::sin(theta) * std::sin(phi), depth * std::cos(theta)));
+    }
+    return points;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Raw pixels of the points. The omnidirectional model is the pinhole model with 4 coefficients
+  /// applied to the point moved by Xi times its norm along the optical axis.
+  std::vector<cv::Point2d> ReferenceProject(const TestCase& testCase, const std::vector<cv::Point3d>& points)
+  {
+    const cv::Mat rvec = cv::Mat::zeros(3, 1, CV_64F);
+    const cv::Mat tvec = cv::Mat::zeros(3, 1, CV_64F);
+    std::vector<cv::Point2d> pixels;
+    if (testCase.CameraModel == vtkMRMLVideoCameraNode::FisheyeCameraModel)
+    {
+      cv::fisheye::projectPoints(points, pixels, rvec, tvec, GetCameraMatrix(), GetDistortion(testCase));
+    }
+    else if (testCase.CameraModel == vtkMRMLVideoCameraNode::OmnidirectionalCameraModel)
+    {
+      std::vector<cv::Point3d> shifted;
+      for (size_t i = 0; i < points.size(); ++i)
+      {
+        shifted.push_back(cv::Point3d(points[i].x, points[i].y, points[i].z + Xi * cv::norm(points[i])));
+      }
+      cv::projectPoints(shifted, rvec, tvec, GetCameraMatrix(), GetDistortion(testCase), pixels);
+    }
+    else
+    {
+      cv::projectPoints(points, rvec, tvec, GetCameraMatrix(), GetDistortion(testCase), pixels);
+    }
+    return pixels;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Undistorted normalized coordinates of the pixels: x / z of the viewing ray, x / (z + Xi) of
+  /// the unit viewing ray for the omnidirectional model. Same iteration counts as the kernels.
+  std::vector<cv::Point2d> ReferenceUndistort(const TestCase& testCase, const std::vector<cv::Point2d>& pixels)
+  {
+    const cv::TermCriteria criteria(cv::TermCriteria::COUNT, 20, 0.0);
+    std::vector<cv::Point2d> normalized;
+    if (testCase.CameraModel == vtkMRMLVideoCameraNode::FisheyeCameraModel)
+    {
+      cv::fisheye::undistortPoints(pixels, normalized, GetCameraMatrix(), GetDistortion(testCase), cv::noArray(), cv::noArray(),
+                                   cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 20, 1e-15));
+    }
+    else
+    {
+      cv::undistortPoints(pixels, normalized, GetCameraMatrix(), GetDistortion(testCase), cv::noArray(), cv::noArray(), criteria);
+    }
+    return normalized;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Largest pixel distance between ProjectPoints and OpenCV, in the precision of ArrayType
+  template <class ArrayType>
+  bool ProjectionError(vtkMRMLVideoCameraNode* node, const std::vector<cv::Point3d>& points, const std::vector<cv::Point2d>& reference, double& error)
+  {
+    vtkNew<ArrayType> input;
+    input->SetNumberOfComponents(3);
+    input->SetNumberOfTuples(static_cast<vtkIdType>(points.size()));
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      input->SetTuple3(static_cast<vtkIdType>(i), points[i].x, points[i].y, points[i].z);
+    }
+    vtkNew<ArrayType> pixels;
+    if (!vtkSlicerVideoCameraProjection::ProjectPoints(node, input.GetPointer(), pixels.GetPointer()))
+    {
+      std::cerr << "ProjectPoints failed" << std::endl;
+      return false;
+    }
+    error = 0.0;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      const double* pixel = pixels->GetTuple2(static_cast<vtkIdType>(i));
+      const double distance = std::sqrt((pixel[0] - reference[i].x) * (pixel[0] - reference[i].x) + (pixel[1] - reference[i].y) * (pixel[1] - reference[i].y));
+      if (!(distance == distance))
+      {
+        std::cerr << "Point " << i << " was not projected" << std::endl;
+        return false;
+      }
+      error = std::max(error, distance);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Largest distance between the rays of BackProjectPixels and OpenCV, as undistorted normalized
+  /// coordinates scaled by Fx (pixels of the ideal camera), in the precision of ArrayType
+  template <class ArrayType>
+  bool BackProjectionError(vtkMRMLVideoCameraNode* node, const std::vector<cv::Point2d>& pixels, const std::vector<cv::Point2d>& reference, double& error)
+  {
+    vtkNew<ArrayType> input;
+    input->SetNumberOfComponents(2);
+    input->SetNumberOfTuples(static_cast<vtkIdType>(pixels.size()));
+    for (size_t i = 0; i < pixels.size(); ++i)
+    {
+      input->SetTuple2(static_cast<vtkIdType>(i), pixels[i].x, pixels[i].y);
+    }
+    vtkNew<ArrayType> rays;
+    if (!vtkSlicerVideoCameraProjection::BackProjectPixels(node, input.GetPointer(), rays.GetPointer()))
+    {
+      std::cerr << "BackProjectPixels failed" << std::endl;
+      return false;
+    }
+    error = 0.0;
+    for (size_t i = 0; i < pixels.size(); ++i)
+    {
+      // unit rays
+      const double* ray = rays->GetTuple3(static_cast<vtkIdType>(i));
+      const double w = ray[2] + node->GetXi();
+      const double dx = ray[0] / w - reference[i].x;
+      const double dy = ray[1] / w - reference[i].y;
+      const double distance = Fx * std::sqrt(dx * dx + dy * dy);
+      if (!(distance == distance))
+      {
+        std::cerr << "Pixel " << i << " was not back-projected" << std::endl;
+        return false;
+      }
+      error = std::max(error, distance);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Largest distance between ComputeUndistortMap and the OpenCV remap table of the same ideal
+  /// camera, pixels
+  bool UndistortMapError(vtkMRMLVideoCameraNode* node, const TestCase& testCase, double& error)
+  {
+    vtkNew<vtkFloatArray> map;
+    if (!vtkSlicerVideoCameraProjection::ComputeUndistortMap(node, ImageWidth, ImageHeight, map.GetPointer()))
+    {
+      std::cerr << "ComputeUndistortMap failed" << std::endl;
+      return false;
+    }
+    cv::Mat mapX, mapY;
+    const cv::Size size(ImageWidth, ImageHeight);
+    if (testCase.CameraModel == vtkMRMLVideoCameraNode::FisheyeCameraModel)
+    {
+      cv::fisheye::initUndistortRectifyMap(GetCameraMatrix(), GetDistortion(testCase), cv::Mat::eye(3, 3, CV_64F), GetCameraMatrix(), size, CV_32FC1, mapX, mapY);
+    }
+    else
+    {
+      cv::initUndistortRectifyMap(GetCameraMatrix(), GetDistortion(testCase), cv::Mat::eye(3, 3, CV_64F), GetCameraMatrix(), size, CV_32FC1, mapX, mapY);
+    }
+    error = 0.0;
+    const float* values = map->GetPointer(0);
+    for (int v = 0; v < ImageHeight; ++v)
+    {
+      for (int u = 0; u < ImageWidth; ++u, values += 2)
+      {
+        const double dx = values[0] - mapX.at<float>(v, u);
+        const double dy = values[1] - mapY.at<float>(v, u);
+        error = std::max(error, std::sqrt(dx * dx + dy * dy));
+      }
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraProjectionTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " Baselines.txt" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkVideoCamerasTestingUtilities::BaselineMap baselines;
+  if (!vtkVideoCamerasTestingUtilities::ReadBaselines(argv[1], baselines))
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<TestCase> testCases = GetTestCases();
+  for (size_t c = 0; c < testCases.size(); ++c)
+  {
+    const TestCase& testCase = testCases[c];
+    vtkNew<vtkMRMLVideoCameraNode> node;
+    SetCamera(node.GetPointer(), testCase);
+
+    const std::vector<cv::Point3d> points = GetPoints(testCase.FieldOfView);
+    const std::vector<cv::Point2d> pixels = ReferenceProject(testCase, points);
+    const std::vector<cv::Point2d> normalized = ReferenceUndistort(testCase, pixels);
+
+    double doubleProjection = 0.0;
+    double floatProjection = 0.0;
+    double doubleBackProjection = 0.0;
+    double floatBackProjection = 0.0;
+    if (!ProjectionError<vtkDoubleArray>(node.GetPointer(), points, pixels, doubleProjection) ||
+        !ProjectionError<vtkFloatArray>(node.GetPointer(), points, pixels, floatProjection) ||
+        !BackProjectionError<vtkDoubleArray>(node.GetPointer(), pixels, normalized, doubleBackProjection) ||
+        !BackProjectionError<vtkFloatArray>(node.GetPointer(), pixels, normalized, floatBackProjection))
+    {
+      std::cerr << testCase.Name << " failed" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << testCase.Name << ": projection " << doubleProjection << " px (float " << floatProjection
+              << " px), back-projection " << doubleBackProjection << " px (float " << floatBackProjection << " px)" << std::endl;
+    if (!vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, "Projection.DoubleTolerance", doubleProjection) ||
+        !vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, "Projection.FloatTolerance", floatProjection) ||
+        !vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, "Projection.BackProjectionDoubleTolerance", doubleBackProjection) ||
+        !vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, "Projection.BackProjectionFloatTolerance", floatBackProjection))
+    {
+      std::cerr << testCase.Name << " failed" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // OpenCV has no remap table of the omnidirectional model outside of its contrib modules
+    if (testCase.CameraModel != vtkMRMLVideoCameraNode::OmnidirectionalCameraModel)
+    {
+      double mapError = 0.0;
+      if (!UndistortMapError(node.GetPointer(), testCase, mapError))
+      {
+        return EXIT_FAILURE;
+      }
+      std::cout << testCase.Name << ": undistort map " << mapError << " px" << std::endl;
+      if (!vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, "Projection.UndistortMapTolerance", mapError))
+      {
+        std::cerr << testCase.Name << " failed" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraRayTriangulationTest1.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras includes
+#include "vtkSlicerVideoCameraRayTriangulation.h"
+#include "vtkVideoCamerasTestingUtilities.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const int DatasetVersion = 1;
+  const int Repetitions = 100;
+
+  struct Ray
+  {
+    std::string Target;
+    double Origin[3];
+    double Direction[3];
+  };
+
+  struct Point
+  {
+    double Position[3];
+  };
+
+  //----------------------------------------------------------------------------
+  bool ReadRays(const char* fileName, std::vector<Ray>& rays, std::map<std::string, Point>& targets, std::map<std::string, Point>& solutions)
+  {
+    std::ifstream file(fileName);
+    if (!file.is_open())
+    {
+      std::cerr << "Cannot open dataset " << fileName << std::endl;
+      return false;
+    }
+    int version = 0;
+    std::string line;
+    while (std::getline(file, line))
+    {
+      std::istringstream stream(line.substr(0, line.find('#')));
+      std::string record;
+      if (!(stream >> record))
+      {
+        continue;
+      }
+      if (record == "Version")
+      {
+        stream >> version;
+      }
+      else if (record == "Ray")
+      {
+        Ray ray;
+        stream >> ray.Target >> ray.Origin[0] >> ray.Origin[1] >> ray.Origin[2] >> ray.Direction[0] >> ray.Direction[1] >> ray.Direction[2];
+        rays.push_back(ray);
+      }
+      else if (record == "Target" || record == "Solution")
+      {
+        std::string name;
+        Point point;
+        stream >> name >> point.Position[0] >> point.Position[1] >> point.Position[2];
+        (record == "Target" ? targets : solutions)[name] = point;
+      }
+      if (stream.fail())
+      {
+        std::cerr << "Invalid line in " << fileName << ": " << line << std::endl;
+        return false;
+      }
+    }
+    if (version != DatasetVersion)
+    {
+      std::cerr << "Dataset version " << version << ", the test expects version " << DatasetVersion << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraRayTriangulationTest1(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " GoldenRays.txt Baselines.txt" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Ray> rays;
+  std::map<std::string, Point> targets;
+  std::map<std::string, Point> solutions;
+  vtkVideoCamerasTestingUtilities::BaselineMap baselines;
+  if (!ReadRays(argv[1], rays, targets, solutions) || !vtkVideoCamerasTestingUtilities::ReadBaselines(argv[2], baselines))
+  {
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkSlicerVideoCameraRayTriangulation> triangulation;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  int solved = 0;
+  for (int repetition = 0; repetition < Repetitions; ++repetition)
+  {
+    triangulation->Reset();
+    for (std::vector<Ray>::const_iterator ray = rays.begin(); ray != rays.end(); ++ray)
+    {
+      if (triangulation->AddRay(ray->Target.c_str(), ray->Origin, ray->Direction) < 0)
+      {
+        std::cerr << "AddRay failed for target " << ray->Target << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    solved = triangulation->Solve();
+  }
+  timer->StopTimer();
+
+  if (solved != static_cast<int>(targets.size()) || triangulation->GetNumberOfTargets() != solved)
+  {
+    std::cerr << "Solved " << solved << " targets of " << targets.size() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  double maximumError = 0.0;
+  double maximumSolutionDifference = 0.0;
+  for (int target = 0; target < triangulation->GetNumberOfTargets(); ++target)
+  {
+    const std::string name = triangulation->GetTargetName(target);
+    if (targets.count(name) == 0 || solutions.count(name) == 0)
+    {
+      std::cerr << "Target " << name << " is not in the dataset" << std::endl;
+      return EXIT_FAILURE;
+    }
+    double point[3] = { 0.0, 0.0, 0.0 };
+    triangulation->GetTargetPoint(target, point);
+    maximumError = std::max(maximumError, std::sqrt(vtkMath::Distance2BetweenPoints(point, targets[name].Position)));
+    maximumSolutionDifference = std::max(maximumSolutionDifference, std::sqrt(vtkMath::Distance2BetweenPoints(point, solutions[name].Position)));
+  }
+  std::cout << "Maximum error " << maximumError << " mm, maximum difference to the golden solutions " << maximumSolutionDifference << " mm" << std::endl;
+
+  if (!vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, "RayTriangulation.Tolerance", maximumError) ||
+      !vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, "RayTriangulation.SolutionTolerance", maximumSolutionDifference) ||
+      !vtkVideoCamerasTestingUtilities::CheckTime(baselines, "RayTriangulation", timer->GetElapsedTime()))
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkSlicerVideoCameraUndistortionGridTest1.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras includes
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkSlicerVideoCameraProjection.h"
+#include "vtkSlicerVideoCameraUndistortionGrid.h"
+#include "vtkVideoCamerasTestingUtilities.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix3x3.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+  const int ImageWidth = 640;
+  const int ImageHeight = 480;
+  const int NumberOfPoints = 5000;
+
+  //----------------------------------------------------------------------------
+  /// Largest distance between the grid lookup and the exact inversion (BackProjectPixels) over
+  /// raw pixels spread over the whole image, off the grid points and cell centers
+  bool MaximumError(vtkMRMLVideoCameraNode* node, vtkSlicerVideoCameraUndistortionGrid* grid, double& maximumError)
+  {
+    vtkNew<vtkDoubleArray> pixels;
+    pixels->SetNumberOfComponents(2);
+    pixels->SetNumberOfTuples(NumberOfPoints);
+    for (int i = 0; i < NumberOfPoints; ++i)
+    {
+      // additive recurrence, low discrepancy in both directions
+      const double u = std::fmod(0.5 + i * 0.7548776662466927, 1.0) * (ImageWidth - 1);
+      const double v = std::fmod(0.5 + i * 0.5698402909980532, 1.0) * (ImageHeight - 1);
+      pixels->SetTuple2(i, u, v);
+    }
+
+    vtkNew<vtkDoubleArray> idealPixels;
+    vtkNew<vtkDoubleArray> rays;
+    if (!grid->UndistortPoints(pixels.GetPointer(), idealPixels.GetPointer()) ||
+        !vtkSlicerVideoCameraProjection::BackProjectPixels(node, pixels.GetPointer(), rays.GetPointer()))
+    {
+      std::cerr << "Undistortion failed" << std::endl;
+      return false;
+    }
+
+    vtkMatrix3x3* matrix = node->GetIntrinsicMatrix();
+    maximumError = 0.0;
+    for (int i = 0; i < NumberOfPoints; ++i)
+    {
+      const double* ray = rays->GetTuple3(i);
+      const double x = ray[0] / ray[2];
+      const double y = ray[1] / ray[2];
+      const double u = matrix->GetElement(0, 0) * x + matrix->GetElement(0, 1) * y + matrix->GetElement(0, 2);
+      const double v = matrix->GetElement(1, 1) * y + matrix->GetElement(1, 2);
+      const double* ideal = idealPixels->GetTuple2(i);
+      if (vtkMath::IsNan(ideal[0]) || vtkMath::IsNan(u))
+      {
+        std::cerr << "Pixel " << i << " could not be undistorted" << std::endl;
+        return false;
+      }
+      maximumError = std::max(maximumError, std::sqrt((ideal[0] - u) * (ideal[0] - u) + (ideal[1] - v) * (ideal[1] - v)));
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVideoCameraUndistortionGridTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " Baselines.txt" << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkVideoCamerasTestingUtilities::BaselineMap baselines;
+  if (!vtkVideoCamerasTestingUtilities::ReadBaselines(argv[1], baselines))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // strong barrel distortion, the field a coarse grid interpolates worst
+  vtkNew<vtkMRMLVideoCameraNode> node;
+  vtkMatrix3x3* matrix = node->GetIntrinsicMatrix();
+  matrix->SetElement(0, 0, 800.0);
+  matrix->SetElement(1, 1, 800.0);
+  matrix->SetElement(0, 2, 319.5);
+  matrix->SetElement(1, 2, 239.5);
+  const double coefficients[5] = { -0.28, 0.09, 0.0012, -0.0008, -0.01 };
+  vtkDoubleArray* distCoeffs = node->GetDistortionCoefficients();
+  distCoeffs->SetNumberOfValues(5);
+  for (int i = 0; i < 5; ++i)
+  {
+    distCoeffs->SetValue(i, coefficients[i]);
+  }
+
+  vtkNew<vtkSlicerVideoCameraUndistortionGrid> grid;
+  grid->SetCameraNode(node.GetPointer());
+  grid->SetImageSize(ImageWidth, ImageHeight);
+
+  // the measured bounds hold away from the cell centers they are measured at
+  for (int refine = 0; refine < 2; ++refine)
+  {
+    grid->SetRefineSolution(refine != 0);
+    double maximumError = 0.0;
+    if (!MaximumError(node.GetPointer(), grid.GetPointer(), maximumError))
+    {
+      return EXIT_FAILURE;
+    }
+    const double bound = refine ? grid->GetMaximumRefinedError() : grid->GetMaximumInterpolationError();
+    std::cout << (refine ? "Refined" : "Interpolated") << " error " << maximumError << " px, measured bound " << bound << " px" << std::endl;
+    if (!vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, refine ? "UndistortionGrid.RefinedTolerance" : "UndistortionGrid.InterpolationTolerance", maximumError) ||
+        !vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, "UndistortionGrid.BoundExcess", maximumError - bound))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // new coefficient values rebuild the grid
+  distCoeffs->SetValue(0, -0.2);
+  double maximumError = 0.0;
+  if (!MaximumError(node.GetPointer(), grid.GetPointer(), maximumError) ||
+      !vtkVideoCamerasTestingUtilities::CheckTolerance(baselines, "UndistortionGrid.RefinedTolerance", maximumError))
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkVideoCameraRigTest1.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// VideoCameras includes
+#include "vtkMRMLVideoCameraNode.h"
+#include "vtkMRMLVideoCameraStorageNode.h"
+#include "vtkVideoCameraObservations.h"
+#include "vtkVideoCameraRig.h"
+
+// MRML includes
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkMatrix3x3.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+  const int NumberOfCameras = 3;
+
+  //----------------------------------------------------------------------------
+  bool CheckCamera(vtkMRMLVideoCameraNode* camera, vtkMRMLVideoCameraNode* expected)
+  {
+    if (camera == nullptr)
+    {
+      std::cerr << "Camera " << expected->GetName() << " was not read" << std::endl;
+      return false;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        if (camera->GetIntrinsicMatrix()->GetElement(i, j) != expected->GetIntrinsicMatrix()->GetElement(i, j))
+        {
+          std::cerr << "Intrinsics of " << expected->GetName() << " differ" << std::endl;
+          return false;
+        }
+      }
+    }
+    for (vtkIdType i = 0; i < expected->GetDistortionCoefficients()->GetNumberOfValues(); ++i)
+    {
+      if (camera->GetDistortionCoefficients()->GetValue(i) != expected->GetDistortionCoefficients()->GetValue(i))
+      {
+        std::cerr << "Distortion coefficients of " << expected->GetName() << " differ" << std::endl;
+        return false;
+      }
+    }
+    if (camera->GetNumberOfCalibrationTableEntries() != expected->GetNumberOfCalibrationTableEntries() ||
+        camera->GetObservations() == nullptr ||
+        camera->GetObservations()->GetNumberOfViews() != expected->GetObservations()->GetNumberOfViews())
+    {
+      std::cerr << "Calibration table or observations of " << expected->GetName() << " differ" << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkVideoCameraRigTest1(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " GoldenCamera.xml TemporaryDirectory" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string rigFileName = std::string(argv[2]) + "/vtkVideoCameraRigTest1.rig.xml";
+
+  // cameras of the rig differ by their focal length
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLVideoCameraStorageNode> storageNode;
+  scene->AddNode(storageNode.GetPointer());
+  storageNode->SetFileName(argv[1]);
+  vtkNew<vtkVideoCameraRig> rig;
+  for (int i = 0; i < NumberOfCameras; ++i)
+  {
+    vtkSmartPointer<vtkMRMLVideoCameraNode> camera = vtkSmartPointer<vtkMRMLVideoCameraNode>::New();
+    if (!storageNode->ReadData(camera))
+    {
+      std::cerr << "Cannot read " << argv[1] << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::ostringstream name;
+    name << "Camera " << i;
+    camera->SetName(name.str().c_str());
+    camera->RemoveAllCalibrationTableEntries();
+    camera->GetIntrinsicMatrix()->SetElement(0, 0, 800.0 + 10.0 * i);
+    rig->AddCamera(camera);
+  }
+  vtkNew<vtkMatrix4x4> camera1ToCamera0;
+  camera1ToCamera0->SetElement(0, 3, 65.5);
+  rig->SetExtrinsics("Camera 1", "Camera 0", camera1ToCamera0.GetPointer());
+
+  if (!vtkMRMLVideoCameraStorageNode::WriteRig(rigFileName.c_str(), rig.GetPointer()) ||
+      !vtkMRMLVideoCameraStorageNode::IsRigFile(rigFileName.c_str()) ||
+      vtkMRMLVideoCameraStorageNode::IsRigFile(argv[1]))
+  {
+    std::cerr << "Cannot write " << rigFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // random access to the last camera through the index
+  vtkNew<vtkVideoCameraRig> index;
+  vtkNew<vtkMRMLVideoCameraNode> lastCamera;
+  if (!vtkMRMLVideoCameraStorageNode::ReadRigIndex(rigFileName.c_str(), index.GetPointer()) ||
+      index->GetNumberOfCameras() != NumberOfCameras || index->GetCamera(0) != nullptr ||
+      !vtkMRMLVideoCameraStorageNode::ReadRigCamera(rigFileName.c_str(), index.GetPointer(), NumberOfCameras - 1, lastCamera.GetPointer()) ||
+      !CheckCamera(index->GetCamera(NumberOfCameras - 1), rig->GetCamera(NumberOfCameras - 1)))
+  {
+    std::cerr << "Cannot read camera " << NumberOfCameras - 1 << " through the index of " << rigFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // all cameras at once
+  vtkNew<vtkVideoCameraRig> readRig;
+  if (!vtkMRMLVideoCameraStorageNode::ReadRig(rigFileName.c_str(), readRig.GetPointer()) ||
+      readRig->GetNumberOfCameras() != NumberOfCameras || readRig->GetNumberOfExtrinsics() != 1)
+  {
+    std::cerr << "Cannot read " << rigFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < NumberOfCameras; ++i)
+  {
+    if (std::string(readRig->GetCameraName(i)) != rig->GetCameraName(i) || !CheckCamera(readRig->GetCamera(i), rig->GetCamera(i)))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+  vtkNew<vtkMatrix4x4> extrinsics;
+  if (std::string(readRig->GetExtrinsicsFrom(0)) != "Camera 1" || std::string(readRig->GetExtrinsicsTo(0)) != "Camera 0" ||
+      !readRig->GetExtrinsics(0, extrinsics.GetPointer()) || extrinsics->GetElement(0, 3) != 65.5)
+  {
+    std::cerr << "Extrinsics differ" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: vtkVideoCamerasTestingUtilities.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// Baselines of the golden dataset tests: "key value" lines, '#' starts a comment.
+// Tests compare their errors with the "<Test>.Tolerance" entries and their wall-clock time with
+// TimeFactor * "<Test>.Seconds"; VIDEOCAMERAS_TEST_TIME_FACTOR overrides TimeFactor, 0 disables.
+
+#ifndef __vtkVideoCamerasTestingUtilities_h
+#define __vtkVideoCamerasTestingUtilities_h
+
+// STD includes
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace vtkVideoCamerasTestingUtilities
+{
+  typedef std::map<std::string, double> BaselineMap;
+
+  //----------------------------------------------------------------------------
+  inline bool ReadBaselines(const char* fileName, BaselineMap& baselines)
+  {
+    std::ifstream file(fileName);
+    if (!file.is_open())
+    {
+      std::cerr << "Cannot open baselines " << fileName << std::endl;
+      return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+      std::istringstream stream(line.substr(0, line.find('#')));
+      std::string key;
+      double value;
+      if (stream >> key >> value)
+      {
+        baselines[key] = value;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool GetBaseline(const BaselineMap& baselines, const std::string& key, double& value)
+  {
+    BaselineMap::const_iterator it = baselines.find(key);
+    if (it == baselines.end())
+    {
+      std::cerr << "Baseline " << key << " is missing" << std::endl;
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool CheckTolerance(const BaselineMap& baselines, const std::string& key, double error)
+  {
+    double tolerance = 0.0;
+    if (!GetBaseline(baselines, key, tolerance))
+    {
+      return false;
+    }
+    if (!(error <= tolerance))
+    {
+      std::cerr << key << " exceeded: error " << error << ", tolerance " << tolerance << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool CheckTime(const BaselineMap& baselines, const std::string& test, double seconds)
+  {
+    double factor = 0.0;
+    double baseline = 0.0;
+    if (!GetBaseline(baselines, "TimeFactor", factor) || !GetBaseline(baselines, test + ".Seconds", baseline))
+    {
+      return false;
+    }
+    const char* environmentFactor = getenv("VIDEOCAMERAS_TEST_TIME_FACTOR");
+    if (environmentFactor != nullptr && *environmentFactor != '\0')
+    {
+      factor = atof(environmentFactor);
+    }
+    std::cout << test << ": " << seconds << " s (baseline " << baseline << " s)" << std::endl;
+    if (factor > 0.0 && seconds > factor * baseline)
+    {
+      std::cerr << test << " is slower than " << factor << " times its baseline: " << seconds << " s, baseline " << baseline << " s" << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+#endif
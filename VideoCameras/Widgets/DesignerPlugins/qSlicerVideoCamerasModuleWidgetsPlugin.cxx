@@ -1,21 +1,21 @@
-/*=auto=========================================================================
-
-Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
-
-See COPYRIGHT.txt
-or http://www.slicer.org/copyright/copyright.txt for details.
-
-Program:   3D Slicer
-Module:    $RCSfile: qSlicerVideoCamerasModuleWidgetsPlugin.cxx,v $
-Date:      $Date: 2018/6/16 10:54:09 $
-Version:   $Revision: 1.0 $
-
-=========================================================================auto=*/
-
-#include "qSlicerVideoCamerasModuleWidgetsPlugin.h"
-
-//-----------------------------------------------------------------------------
-#if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
-  #include <QtPlugin>
-  Q_EXPORT_PLUGIN2(customwidgetplugin, qSlicerVideoCamerasModuleWidgetsPlugin);
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: qSlicerVideoCamerasModuleWidgetsPlugin.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+#include "qSlicerVideoCamerasModuleWidgetsPlugin.h"
+
+//-----------------------------------------------------------------------------
+#if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
+  #include <QtPlugin>
+  Q_EXPORT_PLUGIN2(customwidgetplugin, qSlicerVideoCamerasModuleWidgetsPlugin);
 #endif
\ No newline at end of file
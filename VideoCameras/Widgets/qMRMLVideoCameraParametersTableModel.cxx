@@ -0,0 +1,404 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: qMRMLVideoCameraParametersTableModel.cxx,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+// Qt includes
+#include <QTimer>
+#include <QVector>
+
+// Local includes
+#include "qMRMLVideoCameraParametersTableModel.h"
+
+// MRML includes
+#include <vtkMRMLVideoCameraNode.h>
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMatrix3x3.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+//-----------------------------------------------------------------------------
+/// \ingroup Slicer_QtModules_VideoCamera
+class qMRMLVideoCameraParametersTableModelPrivate
+{
+  Q_DECLARE_PUBLIC(qMRMLVideoCameraParametersTableModel);
+
+protected:
+  qMRMLVideoCameraParametersTableModel* const q_ptr;
+
+public:
+  qMRMLVideoCameraParametersTableModelPrivate(qMRMLVideoCameraParametersTableModel& object, qMRMLVideoCameraParametersTableModel::ParameterGroup group);
+
+  /// Event invoked by the node when the parameters of this group change
+  unsigned long nodeEvent() const;
+
+  /// Read the current values of the group from the node, row-major
+  void readNode(QVector<double>& values, int& rows, int& columns) const;
+
+  /// Write a single value to the node, creating the parameter object if needed
+  void writeNode(int row, int column, double value);
+
+  qMRMLVideoCameraParametersTableModel::ParameterGroup  Group;
+  vtkWeakPointer<vtkMRMLVideoCameraNode>                Node;
+  unsigned long                                         ObserverTag;
+  QTimer                                                UpdateTimer;
+
+  QVector<double>  Values;
+  int              Rows;
+  int              Columns;
+};
+
+//-----------------------------------------------------------------------------
+// qMRMLVideoCameraParametersTableModelPrivate methods
+
+//-----------------------------------------------------------------------------
+qMRMLVideoCameraParametersTableModelPrivate::qMRMLVideoCameraParametersTableModelPrivate(qMRMLVideoCameraParametersTableModel& object, qMRMLVideoCameraParametersTableModel::ParameterGroup group)
+  : q_ptr(&object)
+  , Group(group)
+  , ObserverTag(0)
+  , Rows(0)
+  , Columns(0)
+{
+  this->UpdateTimer.setSingleShot(true);
+  this->UpdateTimer.setInterval(16);
+}
+
+//-----------------------------------------------------------------------------
+unsigned long qMRMLVideoCameraParametersTableModelPrivate::nodeEvent() const
+{
+  switch (this->Group)
+  {
+    case qMRMLVideoCameraParametersTableModel::IntrinsicMatrix:
+      return vtkMRMLVideoCameraNode::IntrinsicsModifiedEvent;
+    case qMRMLVideoCameraParametersTableModel::DistortionCoefficients:
+      return vtkMRMLVideoCameraNode::DistortionCoefficientsModifiedEvent;
+    case qMRMLVideoCameraParametersTableModel::MarkerToImageSensorTransform:
+      return vtkMRMLVideoCameraNode::MarkerToSensorTransformModifiedEvent;
+    case qMRMLVideoCameraParametersTableModel::CameraPlaneOffset:
+    default:
+      return vtkMRMLVideoCameraNode::CameraPlaneOffsetModifiedEvent;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void qMRMLVideoCameraParametersTableModelPrivate::readNode(QVector<double>& values, int& rows, int& columns) const
+{
+  values.clear();
+  rows = 0;
+  columns = 0;
+  if (this->Node == nullptr)
+  {
+    return;
+  }
+
+  switch (this->Group)
+  {
+    case qMRMLVideoCameraParametersTableModel::IntrinsicMatrix:
+    {
+      rows = columns = 3;
+      values.fill(0.0, 9);
+      vtkMatrix3x3* matrix = this->Node->GetIntrinsicMatrix();
+      for (int i = 0; matrix != nullptr && i < 9; ++i)
+      {
+        values[i] = matrix->GetElement(i / 3, i % 3);
+      }
+      break;
+    }
+    case qMRMLVideoCameraParametersTableModel::MarkerToImageSensorTransform:
+    {
+      rows = columns = 4;
+      values.fill(0.0, 16);
+      vtkMatrix4x4* matrix = this->Node->GetMarkerToImageSensorTransform();
+      for (int i = 0; matrix != nullptr && i < 16; ++i)
+      {
+        values[i] = matrix->GetElement(i / 4, i % 4);
+      }
+      break;
+    }
+    case qMRMLVideoCameraParametersTableModel::DistortionCoefficients:
+    {
+      vtkDoubleArray* array = this->Node->GetDistortionCoefficients();
+      rows = 1;
+      columns = array != nullptr ? static_cast<int>(array->GetNumberOfValues()) : 0;
+      values.resize(columns);
+      for (int i = 0; i < columns; ++i)
+      {
+        values[i] = array->GetValue(i);
+      }
+      break;
+    }
+    case qMRMLVideoCameraParametersTableModel::CameraPlaneOffset:
+    {
+      rows = 1;
+      columns = 3;
+      values.fill(0.0, 3);
+      vtkDoubleArray* array = this->Node->GetCameraPlaneOffset();
+      for (int i = 0; array != nullptr && i < 3 && i < array->GetNumberOfValues(); ++i)
+      {
+        values[i] = array->GetValue(i);
+      }
+      break;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void qMRMLVideoCameraParametersTableModelPrivate::writeNode(int row, int column, double value)
+{
+  switch (this->Group)
+  {
+    case qMRMLVideoCameraParametersTableModel::IntrinsicMatrix:
+    {
+      if (this->Node->GetIntrinsicMatrix() == nullptr)
+      {
+        vtkSmartPointer<vtkMatrix3x3> mat = vtkSmartPointer<vtkMatrix3x3>::New();
+        mat->Zero();
+        this->Node->SetAndObserveIntrinsicMatrix(mat);
+      }
+      this->Node->GetIntrinsicMatrix()->SetElement(row, column, value);
+      break;
+    }
+    case qMRMLVideoCameraParametersTableModel::MarkerToImageSensorTransform:
+    {
+      if (this->Node->GetMarkerToImageSensorTransform() == nullptr)
+      {
+        vtkSmartPointer<vtkMatrix4x4> mat = vtkSmartPointer<vtkMatrix4x4>::New();
+        mat->Identity();
+        this->Node->SetAndObserveMarkerToImageSensorTransform(mat);
+      }
+      this->Node->GetMarkerToImageSensorTransform()->SetElement(row, column, value);
+      break;
+    }
+    case qMRMLVideoCameraParametersTableModel::DistortionCoefficients:
+    case qMRMLVideoCameraParametersTableModel::CameraPlaneOffset:
+    {
+      bool distortion = (this->Group == qMRMLVideoCameraParametersTableModel::DistortionCoefficients);
+      vtkDoubleArray* array = distortion ? this->Node->GetDistortionCoefficients() : this->Node->GetCameraPlaneOffset();
+      if (array == nullptr || array->GetNumberOfValues() < this->Columns)
+      {
+        vtkSmartPointer<vtkDoubleArray> arr = vtkSmartPointer<vtkDoubleArray>::New();
+        arr->SetNumberOfValues(this->Columns);
+        arr->Fill(0);
+        for (vtkIdType i = 0; array != nullptr && i < array->GetNumberOfValues(); ++i)
+        {
+          arr->SetValue(i, array->GetValue(i));
+        }
+        arr->SetValue(column, value);
+        if (distortion)
+        {
+          this->Node->SetAndObserveDistortionCoefficients(arr);
+        }
+        else
+        {
+          this->Node->SetAndObserveCameraPlaneOffset(arr);
+        }
+        return;
+      }
+      array->SetValue(column, value);
+      // SetValue does not modify the array
+      array->Modified();
+      break;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+// qMRMLVideoCameraParametersTableModel methods
+
+//------------------------------------------------------------------------------
+qMRMLVideoCameraParametersTableModel::qMRMLVideoCameraParametersTableModel(ParameterGroup group, QObject* parent)
+  : QAbstractTableModel(parent)
+  , d_ptr(new qMRMLVideoCameraParametersTableModelPrivate(*this, group))
+{
+  Q_D(qMRMLVideoCameraParametersTableModel);
+  connect(&d->UpdateTimer, SIGNAL(timeout()), this, SLOT(updateFromNode()));
+}
+
+//------------------------------------------------------------------------------
+qMRMLVideoCameraParametersTableModel::~qMRMLVideoCameraParametersTableModel()
+{
+  Q_D(qMRMLVideoCameraParametersTableModel);
+  if (d->Node != nullptr)
+  {
+    d->Node->RemoveObserver(d->ObserverTag);
+  }
+}
+
+//------------------------------------------------------------------------------
+qMRMLVideoCameraParametersTableModel::ParameterGroup qMRMLVideoCameraParametersTableModel::parameterGroup() const
+{
+  Q_D(const qMRMLVideoCameraParametersTableModel);
+  return d->Group;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLVideoCameraParametersTableModel::setVideoCameraNode(vtkMRMLVideoCameraNode* node)
+{
+  Q_D(qMRMLVideoCameraParametersTableModel);
+
+  if (d->Node == node)
+  {
+    return;
+  }
+
+  if (d->Node != nullptr)
+  {
+    d->Node->RemoveObserver(d->ObserverTag);
+  }
+
+  d->Node = node;
+
+  if (d->Node != nullptr)
+  {
+    d->ObserverTag = d->Node->AddObserver(d->nodeEvent(), this, &qMRMLVideoCameraParametersTableModel::onNodeParameterModified);
+  }
+
+  d->UpdateTimer.stop();
+  this->updateFromNode();
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLVideoCameraNode* qMRMLVideoCameraParametersTableModel::videoCameraNode() const
+{
+  Q_D(const qMRMLVideoCameraParametersTableModel);
+  return d->Node;
+}
+
+//------------------------------------------------------------------------------
+int qMRMLVideoCameraParametersTableModel::refreshInterval() const
+{
+  Q_D(const qMRMLVideoCameraParametersTableModel);
+  return d->UpdateTimer.interval();
+}
+
+//------------------------------------------------------------------------------
+void qMRMLVideoCameraParametersTableModel::setRefreshInterval(int msec)
+{
+  Q_D(qMRMLVideoCameraParametersTableModel);
+  d->UpdateTimer.setInterval(qMax(msec, 0));
+}
+
+//------------------------------------------------------------------------------
+int qMRMLVideoCameraParametersTableModel::rowCount(const QModelIndex& parent) const
+{
+  Q_D(const qMRMLVideoCameraParametersTableModel);
+  return parent.isValid() ? 0 : d->Rows;
+}
+
+//------------------------------------------------------------------------------
+int qMRMLVideoCameraParametersTableModel::columnCount(const QModelIndex& parent) const
+{
+  Q_D(const qMRMLVideoCameraParametersTableModel);
+  return parent.isValid() ? 0 : d->Columns;
+}
+
+//------------------------------------------------------------------------------
+QVariant qMRMLVideoCameraParametersTableModel::data(const QModelIndex& index, int role) const
+{
+  Q_D(const qMRMLVideoCameraParametersTableModel);
+
+  if (!index.isValid() || index.row() >= d->Rows || index.column() >= d->Columns)
+  {
+    return QVariant();
+  }
+
+  switch (role)
+  {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+      return QString::number(d->Values[index.row() * d->Columns + index.column()]);
+    case Qt::TextAlignmentRole:
+      return int(Qt::AlignTrailing | Qt::AlignVCenter);
+    default:
+      return QVariant();
+  }
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLVideoCameraParametersTableModel::setData(const QModelIndex& index, const QVariant& value, int role)
+{
+  Q_D(qMRMLVideoCameraParametersTableModel);
+
+  if (d->Node == nullptr || role != Qt::EditRole || !index.isValid() || index.row() >= d->Rows || index.column() >= d->Columns)
+  {
+    return false;
+  }
+
+  bool ok;
+  double newValue = value.toDouble(&ok);
+  if (!ok)
+  {
+    return false;
+  }
+
+  // Update the cache first so that the resulting node event does not report the cell again
+  d->Values[index.row() * d->Columns + index.column()] = newValue;
+  d->writeNode(index.row(), index.column(), newValue);
+  emit dataChanged(index, index);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+Qt::ItemFlags qMRMLVideoCameraParametersTableModel::flags(const QModelIndex& index) const
+{
+  if (!index.isValid())
+  {
+    return Qt::NoItemFlags;
+  }
+  return Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsEditable;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLVideoCameraParametersTableModel::updateFromNode()
+{
+  Q_D(qMRMLVideoCameraParametersTableModel);
+
+  QVector<double> values;
+  int rows;
+  int columns;
+  d->readNode(values, rows, columns);
+
+  if (rows != d->Rows || columns != d->Columns)
+  {
+    this->beginResetModel();
+    d->Values = values;
+    d->Rows = rows;
+    d->Columns = columns;
+    this->endResetModel();
+    return;
+  }
+
+  for (int i = 0; i < values.size(); ++i)
+  {
+    if (values[i] != d->Values[i])
+    {
+      d->Values[i] = values[i];
+      QModelIndex cell = this->index(i / columns, i % columns);
+      emit dataChanged(cell, cell);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLVideoCameraParametersTableModel::onNodeParameterModified(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(event), void* vtkNotUsed(data))
+{
+  Q_D(qMRMLVideoCameraParametersTableModel);
+
+  // Coalesce bursts of node events into one refresh per interval
+  if (!d->UpdateTimer.isActive())
+  {
+    d->UpdateTimer.start();
+  }
+}
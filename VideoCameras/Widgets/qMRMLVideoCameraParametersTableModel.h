@@ -0,0 +1,82 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2018 Robarts Research Institute. All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+Program:   3D Slicer
+Module:    $RCSfile: qMRMLVideoCameraParametersTableModel.h,v $
+Date:      $Date: 2018/6/16 10:54:09 $
+Version:   $Revision: 1.0 $
+
+=========================================================================auto=*/
+
+#ifndef __qMRMLVideoCameraParametersTableModel_h
+#define __qMRMLVideoCameraParametersTableModel_h
+
+// VideoCamera export includes
+#include "qSlicerVideoCamerasModuleWidgetsExport.h"
+
+// Qt includes
+#include <QAbstractTableModel>
+
+class qMRMLVideoCameraParametersTableModelPrivate;
+class vtkMRMLVideoCameraNode;
+class vtkObject;
+
+/// \ingroup Slicer_QtModules_VideoCamera
+/// Table model exposing one parameter group of a video camera node
+/// Node changes are coalesced and applied at most once per refresh interval, and only the
+/// cells whose value changed are reported through dataChanged.
+class Q_SLICER_MODULE_VIDEOCAMERAS_WIDGETS_EXPORT qMRMLVideoCameraParametersTableModel : public QAbstractTableModel
+{
+  Q_OBJECT
+  Q_ENUMS(ParameterGroup)
+  Q_PROPERTY(int refreshInterval READ refreshInterval WRITE setRefreshInterval)
+
+public:
+  enum ParameterGroup
+  {
+    IntrinsicMatrix,
+    DistortionCoefficients,
+    MarkerToImageSensorTransform,
+    CameraPlaneOffset
+  };
+
+  typedef QAbstractTableModel Superclass;
+  qMRMLVideoCameraParametersTableModel(ParameterGroup group, QObject* parent = 0);
+  virtual ~qMRMLVideoCameraParametersTableModel();
+
+  ParameterGroup parameterGroup() const;
+
+  void setVideoCameraNode(vtkMRMLVideoCameraNode* node);
+  vtkMRMLVideoCameraNode* videoCameraNode() const;
+
+  ///
+  /// Minimum time between two refreshes from the node, in ms (default 16, one display frame)
+  int refreshInterval() const;
+  void setRefreshInterval(int msec);
+
+  virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+  virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+  virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+  virtual bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole);
+  virtual Qt::ItemFlags flags(const QModelIndex& index) const;
+
+public slots:
+  /// Refresh the cached values from the node immediately
+  void updateFromNode();
+
+protected:
+  void onNodeParameterModified(vtkObject* caller, unsigned long event, void* data);
+
+protected:
+  QScopedPointer<qMRMLVideoCameraParametersTableModelPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(qMRMLVideoCameraParametersTableModel);
+  Q_DISABLE_COPY(qMRMLVideoCameraParametersTableModel);
+};
+
+#endif
@@ -1,72 +1,126 @@
-/*==============================================================================
-
-  Program: 3D Slicer
-
-  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
-
-  See COPYRIGHT.txt
-  or http://www.slicer.org/copyright/copyright.txt for details.
-
-  Unless required by applicable law or agreed to in writing, software
-  distributed under the License is distributed on an "AS IS" BASIS,
-  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-  See the License for the specific language governing permissions and
-  limitations under the License.
-
-==============================================================================*/
-
-// Qt includes
-#include <QDebug>
-
-// SlicerQt includes
-#include "qSlicerVideoCamerasModuleWidget.h"
-#include "ui_qSlicerVideoCamerasModuleWidget.h"
-
-//-----------------------------------------------------------------------------
-/// \ingroup Slicer_QtModules_ExtensionTemplate
-class qSlicerVideoCamerasModuleWidgetPrivate: public Ui_qSlicerVideoCamerasModuleWidget
-{
-public:
-  qSlicerVideoCamerasModuleWidgetPrivate();
-};
-
-//-----------------------------------------------------------------------------
-// qSlicerVideoCamerasModuleWidgetPrivate methods
-
-//-----------------------------------------------------------------------------
-qSlicerVideoCamerasModuleWidgetPrivate::qSlicerVideoCamerasModuleWidgetPrivate()
-{
-}
-
-//-----------------------------------------------------------------------------
-// qSlicerVideoCamerasModuleWidget methods
-
-//-----------------------------------------------------------------------------
-qSlicerVideoCamerasModuleWidget::qSlicerVideoCamerasModuleWidget(QWidget* _parent)
-  : Superclass(_parent)
-  , d_ptr(new qSlicerVideoCamerasModuleWidgetPrivate)
-{
-}
-
-//-----------------------------------------------------------------------------
-qSlicerVideoCamerasModuleWidget::~qSlicerVideoCamerasModuleWidget()
-{
-}
-
-//----------------------------------------------------------------------------
-void qSlicerVideoCamerasModuleWidget::setMRMLScene(vtkMRMLScene* scene)
-{
-  Q_D(qSlicerVideoCamerasModuleWidget);
-
-  this->Superclass::setMRMLScene(scene);
-}
-
-//-----------------------------------------------------------------------------
-void qSlicerVideoCamerasModuleWidget::setup()
-{
-  Q_D(qSlicerVideoCamerasModuleWidget);
-  d->setupUi(this);
-  this->Superclass::setup();
-
-  connect(this, SIGNAL(mrmlSceneChanged(vtkMRMLScene*)), d->videoCameraIntrinsicsWidget, SLOT(setMRMLScene(vtkMRMLScene*)));
-}
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QDebug>
+
+// SlicerQt includes
+#include "qSlicerVideoCamerasModuleWidget.h"
+#include "ui_qSlicerVideoCamerasModuleWidget.h"
+
+// Logic includes
+#include "vtkSlicerVideoCamerasLogic.h"
+
+// VTK includes
+#include <vtkCommand.h>
+
+//-----------------------------------------------------------------------------
+/// \ingroup Slicer_QtModules_ExtensionTemplate
+class qSlicerVideoCamerasModuleWidgetPrivate: public Ui_qSlicerVideoCamerasModuleWidget
+{
+public:
+  qSlicerVideoCamerasModuleWidgetPrivate(qSlicerVideoCamerasModuleWidget& object);
+  vtkSlicerVideoCamerasLogic* logic() const;
+
+protected:
+  qSlicerVideoCamerasModuleWidget* const q_ptr;
+  Q_DECLARE_PUBLIC(qSlicerVideoCamerasModuleWidget);
+};
+
+//-----------------------------------------------------------------------------
+// qSlicerVideoCamerasModuleWidgetPrivate methods
+
+//-----------------------------------------------------------------------------
+qSlicerVideoCamerasModuleWidgetPrivate::qSlicerVideoCamerasModuleWidgetPrivate(qSlicerVideoCamerasModuleWidget& object)
+  : q_ptr(&object)
+{
+}
+
+//-----------------------------------------------------------------------------
+vtkSlicerVideoCamerasLogic* qSlicerVideoCamerasModuleWidgetPrivate::logic() const
+{
+  Q_Q(const qSlicerVideoCamerasModuleWidget);
+  return vtkSlicerVideoCamerasLogic::SafeDownCast(q->logic());
+}
+
+//-----------------------------------------------------------------------------
+// qSlicerVideoCamerasModuleWidget methods
+
+//-----------------------------------------------------------------------------
+qSlicerVideoCamerasModuleWidget::qSlicerVideoCamerasModuleWidget(QWidget* _parent)
+  : Superclass(_parent)
+  , d_ptr(new qSlicerVideoCamerasModuleWidgetPrivate(*this))
+{
+}
+
+//-----------------------------------------------------------------------------
+qSlicerVideoCamerasModuleWidget::~qSlicerVideoCamerasModuleWidget()
+{
+}
+
+//----------------------------------------------------------------------------
+void qSlicerVideoCamerasModuleWidget::setMRMLScene(vtkMRMLScene* scene)
+{
+  Q_D(qSlicerVideoCamerasModuleWidget);
+
+  this->Superclass::setMRMLScene(scene);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerVideoCamerasModuleWidget::setup()
+{
+  Q_D(qSlicerVideoCamerasModuleWidget);
+  d->setupUi(this);
+  this->Superclass::setup();
+
+  connect(this, SIGNAL(mrmlSceneChanged(vtkMRMLScene*)), d->videoCameraIntrinsicsWidget, SLOT(setMRMLScene(vtkMRMLScene*)));
+
+  // the logic is modified whenever its undo/redo stacks change
+  connect(d->undoButton, SIGNAL(clicked()), this, SLOT(onUndo()));
+  connect(d->redoButton, SIGNAL(clicked()), this, SLOT(onRedo()));
+  qvtkConnect(d->logic(), vtkCommand::ModifiedEvent, this, SLOT(updateUndoButtons()));
+  this->updateUndoButtons();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerVideoCamerasModuleWidget::onUndo()
+{
+  Q_D(qSlicerVideoCamerasModuleWidget);
+  if (d->logic() != nullptr)
+  {
+    d->logic()->Undo();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerVideoCamerasModuleWidget::onRedo()
+{
+  Q_D(qSlicerVideoCamerasModuleWidget);
+  if (d->logic() != nullptr)
+  {
+    d->logic()->Redo();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerVideoCamerasModuleWidget::updateUndoButtons()
+{
+  Q_D(qSlicerVideoCamerasModuleWidget);
+  vtkSlicerVideoCamerasLogic* logic = d->logic();
+  d->undoButton->setEnabled(logic != nullptr && logic->GetNumberOfUndoLevels() > 0);
+  d->redoButton->setEnabled(logic != nullptr && logic->GetNumberOfRedoLevels() > 0);
+}